@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Compares two result files written by multiasset-benchmarks and flags regressions.
+
+A timing difference only counts as a regression if it exceeds the noise threshold, which is the largest of:
+  * the relative threshold times the baseline,
+  * twice the combined standard deviation of both runs,
+  * the absolute minimum difference.
+Allocation counts are deterministic, so any increase is flagged.
+
+Exits with 1 if there are regressions, so it can fail a CI job.
+"""
+
+import argparse
+import json
+import math
+import sys
+
+
+def load_results(path):
+    with open(path, encoding="utf-8") as file:
+        results = json.load(file)
+
+    if results.get("schemaVersion") != 1:
+        sys.exit(f"{path}: unsupported schema version {results.get('schemaVersion')}")
+
+    return results, {benchmark["name"]: benchmark for benchmark in results["benchmarks"]}
+
+
+def compare_time(name, metric, baseline, current, baseline_deviation, current_deviation, threshold, min_delta):
+    noise = max(threshold * baseline,
+                2 * math.sqrt(baseline_deviation ** 2 + current_deviation ** 2),
+                min_delta)
+    difference = current - baseline
+    change = difference / baseline * 100 if baseline > 0 else 0.0
+
+    if difference > noise:
+        status = "REGRESSION"
+    elif difference < -noise:
+        status = "improved"
+    else:
+        status = None
+
+    return status, f"{name} {metric}: {baseline:.3f} ms -> {current:.3f} ms ({change:+.1f}%)"
+
+
+def compare_count(name, metric, baseline, current):
+    if current > baseline:
+        status = "REGRESSION"
+    elif current < baseline:
+        status = "improved"
+    else:
+        status = None
+
+    return status, f"{name} {metric}: {baseline} -> {current}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="Results of the baseline run")
+    parser.add_argument("current", help="Results of the run to check")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="Relative warm time change treated as noise (default: 0.05)")
+    parser.add_argument("--cold-threshold", type=float, default=0.25,
+                        help="Relative cold time change treated as noise, cold loads vary more (default: 0.25)")
+    parser.add_argument("--rss-threshold", type=float, default=0.10,
+                        help="Relative peak RSS change treated as noise (default: 0.10)")
+    parser.add_argument("--min-delta", type=float, default=0.05,
+                        help="Time differences in milliseconds below this are always noise (default: 0.05)")
+    parser.add_argument("--verbose", action="store_true", help="Also list unchanged metrics")
+    args = parser.parse_args()
+
+    baseline_results, baseline = load_results(args.baseline)
+    current_results, current = load_results(args.current)
+
+    if baseline_results["environment"] != current_results["environment"]:
+        print("warning: runs were made in different environments, timings may not be comparable")
+
+    regressions = 0
+    lines = []
+
+    for name in sorted(baseline.keys() & current.keys()):
+        old = baseline[name]
+        new = current[name]
+
+        if old["success"] and not new["success"]:
+            lines.append(("REGRESSION", f"{name}: no longer loads"))
+            continue
+
+        results = [
+            compare_time(name, "warm median", old["warm"]["medianMilliseconds"], new["warm"]["medianMilliseconds"],
+                         old["warm"]["standardDeviationMilliseconds"], new["warm"]["standardDeviationMilliseconds"],
+                         args.threshold, args.min_delta),
+            compare_time(name, "cold", old["cold"]["milliseconds"], new["cold"]["milliseconds"], 0, 0,
+                         args.cold_threshold, args.min_delta),
+            compare_count(name, "allocations", old["warm"]["allocations"], new["warm"]["allocations"]),
+        ]
+
+        lines.extend(results)
+
+    old_rss = baseline_results["peakRssBytes"]
+    new_rss = current_results["peakRssBytes"]
+
+    if old_rss > 0 and new_rss > old_rss * (1 + args.rss_threshold):
+        lines.append(("REGRESSION", f"peak RSS: {old_rss} -> {new_rss} bytes"))
+
+    for status, text in lines:
+        if status == "REGRESSION":
+            regressions += 1
+
+        if status or args.verbose:
+            print(f"{status or 'unchanged':<11} {text}")
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{'missing':<11} {name}")
+
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{'new':<11} {name}")
+
+    print(f"{regressions} regression(s)")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
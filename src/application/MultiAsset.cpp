@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QMessageBox>
 #include <QSurfaceFormat>
 
@@ -9,6 +10,8 @@
 #include "assetsystems/studiomodel/StudioModelAssetSystem.hpp"
 #include "assetsystems/wad/WadAssetSystem.hpp"
 
+#include "formats/DecodedTextureCache.hpp"
+
 #include "ui/MainWindow.hpp"
 
 MultiAsset::MultiAsset() = default;
@@ -47,6 +50,42 @@ int MultiAsset::Run(int argc, char** argv)
 
 	QApplication::setWindowIcon(QIcon{ ":/multiasset.ico" });
 
+	{
+		QCommandLineParser parser;
+
+		const QCommandLineOption pixmapCacheBudgetOption{ "pixmap-cache-budget",
+			"Maximum memory used by cached pixmaps, in MiB.", "MiB", QString::number(PixmapCache::DefaultBudget / (1024 * 1024)) };
+
+		const QCommandLineOption gpuBudgetOption{ "gpu-budget",
+			"Maximum video memory used by the buffers and textures of all viewers, in MiB.", "MiB",
+			QString::number(GpuResidencyManager::DefaultBudget / (1024 * 1024)) };
+
+		const QCommandLineOption textureCacheBudgetOption{ "texture-cache-budget",
+			"Maximum memory used by decoded textures shared between viewers, in MiB.", "MiB",
+			QString::number(DecodedTextureCache::DefaultBudget / (1024 * 1024)) };
+
+		parser.addHelpOption();
+		parser.addOption(pixmapCacheBudgetOption);
+		parser.addOption(gpuBudgetOption);
+		parser.addOption(textureCacheBudgetOption);
+		parser.process(app);
+
+		if (bool ok = false; const qint64 budget = parser.value(pixmapCacheBudgetOption).toLongLong(&ok); ok)
+		{
+			_pixmapCache.SetBudget(budget * 1024 * 1024);
+		}
+
+		if (bool ok = false; const qulonglong budget = parser.value(gpuBudgetOption).toULongLong(&ok); ok)
+		{
+			_gpuResidencyManager.SetBudget(static_cast<std::size_t>(budget) * 1024 * 1024);
+		}
+
+		if (bool ok = false; const qulonglong budget = parser.value(textureCacheBudgetOption).toULongLong(&ok); ok)
+		{
+			DecodedTextureCache::GetInstance().SetBudget(static_cast<std::size_t>(budget) * 1024 * 1024);
+		}
+	}
+
 	_assetSystems.push_back(std::make_unique<BspAssetSystem>());
 	_assetSystems.push_back(std::make_unique<StudioModelAssetSystem>());
 	_assetSystems.push_back(std::make_unique<SpriteAssetSystem>());
@@ -57,9 +96,20 @@ int MultiAsset::Run(int argc, char** argv)
 		assetSystem->Initialize(this);
 	}
 
+	_assetLoadQueue = std::make_unique<AssetLoadQueue>(&_assetLoaders);
+	_assetIndexer = std::make_unique<AssetIndexer>(&_assetLoaders);
+	_thumbnailService = std::make_unique<ThumbnailService>(&_assetLoaders);
+
 	auto mainWindow = new MainWindow(this);
 
 	mainWindow->showMaximized();
 	
-	return app.exec();
+	const int result = app.exec();
+
+	// Wait for any pending loads, scans and thumbnails to stop before the asset systems are destroyed.
+	_thumbnailService.reset();
+	_assetIndexer.reset();
+	_assetLoadQueue.reset();
+
+	return result;
 }
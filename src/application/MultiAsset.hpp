@@ -5,8 +5,15 @@
 
 #include <QObject>
 
+#include "assets/AssetIndexer.hpp"
 #include "assets/AssetLoaders.hpp"
+#include "assets/AssetLoadQueue.hpp"
 #include "assets/AssetSystem.hpp"
+#include "assets/ThumbnailService.hpp"
+
+#include "ui/GpuResidencyManager.hpp"
+#include "ui/GpuTextureCache.hpp"
+#include "ui/PixmapCache.hpp"
 
 class MultiAsset final : public QObject
 {
@@ -18,6 +25,18 @@ public:
 
 	AssetLoaders* GetAssetLoaders() { return &_assetLoaders; }
 
+	AssetLoadQueue* GetAssetLoadQueue() { return _assetLoadQueue.get(); }
+
+	AssetIndexer* GetAssetIndexer() { return _assetIndexer.get(); }
+
+	ThumbnailService* GetThumbnailService() { return _thumbnailService.get(); }
+
+	PixmapCache* GetPixmapCache() { return &_pixmapCache; }
+
+	GpuResidencyManager* GetGpuResidencyManager() { return &_gpuResidencyManager; }
+
+	GpuTextureCache* GetGpuTextureCache() { return &_gpuTextureCache; }
+
 	int Run(int argc, char** argv);
 
 signals:
@@ -31,5 +50,11 @@ signals:
 
 private:
 	AssetLoaders _assetLoaders;
+	PixmapCache _pixmapCache;
+	GpuResidencyManager _gpuResidencyManager;
+	GpuTextureCache _gpuTextureCache{ &_gpuResidencyManager };
 	std::vector<std::unique_ptr<AssetSystem>> _assetSystems;
+	std::unique_ptr<AssetLoadQueue> _assetLoadQueue;
+	std::unique_ptr<AssetIndexer> _assetIndexer;
+	std::unique_ptr<ThumbnailService> _thumbnailService;
 };
@@ -0,0 +1,691 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include "assets/AssetIndexer.hpp"
+#include "assets/AssetLoaders.hpp"
+
+#include "utils/IOutils.hpp"
+
+constexpr quint32 IndexFileMagic = 0x5849414D; // MAIX
+constexpr quint32 IndexFileVersion = 1;
+
+// Wait this long after the last change notification before scanning, since changes tend to arrive in bursts.
+constexpr int UpdateDelayMilliseconds = 250;
+
+struct AssetIndexScanResult
+{
+	std::vector<AssetIndexEntry> Entries;
+
+	/**
+	*	@brief Directories whose files were listed.
+	*/
+	QSet<QString> ScannedDirectories;
+
+	/**
+	*	@brief All directories that were encountered, including known directories that were not entered.
+	*/
+	QSet<QString> SeenDirectories;
+
+	/**
+	*	@brief Directories that were supposed to be scanned but no longer exist.
+	*/
+	QSet<QString> RemovedDirectories;
+
+	bool IsFullScan{ false };
+};
+
+static QString ToQString(const std::filesystem::path& path)
+{
+	return QString::fromStdU16String(path.generic_u16string());
+}
+
+static std::filesystem::path ToPath(const QString& path)
+{
+	return std::filesystem::path{ path.toStdU16String() };
+}
+
+static QString JoinPath(const QString& directory, const QString& name)
+{
+	return directory.isEmpty() ? name : directory + QLatin1Char('/') + name;
+}
+
+static QString MakeAbsolutePath(const QString& rootDirectory, const QString& path)
+{
+	return path.isEmpty() ? rootDirectory : rootDirectory + QLatin1Char('/') + path;
+}
+
+static QString GetParentDirectory(const QString& path)
+{
+	const qsizetype index = path.lastIndexOf(QLatin1Char('/'));
+	return index != -1 ? path.left(index) : QString{};
+}
+
+static bool IsInDirectory(const QString& path, const QString& directory)
+{
+	return directory.isEmpty() || (path.startsWith(directory) && path.size() > directory.size() && path[directory.size()] == QLatin1Char('/'));
+}
+
+static QString GetIndexFileName(const QString& rootDirectory)
+{
+	const QByteArray hash = QCryptographicHash::hash(rootDirectory.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+		+ QStringLiteral("/index/") + QString::fromLatin1(hash) + QStringLiteral(".index");
+}
+
+static QDataStream& operator<<(QDataStream& stream, const AssetIndexEntry& entry)
+{
+	const auto& metadata = entry.Metadata;
+
+	stream << entry.Path << entry.Type << entry.Size << entry.ModifiedTime
+		<< metadata.Width << metadata.Height << metadata.FrameCount << metadata.TextureCount << metadata.HasBounds
+		<< metadata.Mins.x << metadata.Mins.y << metadata.Mins.z
+		<< metadata.Maxs.x << metadata.Maxs.y << metadata.Maxs.z;
+
+	return stream;
+}
+
+static QDataStream& operator>>(QDataStream& stream, AssetIndexEntry& entry)
+{
+	auto& metadata = entry.Metadata;
+
+	stream >> entry.Path >> entry.Type >> entry.Size >> entry.ModifiedTime
+		>> metadata.Width >> metadata.Height >> metadata.FrameCount >> metadata.TextureCount >> metadata.HasBounds
+		>> metadata.Mins.x >> metadata.Mins.y >> metadata.Mins.z
+		>> metadata.Maxs.x >> metadata.Maxs.y >> metadata.Maxs.z;
+
+	return stream;
+}
+
+static AssetIndexEntries LoadIndex(const QString& rootDirectory)
+{
+	QFile file{ GetIndexFileName(rootDirectory) };
+
+	if (!file.open(QFile::ReadOnly))
+	{
+		return {};
+	}
+
+	QDataStream stream{ &file };
+
+	stream.setVersion(QDataStream::Qt_6_0);
+
+	quint32 magic = 0;
+	quint32 version = 0;
+	QString storedRootDirectory;
+	qint64 count = 0;
+
+	stream >> magic >> version >> storedRootDirectory >> count;
+
+	if (magic != IndexFileMagic || version != IndexFileVersion || storedRootDirectory != rootDirectory || count < 0)
+	{
+		return {};
+	}
+
+	AssetIndexEntries entries;
+
+	entries.reserve(count);
+
+	for (qint64 i = 0; i < count; ++i)
+	{
+		AssetIndexEntry entry;
+		stream >> entry;
+
+		if (stream.status() != QDataStream::Ok)
+		{
+			return {};
+		}
+
+		entries.insert(entry.Path, std::move(entry));
+	}
+
+	return entries;
+}
+
+static void SaveIndex(const QString& rootDirectory, const AssetIndexEntries& entries)
+{
+	const QString fileName = GetIndexFileName(rootDirectory);
+
+	QDir{}.mkpath(QFileInfo{ fileName }.absolutePath());
+
+	QSaveFile file{ fileName };
+
+	if (!file.open(QFile::WriteOnly))
+	{
+		return;
+	}
+
+	QDataStream stream{ &file };
+
+	stream.setVersion(QDataStream::Qt_6_0);
+
+	stream << IndexFileMagic << IndexFileVersion << rootDirectory << static_cast<qint64>(entries.size());
+
+	for (const auto& entry : entries)
+	{
+		stream << entry;
+	}
+
+	file.commit();
+}
+
+/**
+*	@brief Walks directories on multiple threads and indexes the files in them.
+*/
+class DirectoryScanner final
+{
+public:
+	DirectoryScanner(const AssetLoaders& assetLoaders, const QString& rootDirectory, const AssetIndexEntries& previousEntries,
+		const QSet<QString>& knownDirectories, const std::atomic<bool>& cancelled)
+		: _assetLoaders(assetLoaders)
+		, _rootDirectory(ToPath(rootDirectory))
+		, _previousEntries(previousEntries)
+		, _knownDirectories(knownDirectories)
+		, _cancelled(cancelled)
+	{
+	}
+
+	/**
+	*	@brief Scans the given directories.
+	*	Subdirectories are scanned as well unless they are in the set of known directories.
+	*/
+	void Scan(const QSet<QString>& directories, AssetIndexScanResult& result)
+	{
+		_pending.assign(directories.begin(), directories.end());
+
+		const unsigned int threadCount = std::clamp(std::thread::hardware_concurrency(), 1U, 16U);
+
+		std::vector<AssetIndexScanResult> threadResults;
+		threadResults.resize(threadCount);
+
+		{
+			std::vector<std::jthread> threads;
+
+			threads.reserve(threadCount);
+
+			for (auto& threadResult : threadResults)
+			{
+				threads.emplace_back([this, &threadResult] { Run(threadResult); });
+			}
+		}
+
+		for (auto& threadResult : threadResults)
+		{
+			result.Entries.insert(result.Entries.end(),
+				std::make_move_iterator(threadResult.Entries.begin()), std::make_move_iterator(threadResult.Entries.end()));
+			result.ScannedDirectories.unite(threadResult.ScannedDirectories);
+			result.SeenDirectories.unite(threadResult.SeenDirectories);
+			result.RemovedDirectories.unite(threadResult.RemovedDirectories);
+		}
+	}
+
+private:
+	void Run(AssetIndexScanResult& result)
+	{
+		while (true)
+		{
+			QString directory;
+
+			{
+				std::unique_lock lock{ _mutex };
+
+				_condition.wait(lock, [this] { return !_pending.empty() || _busyCount == 0; });
+
+				if (_pending.empty())
+				{
+					return;
+				}
+
+				directory = std::move(_pending.front());
+				_pending.pop_front();
+				++_busyCount;
+			}
+
+			if (!_cancelled)
+			{
+				ScanDirectory(directory, result);
+			}
+
+			{
+				std::lock_guard lock{ _mutex };
+				--_busyCount;
+			}
+
+			_condition.notify_all();
+		}
+	}
+
+	void ScanDirectory(const QString& directory, AssetIndexScanResult& result)
+	{
+		std::error_code error;
+
+		std::filesystem::directory_iterator it{ _rootDirectory / ToPath(directory), error };
+
+		if (error)
+		{
+			result.RemovedDirectories.insert(directory);
+			return;
+		}
+
+		result.ScannedDirectories.insert(directory);
+		result.SeenDirectories.insert(directory);
+
+		for (; it != std::filesystem::directory_iterator{}; it.increment(error))
+		{
+			if (error || _cancelled)
+			{
+				return;
+			}
+
+			const auto& entry = *it;
+
+			const QString path = JoinPath(directory, ToQString(entry.path().filename()));
+
+			// Symbolic links to directories are skipped to avoid cycles.
+			if (entry.is_directory(error) && !entry.is_symlink(error))
+			{
+				result.SeenDirectories.insert(path);
+
+				if (!_knownDirectories.contains(path))
+				{
+					{
+						std::lock_guard lock{ _mutex };
+						_pending.push_back(path);
+					}
+
+					_condition.notify_one();
+				}
+			}
+			else if (entry.is_regular_file(error))
+			{
+				result.Entries.push_back(IndexFile(entry, path));
+			}
+		}
+	}
+
+	AssetIndexEntry IndexFile(const std::filesystem::directory_entry& fileEntry, const QString& path) const
+	{
+		std::error_code error;
+
+		AssetIndexEntry entry;
+
+		entry.Path = path;
+		entry.Size = static_cast<qint64>(fileEntry.file_size(error));
+		entry.ModifiedTime = static_cast<qint64>(fileEntry.last_write_time(error).time_since_epoch().count());
+
+		// Unchanged files don't need to be opened again.
+		if (const auto previous = _previousEntries.constFind(path);
+			previous != _previousEntries.constEnd() && previous->Size == entry.Size && previous->ModifiedTime == entry.ModifiedTime)
+		{
+			return *previous;
+		}
+
+		FILE* file = OpenFileForReading(fileEntry.path());
+
+		if (!file)
+		{
+			return entry;
+		}
+
+		// Only a few bytes are read so buffering would just read more than needed.
+		std::setvbuf(file, nullptr, _IONBF, 0);
+
+		// A corrupt file must not take down the scanner thread, it is indexed without metadata instead.
+		try
+		{
+			if (auto assetLoader = _assetLoaders.Classify(file); assetLoader)
+			{
+				entry.Type = assetLoader->GetName();
+
+				if (auto metadata = assetLoader->TryReadMetadata(file); metadata)
+				{
+					entry.Metadata = *metadata;
+				}
+			}
+		}
+		catch (const std::exception&)
+		{
+			entry.Metadata = {};
+		}
+
+		std::fclose(file);
+
+		return entry;
+	}
+
+private:
+	const AssetLoaders& _assetLoaders;
+	const std::filesystem::path _rootDirectory;
+	const AssetIndexEntries& _previousEntries;
+	const QSet<QString>& _knownDirectories;
+	const std::atomic<bool>& _cancelled;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::deque<QString> _pending;
+	int _busyCount{ 0 };
+};
+
+AssetIndexer::AssetIndexer(const AssetLoaders* assetLoaders, QObject* parent)
+	: QObject(parent)
+	, _assetLoaders(assetLoaders)
+{
+	_threadPool.setMaxThreadCount(1);
+
+	_updateTimer = new QTimer(this);
+	_updateTimer->setSingleShot(true);
+
+	connect(&_watcher, &QFileSystemWatcher::directoryChanged, this, &AssetIndexer::OnDirectoryChanged);
+	connect(&_watcher, &QFileSystemWatcher::fileChanged, this, &AssetIndexer::OnFileChanged);
+	connect(_updateTimer, &QTimer::timeout, this, &AssetIndexer::UpdateChangedDirectories);
+}
+
+AssetIndexer::~AssetIndexer()
+{
+	if (_cancelled)
+	{
+		*_cancelled = true;
+	}
+
+	_threadPool.waitForDone();
+}
+
+void AssetIndexer::SetRootDirectory(const QString& directory)
+{
+	if (_cancelled)
+	{
+		*_cancelled = true;
+	}
+
+	++_generation;
+	_cancelled = std::make_shared<std::atomic<bool>>(false);
+
+	_rootDirectory = QDir::cleanPath(QDir{ directory }.absolutePath());
+	_entries.clear();
+	_directories.clear();
+	_changedDirectories.clear();
+	_updateTimer->stop();
+
+	if (const QStringList watched = _watcher.directories() + _watcher.files(); !watched.isEmpty())
+	{
+		_watcher.removePaths(watched);
+	}
+
+	_isIndexing = true;
+
+	emit IndexingStarted();
+	emit EntriesChanged();
+
+	_threadPool.start([this, generation = _generation, rootDirectory = _rootDirectory, cancelled = _cancelled]
+		{
+			// Make the previous session's index available right away, the scan will correct any outdated entries.
+			const AssetIndexEntries previousEntries = LoadIndex(rootDirectory);
+
+			if (!previousEntries.isEmpty())
+			{
+				QMetaObject::invokeMethod(this, [this, generation, previousEntries]
+					{
+						if (generation == _generation && _isIndexing)
+						{
+							_entries = previousEntries;
+							emit EntriesChanged();
+						}
+					}, Qt::QueuedConnection);
+			}
+
+			auto result = std::make_shared<AssetIndexScanResult>();
+
+			result->IsFullScan = true;
+
+			// Everything is scanned so there are no known directories to skip.
+			const QSet<QString> knownDirectories;
+
+			DirectoryScanner scanner{ *_assetLoaders, rootDirectory, previousEntries, knownDirectories, *cancelled };
+
+			scanner.Scan({ QString{} }, *result);
+
+			if (*cancelled)
+			{
+				return;
+			}
+
+			QMetaObject::invokeMethod(this, [this, generation, result]
+				{
+					OnScanFinished(generation, result);
+				}, Qt::QueuedConnection);
+		});
+}
+
+void AssetIndexer::OnScanFinished(int generation, const std::shared_ptr<AssetIndexScanResult>& result)
+{
+	if (generation != _generation)
+	{
+		return;
+	}
+
+	QStringList addedDirectories;
+	QStringList removedDirectories;
+
+	if (result->IsFullScan)
+	{
+		_entries.clear();
+		_entries.reserve(result->Entries.size());
+
+		_directories = result->SeenDirectories;
+
+		for (const auto& directory : _directories)
+		{
+			addedDirectories.append(MakeAbsolutePath(_rootDirectory, directory));
+		}
+	}
+	else
+	{
+		// Known directories that were not seen again while scanning their parent have been removed.
+		QSet<QString> removed = result->RemovedDirectories;
+
+		for (const auto& directory : _directories)
+		{
+			if (!directory.isEmpty() && result->ScannedDirectories.contains(GetParentDirectory(directory))
+				&& !result->SeenDirectories.contains(directory))
+			{
+				removed.insert(directory);
+			}
+		}
+
+		QSet<QString> resultPaths;
+		resultPaths.reserve(result->Entries.size());
+
+		for (const auto& entry : result->Entries)
+		{
+			resultPaths.insert(entry.Path);
+		}
+
+		const auto isRemoved = [&](const QString& path)
+		{
+			return std::any_of(removed.begin(), removed.end(), [&](const auto& directory) { return IsInDirectory(path, directory); });
+		};
+
+		for (auto it = _entries.begin(); it != _entries.end();)
+		{
+			const QString& path = it.key();
+
+			if ((result->ScannedDirectories.contains(GetParentDirectory(path)) && !resultPaths.contains(path))
+				|| (!removed.isEmpty() && isRemoved(path)))
+			{
+				it = _entries.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		for (auto it = _directories.begin(); it != _directories.end();)
+		{
+			if (removed.contains(*it) || isRemoved(*it))
+			{
+				removedDirectories.append(MakeAbsolutePath(_rootDirectory, *it));
+				it = _directories.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		for (const auto& directory : result->SeenDirectories)
+		{
+			if (!_directories.contains(directory))
+			{
+				_directories.insert(directory);
+				addedDirectories.append(MakeAbsolutePath(_rootDirectory, directory));
+			}
+		}
+	}
+
+	for (auto& entry : result->Entries)
+	{
+		_entries.insert(entry.Path, std::move(entry));
+	}
+
+	if (!removedDirectories.isEmpty())
+	{
+		_watcher.removePaths(removedDirectories);
+	}
+
+	if (!addedDirectories.isEmpty())
+	{
+		_watcher.addPaths(addedDirectories);
+	}
+
+	UpdateWatchedFiles();
+
+	const bool wasIndexing = _isIndexing;
+
+	_isIndexing = false;
+
+	SaveIndex();
+
+	emit EntriesChanged();
+
+	if (wasIndexing)
+	{
+		emit IndexingFinished();
+	}
+
+	// Changes that came in while scanning.
+	if (!_changedDirectories.isEmpty())
+	{
+		_updateTimer->start(UpdateDelayMilliseconds);
+	}
+}
+
+void AssetIndexer::OnDirectoryChanged(const QString& path)
+{
+	const QString relativePath = QDir{ _rootDirectory }.relativeFilePath(path);
+
+	_changedDirectories.insert(relativePath == QLatin1String(".") ? QString{} : relativePath);
+
+	_updateTimer->start(UpdateDelayMilliseconds);
+}
+
+void AssetIndexer::OnFileChanged(const QString& path)
+{
+	// Rescanning the file's directory picks up the new size and modification time.
+	// Files that were replaced or removed are no longer watched, the rescan watches their replacement.
+	OnDirectoryChanged(GetParentDirectory(path));
+}
+
+void AssetIndexer::UpdateWatchedFiles()
+{
+	const QStringList watchedList = _watcher.files();
+
+	QSet<QString> watched{ watchedList.begin(), watchedList.end() };
+
+	QStringList addedFiles;
+
+	for (const auto& entry : _entries)
+	{
+		if (entry.Type.isEmpty())
+		{
+			continue;
+		}
+
+		const QString path = MakeAbsolutePath(_rootDirectory, entry.Path);
+
+		// Whatever is left over afterwards is no longer an asset.
+		if (!watched.remove(path))
+		{
+			addedFiles.append(path);
+		}
+	}
+
+	if (!watched.isEmpty())
+	{
+		_watcher.removePaths(QStringList{ watched.begin(), watched.end() });
+	}
+
+	if (!addedFiles.isEmpty())
+	{
+		_watcher.addPaths(addedFiles);
+	}
+}
+
+void AssetIndexer::UpdateChangedDirectories()
+{
+	// Wait for the current scan to finish, it will restart the timer.
+	if (_isIndexing || _changedDirectories.isEmpty())
+	{
+		return;
+	}
+
+	_isIndexing = true;
+
+	emit IndexingStarted();
+
+	_threadPool.start([this, generation = _generation, rootDirectory = _rootDirectory, cancelled = _cancelled,
+		entries = _entries, directories = _directories, changedDirectories = std::exchange(_changedDirectories, {})]
+		{
+			auto result = std::make_shared<AssetIndexScanResult>();
+
+			DirectoryScanner scanner{ *_assetLoaders, rootDirectory, entries, directories, *cancelled };
+
+			scanner.Scan(changedDirectories, *result);
+
+			if (*cancelled)
+			{
+				return;
+			}
+
+			QMetaObject::invokeMethod(this, [this, generation, result]
+				{
+					OnScanFinished(generation, result);
+				}, Qt::QueuedConnection);
+		});
+}
+
+void AssetIndexer::SaveIndex()
+{
+	_threadPool.start([rootDirectory = _rootDirectory, entries = _entries]
+		{
+			::SaveIndex(rootDirectory, entries);
+		});
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QtTypes>
+
+#include "assets/AssetMetadata.hpp"
+
+class AssetLoaders;
+class QTimer;
+
+struct AssetIndexScanResult;
+
+struct AssetIndexEntry
+{
+	/**
+	*	@brief Path relative to the root directory, using forward slashes.
+	*/
+	QString Path;
+
+	/**
+	*	@brief Name of the loader that handles this file. Empty if the file is not a supported asset.
+	*/
+	QString Type;
+
+	qint64 Size{ 0 };
+	qint64 ModifiedTime{ 0 };
+
+	AssetMetadata Metadata;
+};
+
+using AssetIndexEntries = QHash<QString, AssetIndexEntry>;
+
+/**
+*	@brief Indexes all files in a game or mod directory.
+*	@details The directory is walked on multiple threads and every file is classified using the asset loaders' signatures.
+*	The index is saved to disk so the next session only has to check files whose size or modification time changed.
+*	Once a directory has been indexed it is watched for changes and only changed directories are scanned again.
+*	Asset files are watched as well, since editing a file in place does not change its directory on all platforms.
+*	Other files are not watched to stay within the system's limit on watches.
+*	All members must be used on the GUI thread.
+*/
+class AssetIndexer final : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit AssetIndexer(const AssetLoaders* assetLoaders, QObject* parent = nullptr);
+	~AssetIndexer();
+
+	const QString& GetRootDirectory() const { return _rootDirectory; }
+
+	const AssetIndexEntries& GetEntries() const { return _entries; }
+
+	bool IsIndexing() const { return _isIndexing; }
+
+	/**
+	*	@brief Starts indexing the given directory. Returns immediately.
+	*	@details If an index was saved for this directory before it is made available right away
+	*	and then brought up to date in the background.
+	*/
+	void SetRootDirectory(const QString& directory);
+
+signals:
+	void IndexingStarted();
+	void IndexingFinished();
+
+	/**
+	*	@brief Emitted whenever entries were added, changed or removed.
+	*/
+	void EntriesChanged();
+
+private:
+	void OnScanFinished(int generation, const std::shared_ptr<AssetIndexScanResult>& result);
+
+	void OnDirectoryChanged(const QString& path);
+
+	void OnFileChanged(const QString& path);
+
+	/**
+	*	@brief Watches the files of all asset entries and stops watching files that are no longer assets or have been removed.
+	*/
+	void UpdateWatchedFiles();
+
+	void UpdateChangedDirectories();
+
+	void SaveIndex();
+
+private:
+	const AssetLoaders* const _assetLoaders;
+
+	// Runs one scan or save at a time; scans use their own threads to walk the directory.
+	QThreadPool _threadPool;
+
+	QFileSystemWatcher _watcher;
+	QTimer* _updateTimer;
+
+	QString _rootDirectory;
+
+	// Incremented when the root directory changes so results of older scans are ignored.
+	int _generation{ 0 };
+	std::shared_ptr<std::atomic<bool>> _cancelled;
+
+	bool _isIndexing{ false };
+
+	AssetIndexEntries _entries;
+
+	// Relative paths of all directories, the root directory is an empty string.
+	QSet<QString> _directories;
+
+	QSet<QString> _changedDirectories;
+};
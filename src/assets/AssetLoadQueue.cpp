@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+
+#include <QThread>
+
+#include "assets/AssetLoaders.hpp"
+#include "assets/AssetLoadQueue.hpp"
+
+#include "utils/IOutils.hpp"
+#include "utils/LoadProgress.hpp"
+
+struct AssetLoadQueue::Job
+{
+	QString FileName;
+	LoadProgress Progress;
+};
+
+static AssetLoadResult LoadFile(const AssetLoaders& assetLoaders, const QString& fileName, LoadProgress& progress)
+{
+	FILE* file = OpenFileForReading(std::filesystem::path{ fileName.toStdU16String() });
+
+	if (!file)
+	{
+		return { AssetLoadStatus::Failed };
+	}
+
+	AssetLoadResult result;
+
+	if (auto assetLoader = assetLoaders.Classify(file); assetLoader)
+	{
+		// Parsers throw on malformed files, such as truncated maps. Catch here so the file is still closed.
+		try
+		{
+			result = assetLoader->LoadFile(fileName, file, progress);
+		}
+		catch (const std::exception&)
+		{
+			result = { AssetLoadStatus::Failed };
+		}
+	}
+
+	fclose(file);
+
+	return result;
+}
+
+AssetLoadQueue::AssetLoadQueue(AssetLoaders* assetLoaders, QObject* parent)
+	: QObject(parent)
+	, _assetLoaders(assetLoaders)
+{
+	_threadPool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() - 1, 1, MaxWorkerCount));
+}
+
+AssetLoadQueue::~AssetLoadQueue()
+{
+	// Workers reference the loaders and this object, so they must be stopped first.
+	CancelAll();
+	_threadPool.waitForDone();
+}
+
+void AssetLoadQueue::Load(const QString& fileName)
+{
+	auto job = std::make_shared<Job>();
+
+	job->FileName = fileName;
+
+	_jobs.push_back(job);
+
+	emit LoadStarted(fileName);
+
+	_threadPool.start([this, job]
+		{
+			AssetLoadResult result;
+
+			if (!job->Progress.IsCancelled())
+			{
+				result = LoadFile(*_assetLoaders, job->FileName, job->Progress);
+			}
+
+			job->Progress.SetProgress(1.f);
+
+			QMetaObject::invokeMethod(this, [this, job, result = std::move(result)]() mutable
+				{
+					OnJobFinished(job, std::move(result));
+				}, Qt::QueuedConnection);
+		});
+}
+
+void AssetLoadQueue::CancelAll()
+{
+	for (const auto& job : _jobs)
+	{
+		job->Progress.Cancel();
+	}
+}
+
+float AssetLoadQueue::GetProgress() const
+{
+	const std::size_t totalCount = _finishedCount + _jobs.size();
+
+	if (totalCount == 0)
+	{
+		return 1.f;
+	}
+
+	float progress = static_cast<float>(_finishedCount);
+
+	for (const auto& job : _jobs)
+	{
+		progress += job->Progress.GetProgress();
+	}
+
+	return progress / totalCount;
+}
+
+void AssetLoadQueue::OnJobFinished(const std::shared_ptr<Job>& job, AssetLoadResult result)
+{
+	_jobs.erase(std::find(_jobs.begin(), _jobs.end(), job));
+
+	if (_jobs.empty())
+	{
+		_finishedCount = 0;
+	}
+	else
+	{
+		++_finishedCount;
+	}
+
+	if (job->Progress.IsCancelled())
+	{
+		result.Status = AssetLoadStatus::Cancelled;
+	}
+	else if (result.Status == AssetLoadStatus::Loaded && result.Finish)
+	{
+		result.Finish();
+	}
+
+	emit LoadFinished(job->FileName, result.Status);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include "assets/IAssetLoader.hpp"
+
+class AssetLoaders;
+
+/**
+*	@brief Loads assets on a bounded pool of worker threads.
+*	@details Files are parsed on the worker threads.
+*	Once a file has been loaded the result is handed back to the owning asset system on the GUI thread.
+*	All members must be used on the GUI thread.
+*/
+class AssetLoadQueue final : public QObject
+{
+	Q_OBJECT
+
+public:
+	/**
+	*	@brief Upper limit on the number of files that are loaded at the same time.
+	*	@details Loading is mostly limited by memory bandwidth so using every core won't make it much faster.
+	*/
+	static constexpr int MaxWorkerCount = 4;
+
+	explicit AssetLoadQueue(AssetLoaders* assetLoaders, QObject* parent = nullptr);
+	~AssetLoadQueue();
+
+	/**
+	*	@brief Queues a file to be loaded. Returns immediately.
+	*/
+	void Load(const QString& fileName);
+
+	/**
+	*	@brief Cancels all queued and running loads.
+	*/
+	void CancelAll();
+
+	/**
+	*	@brief Gets the number of files that are queued or being loaded.
+	*/
+	int GetPendingCount() const { return static_cast<int>(_jobs.size()); }
+
+	/**
+	*	@brief Gets the combined progress in the range [0, 1] of all files queued since the queue was last empty.
+	*/
+	float GetProgress() const;
+
+signals:
+	void LoadStarted(const QString& fileName);
+
+	void LoadFinished(const QString& fileName, AssetLoadStatus status);
+
+private:
+	struct Job;
+
+	void OnJobFinished(const std::shared_ptr<Job>& job, AssetLoadResult result);
+
+private:
+	AssetLoaders* const _assetLoaders;
+
+	QThreadPool _threadPool;
+
+	std::vector<std::shared_ptr<Job>> _jobs;
+
+	// Used to report progress over all files queued in one go.
+	int _finishedCount{ 0 };
+};
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include "assets/AssetLoaders.hpp"
+
+constexpr std::size_t IdentifierSize = sizeof(std::uint32_t);
+
+static std::uint32_t ToIdentifier(const void* data)
+{
+	std::uint32_t identifier;
+	std::memcpy(&identifier, data, IdentifierSize);
+	return identifier;
+}
+
+void AssetLoaders::Add(std::unique_ptr<IAssetLoader> loader)
+{
+	assert(loader);
+
+	for (const auto& signature : loader->GetSignatures())
+	{
+		assert(!signature.Bytes.empty());
+		assert((signature.Offset + signature.Bytes.size()) <= MaxHeaderSize);
+
+		// Only MaxHeaderSize bytes are read to classify files, so these could never match.
+		if (signature.Bytes.empty() || (signature.Offset + signature.Bytes.size()) > MaxHeaderSize)
+		{
+			continue;
+		}
+
+		_headerSize = std::max(_headerSize, signature.Offset + signature.Bytes.size());
+
+		if (signature.Offset == 0 && signature.Bytes.size() == IdentifierSize)
+		{
+			const std::pair entry{ ToIdentifier(signature.Bytes.data()), loader.get() };
+
+			const auto it = std::lower_bound(_identifiers.begin(), _identifiers.end(), entry, [](const auto& lhs, const auto& rhs)
+				{
+					return lhs.first < rhs.first;
+				});
+
+			// First loader to claim an identifier keeps it.
+			assert(it == _identifiers.end() || it->first != entry.first);
+
+			if (it == _identifiers.end() || it->first != entry.first)
+			{
+				_identifiers.insert(it, entry);
+			}
+		}
+		else
+		{
+			_genericSignatures.push_back({ signature, loader.get() });
+		}
+	}
+
+	_loaders.push_back(std::move(loader));
+}
+
+IAssetLoader* AssetLoaders::Classify(std::span<const std::byte> header) const
+{
+	if (header.size() >= IdentifierSize)
+	{
+		const std::uint32_t identifier = ToIdentifier(header.data());
+
+		const auto it = std::lower_bound(_identifiers.begin(), _identifiers.end(), identifier, [](const auto& lhs, std::uint32_t rhs)
+			{
+				return lhs.first < rhs;
+			});
+
+		if (it != _identifiers.end() && it->first == identifier)
+		{
+			return it->second;
+		}
+	}
+
+	for (const auto& [signature, loader] : _genericSignatures)
+	{
+		if ((signature.Offset + signature.Bytes.size()) <= header.size()
+			&& std::memcmp(header.data() + signature.Offset, signature.Bytes.data(), signature.Bytes.size()) == 0)
+		{
+			return loader;
+		}
+	}
+
+	return nullptr;
+}
+
+IAssetLoader* AssetLoaders::Classify(FILE* file) const
+{
+	std::array<std::byte, MaxHeaderSize> header;
+
+	const std::size_t bytesRead = std::fread(header.data(), 1, _headerSize, file);
+
+	std::rewind(file);
+
+	return Classify(std::span{ header.data(), bytesRead });
+}
@@ -1,31 +1,65 @@
 #pragma once
 
-#include <algorithm>
-#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <memory>
 #include <ranges>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "assets/IAssetLoader.hpp"
 
 /**
-*	@brief Stores the list of asset loaders.
+*	@brief Stores the list of asset loaders and determines which loader handles a file.
+*	@details The signatures of all loaders are compiled into a dispatch table when loaders are added,
+*	so classifying a file only requires the first few bytes of the file to be read once.
+*	Loaders must be added before any files are classified. After that all members are safe to use from any thread.
 */
 class AssetLoaders final
 {
 public:
+	/**
+	*	@brief Upper limit on the header size that signatures can inspect.
+	*/
+	static constexpr std::size_t MaxHeaderSize = 64;
+
 	auto GetLoaders() const { return _loaders | std::views::transform([](const auto& loader) {return loader.get(); }); }
 
-	void Add(std::unique_ptr<IAssetLoader> loader)
-	{
-		assert(loader);
+	void Add(std::unique_ptr<IAssetLoader> loader);
+
+	/**
+	*	@brief Gets the number of bytes that has to be read from the start of a file to classify it.
+	*/
+	std::size_t GetHeaderSize() const { return _headerSize; }
+
+	/**
+	*	@brief Finds the loader for a file given the start of its contents.
+	*	@param header The first GetHeaderSize() bytes of the file, or the entire file if it's smaller.
+	*	@return The loader, or null if no loader supports the file.
+	*/
+	IAssetLoader* Classify(std::span<const std::byte> header) const;
 
-		_loaders.insert(std::upper_bound(_loaders.begin(), _loaders.end(), loader, [](const auto& lhs, const auto& rhs)
-			{
-				return lhs->GetPriority() >= rhs->GetPriority();
-			}), std::move(loader));
-	}
+	/**
+	*	@brief Reads the header of the given file and finds its loader.
+	*	The file is rewound afterwards.
+	*/
+	IAssetLoader* Classify(FILE* file) const;
 
 private:
+	struct GenericSignature
+	{
+		AssetSignature Signature;
+		IAssetLoader* Loader;
+	};
+
 	std::vector<std::unique_ptr<IAssetLoader>> _loaders;
+
+	// Almost every format uses a 4 byte identifier at the start of the file,
+	// so those are looked up by value and everything else is checked one by one.
+	std::vector<std::pair<std::uint32_t, IAssetLoader*>> _identifiers;
+	std::vector<GenericSignature> _genericSignatures;
+
+	std::size_t _headerSize{ 0 };
 };
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+/**
+*	@brief Quick summary of an asset that can be read without fully loading it.
+*	@details Only the members that make sense for the asset's type are set.
+*/
+struct AssetMetadata
+{
+	int Width{ 0 };
+	int Height{ 0 };
+	int FrameCount{ 0 };
+	int TextureCount{ 0 };
+
+	bool HasBounds{ false };
+	glm::vec3 Mins{ 0 };
+	glm::vec3 Maxs{ 0 };
+};
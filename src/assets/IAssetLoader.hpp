@@ -1,10 +1,68 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdio>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
 
+#include <QImage>
 #include <QString>
 #include <QStringList>
 
+#include "assets/AssetMetadata.hpp"
+
+class LoadProgress;
+
+enum class AssetLoadStatus
+{
+	NotSupported = 0,
+	Failed,
+	Loaded,
+
+	/**
+	*	@brief The load was cancelled by the user. Only reported by AssetLoadQueue, loaders return Failed instead.
+	*/
+	Cancelled
+};
+
+/**
+*	@brief The result of loading an asset on a worker thread.
+*/
+struct AssetLoadResult
+{
+	AssetLoadStatus Status{ AssetLoadStatus::NotSupported };
+
+	/**
+	*	@brief Hands the loaded asset over to the asset system that manages it.
+	*	Only set if @c Status is @c AssetLoadStatus::Loaded. Always invoked on the GUI thread.
+	*/
+	std::function<void()> Finish;
+};
+
+/**
+*	@brief A sequence of bytes at a fixed offset in a file's header that identifies its format.
+*/
+struct AssetSignature
+{
+	std::size_t Offset{ 0 };
+	std::string_view Bytes;
+};
+
+/**
+*	@brief Scales an image down so it fits in a thumbnail of the given size. Smaller images are returned as-is.
+*/
+inline QImage FitThumbnail(const QImage& image, int size)
+{
+	if (image.width() <= size && image.height() <= size)
+	{
+		return image;
+	}
+
+	return image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
 /**
 *	@brief Represents a loader for an asset type.
 *	@details The loader is responsible for adding the loaded asset to the correct asset system.
@@ -15,13 +73,6 @@ class IAssetLoader
 public:
 	virtual ~IAssetLoader() = default;
 
-	/**
-	*	@brief Gets the load priority. Higher priority loaders are checked earlier.
-	*	@details This is needed to ensure that formats like the Half-Life 1 BSP format which lack header identifiers
-	*	are checked after formats that have header identifiers.
-	*/
-	virtual int GetPriority() const { return 0; }
-
 	/**
 	*	@brief Gets the name of the format this loader supports.
 	*/
@@ -35,8 +86,39 @@ public:
 	virtual QStringList GetFileTypes() const = 0;
 
 	/**
-	*	@brief Try to load the given file.
-	*	If the file is a format supported by this loader then it must return true, even if there is an error during loading.
+	*	@brief Gets the header signatures that identify files supported by this loader.
+	*	@details AssetLoaders uses these to pick the loader for a file from a single header read.
+	*	Formats without an identifier can use another fixed header value such as a version number.
+	*	The bytes must remain valid for the lifetime of the loader.
+	*/
+	virtual std::vector<AssetSignature> GetSignatures() const = 0;
+
+	/**
+	*	@brief Reads a quick summary of the given file for indexing purposes.
+	*	Only called for files whose header matches one of this loader's signatures.
+	*	@details This is called on worker threads and should read as little of the file as possible.
+	*/
+	virtual std::optional<AssetMetadata> TryReadMetadata(FILE* file) const { return {}; }
+
+	/**
+	*	@brief Creates a thumbnail of the given file. Only called for files whose header matches one of this loader's signatures.
+	*	@details This is called on worker threads and should decode only what the thumbnail needs.
+	*	@param entryName For files containing multiple assets, the name of the asset to create a thumbnail of.
+	*		If empty, the loader picks a representative asset.
+	*	@param size The thumbnail must fit in a square of this size.
+	*	@param progress Loaders should stop and return a null image if cancellation has been requested.
+	*	@return The thumbnail, or a null image if the file has no thumbnail.
+	*/
+	virtual QImage CreateThumbnail(FILE* file, const QString& entryName, int size, LoadProgress& progress) const { return {}; }
+
+	/**
+	*	@brief Loads the given file. Only called for files whose header matches one of this loader's signatures.
+	*	@return @c AssetLoadStatus::Loaded if the file was loaded, @c AssetLoadStatus::Failed otherwise.
+	*	@details This is called on a worker thread, so it must not touch any widgets or the asset system itself.
+	*	Anything that has to happen on the GUI thread belongs in @c AssetLoadResult::Finish.
+	*	@param fileName Name of the file being loaded, for display purposes and to identify it if it is loaded again.
+	*	@param progress Receives load progress. Loaders should stop and return @c AssetLoadStatus::Failed
+	*		if cancellation has been requested.
 	*/
-	virtual bool TryLoadFile(FILE* file) = 0;
+	virtual AssetLoadResult LoadFile(const QString& fileName, FILE* file, LoadProgress& progress) = 0;
 };
@@ -0,0 +1,196 @@
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QMutexLocker>
+
+#include "assets/ThumbnailCache.hpp"
+
+constexpr quint32 IndexFileMagic = 0x5854414D; // MATX
+constexpr quint32 IndexFileVersion = 1;
+
+// Magic and version.
+constexpr qint64 IndexHeaderSize = 8;
+
+// Key, offset and length.
+constexpr int KeySize = 20;
+constexpr qint64 IndexRecordSize = KeySize + 8 + 4;
+
+ThumbnailCache::ThumbnailCache(const QString& directory)
+	: _indexFile(directory + QStringLiteral("/thumbnails.index"))
+	, _dataFile(directory + QStringLiteral("/thumbnails.data"))
+{
+	QDir{}.mkpath(directory);
+	Load();
+}
+
+ThumbnailCache::~ThumbnailCache() = default;
+
+QByteArray ThumbnailCache::MakeKey(const QString& fileName, const QString& entryName, int size, qint64 fileSize, qint64 modifiedTime)
+{
+	QCryptographicHash hash{ QCryptographicHash::Sha1 };
+
+	hash.addData(fileName.toUtf8());
+	hash.addData(QByteArrayView{ "\0", 1 });
+	hash.addData(entryName.toUtf8());
+	hash.addData(QByteArrayView{ "\0", 1 });
+
+	const qint64 values[] = { size, fileSize, modifiedTime };
+
+	hash.addData(QByteArrayView{ reinterpret_cast<const char*>(values), sizeof(values) });
+
+	return hash.result();
+}
+
+QImage ThumbnailCache::Find(const QByteArray& key)
+{
+	QMutexLocker lock{ &_mutex };
+
+	const auto it = _records.constFind(key);
+
+	if (it == _records.constEnd() || !_dataFile.isOpen() || !_dataFile.seek(it->Offset))
+	{
+		return {};
+	}
+
+	const qint32 length = it->Length;
+	const QByteArray data = _dataFile.read(length);
+
+	// Decode after unlocking so other threads can use the cache in the meantime.
+	lock.unlock();
+
+	QImage image;
+
+	if (data.size() != length || !image.loadFromData(data, "PNG"))
+	{
+		return {};
+	}
+
+	return image;
+}
+
+void ThumbnailCache::Store(const QByteArray& key, const QImage& image)
+{
+	QByteArray data;
+
+	{
+		QBuffer buffer{ &data };
+		buffer.open(QBuffer::WriteOnly);
+
+		if (!image.save(&buffer, "PNG"))
+		{
+			return;
+		}
+	}
+
+	QMutexLocker lock{ &_mutex };
+
+	if (!_indexFile.isOpen() || !_dataFile.isOpen() || _records.contains(key))
+	{
+		return;
+	}
+
+	if ((_dataFile.size() + data.size()) > MaxDataSize)
+	{
+		Reset();
+	}
+
+	const Record record{ _dataFile.size(), static_cast<qint32>(data.size()) };
+
+	// Write the data first so the index never refers to data that was not written.
+	if (!_dataFile.seek(record.Offset) || _dataFile.write(data) != data.size() || !_dataFile.flush())
+	{
+		return;
+	}
+
+	QDataStream stream{ &_indexFile };
+
+	stream.writeRawData(key.constData(), KeySize);
+	stream << record.Offset << record.Length;
+
+	_indexFile.flush();
+
+	_records.insert(key, record);
+}
+
+void ThumbnailCache::Clear()
+{
+	QMutexLocker lock{ &_mutex };
+	Reset();
+}
+
+void ThumbnailCache::Load()
+{
+	if (!_dataFile.open(QFile::ReadWrite))
+	{
+		return;
+	}
+
+	if (!_indexFile.open(QFile::ReadWrite))
+	{
+		_dataFile.close();
+		return;
+	}
+
+	QDataStream stream{ &_indexFile };
+
+	quint32 magic = 0;
+	quint32 version = 0;
+
+	stream >> magic >> version;
+
+	if (stream.status() != QDataStream::Ok || magic != IndexFileMagic || version != IndexFileVersion)
+	{
+		Reset();
+		return;
+	}
+
+	const qint64 dataSize = _dataFile.size();
+	const qint64 recordCount = (_indexFile.size() - IndexHeaderSize) / IndexRecordSize;
+
+	_records.reserve(recordCount);
+
+	for (qint64 i = 0; i < recordCount; ++i)
+	{
+		QByteArray key{ KeySize, Qt::Uninitialized };
+		Record record;
+
+		stream.readRawData(key.data(), KeySize);
+		stream >> record.Offset >> record.Length;
+
+		if (stream.status() != QDataStream::Ok)
+		{
+			break;
+		}
+
+		// Ignore records whose data was not written completely.
+		if (record.Offset >= 0 && record.Length > 0 && (record.Offset + record.Length) <= dataSize)
+		{
+			_records.insert(key, record);
+		}
+	}
+
+	// Drop any partially written record so new records are appended after the last complete one.
+	_indexFile.resize(IndexHeaderSize + (recordCount * IndexRecordSize));
+	_indexFile.seek(_indexFile.size());
+}
+
+void ThumbnailCache::Reset()
+{
+	_records.clear();
+
+	if (!_indexFile.isOpen() || !_dataFile.isOpen())
+	{
+		return;
+	}
+
+	_dataFile.resize(0);
+	_indexFile.resize(0);
+	_indexFile.seek(0);
+
+	QDataStream stream{ &_indexFile };
+
+	stream << IndexFileMagic << IndexFileVersion;
+
+	_indexFile.flush();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QtTypes>
+
+/**
+*	@brief Stores thumbnails on disk so they don't have to be created again in later sessions.
+*	@details All thumbnails are packed into a single data file. A separate index file maps keys to locations in the data file.
+*	Both files are only ever appended to, so storing a thumbnail never rewrites existing data.
+*	When the data file grows larger than MaxDataSize the cache is cleared.
+*	All members are safe to use from any thread.
+*/
+class ThumbnailCache final
+{
+public:
+	static constexpr qint64 MaxDataSize = 256 * 1024 * 1024;
+
+	/**
+	*	@param directory Directory to store the cache files in. Created if it does not exist.
+	*/
+	explicit ThumbnailCache(const QString& directory);
+	~ThumbnailCache();
+
+	ThumbnailCache(const ThumbnailCache&) = delete;
+	ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+	/**
+	*	@brief Creates the key for a thumbnail.
+	*	@details The file's size and modification time are part of the key so thumbnails of modified files are not reused.
+	*/
+	static QByteArray MakeKey(const QString& fileName, const QString& entryName, int size, qint64 fileSize, qint64 modifiedTime);
+
+	/**
+	*	@brief Returns the thumbnail stored under the given key, or a null image if there is none.
+	*/
+	QImage Find(const QByteArray& key);
+
+	void Store(const QByteArray& key, const QImage& image);
+
+	void Clear();
+
+private:
+	struct Record
+	{
+		qint64 Offset{ 0 };
+		qint32 Length{ 0 };
+	};
+
+	void Load();
+
+	// Truncates both files and writes a new index header. Must be called with the mutex locked.
+	void Reset();
+
+private:
+	QMutex _mutex;
+
+	QFile _indexFile;
+	QFile _dataFile;
+
+	QHash<QByteArray, Record> _records;
+};
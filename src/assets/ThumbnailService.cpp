@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QThread>
+
+#include "assets/AssetLoaders.hpp"
+#include "assets/ThumbnailService.hpp"
+
+#include "utils/IOutils.hpp"
+
+static QString GetThumbnailCacheDirectory()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/thumbnails");
+}
+
+ThumbnailService::ThumbnailService(const AssetLoaders* assetLoaders, QObject* parent)
+	: QObject(parent)
+	, _assetLoaders(assetLoaders)
+	, _diskCache(GetThumbnailCacheDirectory())
+{
+	_threadPool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() - 1, 1, MaxWorkerCount));
+}
+
+ThumbnailService::~ThumbnailService()
+{
+	// Workers reference the loaders and this object, so they must be stopped first.
+	CancelAll();
+	_progress.Cancel();
+	_threadPool.waitForDone();
+}
+
+QString ThumbnailService::MakeKey(const QString& fileName, const QString& entryName, int size)
+{
+	return QStringLiteral("%1|%2|%3").arg(fileName, entryName).arg(size);
+}
+
+std::optional<QImage> ThumbnailService::Request(const QString& fileName, const QString& entryName, int size, ThumbnailPriority priority)
+{
+	const QString key = MakeKey(fileName, entryName, size);
+
+	if (const auto image = _memoryCache.object(key); image)
+	{
+		return *image;
+	}
+
+	std::lock_guard lock{ _queueMutex };
+
+	if (const auto it = _pendingJobs.constFind(key); it != _pendingJobs.constEnd())
+	{
+		auto& job = *it;
+
+		// Promote queued background requests that have become visible.
+		if (!job->Started && priority == ThumbnailPriority::Visible && job->Priority != ThumbnailPriority::Visible)
+		{
+			job->Priority = ThumbnailPriority::Visible;
+			_visibleJobs.push_back(job);
+		}
+
+		return {};
+	}
+
+	auto job = std::make_shared<Job>();
+
+	job->Key = key;
+	job->FileName = fileName;
+	job->EntryName = entryName;
+	job->Size = size;
+	job->Priority = priority;
+
+	(priority == ThumbnailPriority::Visible ? _visibleJobs : _backgroundJobs).push_back(job);
+
+	_pendingJobs.insert(key, job);
+
+	// Every worker takes whichever job has the highest priority when it starts, not necessarily this one.
+	_threadPool.start([this]
+		{
+			auto job = TakeNextJob();
+
+			if (!job)
+			{
+				return;
+			}
+
+			const QImage image = CreateThumbnail(*job);
+
+			QMetaObject::invokeMethod(this, [this, job, image]
+				{
+					OnJobFinished(job, image);
+				}, Qt::QueuedConnection);
+		});
+
+	return {};
+}
+
+void ThumbnailService::DemoteVisibleRequests()
+{
+	std::lock_guard lock{ _queueMutex };
+
+	for (auto& job : _visibleJobs)
+	{
+		if (!job->Started && job->Priority == ThumbnailPriority::Visible)
+		{
+			job->Priority = ThumbnailPriority::Background;
+			_backgroundJobs.push_back(job);
+		}
+	}
+
+	_visibleJobs.clear();
+}
+
+void ThumbnailService::CancelAll()
+{
+	std::lock_guard lock{ _queueMutex };
+
+	_visibleJobs.clear();
+	_backgroundJobs.clear();
+
+	// Jobs that have already started still finish and are cached.
+	for (auto it = _pendingJobs.begin(); it != _pendingJobs.end();)
+	{
+		if (!(*it)->Started)
+		{
+			it = _pendingJobs.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ThumbnailService::ClearCache()
+{
+	_memoryCache.clear();
+	_diskCache.Clear();
+}
+
+std::shared_ptr<ThumbnailService::Job> ThumbnailService::TakeNextJob()
+{
+	std::lock_guard lock{ _queueMutex };
+
+	// Visible jobs are taken most recent first since those are most likely to still be on screen.
+	while (!_visibleJobs.empty())
+	{
+		auto job = std::move(_visibleJobs.back());
+		_visibleJobs.pop_back();
+
+		if (!job->Started && job->Priority == ThumbnailPriority::Visible)
+		{
+			job->Started = true;
+			return job;
+		}
+	}
+
+	while (!_backgroundJobs.empty())
+	{
+		auto job = std::move(_backgroundJobs.front());
+		_backgroundJobs.pop_front();
+
+		if (!job->Started && job->Priority == ThumbnailPriority::Background)
+		{
+			job->Started = true;
+			return job;
+		}
+	}
+
+	return {};
+}
+
+QImage ThumbnailService::CreateThumbnail(const Job& job)
+{
+	const QFileInfo info{ job.FileName };
+
+	const QByteArray diskKey = ThumbnailCache::MakeKey(info.absoluteFilePath(), job.EntryName, job.Size,
+		info.size(), info.lastModified().toMSecsSinceEpoch());
+
+	if (auto image = _diskCache.Find(diskKey); !image.isNull())
+	{
+		return image;
+	}
+
+	FILE* file = OpenFileForReading(std::filesystem::path{ job.FileName.toStdU16String() });
+
+	if (!file)
+	{
+		return {};
+	}
+
+	QImage image;
+
+	if (auto assetLoader = _assetLoaders->Classify(file); assetLoader)
+	{
+		// Parsers throw on malformed files. A broken file should not take the application down with it.
+		try
+		{
+			image = assetLoader->CreateThumbnail(file, job.EntryName, job.Size, _progress);
+		}
+		catch (const std::exception&)
+		{
+			image = {};
+		}
+	}
+
+	fclose(file);
+
+	if (!image.isNull())
+	{
+		_diskCache.Store(diskKey, image);
+	}
+
+	return image;
+}
+
+void ThumbnailService::OnJobFinished(const std::shared_ptr<Job>& job, const QImage& image)
+{
+	if (const auto it = _pendingJobs.find(job->Key); it != _pendingJobs.end() && *it == job)
+	{
+		_pendingJobs.erase(it);
+	}
+
+	// Images without a thumbnail are cached too so they are not requested again.
+	_memoryCache.insert(job->Key, new QImage(image), std::max(1, static_cast<int>(image.sizeInBytes() / 1024)));
+
+	emit ThumbnailReady(job->Key, image);
+}
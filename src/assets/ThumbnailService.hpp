@@ -0,0 +1,125 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include "assets/ThumbnailCache.hpp"
+#include "utils/LoadProgress.hpp"
+
+class AssetLoaders;
+
+enum class ThumbnailPriority
+{
+	/**
+	*	@brief The thumbnail will be needed at some point, for example to prefetch items close to the visible area.
+	*/
+	Background = 0,
+
+	/**
+	*	@brief The thumbnail is on screen right now. Visible requests are handled before any background requests.
+	*/
+	Visible
+};
+
+/**
+*	@brief Creates thumbnails of assets on worker threads.
+*	@details Visible requests preempt queued background requests and are handled most recent first,
+*	so the items the user is currently looking at are handled first while scrolling.
+*	Duplicate requests are merged. Finished thumbnails are kept in memory and stored in a ThumbnailCache on disk.
+*	All members must be used on the GUI thread.
+*/
+class ThumbnailService final : public QObject
+{
+	Q_OBJECT
+
+public:
+	static constexpr int MaxWorkerCount = 4;
+
+	/**
+	*	@brief Upper limit on the memory used by thumbnails kept in memory, in KiB.
+	*/
+	static constexpr int MaxMemoryCacheCost = 64 * 1024;
+
+	explicit ThumbnailService(const AssetLoaders* assetLoaders, QObject* parent = nullptr);
+	~ThumbnailService();
+
+	/**
+	*	@brief Creates the key that identifies a thumbnail in ThumbnailReady.
+	*/
+	static QString MakeKey(const QString& fileName, const QString& entryName, int size);
+
+	/**
+	*	@brief Requests a thumbnail. Returns immediately.
+	*	@param entryName For files containing multiple assets, the name of the asset to create a thumbnail of.
+	*		If empty, a representative asset is used.
+	*	@param size The thumbnail will fit in a square of this size.
+	*	@return The thumbnail if it is already in memory, otherwise an empty optional and ThumbnailReady is emitted once it is available.
+	*		Files that have no thumbnail produce a null image.
+	*/
+	std::optional<QImage> Request(const QString& fileName, const QString& entryName, int size, ThumbnailPriority priority);
+
+	/**
+	*	@brief Turns all pending visible requests into background requests.
+	*	@details Views call this before requesting the thumbnails of the items that are visible after scrolling,
+	*	so items that scrolled out of view no longer delay the ones that are on screen.
+	*/
+	void DemoteVisibleRequests();
+
+	/**
+	*	@brief Drops all requests that have not been started yet.
+	*/
+	void CancelAll();
+
+	void ClearCache();
+
+signals:
+	void ThumbnailReady(const QString& key, const QImage& image);
+
+private:
+	struct Job
+	{
+		QString Key;
+		QString FileName;
+		QString EntryName;
+		int Size{ 0 };
+
+		// Accessed with the queue mutex locked.
+		ThumbnailPriority Priority{ ThumbnailPriority::Background };
+		bool Started{ false };
+	};
+
+	std::shared_ptr<Job> TakeNextJob();
+
+	QImage CreateThumbnail(const Job& job);
+
+	void OnJobFinished(const std::shared_ptr<Job>& job, const QImage& image);
+
+private:
+	const AssetLoaders* const _assetLoaders;
+
+	QThreadPool _threadPool;
+
+	// Used to cancel thumbnails that are being created when the service is destroyed.
+	LoadProgress _progress;
+
+	ThumbnailCache _diskCache;
+	QCache<QString, QImage> _memoryCache{ MaxMemoryCacheCost };
+
+	// Jobs are not removed from the queues when they are promoted, demoted or cancelled.
+	// Instead, workers skip jobs that have already been started or that are in the wrong queue.
+	std::mutex _queueMutex;
+	std::deque<std::shared_ptr<Job>> _visibleJobs;
+	std::deque<std::shared_ptr<Job>> _backgroundJobs;
+
+	// Jobs that have not finished yet, used to merge duplicate requests. Only used on the GUI thread.
+	QHash<QString, std::shared_ptr<Job>> _pendingJobs;
+};
@@ -1,13 +1,17 @@
-#include <cstddef>
-#include <cstring>
-#include <iterator>
+#include <memory>
+#include <string_view>
 
 #include "application/MultiAsset.hpp"
 #include "assets/IAssetLoader.hpp"
 #include "assetsystems/bsp/BspAssetSystem.hpp"
+#include "assetsystems/bsp/BspOverview.hpp"
 #include "assetsystems/bsp/ui/BspMainWindow.hpp"
+#include "formats/bsp/BspFile.hpp"
 
-constexpr int BspVersion = 30;
+using namespace std::literals;
+
+// The BSP format has no identifier, so the version number (30, little endian) is used instead.
+constexpr std::string_view BspVersionId = "\x1E\0\0\0"sv;
 
 class BspAssetLoader final : public IAssetLoader
 {
@@ -17,30 +21,51 @@ public:
 	{
 	}
 
-	int GetPriority() const override { return -100; }
-
 	QString GetName() const override { return QStringLiteral("Half-Life 1 Bsp"); }
 
 	QStringList GetFileTypes() const override { return { QStringLiteral("*.bsp") }; }
 
-	bool TryLoadFile(FILE* file) override
+	std::vector<AssetSignature> GetSignatures() const override { return { { 0, BspVersionId } }; }
+
+	std::optional<AssetMetadata> TryReadMetadata(FILE* file) const override
 	{
-		// TODO: should probably be handled in TryLoadBspFile
-		int version;
+		const auto info = TryReadBspInfo(file);
 
-		if (fread(&version, sizeof(int), 1, file) != 1)
+		if (!info)
 		{
-			return false;
+			return {};
 		}
 
-		if (version != BspVersion)
+		return AssetMetadata{ .TextureCount = info->TextureCount, .HasBounds = true, .Mins = info->Mins, .Maxs = info->Maxs };
+	}
+
+	QImage CreateThumbnail(FILE* file, const QString& entryName, int size, LoadProgress& progress) const override
+	{
+		// Faces are needed to draw the overview, so this has to load the whole map.
+		const auto bspFile = TryLoadBspFile(file, &progress);
+
+		if (!bspFile)
 		{
-			return false;
+			return {};
 		}
 
-		_assetSystem->GetWindow()->OpenFile(file);
+		return RenderBspOverview(*bspFile, size);
+	}
+
+	AssetLoadResult LoadFile(const QString& fileName, FILE* file, LoadProgress& progress) override
+	{
+		auto bspFile = TryLoadBspFile(file, &progress);
+
+		if (!bspFile)
+		{
+			return { AssetLoadStatus::Failed };
+		}
 
-		return true;
+		return { AssetLoadStatus::Loaded,
+			[assetSystem = _assetSystem, bspFile = std::make_shared<BspFile>(std::move(*bspFile))]
+			{
+				assetSystem->GetWindow()->OpenFile(std::move(*bspFile));
+			} };
 	}
 
 private:
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <QColor>
+#include <QPainter>
+#include <QPointF>
+#include <QPolygonF>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include "assetsystems/bsp/BspOverview.hpp"
+#include "formats/bsp/BspFile.hpp"
+
+// Faces whose normal points up at least this much count as floors.
+constexpr float MinimumFloorNormalZ = 0.7f;
+
+// Lowest floors are drawn at this brightness, the highest at full brightness.
+constexpr float MinimumBrightness = 0.5f;
+
+// Used for textures stored in external wads.
+const QColor DefaultFloorColor{ 160, 160, 160 };
+
+struct OverviewFace
+{
+	const Face* Source;
+	float Height;
+};
+
+static bool IsSkyTexture(const BspTexture* texture)
+{
+	using namespace std::literals;
+
+	constexpr auto SkyName = "sky"sv;
+
+	return texture && texture->Name.size() == SkyName.size()
+		&& std::equal(SkyName.begin(), SkyName.end(), texture->Name.begin(), [](char lhs, char rhs)
+			{
+				return lhs == std::tolower(static_cast<unsigned char>(rhs));
+			});
+}
+
+static QColor GetAverageColor(const BspTexture* texture)
+{
+	if (!texture || texture->Colormap.empty())
+	{
+		return DefaultFloorColor;
+	}
+
+	// The smallest mip level is representative enough.
+	const auto& pixels = texture->TextureDatas.back();
+
+	if (pixels.empty())
+	{
+		return DefaultFloorColor;
+	}
+
+	std::size_t red = 0;
+	std::size_t green = 0;
+	std::size_t blue = 0;
+
+	for (const auto index : pixels)
+	{
+		const auto& color = texture->Colormap[index];
+
+		red += color.R;
+		green += color.G;
+		blue += color.B;
+	}
+
+	return QColor(
+		static_cast<int>(red / pixels.size()),
+		static_cast<int>(green / pixels.size()),
+		static_cast<int>(blue / pixels.size()));
+}
+
+/**
+*	@brief Computes the face normal using Newell's method.
+*	Faces are wound clockwise when viewed from the front, so the result points away from the front.
+*/
+static glm::vec3 ComputeNewellNormal(std::span<const glm::vec3> vertexes)
+{
+	glm::vec3 normal{ 0 };
+
+	for (std::size_t i = 0; i < vertexes.size(); ++i)
+	{
+		const auto& current = vertexes[i];
+		const auto& next = vertexes[(i + 1) % vertexes.size()];
+
+		normal.x += (current.y - next.y) * (current.z + next.z);
+		normal.y += (current.z - next.z) * (current.x + next.x);
+		normal.z += (current.x - next.x) * (current.y + next.y);
+	}
+
+	const float length = glm::length(normal);
+
+	return length > 0 ? normal / length : normal;
+}
+
+QImage RenderBspOverview(const BspFile& bspFile, int size)
+{
+	if (size <= 0)
+	{
+		return {};
+	}
+
+	// Only the world is drawn, brush entities such as doors and triggers would cover it.
+	const std::span<const Face> faces = !bspFile.Models.empty() ? bspFile.Models.front().Faces : std::span<const Face>{ bspFile.Faces };
+
+	std::vector<OverviewFace> floors;
+
+	glm::vec3 mins{ std::numeric_limits<float>::max() };
+	glm::vec3 maxs{ std::numeric_limits<float>::lowest() };
+
+	for (const auto& face : faces)
+	{
+		if (face.Vertexes.size() < 3)
+		{
+			continue;
+		}
+
+		const BspTexture* texture = face.TextureInfo ? face.TextureInfo->Texture : nullptr;
+
+		if (IsSkyTexture(texture))
+		{
+			continue;
+		}
+
+		// The normal is reversed so floors have a negative Z.
+		if (ComputeNewellNormal(face.Vertexes).z > -MinimumFloorNormalZ)
+		{
+			continue;
+		}
+
+		float height = 0;
+
+		for (const auto& vertex : face.Vertexes)
+		{
+			mins = glm::min(mins, vertex);
+			maxs = glm::max(maxs, vertex);
+			height += vertex.z;
+		}
+
+		floors.push_back({ &face, height / face.Vertexes.size() });
+	}
+
+	if (floors.empty())
+	{
+		return {};
+	}
+
+	// Draw higher floors over lower ones.
+	std::sort(floors.begin(), floors.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.Height < rhs.Height;
+		});
+
+	const float width = std::max(maxs.x - mins.x, 1.f);
+	const float depth = std::max(maxs.y - mins.y, 1.f);
+	const float heightRange = std::max(maxs.z - mins.z, 1.f);
+	const float scale = size / std::max(width, depth);
+
+	QImage image{ std::max(1, static_cast<int>(width * scale)), std::max(1, static_cast<int>(depth * scale)),
+		QImage::Format_ARGB32_Premultiplied };
+
+	image.fill(Qt::transparent);
+
+	QPainter painter{ &image };
+
+	std::unordered_map<const BspTexture*, QColor> colors;
+
+	QPolygonF polygon;
+
+	for (const auto& floorFace : floors)
+	{
+		const BspTexture* texture = floorFace.Source->TextureInfo ? floorFace.Source->TextureInfo->Texture : nullptr;
+
+		auto it = colors.find(texture);
+
+		if (it == colors.end())
+		{
+			it = colors.emplace(texture, GetAverageColor(texture)).first;
+		}
+
+		const float brightness = MinimumBrightness + ((1 - MinimumBrightness) * (floorFace.Height - mins.z) / heightRange);
+
+		const QColor color = QColor::fromRgbF(
+			it->second.redF() * brightness,
+			it->second.greenF() * brightness,
+			it->second.blueF() * brightness);
+
+		polygon.clear();
+
+		// Image Y goes down, world Y goes up.
+		for (const auto& vertex : floorFace.Source->Vertexes)
+		{
+			polygon.append(QPointF{ (vertex.x - mins.x) * scale, (maxs.y - vertex.y) * scale });
+		}
+
+		// Outline with the same color to close the gaps between adjacent faces.
+		painter.setPen(color);
+		painter.setBrush(color);
+		painter.drawPolygon(polygon);
+	}
+
+	return image;
+}
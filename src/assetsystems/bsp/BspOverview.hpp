@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QImage>
+
+class BspFile;
+
+/**
+*	@brief Renders a top-down overview of a map's floors, for use as a thumbnail.
+*	@details Only upward facing world faces are drawn, from the lowest to the highest,
+*	colored using the average color of their texture and shaded by height. Sky faces are skipped.
+*	Can be called on any thread.
+*	@return The overview, fitting in a square of the given size, or a null image if the map has no floors.
+*/
+QImage RenderBspOverview(const BspFile& bspFile, int size);
@@ -1,3 +1,5 @@
+#include <QStatusBar>
+
 #include "ui_BspMainWindow.h"
 
 #include "application/MultiAsset.hpp"
@@ -7,6 +9,8 @@
 #include "assetsystems/bsp/ui/BspMainWindow.hpp"
 #include "assetsystems/bsp/ui/SceneWidget.hpp"
 
+#include "ui/MemoryUsageLabel.hpp"
+
 BspMainWindow::BspMainWindow(MultiAsset* multiAsset)
 	: _multiAsset(multiAsset)
 {
@@ -14,7 +18,7 @@ BspMainWindow::BspMainWindow(MultiAsset* multiAsset)
 
 	_ui->setupUi(this);
 
-	_sceneWidget = new SceneWidget(this);
+	_sceneWidget = new SceneWidget(_multiAsset->GetGpuResidencyManager(), _multiAsset->GetGpuTextureCache(), this);
 
 	_ui->HorizontalLayout->addWidget(_sceneWidget, 1);
 
@@ -24,31 +28,51 @@ BspMainWindow::BspMainWindow(MultiAsset* multiAsset)
 		{
 			emit _multiAsset->PromptOpenFile(this, "Half-Life 1 Bsp");
 		});
+
+	_memoryUsageLabel = new MemoryUsageLabel([this] { return GetMemoryUsage(); }, this);
+
+	statusBar()->addPermanentWidget(_memoryUsageLabel);
 }
 
 BspMainWindow::~BspMainWindow() = default;
 
-void BspMainWindow::OpenFile(FILE* file)
+void BspMainWindow::OpenFile(BspFile&& bspFile)
 {
-	auto bspFile = TryLoadBspFile(file);
+	_bspFile = std::make_shared<const BspFile>(std::move(bspFile));
 
-	if (!bspFile)
-	{
-		return;
-	}
+	const QString entities = QString::fromUtf8(_bspFile->Entities.data(), static_cast<qsizetype>(_bspFile->Entities.size()));
 
-	_bspFile = std::move(*bspFile);
+	_ui->Entities->setPlainText(entities);
 
-	_ui->Entities->setPlainText(QString::fromStdString(_bspFile.Entities));
+	_entityTextBytes = static_cast<std::size_t>(entities.size()) * sizeof(QChar);
 
 	_ui->Textures->clear();
 
-	for (const auto& texture : _bspFile.Textures)
+	for (const auto& texture : _bspFile->Textures)
 	{
-		_ui->Textures->addItem(QString::fromStdString(texture.Name));
+		_ui->Textures->addItem(QString::fromUtf8(texture.Name.data(), static_cast<qsizetype>(texture.Name.size())));
 	}
 
-	_sceneWidget->SetBspFile(&_bspFile);
+	_sceneWidget->SetBspFile(_bspFile);
+
+	_memoryUsageLabel->Update();
 
 	show();
 }
+
+MemoryUsage BspMainWindow::GetMemoryUsage() const
+{
+	auto usage = _sceneWidget->GetMemoryUsage();
+
+	if (_bspFile)
+	{
+		usage += ::GetMemoryUsage(*_bspFile);
+	}
+
+	if (_entityTextBytes > 0)
+	{
+		usage.AddHeap(MemoryCategory::EntityText, _entityTextBytes);
+	}
+
+	return usage;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -7,6 +8,7 @@
 
 #include "formats/bsp/BspFile.hpp"
 
+class MemoryUsageLabel;
 class MultiAsset;
 class SceneWidget;
 class Ui_BspMainWindow;
@@ -17,12 +19,22 @@ public:
 	explicit BspMainWindow(MultiAsset* multiAsset);
 	~BspMainWindow();
 
-	void OpenFile(FILE* file);
+	void OpenFile(BspFile&& bspFile);
+
+	/**
+	*	@brief Gets the memory used by the map, the entity text shown for it and the scene's buffers and textures.
+	*/
+	MemoryUsage GetMemoryUsage() const;
 
 private:
 	MultiAsset* const _multiAsset;
 	std::unique_ptr<Ui_BspMainWindow> _ui;
 	SceneWidget* _sceneWidget;
+	MemoryUsageLabel* _memoryUsageLabel;
+
+	// Shared with the scene's texture uploads, which may still read it after another map is opened.
+	std::shared_ptr<const BspFile> _bspFile;
 
-	BspFile _bspFile;
+	// The entity text is copied into the text box as UTF-16.
+	std::size_t _entityTextBytes{ 0 };
 };
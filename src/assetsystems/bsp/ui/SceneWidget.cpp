@@ -1,40 +1,88 @@
-#include <cassert>
+#include <algorithm>
+#include <cstddef>
+#include <span>
 #include <stdexcept>
 
 #include <QKeyEvent>
 #include <QMessageBox>
+#include <QPainter>
 #include <QWheelEvent>
 
 #include <glm/geometric.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "formats/DecodedTextureCache.hpp"
+#include "formats/Palette.hpp"
+
 #include "formats/bsp/BspFile.hpp"
 
 #include "assetsystems/bsp/ui/SceneWidget.hpp"
 
-SceneWidget::SceneWidget(QWidget* parent)
+// Faces are drawn as triangle fans, so their vertexes need no index buffer.
+struct FaceVertex
+{
+	glm::vec3 Position;
+	glm::vec2 TexCoord;
+};
+
+// Textures without data all share one placeholder.
+constexpr std::uint64_t MissingTextureKey = 0;
+
+static void DecodeMissingTexture(std::span<std::uint8_t> pixels)
+{
+	constexpr std::uint8_t Placeholder[]
+	{
+		0xFF, 0, 0xFF, 0xFF,
+		0, 0, 0, 0xFF,
+		0, 0, 0, 0xFF,
+		0xFF, 0, 0xFF, 0xFF
+	};
+
+	std::copy_n(Placeholder, std::min(std::size(Placeholder), pixels.size()), pixels.begin());
+}
+
+SceneWidget::SceneWidget(GpuResidencyManager* residencyManager, GpuTextureCache* textureCache, QWidget* parent)
 	: QOpenGLWidget(parent)
+	, _residencyManager(residencyManager)
+	, _textureCache(textureCache)
 {
 	setFocusPolicy(Qt::WheelFocus);
 
 	connect(this, &SceneWidget::frameSwapped, this, qOverload<>(&SceneWidget::update));
 
 	_lastUpdateTime = std::chrono::high_resolution_clock::now();
+	_statisticsStartTime = _lastUpdateTime;
 }
 
 SceneWidget::~SceneWidget()
 {
+	_residencyManager->RemoveWidget(this);
+
 	if (_vao)
 	{
+		makeCurrent();
 		DestroyBspObjects();
+		_textureUploader.reset();
 		glDeleteVertexArrays(1, &_vao);
+		doneCurrent();
 	}
 }
 
+void SceneWidget::SetBspFile(std::shared_ptr<const BspFile> bspFile)
+{
+	// Uploads of the previous map's textures keep going, the new map may use the same textures.
+	_currentBspFile = std::move(bspFile);
+	_createObjects = true;
+
+	_rotation = glm::vec2{ 0 };
+	_translation = glm::vec3{ 0 };
+}
+
 void SceneWidget::initializeGL()
 {
 	if (!initializeOpenGLFunctions())
@@ -44,6 +92,8 @@ void SceneWidget::initializeGL()
 
 	glGenVertexArrays(1, &_vao);
 	glBindVertexArray(_vao);
+
+	_textureUploader = std::make_unique<TextureUploader>(this, _residencyManager);
 }
 
 void SceneWidget::paintGL()
@@ -51,16 +101,22 @@ void SceneWidget::paintGL()
 	glClearColor(0.5f, 0.5f, 0.5f, 1.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	_residencyManager->BeginFrame(this);
+
 	if (_createObjects)
 	{
 		_createObjects = false;
 
-		assert(_currentBspFile);
-
 		DestroyBspObjects();
-		CreateBspObjects();
+
+		if (_currentBspFile)
+		{
+			CreateBspObjects();
+		}
 	}
 
+	_textureUploader->Update();
+
 	glViewport(0, 0, width(), height());
 	glMatrixMode(GL_PROJECTION);
 	glLoadMatrixf(glm::value_ptr(glm::perspective(90.f, (float)width() / height(), 1.f, (float)(1 << 16))));
@@ -101,6 +157,8 @@ void SceneWidget::paintGL()
 		_lastUpdateTime = now;
 	}
 
+	UpdateOverlay(now);
+
 	glm::mat4x4 modelMatrix = glm::identity<glm::mat4x4>();
 
 	modelMatrix = glm::translate(modelMatrix, -_translation);
@@ -119,6 +177,8 @@ void SceneWidget::paintGL()
 	{
 		DrawBspObjects();
 	}
+
+	DrawOverlay();
 }
 
 void SceneWidget::keyPressEvent(QKeyEvent* event)
@@ -191,121 +251,137 @@ void SceneWidget::CheckGLErrors(std::source_location location)
 
 void SceneWidget::CreateBspObjects()
 {
-	std::vector<std::uint16_t> indices;
-
-	for (auto& face : _currentBspFile->Faces)
+	for (std::size_t i = 0; i < _currentBspFile->Faces.size(); ++i)
 	{
-		FaceData data;
-
-		glGenBuffers(1, &data.Vbo);
-		glGenBuffers(1, &data.Ibo);
-
-		glBindBuffer(GL_ARRAY_BUFFER, data.Vbo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.Ibo);
-
-		indices.clear();
+		const auto& face = _currentBspFile->Faces[i];
 
-		for (std::uint16_t i = 0; const auto& vertex : face.Vertexes)
-		{
-			indices.push_back(i);
-			++i;
-		}
+		FaceData data;
 
-		glNamedBufferData(data.Vbo, sizeof(glm::vec3) * face.Vertexes.size(), face.Vertexes.data(), GL_STATIC_DRAW);
-		glNamedBufferData(data.Ibo, sizeof(std::uint16_t) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		data.Vbo = _residencyManager->Add(this, GpuResourceType::Buffer, sizeof(FaceVertex) * face.Vertexes.size(),
+			[this, i](GpuResourceId, GLuint buffer) { UploadVertexes(buffer, i); });
 
-		data.IndexCount = face.Vertexes.size();
+		data.VertexCount = face.Vertexes.size();
 
 		_faces.push_back(data);
 	}
 
 	CheckGLErrors();
 
-	_textures.resize(_currentBspFile->Textures.size());
-
-	std::vector<std::uint8_t> pixels;
+	_textureKeys.resize(_currentBspFile->Textures.size());
 
 	for (std::size_t i = 0; i < _currentBspFile->Textures.size(); ++i)
 	{
-		auto& textureId = _textures[i];
-		const auto texture = &_currentBspFile->Textures[i];
+		const auto& texture = _currentBspFile->Textures[i];
+		const auto& sourceData = texture.TextureDatas[0];
 
-		glGenTextures(1, &textureId);
+		if (sourceData.empty())
+		{
+			_textureKeys[i] = MissingTextureKey;
+			_textureCache->Retain(this, MissingTextureKey, 2, 2, &DecodeMissingTexture);
+			continue;
+		}
 
-		CheckGLErrors();
+		_textureKeys[i] = HashIndexedImage(texture.Width, texture.Height, sourceData, texture.Colormap);
+
+		// Decoded on the uploader's worker, possibly after this scene has moved on to another map.
+		_textureCache->Retain(this, _textureKeys[i], texture.Width, texture.Height,
+			[bspFile = _currentBspFile, i](std::span<std::uint8_t> pixels)
+			{
+				const auto& texture = bspFile->Textures[i];
+				DecodeIndexedImage(texture.TextureDatas[0], texture.Colormap, pixels);
+			});
+	}
+}
 
-		glBindTexture(GL_TEXTURE_2D, textureId);
+void SceneWidget::DestroyBspObjects()
+{
+	_residencyManager->RemoveAll(this);
+	_textureCache->ReleaseAll(this);
 
-		CheckGLErrors();
+	_textureKeys.clear();
+	_faces.clear();
+}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+void SceneWidget::UploadVertexes(GLuint buffer, std::size_t faceIndex)
+{
+	const auto& face = _currentBspFile->Faces[faceIndex];
+	const auto textureInfo = face.TextureInfo;
 
-		const auto& sourceData = texture->TextureDatas[0];
+	std::vector<FaceVertex> vertexes;
 
-		if (!sourceData.empty())
-		{
-			pixels.resize(sourceData.size() * 4);
+	vertexes.reserve(face.Vertexes.size());
 
-			for (std::size_t pixelIndex = 0; pixelIndex < sourceData.size(); ++pixelIndex)
-			{
-				const auto& color = texture->Colormap[sourceData[pixelIndex]];
+	for (const auto& vertex : face.Vertexes)
+	{
+		const float s = (glm::dot(vertex, textureInfo->Vertices[0]) + textureInfo->STCoordinates[0]) / textureInfo->Texture->Width;
+		const float t = (glm::dot(vertex, textureInfo->Vertices[1]) + textureInfo->STCoordinates[1]) / textureInfo->Texture->Height;
 
-				pixels[(pixelIndex * 4) + 0] = color.R;
-				pixels[(pixelIndex * 4) + 1] = color.G;
-				pixels[(pixelIndex * 4) + 2] = color.B;
-				pixels[(pixelIndex * 4) + 3] = 0xFF;
-			}
+		vertexes.push_back({ vertex, { s, t } });
+	}
 
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture->Width, texture->Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
-		}
-		else
-		{
-			pixels.resize(16);
+	// Binding the buffer creates it, which glNamedBufferData requires.
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glNamedBufferData(buffer, sizeof(FaceVertex) * vertexes.size(), vertexes.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-			pixels[0] = 0xFF;
-			pixels[1] = 0;
-			pixels[2] = 0xFF;
-			pixels[3] = 0xFF;
+void SceneWidget::UpdateOverlay(std::chrono::high_resolution_clock::time_point now)
+{
+	++_statisticsFrameCount;
+
+	const std::chrono::duration<double> elapsed = now - _statisticsStartTime;
 
-			pixels[4] = 0;
-			pixels[5] = 0;
-			pixels[6] = 0;
-			pixels[7] = 0xFF;
+	if (elapsed.count() < 0.5)
+	{
+		return;
+	}
 
-			pixels[8] = 0;
-			pixels[9] = 0;
-			pixels[10] = 0;
-			pixels[11] = 0xFF;
+	const std::uint64_t uploadedBytes = _textureUploader->GetUploadedBytes();
 
-			pixels[12] = 0xFF;
-			pixels[13] = 0;
-			pixels[14] = 0xFF;
-			pixels[15] = 0xFF;
+	constexpr double BytesPerMiB = 1024 * 1024;
 
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
-		}
+	_overlayText = QString{ "%1 ms/frame, uploading %2 MiB/s, %3 texture(s) pending" }
+		.arg((elapsed.count() * 1000) / _statisticsFrameCount, 0, 'f', 2)
+		.arg(((uploadedBytes - _statisticsUploadedBytes) / BytesPerMiB) / elapsed.count(), 0, 'f', 1)
+		.arg(_textureUploader->GetPendingCount());
 
-		CheckGLErrors();
-	}
+	_statisticsStartTime = now;
+	_statisticsFrameCount = 0;
+	_statisticsUploadedBytes = uploadedBytes;
 }
 
-void SceneWidget::DestroyBspObjects()
+void SceneWidget::DrawOverlay()
 {
-	for (auto& textureId : _textures)
+	if (_overlayText.isEmpty())
 	{
-		glDeleteTextures(1, &textureId);
+		return;
 	}
 
-	_textures.clear();
+	// QPainter resets the state it changes when it ends, and the scene sets up its own state every frame.
+	QPainter painter{ this };
+
+	painter.setPen(Qt::white);
+	painter.drawText(rect().adjusted(8, 8, -8, -8), Qt::AlignTop | Qt::AlignLeft, _overlayText);
+}
+
+MemoryUsage SceneWidget::GetMemoryUsage() const
+{
+	MemoryUsage usage;
 
-	for (auto& face : _faces)
+	usage.Add(MemoryCategory::Geometry, _faces);
+	usage.Add(MemoryCategory::Other, _textureKeys);
+
+	usage.AddGpu(MemoryCategory::Geometry, _residencyManager->GetResidentBytes(this, GpuResourceType::Buffer));
+
+	// Includes textures shared with other scenes.
+	usage.AddGpu(MemoryCategory::Textures, _textureCache->GetResidentBytes(this));
+
+	if (_textureUploader)
 	{
-		glDeleteBuffers(1, &face.Ibo);
-		glDeleteBuffers(1, &face.Vbo);
+		usage.AddGpu(MemoryCategory::Textures, _textureUploader->GetRingBufferSize());
 	}
 
-	_faces.clear();
+	return usage;
 }
 
 constexpr glm::vec3 Colors[]
@@ -328,6 +404,9 @@ void SceneWidget::DrawBspObjects()
 
 	glColor4f(1.f, 1.f, 1.f, 1.f);
 
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
 	auto& worldModel = _currentBspFile->Models[0];
 
 	for (std::size_t colorIndex = 0; const auto& face : worldModel.Faces)
@@ -342,25 +421,27 @@ void SceneWidget::DrawBspObjects()
 
 		const std::ptrdiff_t textureIndex = textureInfo->Texture - _currentBspFile->Textures.data();
 
-		glBindTexture(GL_TEXTURE_2D, _textures[textureIndex]);
+		// Uploads the texture again if it was evicted.
+		glBindTexture(GL_TEXTURE_2D, _textureCache->Acquire(_textureKeys[textureIndex], *_textureUploader));
 
 		CheckGLErrors();
 
-		glBegin(GL_TRIANGLE_FAN);
-		
-		for (const auto& vertex : face.Vertexes)
-		{
-			const float s = (glm::dot(vertex, textureInfo->Vertices[0]) + textureInfo->STCoordinates[0]) / textureInfo->Texture->Width;
-			const float t = (glm::dot(vertex, textureInfo->Vertices[1]) + textureInfo->STCoordinates[1]) / textureInfo->Texture->Height;
+		const auto& faceData = _faces[&face - _currentBspFile->Faces.data()];
 
-			glTexCoord2f(s, t);
-			glVertex3f(vertex.x, vertex.y, vertex.z);
-		}
+		// Uploads the vertexes again if they were evicted.
+		glBindBuffer(GL_ARRAY_BUFFER, _residencyManager->Acquire(faceData.Vbo));
+		glVertexPointer(3, GL_FLOAT, sizeof(FaceVertex), reinterpret_cast<const void*>(offsetof(FaceVertex, Position)));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(FaceVertex), reinterpret_cast<const void*>(offsetof(FaceVertex, TexCoord)));
 
-		glEnd();
+		glDrawArrays(GL_TRIANGLE_FAN, 0, faceData.VertexCount);
 
 		CheckGLErrors();
 
 		++colorIndex;
 	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
 }
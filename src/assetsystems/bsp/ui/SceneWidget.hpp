@@ -1,7 +1,9 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <source_location>
 #include <unordered_map>
 #include <vector>
@@ -9,33 +11,45 @@
 #include <qnamespace.h>
 #include <QOpenGLFunctions_4_5_Compatibility>
 #include <QOpenGLWidget>
+#include <QString>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include "ui/GpuResidencyManager.hpp"
+#include "ui/GpuTextureCache.hpp"
+#include "ui/TextureUploader.hpp"
+
+#include "utils/MemoryUsage.hpp"
+
 class BspFile;
 
 struct FaceData
 {
-	GLuint Vbo{ 0 };
-	GLuint Ibo{ 0 };
-	std::uint16_t IndexCount{ 0 };
+	GpuResourceId Vbo{ 0 };
+	std::uint16_t VertexCount{ 0 };
 };
 
 class SceneWidget final : public QOpenGLWidget, protected QOpenGLFunctions_4_5_Compatibility
 {
 public:
-	explicit SceneWidget(QWidget* parent = nullptr);
+	/**
+	*	@param residencyManager Creates the buffers and textures, which may be evicted while the widget isn't drawn.
+	*	@param textureCache Shares textures with other scenes, and with the previous map when switching maps.
+	*/
+	SceneWidget(GpuResidencyManager* residencyManager, GpuTextureCache* textureCache, QWidget* parent = nullptr);
 	~SceneWidget();
 
-	void SetBspFile(BspFile* bspFile)
-	{
-		_currentBspFile = bspFile;
-		_createObjects = true;
+	/**
+	*	@brief Sets the map to show. Textures that aren't cached yet are uploaded in the background over the next frames.
+	*	Uploads keep the map alive until they finish, so it must not be changed after it is set.
+	*/
+	void SetBspFile(std::shared_ptr<const BspFile> bspFile);
 
-		_rotation = glm::vec2{ 0 };
-		_translation = glm::vec3{ 0 };
-	}
+	/**
+	*	@brief Gets the memory used by resident buffers and textures, which only exist once the widget has been painted.
+	*/
+	MemoryUsage GetMemoryUsage() const;
 
 protected:
 	void initializeGL() override;
@@ -54,18 +68,29 @@ private:
 	void CreateBspObjects();
 	void DestroyBspObjects();
 
+	void UploadVertexes(GLuint buffer, std::size_t faceIndex);
+
+	void UpdateOverlay(std::chrono::high_resolution_clock::time_point now);
+	void DrawOverlay();
+
 	void DrawBspObjects();
 
 private:
+	GpuResidencyManager* const _residencyManager;
+	GpuTextureCache* const _textureCache;
+
 	GLuint _vao{ 0 };
 
+	std::unique_ptr<TextureUploader> _textureUploader;
+
 	bool _createObjects{ false };
 
-	BspFile* _currentBspFile{};
+	std::shared_ptr<const BspFile> _currentBspFile;
 
 	std::vector<FaceData> _faces;
 
-	std::vector<GLuint> _textures;
+	// Keys of the map's textures in the texture cache.
+	std::vector<std::uint64_t> _textureKeys;
 
 	glm::vec3 _translation{ 0 };
 	glm::vec2 _rotation{ 0 };
@@ -73,4 +98,10 @@ private:
 	std::unordered_map<Qt::Key, bool> _keysDown;
 
 	std::chrono::high_resolution_clock::time_point _lastUpdateTime;
+
+	// Frame time and upload bandwidth shown in the overlay are averaged over a short period.
+	std::chrono::high_resolution_clock::time_point _statisticsStartTime;
+	int _statisticsFrameCount{ 0 };
+	std::uint64_t _statisticsUploadedBytes{ 0 };
+	QString _overlayText;
 };
@@ -1,11 +1,17 @@
+#include <memory>
+#include <string_view>
+
 #include "application/MultiAsset.hpp"
 #include "assets/IAssetLoader.hpp"
 #include "assetsystems/sprite/SpriteAssetSystem.hpp"
 
 #include "assetsystems/sprite/ui/SpriteMainWindow.hpp"
+#include "formats/sprite/SpriteCompositor.hpp"
+#include "formats/sprite/SpriteFile.hpp"
+
+using namespace std::literals;
 
-constexpr std::size_t SpriteIdSize = 4;
-constexpr char SpriteId[] = "IDSP";
+constexpr std::string_view SpriteId = "IDSP"sv;
 
 class SpriteAssetLoader final : public IAssetLoader
 {
@@ -19,26 +25,52 @@ public:
 
 	QStringList GetFileTypes() const override { return { QStringLiteral("*.spr") }; }
 
-	bool TryLoadFile(FILE* file) override
+	std::vector<AssetSignature> GetSignatures() const override { return { { 0, SpriteId } }; }
+
+	std::optional<AssetMetadata> TryReadMetadata(FILE* file) const override
+	{
+		const auto info = TryReadSpriteInfo(file);
+
+		if (!info)
+		{
+			return {};
+		}
+
+		return AssetMetadata{ .Width = info->Width, .Height = info->Height, .FrameCount = info->FrameCount };
+	}
+
+	QImage CreateThumbnail(FILE* file, const QString& entryName, int size, LoadProgress& progress) const override
 	{
-		// TODO: should probably be handled in TryLoadSpriteFile
-		char id[SpriteIdSize + 1];
+		// Only the first frame is decoded.
+		const auto spriteFile = TryLoadSpriteFile(file, &progress, 1);
 
-		if (fread(id, SpriteIdSize, 1, file) != 1)
+		if (!spriteFile || spriteFile->Frames.empty())
 		{
-			return false;
+			return {};
 		}
 
-		id[std::size(id) - 1] = '\0';
+		// Show the frame the way the game renders it, over a transparent background.
+		const auto image = CompositeSpriteFrame(*spriteFile, spriteFile->Frames.front(), SpriteBackground{});
+
+		return FitThumbnail(SpriteMainWindow::CreateImage(image), size);
+	}
+
+	AssetLoadResult LoadFile(const QString& fileName, FILE* file, LoadProgress& progress) override
+	{
+		auto spriteFile = SpriteMainWindow::LoadFile(file, progress);
 
-		if (strncmp(id, SpriteId, SpriteIdSize) != 0)
+		if (!spriteFile)
 		{
-			return false;
+			return { AssetLoadStatus::Failed };
 		}
 
-		_assetSystem->GetWindow()->OpenFile(file);
+		spriteFile->FileName = fileName;
 
-		return true;
+		return { AssetLoadStatus::Loaded,
+			[assetSystem = _assetSystem, spriteFile = std::make_shared<UiSpriteFile>(std::move(*spriteFile))]
+			{
+				assetSystem->GetWindow()->OpenFile(std::move(*spriteFile));
+			} };
 	}
 
 private:
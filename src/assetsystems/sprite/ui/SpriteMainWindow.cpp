@@ -1,19 +1,29 @@
 #include <algorithm>
 #include <cmath>
 
+#include <QColorDialog>
+#include <QDoubleSpinBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QItemDelegate>
+#include <QMessageBox>
 #include <QPainter>
-#include <QTimeLine>
+#include <QStatusBar>
 
 #include "ui_SpriteMainWindow.h"
 
 #include "application/MultiAsset.hpp"
 
+#include "formats/sprite/SpriteCompositor.hpp"
 #include "formats/sprite/SpriteFile.hpp"
 
 #include "assetsystems/sprite/ui/SpriteMainWindow.hpp"
+#include "assetsystems/sprite/ui/SpritePreviewWidget.hpp"
 
-static constexpr int SpriteFrameRate = 10;
+#include "ui/MemoryUsageLabel.hpp"
+
+#include "utils/LoadProgress.hpp"
 
 class SpriteFrameItemDelegate : public QItemDelegate
 {
@@ -29,7 +39,7 @@ public:
 
 	void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override
 	{
-		const auto value = index.data(Qt::DecorationRole);
+		const auto value = index.data(Qt::UserRole);
 
 		if (!value.isValid())
 		{
@@ -52,11 +62,11 @@ public:
 
 		rect.adjust(Padding, Padding, -Padding, -Padding);
 
-		const std::size_t frameIndex = index.data(Qt::UserRole).value<std::size_t>();
+		const std::size_t frameIndex = value.value<std::size_t>();
 
 		const auto& frame = _window->GetSpriteFile()->Sprite.Frames[frameIndex];
 
-		painter->drawPixmap(rect.x(), rect.y(), frame.Width, frame.Height, _window->GetSpriteFile()->Pixmaps[frameIndex]);
+		painter->drawPixmap(rect.x(), rect.y(), frame.Width, frame.Height, _window->GetPixmap(frameIndex));
 
 		const QString text = index.data(Qt::DisplayRole).toString();
 
@@ -72,14 +82,14 @@ public:
 
 	QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override
 	{
-		const auto value = index.data(Qt::DecorationRole);
+		const auto value = index.data(Qt::UserRole);
 
 		if (!value.isValid())
 		{
 			return {};
 		}
 
-		const std::size_t frameIndex = index.data(Qt::UserRole).value<std::size_t>();
+		const std::size_t frameIndex = value.value<std::size_t>();
 
 		const auto& frame = _window->GetSpriteFile()->Sprite.Frames[frameIndex];
 
@@ -110,34 +120,85 @@ SpriteMainWindow::SpriteMainWindow(MultiAsset* multiAsset)
 
 	_ui->Frames->setItemDelegate(_itemDelegate);
 
-	_timeline = new QTimeLine(1, this);
-	_timeline->setLoopCount(0);
-	_timeline->setEasingCurve(QEasingCurve{ QEasingCurve::Linear });
-	_timeline->setUpdateInterval(static_cast<int>((1.f / SpriteFrameRate) * 1000)); // Matches default framerate.
+	_previewWidget = new SpritePreviewWidget(_multiAsset->GetGpuResidencyManager(), this);
+
+	_ui->PreviewBox->layout()->addWidget(_previewWidget);
+
+	_ui->FrameRate->setValue(_previewWidget->GetFrameRate());
 
 	connect(_ui->ActionOpen, &QAction::triggered, this, [this]
 		{
 			emit _multiAsset->PromptOpenFile(this, "Half-Life 1 Sprite");
 		});
 
-	connect(_timeline, &QTimeLine::frameChanged, this, &SpriteMainWindow::FrameChanged);
+	connect(_ui->FrameRate, &QDoubleSpinBox::valueChanged, this, [this](double value)
+		{
+			_previewWidget->SetFrameRate(static_cast<float>(value));
+		});
+
+	connect(_ui->ActionExportFrames, &QAction::triggered, this, &SpriteMainWindow::OnExportFrames);
+
+	_memoryUsageLabel = new MemoryUsageLabel([this] { return GetMemoryUsage(); }, this);
+
+	statusBar()->addPermanentWidget(_memoryUsageLabel);
 }
 
-SpriteMainWindow::~SpriteMainWindow() = default;
+SpriteMainWindow::~SpriteMainWindow()
+{
+	_multiAsset->GetPixmapCache()->RemoveAll(this);
+}
 
-void SpriteMainWindow::OpenFile(FILE* file)
+std::optional<UiSpriteFile> SpriteMainWindow::LoadFile(FILE* file, LoadProgress& progress)
 {
-	auto spriteFile = TryLoadSpriteFile(file);
+	auto spriteFile = TryLoadSpriteFile(file, &progress);
 
 	if (!spriteFile)
 	{
-		return;
+		return {};
 	}
 
-	_timeline->stop();
+	// Pixmaps are created when frames are painted.
+	UiSpriteFile uiSpriteFile;
+
+	uiSpriteFile.Sprite = std::move(*spriteFile);
+
+	return uiSpriteFile;
+}
+
+QImage SpriteMainWindow::CreateImage(const SpriteFile& sprite, const SingleSpriteFrame& frame)
+{
+	const auto argbTable = sprite.Colormap.GetArgbTable();
+
+	QList<QRgb> colorTable{ argbTable.begin(), argbTable.end() };
+
+	colorTable.resize(ColormapColorCount);
+
+	// Frame widths aren't necessarily a multiple of 4, so the stride has to be passed explicitly.
+	QImage image{ frame.Pixels.data(), (int)frame.Width, (int)frame.Height, (qsizetype)frame.Width, QImage::Format_Indexed8 };
+
+	image.setColorTable(colorTable);
+
+	// Converting copies the pixels, so the image no longer references the frame's pixels.
+	return image.convertToFormat(QImage::Format_RGB32);
+}
+
+QImage SpriteMainWindow::CreateImage(const SpriteImage& image)
+{
+	const QImage view{ reinterpret_cast<const uchar*>(image.Pixels.data()), image.Width, image.Height,
+		static_cast<qsizetype>(image.Width) * 4, QImage::Format_ARGB32_Premultiplied };
+
+	return view.copy();
+}
+
+void SpriteMainWindow::OpenFile(UiSpriteFile&& spriteFile)
+{
+	_previewWidget->SetSpriteFile(nullptr);
 	_ui->Frames->clear();
 
-	_spriteFile.Sprite = std::move(*spriteFile);
+	// Pixmaps of the previous file are no longer valid.
+	_multiAsset->GetPixmapCache()->RemoveAll(this);
+
+	_spriteFile = std::move(spriteFile);
 
 	_ui->TypeLabel->setText(QString::fromUtf8(SpriteTypeToString(_spriteFile.Sprite.Type)));
 	_ui->Formatlabel->setText(QString::fromUtf8(SpriteTextureFormatToString(_spriteFile.Sprite.TextureFormat)));
@@ -145,53 +206,105 @@ void SpriteMainWindow::OpenFile(FILE* file)
 	_ui->FrameCountLabel->setText(QString::number(_spriteFile.Sprite.Frames.size()));
 	_ui->BoundingLabel->setText(QString::number(static_cast<int>(std::floor(_spriteFile.Sprite.BoundingRadius))));
 
-	_spriteFile.Pixmaps.clear();
+	const auto& frames = _spriteFile.Sprite.Frames;
 
-	_spriteFile.Pixmaps.reserve(_spriteFile.Sprite.Frames.size());
+	const auto addItem = [&](std::size_t frameIndex, const QString& extraInfo)
+	{
+		const auto& frame = frames[frameIndex];
 
-	QList<QRgb> colorTable;
+		auto item = new QListWidgetItem(
+			QString{ "Frame index: %1\nDimensions: %2 x %3\nOrigin: %4, %5%6" }
+			.arg(frameIndex)
+			.arg(frame.Width)
+			.arg(frame.Height)
+			.arg(frame.Origin.x)
+			.arg(frame.Origin.y)
+			.arg(extraInfo));
 
-	colorTable.resize(ColormapColorCount);
+		item->setData(Qt::UserRole, QVariant::fromValue(frameIndex));
 
-	for (std::size_t i = 0; i < _spriteFile.Sprite.Colormap.size(); ++i)
+		_ui->Frames->addItem(item);
+	};
+
+	for (std::size_t descriptorIndex = 0; const auto& descriptor : _spriteFile.Sprite.FrameDescriptors)
 	{
-		colorTable[i] = qRgb(_spriteFile.Sprite.Colormap[i].R, _spriteFile.Sprite.Colormap[i].G, _spriteFile.Sprite.Colormap[i].B);
+		if (descriptor.Type == SpriteFrameType::SINGLE)
+		{
+			addItem(descriptor.Index, {});
+		}
+		else
+		{
+			const auto& group = _spriteFile.Sprite.Groups[descriptor.Index];
+
+			for (std::size_t i = 0; i < group.GetFrameCount(); ++i)
+			{
+				addItem(group.FirstFrame + i, QString{ "\nGroup %1, ends at %2s" }.arg(descriptorIndex).arg(group.Intervals[i]));
+			}
+		}
+
+		++descriptorIndex;
 	}
 
-	for (const auto& frame : _spriteFile.Sprite.Frames)
-	{
-		QImage image{ frame.Pixels.data(), (int)frame.Width, (int)frame.Height, QImage::Format_Indexed8 };
+	_previewWidget->SetSpriteFile(&_spriteFile.Sprite);
 
-		image.setColorTable(colorTable);
+	_ui->ActionExportFrames->setEnabled(!frames.empty());
 
-		_spriteFile.Pixmaps.push_back(QPixmap::fromImage(image));
+	_memoryUsageLabel->Update();
 
-		auto item = new QListWidgetItem(QIcon{ _spriteFile.Pixmaps.back()},
-			QString{ "Frame index: %1\nDimensions: %2 x %3\nOrigin: %4, %5" }
-			.arg(_spriteFile.Pixmaps.size() - 1)
-			.arg(frame.Width)
-			.arg(frame.Height)
-			.arg(frame.Origin.x)
-			.arg(frame.Origin.y));
+	show();
+}
 
-		item->setData(Qt::UserRole, QVariant::fromValue(_spriteFile.Pixmaps.size() - 1));
+QPixmap SpriteMainWindow::GetPixmap(std::size_t frameIndex) const
+{
+	return _multiAsset->GetPixmapCache()->Get({ this, frameIndex }, [&, this]
+		{
+			return CreateImage(_spriteFile.Sprite, _spriteFile.Sprite.Frames[frameIndex]);
+		});
+}
 
-		_ui->Frames->addItem(item);
+MemoryUsage SpriteMainWindow::GetMemoryUsage() const
+{
+	auto usage = ::GetMemoryUsage(_spriteFile.Sprite);
+
+	usage += _previewWidget->GetMemoryUsage();
+
+	const auto pixmapCache = _multiAsset->GetPixmapCache();
+
+	usage.AddHeap(MemoryCategory::Pixmaps, static_cast<std::size_t>(pixmapCache->GetResidentBytes(this)), pixmapCache->GetCount(this));
+
+	return usage;
+}
+
+void SpriteMainWindow::OnExportFrames()
+{
+	const QColor color = QColorDialog::getColor(Qt::transparent, this, "Background Color", QColorDialog::ShowAlphaChannel);
+
+	if (!color.isValid())
+	{
+		return;
 	}
 
-	if (!_spriteFile.Pixmaps.empty())
+	const QString directory = QFileDialog::getExistingDirectory(this, "Export Frames", QFileInfo{ _spriteFile.FileName }.absolutePath());
+
+	if (directory.isEmpty())
 	{
-		_timeline->setFrameRange(0, static_cast<int>(_spriteFile.Pixmaps.size() - 1));
-		_timeline->setDuration(static_cast<int>(_spriteFile.Pixmaps.size() * 1000) / SpriteFrameRate);
-		// This won't be called for the first frame so we have to do it manually.
-		FrameChanged(0);
-		_timeline->start();
+		return;
 	}
 
-	show();
-}
+	// Frames are composited on all cores, saving happens here since PNG encoding is the cheap part for small frames.
+	const auto images = CompositeSpriteFrames(_spriteFile.Sprite, SpriteBackground{ .Color = qPremultiply(color.rgba()) });
 
-void SpriteMainWindow::FrameChanged(int frame)
-{
-	_ui->PreviewLabel->setPixmap(_spriteFile.Pixmaps[frame]);
+	const QString baseName = QFileInfo{ _spriteFile.FileName }.completeBaseName();
+	const QDir outputDirectory{ directory };
+
+	for (std::size_t i = 0; i < images.size(); ++i)
+	{
+		const QString fileName = outputDirectory.filePath(QString{ "%1_%2.png" }.arg(baseName).arg(i, 3, 10, QChar{ '0' }));
+
+		if (!CreateImage(images[i]).save(fileName, "PNG"))
+		{
+			QMessageBox::critical(this, "Export Frames", QString{ "Couldn't save \"%1\"" }.arg(fileName));
+			return;
+		}
+	}
 }
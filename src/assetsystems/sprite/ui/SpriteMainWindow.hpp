@@ -1,24 +1,31 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
 #include <memory>
+#include <optional>
 #include <vector>
 
+#include <QImage>
 #include <QMainWindow>
 #include <QPixmap>
+#include <QString>
 
+#include "formats/sprite/SpriteCompositor.hpp"
 #include "formats/sprite/SpriteFile.hpp"
 
+class LoadProgress;
+class MemoryUsageLabel;
 class MultiAsset;
-class QTimeLine;
 class SpriteFrameItemDelegate;
+class SpritePreviewWidget;
 class Ui_SpriteMainWindow;
 
 class UiSpriteFile
 {
 public:
+	QString FileName;
 	SpriteFile Sprite;
-
-	std::vector<QPixmap> Pixmaps;
 };
 
 class SpriteMainWindow final : public QMainWindow
@@ -29,17 +36,43 @@ public:
 
 	const UiSpriteFile* GetSpriteFile() const { return &_spriteFile; }
 
-	void OpenFile(FILE* file);
+	/**
+	*	@brief Loads and prepares a sprite file for display. Can be called on any thread.
+	*/
+	static std::optional<UiSpriteFile> LoadFile(FILE* file, LoadProgress& progress);
+
+	/**
+	*	@brief Converts a frame to an image that does not reference the frame's pixels. Can be called on any thread.
+	*/
+	static QImage CreateImage(const SpriteFile& sprite, const SingleSpriteFrame& frame);
+
+	/**
+	*	@brief Converts a composited frame to an image that does not reference the frame's pixels. Can be called on any thread.
+	*/
+	static QImage CreateImage(const SpriteImage& image);
+
+	void OpenFile(UiSpriteFile&& spriteFile);
+
+	/**
+	*	@brief Gets the pixmap for the given frame, creating it if it is not in the pixmap cache.
+	*/
+	QPixmap GetPixmap(std::size_t frameIndex) const;
+
+	/**
+	*	@brief Gets the memory used by the sprite, its resident pixmaps and the preview's atlas.
+	*/
+	MemoryUsage GetMemoryUsage() const;
 
 private slots:
-	void FrameChanged(int frame);
+	void OnExportFrames();
 
 private:
 	MultiAsset* _multiAsset;
 	std::unique_ptr<Ui_SpriteMainWindow> _ui;
 	SpriteFrameItemDelegate* _itemDelegate;
 
-	QTimeLine* _timeline;
+	SpritePreviewWidget* _previewWidget;
+	MemoryUsageLabel* _memoryUsageLabel;
 
 	UiSpriteFile _spriteFile;
 };
@@ -0,0 +1,505 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+#include <glm/geometric.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "formats/sprite/SpriteFile.hpp"
+
+#include "assetsystems/sprite/ui/SpritePreviewWidget.hpp"
+
+// Transparent border around each frame so filtering never samples a neighbouring frame.
+constexpr int AtlasPadding = 1;
+
+/**
+*	@brief Places frames in rows, tallest first so rows waste little space.
+*	@return The size of the atlas, or nothing if the frames don't fit in a texture of @p maxSize.
+*/
+static std::optional<glm::ivec2> PackFrames(std::span<const SingleSpriteFrame> frames, int maxSize, std::vector<glm::ivec2>& positions)
+{
+	positions.resize(frames.size());
+
+	std::vector<std::size_t> order(frames.size());
+
+	std::iota(order.begin(), order.end(), std::size_t{ 0 });
+
+	std::stable_sort(order.begin(), order.end(), [&](auto lhs, auto rhs)
+		{
+			return frames[lhs].Height > frames[rhs].Height;
+		});
+
+	std::size_t area = 0;
+	int widestFrame = 1;
+
+	for (const auto& frame : frames)
+	{
+		area += static_cast<std::size_t>(frame.Width + AtlasPadding) * (frame.Height + AtlasPadding);
+		widestFrame = std::max(widestFrame, frame.Width + AtlasPadding);
+	}
+
+	int width = 1;
+
+	while (width < widestFrame || (static_cast<std::size_t>(width) * width) < area)
+	{
+		width *= 2;
+	}
+
+	// Start with a square atlas, widen it if the rows end up too tall.
+	for (; width <= maxSize; width *= 2)
+	{
+		int x = 0;
+		int y = 0;
+		int rowHeight = 0;
+
+		for (const auto index : order)
+		{
+			const auto& frame = frames[index];
+
+			if ((x + frame.Width + AtlasPadding) > width)
+			{
+				x = 0;
+				y += rowHeight;
+				rowHeight = 0;
+			}
+
+			positions[index] = glm::ivec2{ x, y };
+
+			x += frame.Width + AtlasPadding;
+			rowHeight = std::max(rowHeight, frame.Height + AtlasPadding);
+		}
+
+		if ((y + rowHeight) <= maxSize)
+		{
+			return glm::ivec2{ width, std::max(y + rowHeight, 1) };
+		}
+	}
+
+	return {};
+}
+
+/**
+*	@brief Creates the color each palette index is drawn with, matching how the engine uploads sprites.
+*/
+static std::array<std::array<std::uint8_t, 4>, ColormapColorCount> CreateColorTable(const SpriteFile& sprite)
+{
+	std::array<std::array<std::uint8_t, 4>, ColormapColorCount> colors{};
+
+	for (std::size_t i = 0; i < ColormapColorCount; ++i)
+	{
+		const auto& color = sprite.Colormap[i];
+
+		switch (sprite.TextureFormat)
+		{
+		// The color is that of the last palette entry, the index is the alpha.
+		case SpriteTextureFormat::INDEXALPHA:
+		{
+			const auto& lastColor = sprite.Colormap[ColormapColorCount - 1];
+			colors[i] = { lastColor.R, lastColor.G, lastColor.B, static_cast<std::uint8_t>(i) };
+			break;
+		}
+
+		// The last palette entry is transparent.
+		case SpriteTextureFormat::ALPHTEST:
+		{
+			if (i == (ColormapColorCount - 1))
+			{
+				colors[i] = { 0, 0, 0, 0 };
+			}
+			else
+			{
+				colors[i] = { color.R, color.G, color.B, 0xFF };
+			}
+			break;
+		}
+
+		default:
+		{
+			colors[i] = { color.R, color.G, color.B, 0xFF };
+			break;
+		}
+		}
+	}
+
+	return colors;
+}
+
+SpritePreviewWidget::SpritePreviewWidget(GpuResidencyManager* residencyManager, QWidget* parent)
+	: QOpenGLWidget(parent)
+	, _residencyManager(residencyManager)
+{
+	setFocusPolicy(Qt::WheelFocus);
+
+	// Redraw as soon as the previous frame has been shown, so animation runs at the monitor's refresh rate.
+	connect(this, &SpritePreviewWidget::frameSwapped, this, qOverload<>(&SpritePreviewWidget::update));
+
+	_startTime = std::chrono::steady_clock::now();
+}
+
+SpritePreviewWidget::~SpritePreviewWidget()
+{
+	_residencyManager->RemoveWidget(this);
+
+	if (isValid())
+	{
+		makeCurrent();
+		DestroyAtlas();
+		doneCurrent();
+	}
+}
+
+void SpritePreviewWidget::SetSpriteFile(const SpriteFile* spriteFile)
+{
+	_spriteFile = spriteFile;
+	_createAtlas = true;
+
+	_scheduler = spriteFile ? SpriteAnimationScheduler{ *spriteFile, _frameRate } : SpriteAnimationScheduler{};
+	_phase = _scheduler.GetPhase(0);
+	_startTime = std::chrono::steady_clock::now();
+
+	_cameraAngles = glm::vec2{ 15, 180 };
+	_cameraDistance = spriteFile ? std::max(32.f, static_cast<float>(std::max(spriteFile->Width, spriteFile->Height))) : 128.f;
+
+	update();
+}
+
+void SpritePreviewWidget::SetFrameRate(float frameRate)
+{
+	_frameRate = frameRate;
+
+	if (_spriteFile)
+	{
+		_scheduler = SpriteAnimationScheduler{ *_spriteFile, _frameRate };
+	}
+}
+
+void SpritePreviewWidget::initializeGL()
+{
+	if (!initializeOpenGLFunctions())
+	{
+		throw std::runtime_error("Couldn't initialize OpenGL functions");
+	}
+}
+
+void SpritePreviewWidget::paintGL()
+{
+	glClearColor(0.25f, 0.25f, 0.25f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	_residencyManager->BeginFrame(this);
+
+	if (_createAtlas)
+	{
+		_createAtlas = false;
+
+		DestroyAtlas();
+
+		if (_spriteFile)
+		{
+			CreateAtlas();
+		}
+	}
+
+	glViewport(0, 0, width(), height());
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixf(glm::value_ptr(glm::perspective(glm::radians(90.f), (float)width() / std::max(height(), 1), 1.f, (float)(1 << 16))));
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixf(glm::value_ptr(glm::lookAt(
+		[this]
+		{
+			const float pitch = glm::radians(_cameraAngles.x);
+			const float yaw = glm::radians(_cameraAngles.y);
+
+			return glm::vec3{ std::cos(pitch) * std::cos(yaw), std::cos(pitch) * std::sin(yaw), std::sin(pitch) } * _cameraDistance;
+		}(),
+		glm::vec3{ 0 }, glm::vec3{ 0, 0, 1 })));
+
+	DrawGrid();
+
+	if (_atlas != 0 && !_frames.empty())
+	{
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _startTime;
+
+		DrawSprite(_scheduler.GetFrame(elapsed.count(), _phase));
+	}
+}
+
+void SpritePreviewWidget::mousePressEvent(QMouseEvent* event)
+{
+	_lastMousePosition = event->position().toPoint();
+}
+
+void SpritePreviewWidget::mouseMoveEvent(QMouseEvent* event)
+{
+	if ((event->buttons() & Qt::LeftButton) == 0)
+	{
+		return;
+	}
+
+	const QPoint position = event->position().toPoint();
+	const QPoint delta = position - _lastMousePosition;
+
+	_lastMousePosition = position;
+
+	constexpr float DegreesPerPixel = 0.5f;
+
+	_cameraAngles.x = std::clamp(_cameraAngles.x + (delta.y() * DegreesPerPixel), -89.f, 89.f);
+	_cameraAngles.y = std::fmod(_cameraAngles.y - (delta.x() * DegreesPerPixel), 360.f);
+}
+
+void SpritePreviewWidget::wheelEvent(QWheelEvent* event)
+{
+	if (const QPoint degrees = event->angleDelta() / 8; !degrees.isNull())
+	{
+		_cameraDistance = std::clamp(_cameraDistance * std::pow(0.9f, degrees.y() / 15.f), 8.f, 8192.f);
+	}
+}
+
+void SpritePreviewWidget::CheckGLErrors(std::source_location location)
+{
+	const GLenum error = glGetError();
+
+	if (error == GL_NO_ERROR)
+	{
+		return;
+	}
+
+	QMessageBox::critical(this, "OpenGL Error", QString{ "OpenGL error %1 (0X%2)" }.arg(error).arg(error, 0, 16));
+}
+
+void SpritePreviewWidget::CreateAtlas()
+{
+	const auto& frames = _spriteFile->Frames;
+
+	if (frames.empty())
+	{
+		return;
+	}
+
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+	const auto atlasSize = PackFrames(frames, maxSize, _atlasPositions);
+
+	if (!atlasSize)
+	{
+		QMessageBox::warning(this, "Sprite Preview", "This sprite's frames don't fit in a single texture and can't be previewed.");
+		return;
+	}
+
+	_atlasSize = *atlasSize;
+
+	_frames.resize(frames.size());
+
+	_floorHeight = 0;
+
+	for (std::size_t i = 0; i < frames.size(); ++i)
+	{
+		const auto& frame = frames[i];
+		const auto position = _atlasPositions[i];
+
+		_frames[i].Min = glm::vec2{ position } / glm::vec2{ _atlasSize };
+		_frames[i].Max = glm::vec2{ position + glm::ivec2{ frame.Width, frame.Height } } / glm::vec2{ _atlasSize };
+
+		_floorHeight = std::min(_floorHeight, static_cast<float>(frame.Origin.y - frame.Height));
+	}
+
+	_atlas = _residencyManager->Add(this, GpuResourceType::Texture, static_cast<std::size_t>(_atlasSize.x) * _atlasSize.y * 4,
+		[this](GpuResourceId, GLuint textureId) { UploadAtlas(textureId); });
+}
+
+void SpritePreviewWidget::UploadAtlas(GLuint textureId)
+{
+	// Only runs when the atlas is created or brought back after eviction, never while animating.
+	const auto colors = CreateColorTable(*_spriteFile);
+
+	std::vector<std::uint8_t> pixels(static_cast<std::size_t>(_atlasSize.x) * _atlasSize.y * 4, 0);
+
+	for (std::size_t i = 0; i < _spriteFile->Frames.size(); ++i)
+	{
+		const auto& frame = _spriteFile->Frames[i];
+		const auto position = _atlasPositions[i];
+
+		for (int y = 0; y < frame.Height; ++y)
+		{
+			const std::uint8_t* source = frame.Pixels.data() + (static_cast<std::size_t>(y) * frame.Width);
+			std::uint8_t* dest = pixels.data() + (((static_cast<std::size_t>(position.y + y) * _atlasSize.x) + position.x) * 4);
+
+			for (int x = 0; x < frame.Width; ++x, dest += 4)
+			{
+				std::copy_n(colors[source[x]].data(), 4, dest);
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, textureId);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _atlasSize.x, _atlasSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	CheckGLErrors();
+}
+
+MemoryUsage SpritePreviewWidget::GetMemoryUsage() const
+{
+	MemoryUsage usage;
+
+	usage.Add(MemoryCategory::Other, _frames);
+	usage.Add(MemoryCategory::Other, _atlasPositions);
+	usage.AddGpu(MemoryCategory::Textures, _residencyManager->GetResidentBytes(this, GpuResourceType::Texture));
+
+	return usage;
+}
+
+void SpritePreviewWidget::DestroyAtlas()
+{
+	if (_atlas != 0)
+	{
+		_residencyManager->Remove(_atlas);
+		_atlas = 0;
+	}
+
+	_atlasPositions.clear();
+	_frames.clear();
+}
+
+void SpritePreviewWidget::DrawGrid()
+{
+	constexpr int GridSize = 256;
+	constexpr int GridSpacing = 16;
+
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+	glDisable(GL_ALPHA_TEST);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+
+	glColor4f(0.4f, 0.4f, 0.4f, 1.f);
+
+	glBegin(GL_LINES);
+
+	for (int i = -GridSize; i <= GridSize; i += GridSpacing)
+	{
+		glVertex3f(static_cast<float>(i), -GridSize, _floorHeight);
+		glVertex3f(static_cast<float>(i), GridSize, _floorHeight);
+		glVertex3f(-GridSize, static_cast<float>(i), _floorHeight);
+		glVertex3f(GridSize, static_cast<float>(i), _floorHeight);
+	}
+
+	glEnd();
+}
+
+void SpritePreviewWidget::DrawSprite(std::size_t frameIndex)
+{
+	const auto& frame = _spriteFile->Frames[frameIndex];
+	const auto& atlasFrame = _frames[frameIndex];
+
+	// Get the camera axes from the modelview matrix, the same vectors the engine uses for billboards.
+	glm::mat4x4 view;
+	glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(view));
+
+	const glm::vec3 viewRight{ view[0][0], view[1][0], view[2][0] };
+	const glm::vec3 viewUp{ view[0][1], view[1][1], view[2][1] };
+	const glm::vec3 viewForward{ -view[0][2], -view[1][2], -view[2][2] };
+
+	glm::vec3 up{ 0, 0, 1 };
+	glm::vec3 right;
+
+	switch (_spriteFile->Type)
+	{
+	case SpriteType::VP_PARALLEL_UPRIGHT:
+	case SpriteType::FACING_UPRIGHT:
+		// Both rotate around the Z axis only. The camera always looks at the sprite here, so facing the camera position
+		// and facing the view direction are the same.
+		right = glm::normalize(glm::vec3{ viewForward.y, -viewForward.x, 0 });
+		break;
+
+	case SpriteType::ORIENTED:
+		// Uses the entity's angles, which are 0 in the preview.
+		right = glm::vec3{ 0, -1, 0 };
+		break;
+
+	// VP_PARALLEL_ORIENTED rolls the parallel axes by the entity's roll, which is 0 in the preview.
+	default:
+		up = viewUp;
+		right = viewRight;
+		break;
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, _residencyManager->Acquire(_atlas));
+
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+
+	switch (_spriteFile->TextureFormat)
+	{
+	case SpriteTextureFormat::ADDITIVE:
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		glDepthMask(GL_FALSE);
+		break;
+
+	case SpriteTextureFormat::INDEXALPHA:
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+		break;
+
+	case SpriteTextureFormat::ALPHTEST:
+		glEnable(GL_ALPHA_TEST);
+		glAlphaFunc(GL_GREATER, 0.5f);
+		break;
+
+	default: break;
+	}
+
+	const float top = static_cast<float>(frame.Origin.y);
+	const float bottom = static_cast<float>(frame.Origin.y - frame.Height);
+	const float left = static_cast<float>(frame.Origin.x);
+	const float rightEdge = static_cast<float>(frame.Origin.x + frame.Width);
+
+	glColor4f(1.f, 1.f, 1.f, 1.f);
+
+	glBegin(GL_QUADS);
+
+	const auto vertex = [&](float s, float t, float height, float width)
+	{
+		const glm::vec3 point = (up * height) + (right * width);
+
+		glTexCoord2f(s, t);
+		glVertex3f(point.x, point.y, point.z);
+	};
+
+	vertex(atlasFrame.Min.x, atlasFrame.Max.y, bottom, left);
+	vertex(atlasFrame.Min.x, atlasFrame.Min.y, top, left);
+	vertex(atlasFrame.Max.x, atlasFrame.Min.y, top, rightEdge);
+	vertex(atlasFrame.Max.x, atlasFrame.Max.y, bottom, rightEdge);
+
+	glEnd();
+
+	glDisable(GL_BLEND);
+	glDisable(GL_ALPHA_TEST);
+	glDepthMask(GL_TRUE);
+
+	CheckGLErrors();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <source_location>
+#include <vector>
+
+#include <QOpenGLFunctions_4_5_Compatibility>
+#include <QOpenGLWidget>
+#include <QPoint>
+
+#include <glm/vec2.hpp>
+
+#include "formats/sprite/SpriteAnimationScheduler.hpp"
+
+#include "ui/GpuResidencyManager.hpp"
+
+#include "utils/MemoryUsage.hpp"
+
+class SpriteFile;
+
+/**
+*	@brief Location of a frame in the sprite atlas, in texture coordinates.
+*/
+struct SpriteAtlasFrame
+{
+	glm::vec2 Min{ 0 };
+	glm::vec2 Max{ 0 };
+};
+
+/**
+*	@brief Previews an animated sprite in 3D the way the engine draws it.
+*	@details All frames are packed into a single atlas texture that is uploaded once, and again only if it was evicted,
+*	so animating only changes texture coordinates. The widget redraws after every buffer swap,
+*	so animation runs at the monitor's refresh rate while frames advance as scheduled by SpriteAnimationScheduler.
+*	The sprite's texture format selects the blend mode and its type selects how the billboard faces the camera.
+*	Drag to orbit the camera around the sprite, scroll to zoom.
+*/
+class SpritePreviewWidget final : public QOpenGLWidget, protected QOpenGLFunctions_4_5_Compatibility
+{
+public:
+	/**
+	*	@param residencyManager Creates the atlas, which may be evicted while the widget isn't drawn.
+	*/
+	explicit SpritePreviewWidget(GpuResidencyManager* residencyManager, QWidget* parent = nullptr);
+	~SpritePreviewWidget();
+
+	/**
+	*	@brief Sets the sprite to show. The sprite must remain valid until another sprite is set.
+	*/
+	void SetSpriteFile(const SpriteFile* spriteFile);
+
+	float GetFrameRate() const { return _frameRate; }
+
+	void SetFrameRate(float frameRate);
+
+	/**
+	*	@brief Gets the memory used by the atlas while it is resident, which is once the widget has been painted.
+	*/
+	MemoryUsage GetMemoryUsage() const;
+
+protected:
+	void initializeGL() override;
+	void paintGL() override;
+
+	void mousePressEvent(QMouseEvent* event) override;
+	void mouseMoveEvent(QMouseEvent* event) override;
+	void wheelEvent(QWheelEvent* event) override;
+
+private:
+	void CheckGLErrors(std::source_location location = std::source_location::current());
+
+	void CreateAtlas();
+	void DestroyAtlas();
+
+	void UploadAtlas(GLuint textureId);
+
+	void DrawGrid();
+	void DrawSprite(std::size_t frameIndex);
+
+private:
+	GpuResidencyManager* const _residencyManager;
+
+	const SpriteFile* _spriteFile{};
+	bool _createAtlas{ false };
+
+	GpuResourceId _atlas{ 0 };
+	glm::ivec2 _atlasSize{ 0 };
+
+	// Position of each frame in the atlas, in pixels.
+	std::vector<glm::ivec2> _atlasPositions;
+	std::vector<SpriteAtlasFrame> _frames;
+
+	// Height of the lowest frame's bottom edge, where the grid is drawn.
+	float _floorHeight{ 0 };
+
+	float _frameRate{ SpriteAnimationScheduler::DefaultFrameRate };
+	SpriteAnimationScheduler _scheduler;
+	double _phase{ 0 };
+	std::chrono::steady_clock::time_point _startTime;
+
+	// Camera orbits around the sprite's origin. Pitch and yaw in degrees.
+	glm::vec2 _cameraAngles{ 15, 180 };
+	float _cameraDistance{ 128 };
+
+	QPoint _lastMousePosition;
+};
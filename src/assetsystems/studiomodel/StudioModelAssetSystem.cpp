@@ -1,13 +1,16 @@
-#include <cstddef>
-#include <cstring>
-#include <iterator>
+#include <memory>
+#include <string_view>
 
 #include "application/MultiAsset.hpp"
 #include "assets/IAssetLoader.hpp"
 #include "assetsystems/studiomodel/StudioModelAssetSystem.hpp"
 
-constexpr std::size_t StudioModelIdSize = 4;
-constexpr char StudioModelId[] = "IDST";
+#include "assetsystems/studiomodel/ui/StudioModelMainWindow.hpp"
+#include "formats/studiomodel/StudioModelFile.hpp"
+
+using namespace std::literals;
+
+constexpr std::string_view StudioModelId = "IDST"sv;
 
 class StudioModelAssetLoader final : public IAssetLoader
 {
@@ -21,23 +24,36 @@ public:
 
 	QStringList GetFileTypes() const override { return { QStringLiteral("*.mdl") }; }
 
-	bool TryLoadFile(FILE* file) override
+	std::vector<AssetSignature> GetSignatures() const override { return { { 0, StudioModelId } }; }
+
+	std::optional<AssetMetadata> TryReadMetadata(FILE* file) const override
 	{
-		char id[StudioModelIdSize + 1];
+		const auto info = TryReadStudioModelInfo(file);
 
-		if (fread(id, StudioModelIdSize, 1, file) != 1)
+		if (!info)
 		{
-			return false;
+			return {};
 		}
 
-		id[std::size(id) - 1] = '\0';
+		return AssetMetadata{ .TextureCount = info->TextureCount,
+			.HasBounds = true, .Mins = info->BBMin, .Maxs = info->BBMax };
+	}
+
+	AssetLoadResult LoadFile(const QString& fileName, FILE* file, LoadProgress& progress) override
+	{
+		// The model is mapped rather than read through the file.
+		auto modelFile = StudioModelMainWindow::LoadFile(fileName);
 
-		if (strncmp(id, StudioModelId, StudioModelIdSize) != 0)
+		if (!modelFile)
 		{
-			return false;
+			return { AssetLoadStatus::Failed };
 		}
 
-		return true;
+		return { AssetLoadStatus::Loaded,
+			[assetSystem = _assetSystem, modelFile = std::make_shared<UiStudioModelFile>(std::move(*modelFile))]
+			{
+				assetSystem->GetWindow()->OpenFile(std::move(*modelFile));
+			} };
 	}
 
 private:
@@ -46,5 +62,16 @@ private:
 
 void StudioModelAssetSystem::Initialize(MultiAsset* multiAsset)
 {
+	_multiAsset = multiAsset;
 	multiAsset->GetAssetLoaders()->Add(std::make_unique<StudioModelAssetLoader>(this));
 }
+
+StudioModelMainWindow* StudioModelAssetSystem::GetWindow()
+{
+	if (!_window)
+	{
+		_window = new StudioModelMainWindow(_multiAsset);
+	}
+
+	return _window;
+}
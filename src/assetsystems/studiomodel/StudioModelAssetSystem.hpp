@@ -2,8 +2,17 @@
 
 #include "assets/AssetSystem.hpp"
 
+class MultiAsset;
+class StudioModelMainWindow;
+
 class StudioModelAssetSystem final : public AssetSystem
 {
 public:
 	void Initialize(MultiAsset* multiAsset) override;
+
+	StudioModelMainWindow* GetWindow();
+
+private:
+	MultiAsset* _multiAsset{};
+	StudioModelMainWindow* _window{};
 };
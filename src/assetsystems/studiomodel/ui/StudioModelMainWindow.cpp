@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include <QStatusBar>
+#include <QTreeWidgetItem>
+
+#include "ui_StudioModelMainWindow.h"
+
+#include "application/MultiAsset.hpp"
+
+#include "assetsystems/studiomodel/ui/StudioModelMainWindow.hpp"
+
+#include "ui/MemoryUsageLabel.hpp"
+
+/**
+*	@brief Names in the file are fixed size and not necessarily null terminated.
+*/
+template<std::size_t Size>
+static QString NameToString(const char (&name)[Size])
+{
+	return QString::fromUtf8(name, static_cast<qsizetype>(std::find(name, name + Size, '\0') - name));
+}
+
+StudioModelMainWindow::StudioModelMainWindow(MultiAsset* multiAsset)
+	: _multiAsset(multiAsset)
+{
+	_ui = std::make_unique<Ui_StudioModelMainWindow>();
+
+	_ui->setupUi(this);
+
+	connect(_ui->ActionOpen, &QAction::triggered, this, [this]
+		{
+			emit _multiAsset->PromptOpenFile(this, "Half-Life 1 StudioModel");
+		});
+
+	_memoryUsageLabel = new MemoryUsageLabel([this] { return GetMemoryUsage(); }, this);
+
+	statusBar()->addPermanentWidget(_memoryUsageLabel);
+}
+
+StudioModelMainWindow::~StudioModelMainWindow() = default;
+
+std::optional<UiStudioModelFile> StudioModelMainWindow::LoadFile(const QString& fileName)
+{
+	auto model = StudioModelFile::TryOpen(std::filesystem::path{ fileName.toStdU16String() });
+
+	if (!model)
+	{
+		return {};
+	}
+
+	return UiStudioModelFile{ fileName, std::move(*model) };
+}
+
+void StudioModelMainWindow::OpenFile(UiStudioModelFile&& modelFile)
+{
+	_ui->Contents->clear();
+
+	_modelFile = std::move(modelFile);
+
+	const auto& model = _modelFile->Model;
+
+	setWindowTitle(QString{ "StudioModel Viewer - %1" }.arg(_modelFile->FileName));
+
+	const auto addSection = [this](const QString& name, std::size_t count)
+	{
+		return new QTreeWidgetItem(_ui->Contents, { name, QString::number(count) });
+	};
+
+	const auto bones = addSection("Bones", model.GetBones().size());
+
+	for (const auto& bone : model.GetBones())
+	{
+		new QTreeWidgetItem(bones, { NameToString(bone.Name),
+			bone.Parent != -1 ? QString{ "Parent: %1" }.arg(NameToString(model.GetBones()[bone.Parent].Name)) : QString{} });
+	}
+
+	const auto sequences = addSection("Sequences", model.GetSequences().size());
+
+	for (const auto& sequence : model.GetSequences())
+	{
+		new QTreeWidgetItem(sequences, { NameToString(sequence.Label),
+			QString{ "%1 frames at %2 fps, group %3" }.arg(sequence.FrameCount).arg(sequence.Fps).arg(sequence.SequenceGroup) });
+	}
+
+	const auto bodyParts = addSection("Body parts", model.GetBodyParts().size());
+
+	for (const auto& bodyPart : model.GetBodyParts())
+	{
+		const auto bodyPartItem = new QTreeWidgetItem(bodyParts, { NameToString(bodyPart.Name),
+			QString{ "%1 models" }.arg(bodyPart.ModelCount) });
+
+		for (const auto& subModel : model.GetModels(bodyPart))
+		{
+			const auto modelItem = new QTreeWidgetItem(bodyPartItem, { NameToString(subModel.Name),
+				QString{ "%1 vertices, %2 normals" }.arg(subModel.VertexCount).arg(subModel.NormalCount) });
+
+			for (int i = 0; const auto& mesh : model.GetMeshes(subModel))
+			{
+				new QTreeWidgetItem(modelItem, { QString{ "Mesh %1" }.arg(i++),
+					QString{ "%1 triangles, skin reference %2" }.arg(mesh.TriangleCount).arg(mesh.SkinReference) });
+			}
+		}
+	}
+
+	// Opens the texture file if the model has one.
+	if (const auto textureSet = model.GetTextureSet(); textureSet)
+	{
+		const auto textures = addSection("Textures", textureSet->GetTextures().size());
+
+		for (const auto& texture : textureSet->GetTextures())
+		{
+			new QTreeWidgetItem(textures, { NameToString(texture.Name), QString{ "%1x%2" }.arg(texture.Width).arg(texture.Height) });
+		}
+	}
+	else
+	{
+		new QTreeWidgetItem(_ui->Contents, { "Textures",
+			QString{ "Couldn't load \"%1\"" }.arg(QString::fromStdU16String(GetStudioTextureFilePath(model.GetPath()).filename().u16string())) });
+	}
+
+	_ui->Contents->resizeColumnToContents(0);
+
+	_memoryUsageLabel->Update();
+
+	show();
+}
+
+MemoryUsage StudioModelMainWindow::GetMemoryUsage() const
+{
+	return _modelFile ? ::GetMemoryUsage(_modelFile->Model) : MemoryUsage{};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <QMainWindow>
+#include <QString>
+
+#include "formats/studiomodel/StudioModelFile.hpp"
+
+class MemoryUsageLabel;
+class MultiAsset;
+class Ui_StudioModelMainWindow;
+
+class UiStudioModelFile
+{
+public:
+	QString FileName;
+	StudioModelFile Model;
+};
+
+class StudioModelMainWindow final : public QMainWindow
+{
+public:
+	explicit StudioModelMainWindow(MultiAsset* multiAsset);
+	~StudioModelMainWindow();
+
+	/**
+	*	@brief Opens a model for display. Can be called on any thread.
+	*	@details Only the model file itself is mapped, texture and sequence group files are opened when they are first used.
+	*/
+	static std::optional<UiStudioModelFile> LoadFile(const QString& fileName);
+
+	void OpenFile(UiStudioModelFile&& modelFile);
+
+	MemoryUsage GetMemoryUsage() const;
+
+private:
+	MultiAsset* _multiAsset;
+	std::unique_ptr<Ui_StudioModelMainWindow> _ui;
+
+	MemoryUsageLabel* _memoryUsageLabel;
+
+	std::optional<UiStudioModelFile> _modelFile;
+};
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#include "assetsystems/wad/TextureNameIndex.hpp"
+
+constexpr std::size_t TrigramSize = 3;
+
+// Specifiers are a single character followed by the frame or tile index.
+constexpr std::size_t SpecifierSize = 2;
+
+static std::uint32_t MakeTrigram(std::string_view text)
+{
+	return (static_cast<std::uint32_t>(static_cast<unsigned char>(text[0])) << 16)
+		| (static_cast<std::uint32_t>(static_cast<unsigned char>(text[1])) << 8)
+		| static_cast<std::uint32_t>(static_cast<unsigned char>(text[2]));
+}
+
+static bool IsSpecifierCharacter(char c)
+{
+	switch (c)
+	{
+	case '+':
+	case '-':
+	case '{':
+	case '!':
+	case '~': return true;
+	default: return false;
+	}
+}
+
+bool HasTextureSpecifiers(std::string_view name)
+{
+	return name.size() >= SpecifierSize && (name[0] == '+' || name[0] == '-');
+}
+
+std::string_view SkipTextureSpecifiers(std::string_view name)
+{
+	if (HasTextureSpecifiers(name))
+	{
+		name.remove_prefix(SpecifierSize);
+	}
+
+	return name;
+}
+
+std::string FoldTextureName(std::string_view name)
+{
+	std::string folded{ name };
+
+	std::transform(folded.begin(), folded.end(), folded.begin(), [](char c)
+		{
+			return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		});
+
+	return folded;
+}
+
+bool CompareFoldedTextureNames(std::string_view lhs, std::string_view rhs)
+{
+	// If the base names are the same then we want to sort according to specifiers.
+	if (const int result = SkipTextureSpecifiers(lhs).compare(SkipTextureSpecifiers(rhs)); result != 0)
+	{
+		return result < 0;
+	}
+
+	return lhs < rhs;
+}
+
+TextureNameIndex::TextureNameIndex(std::vector<std::string> foldedNames)
+	: _names(std::move(foldedNames))
+{
+	for (std::uint32_t i = 0; i < _names.size(); ++i)
+	{
+		const std::string_view name = _names[i];
+
+		for (std::size_t offset = 0; (offset + TrigramSize) <= name.size(); ++offset)
+		{
+			auto& names = _trigrams[MakeTrigram(name.substr(offset))];
+
+			// Names are visited in order so duplicates can only be at the end.
+			if (names.empty() || names.back() != i)
+			{
+				names.push_back(i);
+			}
+		}
+	}
+
+	_prefixOrder.resize(_names.size());
+
+	for (std::uint32_t i = 0; i < _names.size(); ++i)
+	{
+		_prefixOrder[i] = i;
+	}
+
+	std::sort(_prefixOrder.begin(), _prefixOrder.end(), [this](auto lhs, auto rhs)
+		{
+			return _names[lhs] < _names[rhs];
+		});
+}
+
+bool TextureNameIndex::IsPrefixQuery(std::string_view foldedQuery)
+{
+	return !foldedQuery.empty() && IsSpecifierCharacter(foldedQuery.front());
+}
+
+bool TextureNameIndex::Narrows(std::string_view query, std::string_view previousQuery)
+{
+	if (IsPrefixQuery(previousQuery))
+	{
+		return query.starts_with(previousQuery);
+	}
+
+	return query.find(previousQuery) != std::string_view::npos;
+}
+
+std::vector<std::uint32_t> TextureNameIndex::Find(std::string_view foldedQuery) const
+{
+	std::vector<std::uint32_t> result;
+
+	if (IsPrefixQuery(foldedQuery))
+	{
+		const auto begin = std::lower_bound(_prefixOrder.begin(), _prefixOrder.end(), foldedQuery, [this](auto index, auto query)
+			{
+				return _names[index] < query;
+			});
+
+		const auto end = std::find_if(begin, _prefixOrder.end(), [&, this](auto index)
+			{
+				return !std::string_view{ _names[index] }.starts_with(foldedQuery);
+			});
+
+		result.assign(begin, end);
+		std::sort(result.begin(), result.end());
+
+		return result;
+	}
+
+	if (foldedQuery.size() < TrigramSize)
+	{
+		// Short queries match too many names for an index to help.
+		for (std::uint32_t i = 0; i < _names.size(); ++i)
+		{
+			if (Matches(i, foldedQuery, false))
+			{
+				result.push_back(i);
+			}
+		}
+
+		return result;
+	}
+
+	// Start with the rarest trigram and intersect with the others.
+	std::vector<const std::vector<std::uint32_t>*> postings;
+
+	for (std::size_t offset = 0; (offset + TrigramSize) <= foldedQuery.size(); ++offset)
+	{
+		const auto it = _trigrams.find(MakeTrigram(foldedQuery.substr(offset)));
+
+		if (it == _trigrams.end())
+		{
+			return result;
+		}
+
+		postings.push_back(&it->second);
+	}
+
+	std::sort(postings.begin(), postings.end(), [](const auto lhs, const auto rhs)
+		{
+			return lhs->size() < rhs->size();
+		});
+
+	result = *postings.front();
+
+	std::vector<std::uint32_t> intersection;
+
+	for (std::size_t i = 1; i < postings.size() && !result.empty(); ++i)
+	{
+		intersection.clear();
+		std::set_intersection(result.begin(), result.end(), postings[i]->begin(), postings[i]->end(), std::back_inserter(intersection));
+		result.swap(intersection);
+	}
+
+	// Names containing all trigrams don't necessarily contain them in the right order.
+	if (postings.size() > 1)
+	{
+		std::erase_if(result, [&, this](auto index)
+			{
+				return !Matches(index, foldedQuery, false);
+			});
+	}
+
+	return result;
+}
+
+std::vector<std::uint32_t> TextureNameIndex::Find(std::string_view foldedQuery, const std::vector<std::uint32_t>& candidates) const
+{
+	const bool isPrefixQuery = IsPrefixQuery(foldedQuery);
+
+	std::vector<std::uint32_t> result;
+
+	std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(result), [&, this](auto index)
+		{
+			return Matches(index, foldedQuery, isPrefixQuery);
+		});
+
+	return result;
+}
+
+bool TextureNameIndex::Matches(std::uint32_t index, std::string_view foldedQuery, bool isPrefixQuery) const
+{
+	const std::string_view name = _names[index];
+
+	return isPrefixQuery ? name.starts_with(foldedQuery) : name.find(foldedQuery) != std::string_view::npos;
+}
+
+MemoryUsage TextureNameIndex::GetMemoryUsage() const
+{
+	MemoryUsage usage;
+
+	usage.Add(MemoryCategory::Other, _names);
+
+	for (const auto& name : _names)
+	{
+		usage.Add(MemoryCategory::Other, name);
+	}
+
+	usage.Add(MemoryCategory::Other, _trigrams);
+
+	for (const auto& [trigram, nameIndices] : _trigrams)
+	{
+		usage.Add(MemoryCategory::Other, nameIndices);
+	}
+
+	usage.Add(MemoryCategory::Other, _prefixOrder);
+
+	return usage;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/MemoryUsage.hpp"
+
+/**
+*	@brief Returns whether the name starts with an animation or random tiling specifier such as @c +0 or @c -1.
+*/
+bool HasTextureSpecifiers(std::string_view name);
+
+/**
+*	@brief Returns the name without its animation or random tiling specifier.
+*/
+std::string_view SkipTextureSpecifiers(std::string_view name);
+
+/**
+*	@brief Folds a texture name for case insensitive comparisons.
+*/
+std::string FoldTextureName(std::string_view name);
+
+/**
+*	@brief Returns whether @p lhs is listed before @p rhs.
+*	@details Textures are sorted by name without specifiers so animation frames and random tiles are listed
+*	next to the texture they belong to, and then by the specifiers themselves.
+*	Both names must have been folded with FoldTextureName.
+*/
+bool CompareFoldedTextureNames(std::string_view lhs, std::string_view rhs);
+
+/**
+*	@brief Search index over a list of texture names.
+*	@details Substring queries are answered using a trigram index.
+*	Queries that start with a texture specifier character (@c + @c - @c { @c ! @c ~) only match names starting with the query,
+*	since those characters only have meaning at the start of a name. For example @c +0 finds the first frame of every animation
+*	and @c { finds every transparent texture.
+*	The index is immutable once built and can be used from any thread.
+*/
+class TextureNameIndex final
+{
+public:
+	TextureNameIndex() = default;
+
+	/**
+	*	@param foldedNames Names folded with FoldTextureName. Results refer to names by their position in this list.
+	*/
+	explicit TextureNameIndex(std::vector<std::string> foldedNames);
+
+	std::size_t GetNameCount() const { return _names.size(); }
+
+	const std::string& GetName(std::uint32_t index) const { return _names[index]; }
+
+	/**
+	*	@brief Returns whether the query only matches names starting with it.
+	*/
+	static bool IsPrefixQuery(std::string_view foldedQuery);
+
+	/**
+	*	@brief Returns whether every name matching @p query also matches @p previousQuery,
+	*	in which case the results of @p previousQuery can be narrowed down instead of searching the whole index.
+	*	Both queries must have been folded.
+	*/
+	static bool Narrows(std::string_view query, std::string_view previousQuery);
+
+	/**
+	*	@brief Finds all names matching the query.
+	*	@param foldedQuery Query folded with FoldTextureName. An empty query matches all names.
+	*	@return Indices of matching names in ascending order.
+	*/
+	std::vector<std::uint32_t> Find(std::string_view foldedQuery) const;
+
+	/**
+	*	@brief Finds all names in @p candidates that match the query.
+	*	@param candidates Indices in ascending order, usually the result of a query that this query narrows.
+	*/
+	std::vector<std::uint32_t> Find(std::string_view foldedQuery, const std::vector<std::uint32_t>& candidates) const;
+
+	bool Matches(std::uint32_t index, std::string_view foldedQuery) const
+	{
+		return Matches(index, foldedQuery, IsPrefixQuery(foldedQuery));
+	}
+
+	MemoryUsage GetMemoryUsage() const;
+
+private:
+	bool Matches(std::uint32_t index, std::string_view foldedQuery, bool isPrefixQuery) const;
+
+private:
+	std::vector<std::string> _names;
+
+	// Maps each trigram to the names containing it, in ascending order.
+	std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> _trigrams;
+
+	// Name indices sorted by folded name, for prefix queries.
+	std::vector<std::uint32_t> _prefixOrder;
+};
@@ -1,15 +1,18 @@
-#include <cstddef>
-#include <cstring>
-#include <iterator>
+#include <algorithm>
+#include <memory>
+#include <string_view>
 
 #include "application/MultiAsset.hpp"
 #include "assets/IAssetLoader.hpp"
 #include "assetsystems/wad/WadAssetSystem.hpp"
 #include "assetsystems/wad/ui/WadMainWindow.hpp"
+#include "formats/wad/WadFile.hpp"
 
-constexpr std::size_t WadIdSize = 4;
-constexpr char Wad2Id[] = "WAD2";
-constexpr char Wad3Id[] = "WAD3";
+using namespace std::literals;
+
+// TODO: should this support WAD2? Engine assumes wads are WAD3, probably to support old wads that use the wrong id.
+constexpr std::string_view Wad2Id = "WAD2"sv;
+constexpr std::string_view Wad3Id = "WAD3"sv;
 
 class WadAssetLoader final : public IAssetLoader
 {
@@ -23,27 +26,53 @@ public:
 
 	QStringList GetFileTypes() const override { return { QStringLiteral("*.wad") }; }
 
-	bool TryLoadFile(FILE* file) override
+	std::vector<AssetSignature> GetSignatures() const override { return { { 0, Wad2Id }, { 0, Wad3Id } }; }
+
+	std::optional<AssetMetadata> TryReadMetadata(FILE* file) const override
 	{
-		// TODO: should probably be handled in TryLoadWadFile
-		char id[WadIdSize + 1];
+		const auto info = TryReadWadInfo(file);
 
-		if (fread(id, WadIdSize, 1, file) != 1)
+		if (!info)
 		{
-			return false;
+			return {};
 		}
 
-		id[std::size(id) - 1] = '\0';
+		return AssetMetadata{ .TextureCount = info->TextureCount };
+	}
 
-		// TODO: should this support WAD2? Engine assumes wads are WAD3, probably to support old wads that use the wrong id.
-		if (strncmp(id, Wad2Id, WadIdSize) != 0 && strncmp(id, Wad3Id, WadIdSize) != 0)
+	QImage CreateThumbnail(FILE* file, const QString& entryName, int size, LoadProgress& progress) const override
+	{
+		// Only the requested texture is read.
+		const auto entry = TryLoadWadTexture(file, entryName.toStdString());
+
+		if (!entry || entry->Width == 0 || entry->Height == 0)
 		{
-			return false;
+			return {};
 		}
 
-		_assetSystem->GetWindow()->OpenFile(file);
+		// Start from the smallest mip level that is still at least as large as the thumbnail.
+		const float scale = std::min(1.f, static_cast<float>(size) / std::max(entry->Width, entry->Height));
+
+		const std::size_t mipLevel = entry->SelectMipLevel(
+			static_cast<unsigned int>(entry->Width * scale), static_cast<unsigned int>(entry->Height * scale));
+
+		return FitThumbnail(WadMainWindow::CreateImage(*entry, mipLevel), size);
+	}
+
+	AssetLoadResult LoadFile(const QString& fileName, FILE* file, LoadProgress& progress) override
+	{
+		auto wadFile = WadMainWindow::LoadFile(file, progress);
+
+		if (!wadFile)
+		{
+			return { AssetLoadStatus::Failed };
+		}
 
-		return true;
+		return { AssetLoadStatus::Loaded,
+			[assetSystem = _assetSystem, fileName, wadFile = std::make_shared<UiWadFile>(std::move(*wadFile))]
+			{
+				assetSystem->GetWindow()->OpenFile(fileName, std::move(*wadFile));
+			} };
 	}
 
 private:
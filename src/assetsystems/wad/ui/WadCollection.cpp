@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <iterator>
+
+#include <QFileInfo>
+
+#include "assetsystems/wad/ui/WadCollection.hpp"
+
+static std::vector<QString> GetNames(const UiWadFile& file)
+{
+	std::vector<QString> names;
+
+	names.reserve(file.Entries.size());
+
+	for (const auto& entry : file.Entries)
+	{
+		names.push_back(QString::fromStdString(entry.Entry.Name));
+	}
+
+	return names;
+}
+
+static bool HasIdenticalContents(const WadEntry& lhs, const WadEntry& rhs)
+{
+	return lhs.Type == rhs.Type
+		&& lhs.Width == rhs.Width
+		&& lhs.Height == rhs.Height
+		&& lhs.Pixels == rhs.Pixels
+		// Palettes are interned, so identical palettes are the same palette.
+		&& lhs.Colormap == rhs.Colormap;
+}
+
+static void AddMemoryUsage(MemoryUsage& usage, const QString& string)
+{
+	// Qt strings don't store short strings inline, only null strings have no buffer.
+	if (!string.isNull())
+	{
+		usage.AddHeap(MemoryCategory::Other, (static_cast<std::size_t>(string.capacity()) + 1) * sizeof(QChar));
+	}
+}
+
+MemoryUsage UiWadFile::GetMemoryUsage() const
+{
+	MemoryUsage usage;
+
+	usage.Add(MemoryCategory::Other, Entries);
+
+	for (const auto& entry : Entries)
+	{
+		usage += ::GetMemoryUsage(entry.Entry);
+	}
+
+	usage += NameIndex.GetMemoryUsage();
+
+	return usage;
+}
+
+int WadCollection::FindWad(const QString& fileName) const
+{
+	const auto it = std::find_if(_wads.begin(), _wads.end(), [&](const auto& wad)
+		{
+			return wad->FileName == fileName;
+		});
+
+	return it != _wads.end() ? static_cast<int>(it - _wads.begin()) : -1;
+}
+
+std::size_t WadCollection::Mount(const QString& fileName, UiWadFile&& file)
+{
+	auto wad = std::make_unique<Wad>();
+
+	wad->FileName = fileName;
+	wad->DisplayName = QFileInfo{ fileName }.fileName();
+	wad->File = std::move(file);
+	wad->Names = GetNames(wad->File);
+
+	const auto wadIndex = static_cast<std::uint32_t>(_wads.size());
+
+	_wads.push_back(std::move(wad));
+
+	Merge(wadIndex);
+
+	return wadIndex;
+}
+
+void WadCollection::Replace(std::size_t index, UiWadFile&& file)
+{
+	_wads[index]->File = std::move(file);
+	_wads[index]->Names = GetNames(_wads[index]->File);
+
+	_entries.clear();
+	_order.clear();
+	_entriesByName.clear();
+	_entriesByContent.clear();
+
+	for (std::uint32_t i = 0; i < _wads.size(); ++i)
+	{
+		Merge(i);
+	}
+}
+
+void WadCollection::Clear()
+{
+	_wads.clear();
+	_entries.clear();
+	_order.clear();
+	_positions.clear();
+	_entriesByName.clear();
+	_entriesByContent.clear();
+}
+
+std::vector<std::uint32_t> WadCollection::Find(std::string_view foldedQuery) const
+{
+	std::vector<std::uint32_t> result;
+
+	for (const auto& wad : _wads)
+	{
+		for (const auto entryIndex : wad->File.NameIndex.Find(foldedQuery))
+		{
+			result.push_back(_positions[wad->EntryIds[entryIndex]]);
+		}
+	}
+
+	// Shadowed textures and duplicates resolve to the same position as the texture they belong to.
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+
+	return result;
+}
+
+std::vector<std::uint32_t> WadCollection::Find(std::string_view foldedQuery, const std::vector<std::uint32_t>& candidates) const
+{
+	const auto matches = [&, this](const WadEntryRef& ref)
+	{
+		return _wads[ref.WadIndex]->File.NameIndex.Matches(ref.EntryIndex, foldedQuery);
+	};
+
+	std::vector<std::uint32_t> result;
+
+	std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(result), [&, this](auto position)
+		{
+			const auto& entry = GetEntry(position);
+
+			return matches(entry.Source)
+				|| std::any_of(entry.Duplicates.begin(), entry.Duplicates.end(), matches)
+				|| std::any_of(entry.Shadowed.begin(), entry.Shadowed.end(), matches);
+		});
+
+	return result;
+}
+
+MemoryUsage WadCollection::GetMemoryUsage() const
+{
+	MemoryUsage usage;
+
+	for (const auto& wad : _wads)
+	{
+		usage.AddHeap(MemoryCategory::Other, sizeof(Wad));
+
+		AddMemoryUsage(usage, wad->FileName);
+		AddMemoryUsage(usage, wad->DisplayName);
+
+		usage += wad->File.GetMemoryUsage();
+
+		usage.Add(MemoryCategory::Other, wad->Names);
+
+		for (const auto& name : wad->Names)
+		{
+			AddMemoryUsage(usage, name);
+		}
+
+		usage.Add(MemoryCategory::Other, wad->EntryIds);
+	}
+
+	usage.Add(MemoryCategory::Other, _wads);
+	usage.Add(MemoryCategory::Other, _entries);
+
+	for (const auto& entry : _entries)
+	{
+		usage.Add(MemoryCategory::Other, entry.Duplicates);
+		usage.Add(MemoryCategory::Other, entry.Shadowed);
+	}
+
+	usage.Add(MemoryCategory::Other, _order);
+	usage.Add(MemoryCategory::Other, _positions);
+	usage.Add(MemoryCategory::Other, _entriesByName);
+	usage.Add(MemoryCategory::Other, _entriesByContent);
+
+	return usage;
+}
+
+void WadCollection::Merge(std::uint32_t wadIndex)
+{
+	auto& wad = *_wads[wadIndex];
+	const auto& entries = wad.File.Entries;
+
+	wad.EntryIds.resize(entries.size());
+
+	// Entries are sorted within the wad, so new entries are also created in sorted order.
+	std::vector<std::uint32_t> newEntryIds;
+
+	for (std::uint32_t i = 0; i < entries.size(); ++i)
+	{
+		const WadEntryRef ref{ wadIndex, i };
+		const std::string_view name = GetFoldedName(ref);
+
+		// The engine only looks up textures by name, other lumps can't shadow or be shadowed.
+		const bool isTexture = entries[i].Entry.Type == WadLumpType::Miptex;
+
+		if (const auto it = isTexture ? _entriesByName.find(name) : _entriesByName.end(); it != _entriesByName.end())
+		{
+			_entries[it->second].Shadowed.push_back(ref);
+			wad.EntryIds[i] = it->second;
+			continue;
+		}
+
+		std::uint32_t id = static_cast<std::uint32_t>(_entries.size());
+
+		const auto [begin, end] = _entriesByContent.equal_range(entries[i].ContentHash);
+
+		const auto duplicate = std::find_if(begin, end, [&, this](const auto& candidate)
+			{
+				return HasIdenticalContents(GetWadEntry(_entries[candidate.second].Source), entries[i].Entry);
+			});
+
+		if (duplicate != end)
+		{
+			id = duplicate->second;
+			_entries[id].Duplicates.push_back(ref);
+		}
+		else
+		{
+			_entries.push_back({ ref });
+			_entriesByContent.emplace(entries[i].ContentHash, id);
+			newEntryIds.push_back(id);
+		}
+
+		// The name is taken even by duplicates, since the engine would find it in this wad first.
+		if (isTexture)
+		{
+			_entriesByName.emplace(name, id);
+		}
+
+		wad.EntryIds[i] = id;
+	}
+
+	std::vector<std::uint32_t> order;
+
+	order.reserve(_order.size() + newEntryIds.size());
+
+	std::merge(_order.begin(), _order.end(), newEntryIds.begin(), newEntryIds.end(), std::back_inserter(order),
+		[this](auto lhs, auto rhs)
+		{
+			return CompareFoldedTextureNames(GetFoldedName(_entries[lhs].Source), GetFoldedName(_entries[rhs].Source));
+		});
+
+	_order = std::move(order);
+
+	UpdatePositions();
+}
+
+void WadCollection::UpdatePositions()
+{
+	_positions.resize(_entries.size());
+
+	for (std::uint32_t position = 0; position < _order.size(); ++position)
+	{
+		_positions[_order[position]] = position;
+	}
+}
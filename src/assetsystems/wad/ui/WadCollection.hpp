@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <QString>
+
+#include "assetsystems/wad/TextureNameIndex.hpp"
+#include "formats/wad/WadFile.hpp"
+
+#include "utils/MemoryUsage.hpp"
+
+class UiWadEntry
+{
+public:
+	WadEntry Entry;
+
+	/**
+	*	@brief Hash of the pixels and palette, used to find identical textures.
+	*/
+	std::uint64_t ContentHash{ 0 };
+};
+
+class UiWadFile
+{
+public:
+	std::vector<UiWadEntry> Entries;
+
+	/**
+	*	@brief Index over the names of @c Entries, in the same order.
+	*/
+	TextureNameIndex NameIndex;
+
+	MemoryUsage GetMemoryUsage() const;
+};
+
+/**
+*	@brief Refers to an entry in one of the wads in a WadCollection.
+*/
+struct WadEntryRef
+{
+	std::uint32_t WadIndex{ 0 };
+	std::uint32_t EntryIndex{ 0 };
+};
+
+/**
+*	@brief A texture as shown in the merged texture list.
+*/
+struct WadCollectionEntry
+{
+	/**
+	*	@brief The entry the engine uses.
+	*/
+	WadEntryRef Source;
+
+	/**
+	*	@brief Entries in later wads with identical pixels and palette, but a different name.
+	*/
+	std::vector<WadEntryRef> Duplicates;
+
+	/**
+	*	@brief Entries in later wads with the same name as this entry or one of its duplicates. The engine never uses these.
+	*/
+	std::vector<WadEntryRef> Shadowed;
+};
+
+/**
+*	@brief Merges the textures of multiple wads into a single sorted list.
+*	@details Wads are searched in the order they were mounted, like the engine searches the wads listed by a map.
+*	A texture in a later wad is shadowed if an earlier wad has a texture with the same name,
+*	and collapsed into an earlier texture if its pixels and palette are identical.
+*	Since new wads are always searched last, mounting a wad never changes how already mounted textures are resolved:
+*	only the new wad's textures are added, merged into the existing sorted list.
+*/
+class WadCollection final
+{
+public:
+	struct Wad
+	{
+		QString FileName;
+		QString DisplayName;
+		UiWadFile File;
+
+		// Converted once so painting doesn't have to convert them over and over.
+		std::vector<QString> Names;
+
+		// Index in the collection's entries of the entry each texture resolves to.
+		std::vector<std::uint32_t> EntryIds;
+	};
+
+	std::size_t GetWadCount() const { return _wads.size(); }
+
+	const Wad& GetWad(std::size_t index) const { return *_wads[index]; }
+
+	/**
+	*	@brief Gets the index of a mounted wad by file name, or -1 if it is not mounted.
+	*/
+	int FindWad(const QString& fileName) const;
+
+	/**
+	*	@brief Adds a wad after all mounted wads.
+	*	@return The index of the new wad.
+	*/
+	std::size_t Mount(const QString& fileName, UiWadFile&& file);
+
+	/**
+	*	@brief Replaces a mounted wad with a newly loaded version, keeping its place in the search order.
+	*	@details Unlike mounting, this has to merge all wads again, but nothing has to be loaded again.
+	*/
+	void Replace(std::size_t index, UiWadFile&& file);
+
+	void Clear();
+
+	/**
+	*	@brief Gets the number of textures in the merged list.
+	*/
+	std::size_t GetEntryCount() const { return _order.size(); }
+
+	/**
+	*	@brief Gets a texture by its position in the sorted, merged list.
+	*/
+	const WadCollectionEntry& GetEntry(std::size_t position) const { return _entries[_order[position]]; }
+
+	const WadEntry& GetWadEntry(const WadEntryRef& ref) const { return _wads[ref.WadIndex]->File.Entries[ref.EntryIndex].Entry; }
+
+	/**
+	*	@brief Finds all textures matching the query, including textures whose duplicates match it.
+	*	@param foldedQuery Query folded with FoldTextureName.
+	*	@return Positions in the merged list in ascending order.
+	*/
+	std::vector<std::uint32_t> Find(std::string_view foldedQuery) const;
+
+	/**
+	*	@brief Finds all textures in @p candidates that match the query.
+	*	@param candidates Positions in ascending order, usually the result of a query that this query narrows.
+	*/
+	std::vector<std::uint32_t> Find(std::string_view foldedQuery, const std::vector<std::uint32_t>& candidates) const;
+
+	/**
+	*	@brief Gets the memory used by all mounted wads and the merged list.
+	*/
+	MemoryUsage GetMemoryUsage() const;
+
+private:
+	const std::string& GetFoldedName(const WadEntryRef& ref) const { return _wads[ref.WadIndex]->File.NameIndex.GetName(ref.EntryIndex); }
+
+	void Merge(std::uint32_t wadIndex);
+
+	void UpdatePositions();
+
+private:
+	std::vector<std::unique_ptr<Wad>> _wads;
+
+	// In the order they were added. Ids are indices into this list.
+	std::vector<WadCollectionEntry> _entries;
+
+	// Entry ids sorted like the texture list, and the position of each entry id in that list.
+	std::vector<std::uint32_t> _order;
+	std::vector<std::uint32_t> _positions;
+
+	std::unordered_map<std::string_view, std::uint32_t> _entriesByName;
+	std::unordered_multimap<std::uint64_t, std::uint32_t> _entriesByContent;
+};
@@ -1,21 +1,32 @@
 #include <algorithm>
-#include <cstring>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <string>
 #include <vector>
 
 #include <QFont>
 #include <QFontMetrics>
 #include <QItemDelegate>
 #include <QPainter>
-#include <QTimer>
+#include <QStatusBar>
+#include <QStringList>
 
 #include "ui_WadMainWindow.h"
 
 #include "application/MultiAsset.hpp"
 
 #include "assetsystems/wad/ui/WadMainWindow.hpp"
+#include "assetsystems/wad/ui/WadTextureModel.hpp"
+
+#include "formats/DecodedTextureCache.hpp"
 
 #include "formats/wad/WadFile.hpp"
 
+#include "ui/MemoryUsageLabel.hpp"
+
+#include "utils/LoadProgress.hpp"
+
 class TextureItemDelegate : public QItemDelegate
 {
 public:
@@ -32,6 +43,10 @@ public:
 		const QStyleOptionViewItem& option,
 		const QModelIndex& index) const override
 	{
+		// Paint straight from the model instead of going through QVariant.
+		const auto model = static_cast<const WadTextureModel*>(index.model());
+		const auto& entry = model->GetWadEntry(index.row());
+
 		painter->save();
 
 		painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
@@ -44,11 +59,7 @@ public:
 
 		QSize size{ 0, 0 };
 
-		if (const auto value = index.data(Qt::DecorationRole); value.isValid() && !value.isNull())
 		{
-			const auto& uiEntry = _window->GetWadFile()->Entries[index.data(Qt::UserRole).value<std::size_t>()];
-			const auto& entry = uiEntry.Entry;
-
 			int width = (int)entry.Width;
 			int height = (int)entry.Height;
 
@@ -67,10 +78,12 @@ public:
 
 			const QSize pixmapSize{ width, height };
 
-			painter->drawPixmap(rect.x(), rect.y(), pixmapSize.width(), pixmapSize.height(), uiEntry.Pixmap);
+			// The pixmap already has this size, so it is drawn without scaling.
+			painter->drawPixmap(rect.x(), rect.y(), pixmapSize.width(), pixmapSize.height(),
+				_window->GetPixmap(model->GetPosition(index.row()), Size));
 		}
 
-		const QString text = index.data(Qt::DisplayRole).toString();
+		const QString& text = model->GetName(index.row());
 
 		QSize textSize = option.fontMetrics.size(0, text);
 
@@ -102,33 +115,27 @@ public:
 	{
 		QSize size{ 0, 0 };
 
-		const auto value = index.data(Qt::DecorationRole);
+		QSize textSize{ 0, option.fontMetrics.height() };
 
-		if (value.isValid() && !value.isNull())
+		if (Size == 1)
 		{
-			const auto& entry = _window->GetWadFile()->Entries[index.data(Qt::UserRole).value<std::size_t>()].Entry;
+			const auto model = static_cast<const WadTextureModel*>(index.model());
+			const auto& entry = model->GetWadEntry(index.row());
 
-			int width = (int)entry.Width;
-			int height = (int)entry.Height;
+			size = QSize{ (int)entry.Width, (int)entry.Height };
 
-			if (Size == 1)
-			{
-				size = QSize{ width, height };
-			}
-			else
+			textSize = option.fontMetrics.size(0, model->GetName(index.row()));
+
+			// Only adjust width in 1:1 mode.
+			if (size.width() < textSize.width())
 			{
-				size = QSize{ Size, Size };
+				size.setWidth(textSize.width());
 			}
 		}
-
-		const QString text = index.data(Qt::DisplayRole).toString();
-
-		QSize textSize = option.fontMetrics.size(0, text);
-
-		// Only adjust width in 1:1 mode.
-		if (Size == 1 && size.width() < textSize.width())
+		else
 		{
-			size.setWidth(textSize.width());
+			// All items are the same size so the view can lay them out without asking every item.
+			size = QSize{ Size, Size };
 		}
 
 		size.setHeight(size.height() + textSize.height() + VerticalSpacing);
@@ -179,13 +186,14 @@ WadMainWindow::WadMainWindow(MultiAsset* multiAsset)
 		_ui->WadEntryList->setContentsMargins(margins);
 	}
 
+	_model = new WadTextureModel(&_collection, this);
+
+	_ui->WadEntryList->setModel(_model);
+
 	_itemDelegate = new TextureItemDelegate(this);
 
 	_ui->WadEntryList->setItemDelegate(_itemDelegate);
 
-	_filterTimer = new QTimer(this);
-	_filterTimer->setSingleShot(true);
-
 	for (auto size : Sizes)
 	{
 		if (size == 1)
@@ -203,101 +211,353 @@ WadMainWindow::WadMainWindow(MultiAsset* multiAsset)
 			emit _multiAsset->PromptOpenFile(this, "Half-Life 1 Wad");
 		});
 
-	connect(_ui->WadEntryList, &QListWidget::currentRowChanged, this, &WadMainWindow::OnEntryChanged);
+	connect(_ui->ActionCloseAll, &QAction::triggered, this, &WadMainWindow::OnCloseAll);
+
+	connect(_ui->WadEntryList->selectionModel(), &QItemSelectionModel::currentChanged, this, &WadMainWindow::OnEntryChanged);
 	connect(_ui->Size, &QComboBox::currentIndexChanged, this, &WadMainWindow::OnSizeChanged);
 	connect(_ui->Filter, &QComboBox::editTextChanged, this, &WadMainWindow::OnFilterChanged);
-	connect(_filterTimer, &QTimer::timeout, this, &WadMainWindow::UpdateTextureList);
+
+	_memoryUsageLabel = new MemoryUsageLabel([this] { return GetMemoryUsage(); }, this);
+
+	statusBar()->addPermanentWidget(_memoryUsageLabel);
 }
 
-WadMainWindow::~WadMainWindow() = default;
+WadMainWindow::~WadMainWindow()
+{
+	_multiAsset->GetPixmapCache()->RemoveAll(this);
+}
 
-static bool HasTextureSpecifiers(const char* name)
+/**
+*	@brief Interns a decoded palette. Lumps always decode to a full palette, missing colors are black.
+*/
+static PaletteHandle InternPalette(const std::vector<RGB24>& colors)
 {
-	return name[0] == '+' || name[0] == '-';
+	return PalettePool::GetInstance().Intern(std::span<const RGB24, ColormapColorCount>{ colors.data(), ColormapColorCount });
 }
 
-static const char* SkipTextureSpecifiers(const char* name)
+/**
+*	@brief Creates an entry that shows a lump other than a texture as a single image.
+*/
+static WadEntry CreateLumpEntry(const WadLumpInfo& info, unsigned int width, unsigned int height,
+	std::vector<std::uint8_t> pixels, PaletteHandle colormap)
 {
-	if (HasTextureSpecifiers(name))
-	{
-		name += 2;
-	}
+	WadEntry entry;
 
-	return name;
+	entry.Name = info.Name;
+	entry.Type = info.Type;
+	entry.Width = width;
+	entry.Height = height;
+	entry.MipLevelCount = 1;
+	entry.Pixels = std::move(pixels);
+	entry.Colormap = std::move(colormap);
+
+	return entry;
 }
 
-void WadMainWindow::OpenFile(FILE* file)
+/**
+*	@brief Decodes a lump into an image that can be shown in the texture list.
+*	@param gamePalette Palette used by lumps that don't have their own.
+*/
+static std::optional<WadEntry> TryDecodeLumpEntry(const WadLumpInfo& info, std::span<const std::byte> data,
+	const PaletteHandle& gamePalette)
 {
-	auto wadFile = TryLoadWadFile(file);
+	switch (info.Type)
+	{
+	case WadLumpType::Miptex: return TryDecodeWadMiptex(data, info.Name);
 
-	if (!wadFile)
+	case WadLumpType::QPic:
 	{
-		return;
+		auto picture = TryDecodeWadPicture(data);
+
+		if (!picture)
+		{
+			return {};
+		}
+
+		return CreateLumpEntry(info, picture->Width, picture->Height, std::move(picture->Pixels),
+			!picture->Colormap.empty() ? InternPalette(picture->Colormap) : gamePalette);
 	}
 
-	std::sort(wadFile->Entries.begin(), wadFile->Entries.end(), [](const auto& lhs, const auto& rhs)
+	case WadLumpType::Font:
+	{
+		// Shown as the image containing all glyphs.
+		auto font = TryDecodeWadFont(data);
+
+		if (!font)
 		{
-			const char* leftName = lhs.Name.c_str();
-			const char* rightName = rhs.Name.c_str();
+			return {};
+		}
+
+		return CreateLumpEntry(info, font->Width, font->Height, std::move(font->Pixels), InternPalette(font->Colormap));
+	}
 
-			if (HasTextureSpecifiers(leftName) || HasTextureSpecifiers(rightName))
+	case WadLumpType::Palette:
+	{
+		// Shown as a 16x16 grid of colors.
+		auto palette = TryDecodeWadPalette(data);
+
+		if (!palette)
+		{
+			return {};
+		}
+
+		constexpr unsigned int CellSize = 8;
+		constexpr unsigned int Size = 16 * CellSize;
+
+		std::vector<std::uint8_t> pixels(Size * Size);
+
+		for (unsigned int y = 0; y < Size; ++y)
+		{
+			for (unsigned int x = 0; x < Size; ++x)
 			{
-				const char* skippedLeftName = SkipTextureSpecifiers(leftName);
-				const char* skippedRightName = SkipTextureSpecifiers(rightName);
-
-				// If the base names are the same then we want to sort according to specifiers.
-				if (_stricmp(skippedLeftName, skippedRightName) != 0)
-				{
-					leftName = skippedLeftName;
-					rightName = skippedRightName;
-				}
+				pixels[(y * Size) + x] = static_cast<std::uint8_t>(((y / CellSize) * 16) + (x / CellSize));
 			}
+		}
 
-			return _stricmp(leftName, rightName) < 0;
-		});
+		return CreateLumpEntry(info, Size, Size, std::move(pixels), InternPalette(*palette));
+	}
+
+	case WadLumpType::Colormap:
+	case WadLumpType::Colormap2:
+	{
+		// Shown with one row per level, mapping each palette index to its color at that level.
+		auto colormap = TryDecodeWadColormap(data);
+
+		if (!colormap)
+		{
+			return {};
+		}
+
+		const auto levelCount = static_cast<unsigned int>(colormap->GetLevelCount());
+
+		return CreateLumpEntry(info, ColormapColorCount, levelCount, std::move(colormap->Table), gamePalette);
+	}
+
+	// Raw lumps have no known layout.
+	default: return {};
+	}
+}
+
+std::optional<UiWadFile> WadMainWindow::LoadFile(FILE* file, LoadProgress& progress)
+{
+	// Only the directory is read up front, lumps are read one at a time as they are decoded.
+	const auto directory = TryLoadWadDirectory(file);
+
+	if (!directory)
+	{
+		return {};
+	}
+
+	// Lumps without a palette of their own use the wad's palette if it has one, like Quake's gfx.wad.
+	std::vector<RGB24> gamePalette;
+
+	if (const auto it = std::find_if(directory->begin(), directory->end(), [](const auto& info)
+		{
+			return info.Type == WadLumpType::Palette;
+		}); it != directory->end())
+	{
+		if (const auto data = TryReadWadLump(file, *it); data)
+		{
+			gamePalette = TryDecodeWadPalette(*data).value_or(std::vector<RGB24>{});
+		}
+	}
+
+	if (gamePalette.empty())
+	{
+		gamePalette.resize(ColormapColorCount);
+
+		for (std::size_t i = 0; i < ColormapColorCount; ++i)
+		{
+			const auto value = static_cast<std::uint8_t>(i);
+			gamePalette[i] = RGB24{ value, value, value };
+		}
+	}
 
-	_wadFile.Entries.clear();
+	const auto sharedGamePalette = InternPalette(gamePalette);
 
-	_wadFile.Entries.reserve(wadFile->Entries.size());
+	const int lumpCount = static_cast<int>(directory->size());
 
-	QList<QRgb> colorTable;
+	std::vector<WadEntry> entries;
 
-	colorTable.resize(ColormapColorCount);
+	entries.reserve(directory->size());
 
-	for (auto& entry : wadFile->Entries)
+	for (int i = 0; i < lumpCount; ++i)
 	{
-		QImage image{ entry.Pixels.data(), (int)entry.Width, (int)entry.Height, QImage::Format_Indexed8 };
+		if (progress.IsCancelled())
+		{
+			return {};
+		}
+
+		progress.SetProgress(i, lumpCount);
+
+		const auto& info = (*directory)[i];
 
-		for (std::size_t i = 0; i < entry.Colormap.size(); ++i)
+		const auto data = TryReadWadLump(file, info);
+
+		if (!data)
 		{
-			colorTable[i] = qRgb(entry.Colormap[i].R, entry.Colormap[i].G, entry.Colormap[i].B);
+			continue;
 		}
 
-		image.setColorTable(colorTable);
+		if (auto entry = TryDecodeLumpEntry(info, *data, sharedGamePalette); entry)
+		{
+			entries.push_back(std::move(*entry));
+		}
+	}
+
+	// Fold names once so sorting and searching don't have to do it on every comparison.
+	std::vector<std::string> foldedNames;
+
+	foldedNames.reserve(entries.size());
+
+	for (const auto& entry : entries)
+	{
+		foldedNames.push_back(FoldTextureName(entry.Name));
+	}
+
+	std::vector<std::size_t> order(entries.size());
+
+	std::iota(order.begin(), order.end(), std::size_t{ 0 });
+
+	std::sort(order.begin(), order.end(), [&](auto lhs, auto rhs)
+		{
+			return CompareFoldedTextureNames(foldedNames[lhs], foldedNames[rhs]);
+		});
+
+	UiWadFile uiWadFile;
 
-		_wadFile.Entries.emplace_back(std::move(entry), QPixmap::fromImage(image));
+	uiWadFile.Entries.reserve(entries.size());
+
+	std::vector<std::string> sortedNames;
+
+	sortedNames.reserve(order.size());
+
+	for (const auto index : order)
+	{
+		// Pixmaps are created when entries are painted.
+		auto& entry = uiWadFile.Entries.emplace_back(std::move(entries[index]));
+		sortedNames.push_back(std::move(foldedNames[index]));
+
+		// Hashed here so mounting doesn't have to read every texture on the GUI thread.
+		entry.ContentHash = HashIndexedImage(entry.Entry.Width, entry.Entry.Height, entry.Entry.Pixels, entry.Entry.Colormap);
 	}
 
-	UpdateTextureList();
+	uiWadFile.NameIndex = TextureNameIndex{ std::move(sortedNames) };
+
+	return uiWadFile;
+}
+
+QImage WadMainWindow::CreateImage(const WadEntry& entry, std::size_t mipLevel)
+{
+	const auto width = entry.GetMipWidth(mipLevel);
+	const auto height = entry.GetMipHeight(mipLevel);
+
+	// Shared with maps that use the same texture, and with other windows showing it.
+	auto decoded = DecodedTextureCache::GetInstance().GetIndexed(width, height, entry.GetMipPixels(mipLevel), entry.Colormap);
+
+	// The image refers to the decoded pixels instead of copying them, and keeps them alive until it is destroyed.
+	// Every row is a multiple of 4 bytes, and the pixels are only copied if the image is modified.
+	const auto holder = new std::shared_ptr<const DecodedTexture>(std::move(decoded));
+
+	return QImage{ (*holder)->Pixels.data(), (int)width, (int)height, (int)width * 4, QImage::Format_RGBX8888,
+		[](void* info)
+		{
+			delete static_cast<std::shared_ptr<const DecodedTexture>*>(info);
+		},
+		holder };
+}
+
+void WadMainWindow::OpenFile(const QString& fileName, UiWadFile&& wadFile)
+{
+	_model->BeginCollectionChange();
+
+	if (const int index = _collection.FindWad(fileName); index != -1)
+	{
+		// Pixmaps refer to entries by index, which may have changed.
+		_multiAsset->GetPixmapCache()->RemoveAll(this);
+		_collection.Replace(static_cast<std::size_t>(index), std::move(wadFile));
+	}
+	else
+	{
+		// Existing entries keep their index, so their pixmaps remain valid.
+		_collection.Mount(fileName, std::move(wadFile));
+	}
+
+	_model->EndCollectionChange();
+
+	UpdateWindowTitle();
 
 	OnSizeChanged(_ui->Size->currentIndex());
 
+	_memoryUsageLabel->Update();
+
 	show();
 }
 
-void WadMainWindow::OnEntryChanged(int index)
+QPixmap WadMainWindow::GetPixmap(std::size_t position, int size) const
+{
+	const auto source = _collection.GetEntry(position).Source;
+
+	// Each size is cached separately. Sizes are at most 512 so they fit in the low bits.
+	const PixmapKey key{ this, (static_cast<std::uint64_t>(source.WadIndex) << 40)
+		| (static_cast<std::uint64_t>(source.EntryIndex) << 10)
+		| static_cast<std::uint64_t>(size) };
+
+	return _multiAsset->GetPixmapCache()->Get(key, [&, this]
+		{
+			const auto& entry = _collection.GetWadEntry(source);
+
+			if (size == 1)
+			{
+				return CreateImage(entry);
+			}
+
+			// Textures are compressed to fit the size, matching how the delegate lays them out.
+			const unsigned int width = std::min((unsigned int)size, entry.Width);
+			const unsigned int height = std::min((unsigned int)size, entry.Height);
+
+			const QImage image = CreateImage(entry, entry.SelectMipLevel(width, height));
+
+			if (image.width() == (int)width && image.height() == (int)height)
+			{
+				return image;
+			}
+
+			return image.scaled((int)width, (int)height, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+		});
+}
+
+MemoryUsage WadMainWindow::GetMemoryUsage() const
 {
-	if (index == -1)
+	auto usage = _collection.GetMemoryUsage();
+
+	const auto pixmapCache = _multiAsset->GetPixmapCache();
+
+	usage.AddHeap(MemoryCategory::Pixmaps, static_cast<std::size_t>(pixmapCache->GetResidentBytes(this)), pixmapCache->GetCount(this));
+
+	return usage;
+}
+
+void WadMainWindow::OnEntryChanged(const QModelIndex& index)
+{
+	if (!index.isValid())
 	{
 		_ui->TextureName->setText({});
 		_ui->TextureDimensions->setText({});
 		return;
 	}
 
-	const auto& entry = _wadFile.Entries[index];
+	const auto& entry = _model->GetWadEntry(index.row());
+
+	_ui->TextureName->setText(QString{ "%1 (%2)" }.arg(_model->GetName(index.row()), _model->GetSourceName(index.row())));
+	QString dimensions = QString{ "%1x%2" }.arg(entry.Width).arg(entry.Height);
+
+	if (entry.Type != WadLumpType::Miptex)
+	{
+		dimensions += QString{ " (%1)" }.arg(QString::fromUtf8(GetWadLumpTypeName(entry.Type)));
+	}
 
-	_ui->TextureName->setText(QString::fromStdString(entry.Entry.Name));
-	_ui->TextureDimensions->setText(QString{ "%1x%2" }.arg(entry.Entry.Width).arg(entry.Entry.Height));
+	_ui->TextureDimensions->setText(dimensions);
 }
 
 void WadMainWindow::OnSizeChanged(int index)
@@ -306,6 +566,9 @@ void WadMainWindow::OnSizeChanged(int index)
 
 	_itemDelegate->Size = size;
 
+	// Fixed sizes make every item the same size. In 1:1 mode items are as large as their texture.
+	_ui->WadEntryList->setUniformItemSizes(size != 1);
+
 	// This causes the list to perform layout again, including calling sizeHint for items.
 	// Cheaper than emitting sizeHintChanged for every single item.
 	_ui->WadEntryList->setRootIndex(_ui->WadEntryList->rootIndex());
@@ -313,29 +576,31 @@ void WadMainWindow::OnSizeChanged(int index)
 
 void WadMainWindow::OnFilterChanged()
 {
-	// Wait a short time to avoid constant updates while typing.
-	_filterTimer->start(500);
+	// Searches are incremental, so the list can be updated on every keystroke.
+	_model->SetFilter(_ui->Filter->currentText());
 }
 
-void WadMainWindow::UpdateTextureList()
+void WadMainWindow::OnCloseAll()
 {
-	const QString filter = _ui->Filter->currentText();
+	_multiAsset->GetPixmapCache()->RemoveAll(this);
 
-	_ui->WadEntryList->clear();
+	_model->BeginCollectionChange();
+	_collection.Clear();
+	_model->EndCollectionChange();
 
-	for (std::size_t i = 0; const auto & entry : _wadFile.Entries)
-	{
-		QString name = QString::fromStdString(entry.Entry.Name);
+	UpdateWindowTitle();
 
-		if (name.contains(filter, Qt::CaseInsensitive))
-		{
-			auto item = new QListWidgetItem(QIcon{ entry.Pixmap }, name);
-
-			item->setData(Qt::UserRole, QVariant::fromValue(i));
+	_memoryUsageLabel->Update();
+}
 
-			_ui->WadEntryList->addItem(item);
-		}
+void WadMainWindow::UpdateWindowTitle()
+{
+	QStringList names;
 
-		++i;
+	for (std::size_t i = 0; i < _collection.GetWadCount(); ++i)
+	{
+		names.append(_collection.GetWad(i).DisplayName);
 	}
+
+	setWindowTitle(names.isEmpty() ? QStringLiteral("Wad Viewer") : QString{ "Wad Viewer - %1" }.arg(names.join(", ")));
 }
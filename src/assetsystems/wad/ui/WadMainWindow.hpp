@@ -1,31 +1,26 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
 #include <memory>
+#include <optional>
 #include <vector>
 
+#include <QImage>
 #include <QMainWindow>
 #include <QPixmap>
+#include <QString>
 
+#include "assetsystems/wad/ui/WadCollection.hpp"
 #include "formats/wad/WadFile.hpp"
 
+class LoadProgress;
+class MemoryUsageLabel;
 class MultiAsset;
-class QString;
-class QTimer;
+class QModelIndex;
 class TextureItemDelegate;
 class Ui_WadMainWindow;
-
-class UiWadEntry
-{
-public:
-	WadEntry Entry;
-	QPixmap Pixmap;
-};
-
-class UiWadFile
-{
-public:
-	std::vector<UiWadEntry> Entries;
-};
+class WadTextureModel;
 
 class WadMainWindow final : public QMainWindow
 {
@@ -33,27 +28,59 @@ public:
 	explicit WadMainWindow(MultiAsset* multiAsset);
 	~WadMainWindow();
 
-	const UiWadFile* GetWadFile() const { return &_wadFile; }
-
-	void OpenFile(FILE* file);
+	const WadCollection* GetCollection() const { return &_collection; }
+
+	/**
+	*	@brief Loads and prepares a wad file for display. Can be called on any thread.
+	*/
+	static std::optional<UiWadFile> LoadFile(FILE* file, LoadProgress& progress);
+
+	/**
+	*	@brief Converts a mip level of a texture to an image that does not reference the entry's pixels.
+	*	Can be called on any thread.
+	*/
+	static QImage CreateImage(const WadEntry& entry, std::size_t mipLevel = 0);
+
+	/**
+	*	@brief Mounts a wad after the wads that are already open.
+	*	If the wad is already open it is replaced with the newly loaded version instead.
+	*/
+	void OpenFile(const QString& fileName, UiWadFile&& wadFile);
+
+	/**
+	*	@brief Gets the pixmap for the texture at the given position in the merged list as shown at the given size, creating it if it is not in the pixmap cache.
+	*	@details The pixmap is created from the smallest mip level that covers the size
+	*	and is already scaled so painting it doesn't need to scale it again.
+	*	@param size One of the sizes the texture list can show textures at. 1 is the texture's own size.
+	*/
+	QPixmap GetPixmap(std::size_t position, int size) const;
+
+	/**
+	*	@brief Gets the memory used by the open wads and their resident pixmaps.
+	*/
+	MemoryUsage GetMemoryUsage() const;
 
 private slots:
-	void OnEntryChanged(int index);
+	void OnEntryChanged(const QModelIndex& index);
 
 	void OnSizeChanged(int index);
 
 	void OnFilterChanged();
 
-	void UpdateTextureList();
+	void OnCloseAll();
+
+private:
+	void UpdateWindowTitle();
 
 private:
 	MultiAsset* _multiAsset;
 
 	std::unique_ptr<Ui_WadMainWindow> _ui;
 
-	UiWadFile _wadFile;
+	WadCollection _collection;
 
+	WadTextureModel* _model;
 	TextureItemDelegate* _itemDelegate;
 
-	QTimer* _filterTimer;
+	MemoryUsageLabel* _memoryUsageLabel;
 };
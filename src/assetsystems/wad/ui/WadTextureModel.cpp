@@ -0,0 +1,104 @@
+#include "assetsystems/wad/ui/WadTextureModel.hpp"
+
+WadTextureModel::WadTextureModel(const WadCollection* collection, QObject* parent)
+	: QAbstractListModel(parent)
+	, _collection(collection)
+{
+	UpdateVisibleEntries();
+}
+
+void WadTextureModel::BeginCollectionChange()
+{
+	beginResetModel();
+}
+
+void WadTextureModel::EndCollectionChange()
+{
+	// Positions change when textures are added, so previous results can't be reused.
+	_searches.clear();
+
+	UpdateVisibleEntries();
+
+	endResetModel();
+}
+
+void WadTextureModel::SetFilter(const QString& filter)
+{
+	if (_filter == filter)
+	{
+		return;
+	}
+
+	beginResetModel();
+
+	_filter = filter;
+
+	UpdateVisibleEntries();
+
+	endResetModel();
+}
+
+int WadTextureModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+	{
+		return 0;
+	}
+
+	return static_cast<int>(GetVisibleEntries().size());
+}
+
+QVariant WadTextureModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || index.row() >= rowCount())
+	{
+		return {};
+	}
+
+	switch (role)
+	{
+	case Qt::DisplayRole: return GetName(index.row());
+	case Qt::ToolTipRole: return GetToolTip(index.row());
+	case Qt::UserRole: return QVariant::fromValue(GetPosition(index.row()));
+	default: return {};
+	}
+}
+
+QString WadTextureModel::GetToolTip(int row) const
+{
+	const auto& entry = GetEntry(row);
+
+	QString toolTip = QString{ "%1 (%2)" }.arg(GetName(row), GetSourceName(row));
+
+	for (const auto& duplicate : entry.Duplicates)
+	{
+		toolTip += QString{ "\nIdentical to %1 (%2)" }.arg(GetName(duplicate), _collection->GetWad(duplicate.WadIndex).DisplayName);
+	}
+
+	for (const auto& shadowed : entry.Shadowed)
+	{
+		toolTip += QString{ "\nShadows %1 (%2)" }.arg(GetName(shadowed), _collection->GetWad(shadowed.WadIndex).DisplayName);
+	}
+
+	return toolTip;
+}
+
+void WadTextureModel::UpdateVisibleEntries()
+{
+	std::string query = FoldTextureName(_filter.toStdString());
+
+	// Go back to the last search that this query narrows down. When deleting characters this is usually an exact match.
+	while (!_searches.empty() && !TextureNameIndex::Narrows(query, _searches.back().Query))
+	{
+		_searches.pop_back();
+	}
+
+	if (!_searches.empty() && _searches.back().Query == query)
+	{
+		return;
+	}
+
+	auto entries = _searches.empty() ? _collection->Find(query) : _collection->Find(query, _searches.back().Entries);
+
+	_searches.push_back({ std::move(query), std::move(entries) });
+}
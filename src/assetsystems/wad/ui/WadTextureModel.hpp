@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QString>
+
+#include "assetsystems/wad/ui/WadCollection.hpp"
+
+/**
+*	@brief List model over the merged textures of the wads in a WadCollection.
+*	@details Rows map to positions in the merged list through an array, so filtering only rebuilds that array.
+*	No per-item objects are created.
+*	Filtering is incremental: the results of previous queries are kept while the user types,
+*	so appending to the filter narrows the previous results and deleting from it reuses earlier results.
+*/
+class WadTextureModel final : public QAbstractListModel
+{
+public:
+	explicit WadTextureModel(const WadCollection* collection, QObject* parent = nullptr);
+
+	const WadCollection* GetCollection() const { return _collection; }
+
+	/**
+	*	@brief Must be called before the collection is changed.
+	*/
+	void BeginCollectionChange();
+
+	/**
+	*	@brief Must be called after the collection has changed. Applies the current filter to the new contents.
+	*/
+	void EndCollectionChange();
+
+	const QString& GetFilter() const { return _filter; }
+
+	/**
+	*	@brief Shows only entries matching the filter, ignoring case.
+	*	@see TextureNameIndex for the supported queries.
+	*/
+	void SetFilter(const QString& filter);
+
+	/**
+	*	@brief Gets the position in the collection's merged list of the texture shown at the given row.
+	*/
+	std::size_t GetPosition(int row) const { return GetVisibleEntries()[row]; }
+
+	const WadCollectionEntry& GetEntry(int row) const { return _collection->GetEntry(GetPosition(row)); }
+
+	const WadEntry& GetWadEntry(int row) const { return _collection->GetWadEntry(GetEntry(row).Source); }
+
+	const QString& GetName(int row) const { return GetName(GetEntry(row).Source); }
+
+	const QString& GetName(const WadEntryRef& ref) const { return _collection->GetWad(ref.WadIndex).Names[ref.EntryIndex]; }
+
+	const QString& GetSourceName(int row) const { return _collection->GetWad(GetEntry(row).Source.WadIndex).DisplayName; }
+
+	int rowCount(const QModelIndex& parent = {}) const override;
+
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+	struct SearchResult
+	{
+		std::string Query;
+		std::vector<std::uint32_t> Entries;
+	};
+
+	const std::vector<std::uint32_t>& GetVisibleEntries() const { return _searches.back().Entries; }
+
+	QString GetToolTip(int row) const;
+
+	void UpdateVisibleEntries();
+
+private:
+	const WadCollection* const _collection;
+
+	QString _filter;
+
+	// Each search narrows the one before it. The last one is the current filter.
+	std::vector<SearchResult> _searches;
+};
@@ -0,0 +1,82 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "benchmarks/AllocationCounter.hpp"
+
+static std::atomic<std::uint64_t> AllocationCount{ 0 };
+static std::atomic<std::uint64_t> AllocatedBytes{ 0 };
+
+AllocationCounts GetAllocationCounts()
+{
+	return { AllocationCount.load(std::memory_order_relaxed), AllocatedBytes.load(std::memory_order_relaxed) };
+}
+
+static void CountAllocation(std::size_t size)
+{
+	AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// The array and nothrow forms call these by default, so replacing these is enough to count all allocations.
+void* operator new(std::size_t size)
+{
+	CountAllocation(size);
+
+	if (void* memory = std::malloc(size != 0 ? size : 1); memory)
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	CountAllocation(size);
+
+	const auto alignmentValue = static_cast<std::size_t>(alignment);
+
+#ifdef _WIN32
+	void* memory = _aligned_malloc(size != 0 ? size : 1, alignmentValue);
+#else
+	// aligned_alloc requires the size to be a multiple of the alignment.
+	const std::size_t alignedSize = ((size + alignmentValue - 1) / alignmentValue) * alignmentValue;
+	void* memory = std::aligned_alloc(alignmentValue, alignedSize != 0 ? alignedSize : alignmentValue);
+#endif
+
+	if (memory)
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
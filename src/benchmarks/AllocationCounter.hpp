@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+*	@brief Number and total size of allocations made through the global @c operator @c new.
+*/
+struct AllocationCounts
+{
+	std::uint64_t Count{ 0 };
+	std::uint64_t Bytes{ 0 };
+};
+
+inline AllocationCounts operator-(const AllocationCounts& lhs, const AllocationCounts& rhs)
+{
+	return { lhs.Count - rhs.Count, lhs.Bytes - rhs.Bytes };
+}
+
+/**
+*	@brief Gets the allocations made by all threads since the program started.
+*	@details The benchmark executable replaces the global allocation functions to count them,
+*	so this only covers allocations made with @c new, including those made by standard containers.
+*/
+AllocationCounts GetAllocationCounts();
@@ -0,0 +1,797 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/AllocationCounter.hpp"
+#include "benchmarks/ProcessStats.hpp"
+
+#include "formats/bsp/BspFile.hpp"
+#include "formats/sprite/SpriteFile.hpp"
+#include "formats/studiomodel/StudioModelAnimator.hpp"
+#include "formats/studiomodel/StudioModelGenerator.hpp"
+#include "formats/wad/WadFile.hpp"
+
+#include "utils/BinaryReader.hpp"
+#include "utils/IOutils.hpp"
+#include "utils/JsonWriter.hpp"
+
+constexpr int SchemaVersion = 1;
+
+constexpr std::string_view Usage = R"(Usage: multiasset-benchmarks [options] <paths...>
+
+Times cold and warm loads of every .bsp, .wad and .spr file in the given files and directories,
+plus BinaryReader on synthetic data and StudioModel animation on a generated model. Files are grouped into small (< 1 MiB), medium (< 32 MiB) and huge inputs.
+
+Options:
+  --output <file>       Write the JSON results to a file instead of standard output.
+  --iterations <count>  Minimum number of warm loads per file. Defaults to 10.
+  --min-time <seconds>  Minimum total time of the warm loads per file. Defaults to 1.
+  --filter <text>       Only run benchmarks whose name contains this text.
+  --pretty              Indent the JSON results.
+  --help                Show this message.
+
+The exit code is 1 if any input failed to load.
+Compare two result files with scripts/compare_benchmarks.py.
+)";
+
+constexpr std::uintmax_t SmallInputLimit = 1 << 20;
+constexpr std::uintmax_t MediumInputLimit = 32 << 20;
+
+// Keeps huge inputs from running for minutes when the minimum time is reached long before.
+constexpr int MaxIterations = 10000;
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+	std::vector<std::filesystem::path> Inputs;
+	std::filesystem::path OutputFile;
+	int MinIterations{ 10 };
+	double MinSeconds{ 1 };
+	std::string Filter;
+	bool Pretty{ false };
+};
+
+/**
+*	@brief Result of a single load.
+*/
+struct LoadResult
+{
+	bool Success{ false };
+
+	/**
+	*	@brief Number of format specific items loaded, used for the items per second throughput.
+	*/
+	std::size_t ItemCount{ 0 };
+};
+
+struct Format
+{
+	std::string_view Extension;
+	std::string_view Name;
+
+	/**
+	*	@brief What is counted by LoadResult::ItemCount.
+	*/
+	std::string_view ItemName;
+
+	LoadResult (*Load)(FILE* file);
+};
+
+static const Format Formats[] = {
+	{ ".bsp", "bsp", "faces", [](FILE* file)
+		{
+			const auto bsp = TryLoadBspFile(file);
+			return LoadResult{ bsp.has_value(), bsp ? bsp->Faces.size() : 0 };
+		} },
+	{ ".spr", "sprite", "frames", [](FILE* file)
+		{
+			const auto sprite = TryLoadSpriteFile(file);
+			return LoadResult{ sprite.has_value(), sprite ? sprite->Frames.size() : 0 };
+		} },
+	{ ".wad", "wad", "textures", [](FILE* file)
+		{
+			const auto wad = TryLoadWadFile(file);
+			return LoadResult{ wad.has_value(), wad ? wad->Entries.size() : 0 };
+		} }
+};
+
+static const Format* FindFormat(const std::filesystem::path& path)
+{
+	auto extension = path.extension().string();
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+		{
+			return static_cast<char>(std::tolower(c));
+		});
+
+	const auto it = std::find_if(std::begin(Formats), std::end(Formats), [&](const auto& format)
+		{
+			return format.Extension == extension;
+		});
+
+	return it != std::end(Formats) ? &*it : nullptr;
+}
+
+static std::string_view GetTier(std::uintmax_t size)
+{
+	if (size < SmallInputLimit)
+	{
+		return "small";
+	}
+
+	if (size < MediumInputLimit)
+	{
+		return "medium";
+	}
+
+	return "huge";
+}
+
+struct Measurement
+{
+	double Milliseconds{ 0 };
+	AllocationCounts Allocations;
+	LoadResult Result;
+};
+
+template<typename Function>
+static Measurement Measure(Function&& function)
+{
+	Measurement measurement;
+
+	const auto allocationsBefore = GetAllocationCounts();
+	const auto start = Clock::now();
+
+	measurement.Result = function();
+
+	measurement.Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	measurement.Allocations = GetAllocationCounts() - allocationsBefore;
+
+	return measurement;
+}
+
+struct Statistics
+{
+	double Min{ 0 };
+	double Median{ 0 };
+	double Mean{ 0 };
+	double StandardDeviation{ 0 };
+};
+
+static Statistics ComputeStatistics(std::vector<double> values)
+{
+	Statistics statistics;
+
+	if (values.empty())
+	{
+		return statistics;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	const std::size_t middle = values.size() / 2;
+
+	statistics.Min = values.front();
+	statistics.Median = (values.size() % 2) != 0 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+	statistics.Mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+
+	double sumOfSquares = 0;
+
+	for (const double value : values)
+	{
+		sumOfSquares += (value - statistics.Mean) * (value - statistics.Mean);
+	}
+
+	statistics.StandardDeviation = values.size() > 1 ? std::sqrt(sumOfSquares / (values.size() - 1)) : 0;
+
+	return statistics;
+}
+
+struct Benchmark
+{
+	std::string Name;
+	std::string_view Format;
+	std::string_view Tier;
+	std::string_view ItemName;
+	std::uintmax_t Bytes{ 0 };
+
+	/**
+	*	@brief Loads the input once. Called for the cold load and every warm load.
+	*/
+	std::function<LoadResult()> Run;
+
+	/**
+	*	@brief Prepares a cold load. Returns whether the input could actually be made cold.
+	*/
+	std::function<bool()> PrepareCold;
+};
+
+/**
+*	@return Whether the input loaded successfully.
+*/
+static bool RunBenchmark(JsonWriter& writer, const Benchmark& benchmark, const Options& options)
+{
+	std::fprintf(stderr, "%s\n", benchmark.Name.c_str());
+
+	writer.BeginObject();
+
+	writer.Property("name", benchmark.Name);
+	writer.Property("format", benchmark.Format);
+	writer.Property("tier", benchmark.Tier);
+	writer.Property("bytes", static_cast<std::uint64_t>(benchmark.Bytes));
+
+	const bool evicted = benchmark.PrepareCold ? benchmark.PrepareCold() : false;
+	const auto cold = Measure(benchmark.Run);
+
+	writer.Property("success", cold.Result.Success);
+	writer.Property(benchmark.ItemName, static_cast<std::uint64_t>(cold.Result.ItemCount));
+
+	writer.Key("cold");
+	writer.BeginObject();
+	writer.Property("evictedFromCache", evicted);
+	writer.Property("milliseconds", cold.Milliseconds);
+	writer.Property("allocations", cold.Allocations.Count);
+	writer.Property("allocatedBytes", cold.Allocations.Bytes);
+	writer.EndObject();
+
+	std::vector<double> times;
+	AllocationCounts warmAllocations;
+
+	const auto warmStart = Clock::now();
+
+	while (times.size() < MaxIterations
+		&& (static_cast<int>(times.size()) < options.MinIterations
+			|| std::chrono::duration<double>(Clock::now() - warmStart).count() < options.MinSeconds))
+	{
+		const auto warm = Measure(benchmark.Run);
+
+		// Loads are deterministic, so every iteration allocates the same amount.
+		warmAllocations = warm.Allocations;
+		times.push_back(warm.Milliseconds);
+	}
+
+	const auto statistics = ComputeStatistics(times);
+
+	writer.Key("warm");
+	writer.BeginObject();
+	writer.Property("iterations", static_cast<std::uint64_t>(times.size()));
+	writer.Property("minMilliseconds", statistics.Min);
+	writer.Property("medianMilliseconds", statistics.Median);
+	writer.Property("meanMilliseconds", statistics.Mean);
+	writer.Property("standardDeviationMilliseconds", statistics.StandardDeviation);
+	writer.Property("allocations", warmAllocations.Count);
+	writer.Property("allocatedBytes", warmAllocations.Bytes);
+	writer.EndObject();
+
+	// Based on the median since a few slow iterations shouldn't affect it.
+	const double seconds = statistics.Median / 1000;
+
+	writer.Key("throughput");
+	writer.BeginObject();
+	writer.Property("megabytesPerSecond", seconds > 0 ? (benchmark.Bytes / 1e6) / seconds : 0.0);
+	writer.Property(std::string{ benchmark.ItemName } + "PerSecond", seconds > 0 ? cold.Result.ItemCount / seconds : 0.0);
+	writer.EndObject();
+
+	writer.Property("peakRssBytes", GetPeakResidentSetSize());
+
+	writer.EndObject();
+
+	return cold.Result.Success;
+}
+
+static std::vector<Benchmark> CreateFileBenchmarks(const Options& options)
+{
+	std::vector<Benchmark> benchmarks;
+
+	const auto addFile = [&](const std::filesystem::path& path, const std::filesystem::path& root)
+	{
+		const auto format = FindFormat(path);
+
+		if (!format)
+		{
+			return;
+		}
+
+		std::error_code ec;
+		const auto size = std::filesystem::file_size(path, ec);
+
+		if (ec)
+		{
+			std::fprintf(stderr, "Could not get the size of \"%s\": %s\n", path.string().c_str(), ec.message().c_str());
+			return;
+		}
+
+		Benchmark benchmark;
+
+		const auto tier = GetTier(size);
+		const auto relativePath = root.empty() ? path.filename() : path.lexically_relative(root);
+
+		benchmark.Name = std::string{ format->Name } + "/" + std::string{ tier } + "/" + relativePath.generic_string();
+		benchmark.Format = format->Name;
+		benchmark.Tier = tier;
+		benchmark.ItemName = format->ItemName;
+		benchmark.Bytes = size;
+
+		benchmark.Run = [path, load = format->Load]
+		{
+			FILE* file = OpenFileForReading(path);
+
+			if (!file)
+			{
+				return LoadResult{};
+			}
+
+			LoadResult result;
+
+			// Some loaders throw on truncated data, which counts as a failed load here.
+			try
+			{
+				result = load(file);
+			}
+			catch (const std::exception&)
+			{
+			}
+
+			std::fclose(file);
+
+			return result;
+		};
+
+		benchmark.PrepareCold = [path]
+		{
+			return TryEvictFileFromCache(path);
+		};
+
+		benchmarks.push_back(std::move(benchmark));
+	};
+
+	for (const auto& input : options.Inputs)
+	{
+		std::error_code ec;
+
+		if (!std::filesystem::is_directory(input, ec))
+		{
+			addFile(input, {});
+			continue;
+		}
+
+		for (auto it = std::filesystem::recursive_directory_iterator{ input, ec };
+			!ec && it != std::filesystem::recursive_directory_iterator{}; it.increment(ec))
+		{
+			if (it->is_regular_file(ec))
+			{
+				addFile(it->path(), input);
+			}
+		}
+	}
+
+	// Directory iteration order is unspecified, sort so results can be compared between runs.
+	std::sort(benchmarks.begin(), benchmarks.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.Name < rhs.Name;
+		});
+
+	return benchmarks;
+}
+
+/**
+*	@brief Benchmarks of the reader all loaders are built on, so its cost can be seen apart from the loaders.
+*/
+static std::vector<Benchmark> CreateBinaryReaderBenchmarks()
+{
+	constexpr std::size_t DataSize = 16 << 20;
+	constexpr std::size_t StringLength = 16;
+
+	// Shared by both benchmarks, filled with a repeating pattern that contains null terminators for the string reads.
+	static const auto data = []
+	{
+		std::vector<std::byte> buffer(DataSize);
+
+		for (std::size_t i = 0; i < buffer.size(); ++i)
+		{
+			buffer[i] = static_cast<std::byte>((i % StringLength) < 10 ? 'a' + (i % 26) : 0);
+		}
+
+		return buffer;
+	}();
+
+	std::vector<Benchmark> benchmarks;
+
+	Benchmark integers;
+
+	integers.Name = "binaryreader/synthetic/int32";
+	integers.Format = "binaryreader";
+	integers.Tier = "synthetic";
+	integers.ItemName = "values";
+	integers.Bytes = DataSize;
+	integers.Run = []
+	{
+		BinaryReader reader{ data };
+
+		std::uint32_t sum = 0;
+
+		for (std::size_t i = 0; i < DataSize / sizeof(std::int32_t); ++i)
+		{
+			sum += static_cast<std::uint32_t>(reader.ReadInt32());
+		}
+
+		// Use the result so the reads can't be optimized away.
+		return LoadResult{ sum != 1, DataSize / sizeof(std::int32_t) };
+	};
+
+	benchmarks.push_back(std::move(integers));
+
+	Benchmark strings;
+
+	strings.Name = "binaryreader/synthetic/string16";
+	strings.Format = "binaryreader";
+	strings.Tier = "synthetic";
+	strings.ItemName = "values";
+	strings.Bytes = DataSize;
+	strings.Run = []
+	{
+		BinaryReader reader{ data };
+
+		std::size_t totalLength = 0;
+
+		for (std::size_t i = 0; i < DataSize / StringLength; ++i)
+		{
+			totalLength += reader.ReadFixedUTF8String(StringLength).size();
+		}
+
+		return LoadResult{ totalLength != 1, DataSize / StringLength };
+	};
+
+	benchmarks.push_back(std::move(strings));
+
+	return benchmarks;
+}
+
+/**
+*	@brief Benchmarks of StudioModel animation and skinning on a generated model the size of a detailed character.
+*/
+static std::vector<Benchmark> CreateStudioModelBenchmarks()
+{
+	static constexpr int PoseCount = 256;
+	static constexpr std::size_t InstanceCount = 1024;
+
+	struct State
+	{
+		StudioModelFile Model;
+		StudioModelAnimator Animator;
+		std::vector<StudioModelPose> Poses;
+		StudioBoneTransforms Bones;
+		StudioVectorArrays Vertexes;
+		std::vector<StudioModelInstance> Instances;
+
+		explicit State(StudioModelFile&& model)
+			: Model(std::move(model))
+			, Animator(Model)
+		{
+		}
+	};
+
+	StudioModelGeneratorSettings settings;
+
+	settings.Seed = 1;
+	settings.BoneCount = 64;
+	settings.VertexesPerBone = 32;
+	settings.SequenceCount = 16;
+	settings.FrameCount = 60;
+
+	const auto path = std::filesystem::temp_directory_path() / "multiasset-benchmark.mdl";
+
+	auto model = TryGenerateStudioModelFile(path, settings) ? StudioModelFile::TryOpen(path) : std::nullopt;
+
+	if (!model)
+	{
+		std::fprintf(stderr, "Could not generate \"%s\", skipping StudioModel benchmarks\n", path.string().c_str());
+		return {};
+	}
+
+	const auto state = std::make_shared<State>(std::move(*model));
+
+	// Poses cover every sequence at fractional frames, half of them blending into another sequence.
+	for (int i = 0; i < PoseCount; ++i)
+	{
+		StudioModelPose pose;
+
+		pose.Sequence = { i % settings.SequenceCount, static_cast<float>(i % settings.FrameCount) + 0.5f };
+
+		if ((i % 2) != 0)
+		{
+			pose.BlendSequence = { (i + 1) % settings.SequenceCount, static_cast<float>(i % settings.FrameCount) };
+			pose.BlendWeight = 0.25f;
+		}
+
+		state->Poses.push_back(pose);
+	}
+
+	state->Instances.resize(InstanceCount);
+
+	for (std::size_t i = 0; i < InstanceCount; ++i)
+	{
+		state->Instances[i].Animator = &state->Animator;
+		state->Instances[i].Pose = state->Poses[i % state->Poses.size()];
+	}
+
+	const std::size_t boneCount = state->Animator.GetBoneCount();
+	const std::size_t vertexCount = state->Animator.GetVertexes().Count;
+
+	std::vector<Benchmark> benchmarks;
+
+	Benchmark bones;
+
+	bones.Name = "studiomodel/synthetic/bones";
+	bones.Format = "studiomodel";
+	bones.Tier = "synthetic";
+	bones.ItemName = "bones";
+	bones.Bytes = PoseCount * boneCount * sizeof(StudioBoneTransforms::Matrix);
+	bones.Run = [state, boneCount]
+	{
+		bool success = true;
+
+		for (const auto& pose : state->Poses)
+		{
+			success = state->Animator.TryComputeBoneTransforms(pose, state->Bones) && success;
+		}
+
+		return LoadResult{ success, state->Poses.size() * boneCount };
+	};
+
+	benchmarks.push_back(std::move(bones));
+
+	const auto addSkinning = [&](std::string_view name, StudioSkinningKernel kernel)
+	{
+		if (!IsStudioSkinningKernelSupported(kernel))
+		{
+			return;
+		}
+
+		Benchmark skinning;
+
+		skinning.Name = "studiomodel/synthetic/skinning-" + std::string{ name };
+		skinning.Format = "studiomodel";
+		skinning.Tier = "synthetic";
+		skinning.ItemName = "vertexes";
+		skinning.Bytes = PoseCount * vertexCount * sizeof(float) * 3;
+		skinning.Run = [state, vertexCount, kernel]
+		{
+			const bool success = state->Animator.TryComputeBoneTransforms(state->Poses.front(), state->Bones);
+
+			for (int i = 0; i < PoseCount; ++i)
+			{
+				SkinStudioVectors(state->Bones, state->Animator.GetVertexes(), true, state->Vertexes, kernel);
+			}
+
+			return LoadResult{ success, PoseCount * vertexCount };
+		};
+
+		benchmarks.push_back(std::move(skinning));
+	};
+
+	addSkinning("scalar", StudioSkinningKernel::Scalar);
+	addSkinning("avx2", StudioSkinningKernel::Avx2);
+
+	Benchmark instances;
+
+	instances.Name = "studiomodel/synthetic/instances";
+	instances.Format = "studiomodel";
+	instances.Tier = "synthetic";
+	instances.ItemName = "vertexes";
+	instances.Bytes = InstanceCount * vertexCount * sizeof(float) * 6;
+	instances.Run = [state, vertexCount]
+	{
+		EvaluateStudioModelInstances(state->Instances);
+
+		const bool success = std::all_of(state->Instances.begin(), state->Instances.end(), [](const auto& instance)
+			{
+				return instance.Valid;
+			});
+
+		return LoadResult{ success, state->Instances.size() * vertexCount };
+	};
+
+	benchmarks.push_back(std::move(instances));
+
+	return benchmarks;
+}
+
+/**
+*	@return The options, or nothing if the program should exit with @p exitCode.
+*/
+static std::optional<Options> ParseOptions(int argc, char* argv[], int& exitCode)
+{
+	exitCode = 2;
+
+	Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument{ argv[i] };
+
+		const auto getValue = [&]() -> const char*
+		{
+			if ((i + 1) >= argc)
+			{
+				std::fprintf(stderr, "Missing value for option \"%s\"\n", argv[i]);
+				return nullptr;
+			}
+
+			return argv[++i];
+		};
+
+		if (argument == "--help")
+		{
+			std::fputs(Usage.data(), stdout);
+			exitCode = 0;
+			return {};
+		}
+		else if (argument == "--pretty")
+		{
+			options.Pretty = true;
+		}
+		else if (argument == "--output" || argument == "--filter" || argument == "--iterations" || argument == "--min-time")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			if (argument == "--output")
+			{
+				options.OutputFile = value;
+			}
+			else if (argument == "--filter")
+			{
+				options.Filter = value;
+			}
+			else if (argument == "--iterations")
+			{
+				options.MinIterations = std::max(1, std::atoi(value));
+			}
+			else
+			{
+				options.MinSeconds = std::max(0.0, std::atof(value));
+			}
+		}
+		else if (argument.starts_with("--"))
+		{
+			std::fprintf(stderr, "Unknown option \"%s\"\n", argv[i]);
+			return {};
+		}
+		else
+		{
+			options.Inputs.push_back(argument);
+		}
+	}
+
+	return options;
+}
+
+static const char* GetBuildType()
+{
+#ifdef NDEBUG
+	return "release";
+#else
+	return "debug";
+#endif
+}
+
+static const char* GetCompiler()
+{
+#if defined(__clang__)
+	return "clang " __clang_version__;
+#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	return "msvc";
+#else
+	return "unknown";
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	int exitCode = 0;
+
+	const auto options = ParseOptions(argc, argv, exitCode);
+
+	if (!options)
+	{
+		return exitCode;
+	}
+
+	auto benchmarks = CreateBinaryReaderBenchmarks();
+
+	{
+		auto studioModelBenchmarks = CreateStudioModelBenchmarks();
+		benchmarks.insert(benchmarks.end(), std::make_move_iterator(studioModelBenchmarks.begin()), std::make_move_iterator(studioModelBenchmarks.end()));
+	}
+
+	{
+		auto fileBenchmarks = CreateFileBenchmarks(*options);
+		benchmarks.insert(benchmarks.end(), std::make_move_iterator(fileBenchmarks.begin()), std::make_move_iterator(fileBenchmarks.end()));
+	}
+
+	if (!options->Filter.empty())
+	{
+		std::erase_if(benchmarks, [&](const auto& benchmark)
+			{
+				return benchmark.Name.find(options->Filter) == std::string::npos;
+			});
+	}
+
+	JsonWriter writer{ options->Pretty };
+
+	writer.BeginObject();
+
+	writer.Property("schemaVersion", SchemaVersion);
+
+	writer.Key("environment");
+	writer.BeginObject();
+	writer.Property("compiler", GetCompiler());
+	writer.Property("buildType", GetBuildType());
+	writer.Property("hardwareThreads", std::thread::hardware_concurrency());
+	writer.EndObject();
+
+	writer.Key("settings");
+	writer.BeginObject();
+	writer.Property("minIterations", options->MinIterations);
+	writer.Property("minSeconds", options->MinSeconds);
+	writer.EndObject();
+
+	writer.Key("benchmarks");
+	writer.BeginArray();
+
+	bool allSucceeded = true;
+
+	for (const auto& benchmark : benchmarks)
+	{
+		if (!RunBenchmark(writer, benchmark, *options))
+		{
+			allSucceeded = false;
+		}
+	}
+
+	writer.EndArray();
+
+	writer.Property("peakRssBytes", GetPeakResidentSetSize());
+
+	writer.EndObject();
+
+	FILE* output = options->OutputFile.empty() ? stdout : OpenFileForWriting(options->OutputFile);
+
+	if (!output)
+	{
+		std::fprintf(stderr, "Could not open \"%s\" for writing\n", options->OutputFile.string().c_str());
+		return 1;
+	}
+
+	std::fwrite(writer.GetString().data(), 1, writer.GetString().size(), output);
+	std::fputc('\n', output);
+
+	if (output != stdout)
+	{
+		std::fclose(output);
+	}
+
+	return allSucceeded ? 0 : 1;
+}
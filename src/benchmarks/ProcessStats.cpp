@@ -0,0 +1,59 @@
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "benchmarks/ProcessStats.hpp"
+
+std::uint64_t GetPeakResidentSetSize()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+#ifdef __APPLE__
+	return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+	// Linux reports kilobytes.
+	return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+bool TryEvictFileFromCache(const std::filesystem::path& path)
+{
+#if defined(_WIN32) || defined(__APPLE__)
+	(void)path;
+	return false;
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	const bool success = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+
+	close(fd);
+
+	return success;
+#endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+/**
+*	@brief Gets the largest amount of physical memory the process has used so far, in bytes.
+*	@return 0 if the platform doesn't provide it.
+*/
+std::uint64_t GetPeakResidentSetSize();
+
+/**
+*	@brief Asks the operating system to drop the file's pages from its cache, so the next read comes from disk.
+*	@details Only pages that aren't in use elsewhere are dropped.
+*	@return Whether the platform supports this. If not, cold loads only measure the first load in this process.
+*/
+bool TryEvictFileFromCache(const std::filesystem::path& path);
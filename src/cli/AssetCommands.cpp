@@ -0,0 +1,896 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_set>
+
+#include "cli/AssetCommands.hpp"
+
+#include "formats/bsp/BspFile.hpp"
+#include "formats/png/PngWriter.hpp"
+#include "formats/sprite/SpriteAnimationScheduler.hpp"
+#include "formats/sprite/SpriteCompositor.hpp"
+#include "formats/sprite/SpriteFile.hpp"
+#include "formats/studiomodel/StudioModelFile.hpp"
+#include "formats/wad/WadFile.hpp"
+#include "formats/wad/WadWriter.hpp"
+
+#include "utils/IOutils.hpp"
+#include "utils/MappedFile.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static double GetMillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::string_view GetAssetTypeName(AssetType type)
+{
+	switch (type)
+	{
+	case AssetType::Bsp: return "bsp";
+	case AssetType::Sprite: return "sprite";
+	case AssetType::StudioModel: return "studiomodel";
+	case AssetType::Wad: return "wad";
+	default: return "unknown";
+	}
+}
+
+static std::string ToLower(std::string value)
+{
+	std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+		{
+			return static_cast<char>(std::tolower(c));
+		});
+
+	return value;
+}
+
+AssetType GetAssetType(const std::filesystem::path& path)
+{
+	const auto extension = ToLower(path.extension().string());
+
+	if (extension == ".bsp")
+	{
+		return AssetType::Bsp;
+	}
+
+	if (extension == ".spr")
+	{
+		return AssetType::Sprite;
+	}
+
+	if (extension == ".mdl")
+	{
+		return IsStudioModelCompanionFile(path) ? AssetType::Unknown : AssetType::StudioModel;
+	}
+
+	if (extension == ".wad")
+	{
+		return AssetType::Wad;
+	}
+
+	return AssetType::Unknown;
+}
+
+static AssetReport CreateReport(const std::filesystem::path& path)
+{
+	AssetReport report;
+
+	report.Path = path;
+	report.Type = GetAssetType(path);
+
+	std::error_code ec;
+
+	if (const auto size = std::filesystem::file_size(path, ec); !ec)
+	{
+		report.FileSize = size;
+	}
+
+	return report;
+}
+
+/**
+*	@brief Runs a loader, turning exceptions thrown on malformed data into errors in the report.
+*	Not all loaders check sizes before reading yet, so reading past the end of the data throws.
+*/
+template<typename Function>
+static void RunCatchingErrors(AssetReport& report, Function&& function)
+{
+	try
+	{
+		function();
+	}
+	catch (const std::out_of_range&)
+	{
+		report.Error = "Unexpected end of data";
+	}
+	catch (const std::exception& e)
+	{
+		report.Error = e.what();
+	}
+}
+
+/**
+*	@brief Opens the report's file and loads it with a loader that takes a @c FILE*, timing the load.
+*/
+template<typename T, typename Loader>
+static std::optional<T> TryLoadFromFile(AssetReport& report, std::string_view typeDescription, Loader&& loader)
+{
+	FILE* file = OpenFileForReading(report.Path);
+
+	if (!file)
+	{
+		report.Error = "Could not open file";
+		return {};
+	}
+
+	std::optional<T> result;
+
+	const auto start = Clock::now();
+
+	RunCatchingErrors(report, [&]
+		{
+			result = loader(file);
+		});
+
+	report.LoadMilliseconds = GetMillisecondsSince(start);
+
+	std::fclose(file);
+
+	if (!result && report.Error.empty())
+	{
+		report.Error = "Not a valid " + std::string{ typeDescription } + " file";
+	}
+
+	return result;
+}
+
+static void AddStat(AssetReport& report, std::string name, AssetStatValue value)
+{
+	report.Stats.emplace_back(std::move(name), std::move(value));
+}
+
+static void AddCount(AssetReport& report, std::string name, std::size_t value)
+{
+	AddStat(report, std::move(name), static_cast<std::int64_t>(value));
+}
+
+/**
+*	@brief Replaces characters that can't be used in file names on all platforms.
+*	Quake textures start with '*', for example.
+*/
+static std::string ToSafeFileName(std::string_view name)
+{
+	std::string result{ name };
+
+	for (auto& c : result)
+	{
+		if (static_cast<unsigned char>(c) < 0x20 || std::string_view{ "<>:\"/\\|?*" }.find(c) != std::string_view::npos)
+		{
+			c = '_';
+		}
+	}
+
+	if (result.empty())
+	{
+		result = "_";
+	}
+
+	return result;
+}
+
+static void ValidateBsp(AssetReport& report)
+{
+	const auto bsp = TryLoadFromFile<BspFile>(report, "BSP30", [](FILE* file)
+		{
+			return TryLoadBspFile(file);
+		});
+
+	if (!bsp)
+	{
+		return;
+	}
+
+	report.Valid = true;
+
+	const auto embeddedTextureCount = std::count_if(bsp->Textures.begin(), bsp->Textures.end(), [](const auto& texture)
+		{
+			return !texture.TextureDatas[0].empty();
+		});
+
+	AddCount(report, "entityDataBytes", bsp->Entities.size());
+	AddCount(report, "entities", static_cast<std::size_t>(std::count(bsp->Entities.begin(), bsp->Entities.end(), '{')));
+	AddCount(report, "textures", bsp->Textures.size());
+	AddCount(report, "embeddedTextures", static_cast<std::size_t>(embeddedTextureCount));
+	AddCount(report, "textureInfos", bsp->TextureInfos.size());
+	AddCount(report, "faces", bsp->Faces.size());
+	AddCount(report, "models", bsp->Models.size());
+
+	report.Memory = GetMemoryUsage(*bsp);
+
+	if (!bsp->Models.empty())
+	{
+		const auto size = bsp->Models[0].Maxs - bsp->Models[0].Mins;
+
+		AddStat(report, "worldSizeX", static_cast<double>(size.x));
+		AddStat(report, "worldSizeY", static_cast<double>(size.y));
+		AddStat(report, "worldSizeZ", static_cast<double>(size.z));
+	}
+}
+
+static std::optional<SpriteFile> TryLoadSprite(AssetReport& report)
+{
+	return TryLoadFromFile<SpriteFile>(report, "sprite", [](FILE* file)
+		{
+			return TryLoadSpriteFile(file);
+		});
+}
+
+static void ValidateSprite(AssetReport& report)
+{
+	const auto sprite = TryLoadSprite(report);
+
+	if (!sprite)
+	{
+		return;
+	}
+
+	report.Valid = true;
+
+	AddStat(report, "type", std::string{ SpriteTypeToString(sprite->Type) });
+	AddStat(report, "textureFormat", std::string{ SpriteTextureFormatToString(sprite->TextureFormat) });
+	AddStat(report, "width", static_cast<std::int64_t>(sprite->Width));
+	AddStat(report, "height", static_cast<std::int64_t>(sprite->Height));
+	AddStat(report, "randomSync", sprite->SyncType == SyncType::RAND);
+	AddCount(report, "frameEntries", sprite->FrameDescriptors.size());
+	AddCount(report, "frames", sprite->Frames.size());
+	AddCount(report, "groups", sprite->Groups.size());
+	AddStat(report, "durationSeconds", SpriteAnimationScheduler{ *sprite }.GetDuration());
+
+	report.Memory = GetMemoryUsage(*sprite);
+}
+
+static void ValidateStudioModel(AssetReport& report)
+{
+	std::optional<StudioModelFile> model;
+
+	const auto start = Clock::now();
+
+	RunCatchingErrors(report, [&]
+		{
+			model = StudioModelFile::TryOpen(report.Path);
+		});
+
+	if (!model)
+	{
+		report.LoadMilliseconds = GetMillisecondsSince(start);
+
+		if (report.Error.empty())
+		{
+			report.Error = "Not a valid StudioModel file";
+		}
+
+		return;
+	}
+
+	std::size_t modelCount = 0;
+	std::size_t meshCount = 0;
+	std::size_t vertexCount = 0;
+	std::size_t triangleCount = 0;
+
+	for (const auto& bodyPart : model->GetBodyParts())
+	{
+		for (const auto& subModel : model->GetModels(bodyPart))
+		{
+			++modelCount;
+			vertexCount += static_cast<std::size_t>(subModel.VertexCount);
+
+			for (const auto& mesh : model->GetMeshes(subModel))
+			{
+				++meshCount;
+				triangleCount += static_cast<std::size_t>(mesh.TriangleCount);
+			}
+		}
+	}
+
+	// Opening the model only reads the model file itself, record that before everything else is loaded.
+	const auto initialSequenceGroupCount = model->GetLoadedSequenceGroupCount();
+
+	const auto textureSet = model->GetTextureSet();
+
+	if (!textureSet)
+	{
+		report.Error = "Could not load textures from \"" + GetStudioTextureFilePath(report.Path).filename().string() + "\"";
+	}
+
+	for (const auto& sequence : model->GetSequences())
+	{
+		if (!report.Error.empty())
+		{
+			break;
+		}
+
+		const auto animations = model->GetAnimations(sequence);
+
+		if (!animations)
+		{
+			report.Error = "Could not load sequence group \""
+				+ GetStudioSequenceGroupPath(report.Path, sequence.SequenceGroup).filename().string() + "\"";
+		}
+		else if (!AreValidAnimationValues(*animations, sequence.FrameCount))
+		{
+			const std::string label{ std::begin(sequence.Label), std::find(std::begin(sequence.Label), std::end(sequence.Label), '\0') };
+			report.Error = "Invalid animation data in sequence \"" + label + "\"";
+		}
+	}
+
+	report.LoadMilliseconds = GetMillisecondsSince(start);
+
+	if (!report.Error.empty())
+	{
+		return;
+	}
+
+	report.Valid = true;
+
+	AddCount(report, "bones", model->GetBones().size());
+	AddCount(report, "boneControllers", model->GetBoneControllers().size());
+	AddCount(report, "hitboxes", model->GetHitboxes().size());
+	AddCount(report, "attachments", model->GetAttachments().size());
+	AddCount(report, "sequences", model->GetSequences().size());
+	AddCount(report, "sequenceGroups", model->GetSequenceGroups().size());
+	AddCount(report, "sequenceGroupsLoadedOnOpen", initialSequenceGroupCount);
+	AddCount(report, "bodyParts", model->GetBodyParts().size());
+	AddCount(report, "models", modelCount);
+	AddCount(report, "meshes", meshCount);
+	AddCount(report, "vertexes", vertexCount);
+	AddCount(report, "triangles", triangleCount);
+	AddCount(report, "textures", textureSet->GetTextures().size());
+	AddStat(report, "externalTextures", model->HasExternalTextures());
+	AddCount(report, "skinFamilies", static_cast<std::size_t>(textureSet->GetSkinFamilyCount()));
+
+	report.Memory = GetMemoryUsage(*model);
+}
+
+using DecodedWadLump = std::variant<std::monostate, WadEntry, WadPicture, WadFont, std::vector<RGB24>, WadColormap>;
+
+/**
+*	@brief Decodes a lump with the decoder for its type.
+*	@return An empty variant for lumps that have no decoder, or nothing if the lump is invalid.
+*/
+static std::optional<DecodedWadLump> TryDecodeWadLump(const WadLumpInfo& info, std::span<const std::byte> data)
+{
+	if (info.Compression != 0)
+	{
+		return {};
+	}
+
+	const auto lump = data.subspan(info.FilePos, info.DiskSize);
+
+	const auto toVariant = [](auto&& decoded) -> std::optional<DecodedWadLump>
+	{
+		if (!decoded)
+		{
+			return {};
+		}
+
+		return DecodedWadLump{ std::move(*decoded) };
+	};
+
+	switch (info.Type)
+	{
+	case WadLumpType::Miptex: return toVariant(TryDecodeWadMiptex(lump, info.Name));
+	case WadLumpType::QPic: return toVariant(TryDecodeWadPicture(lump));
+	case WadLumpType::Font: return toVariant(TryDecodeWadFont(lump));
+	case WadLumpType::Palette: return toVariant(TryDecodeWadPalette(lump));
+	case WadLumpType::Colormap:
+	case WadLumpType::Colormap2: return toVariant(TryDecodeWadColormap(lump));
+	default: return DecodedWadLump{};
+	}
+}
+
+struct LoadedWad
+{
+	MappedFile File;
+	std::vector<WadLumpInfo> Directory;
+
+	// Same order as the directory. Lumps that failed to decode are empty.
+	std::vector<std::optional<DecodedWadLump>> Lumps;
+};
+
+/**
+*	@brief Maps a wad and decodes all of its lumps.
+*	@details Lumps are decoded straight from the mapping, the file is never copied into memory as a whole.
+*/
+static std::optional<LoadedWad> TryLoadWad(AssetReport& report)
+{
+	auto file = MappedFile::TryOpen(report.Path);
+
+	if (!file)
+	{
+		report.Error = "Could not open file";
+		return {};
+	}
+
+	const auto start = Clock::now();
+
+	LoadedWad wad;
+
+	bool validDirectory = false;
+
+	RunCatchingErrors(report, [&]
+		{
+			auto directory = TryReadWadDirectory(file->GetData());
+
+			if (!directory)
+			{
+				return;
+			}
+
+			validDirectory = true;
+
+			wad.Directory = std::move(*directory);
+			wad.Lumps.reserve(wad.Directory.size());
+
+			for (const auto& info : wad.Directory)
+			{
+				wad.Lumps.push_back(TryDecodeWadLump(info, file->GetData()));
+			}
+		});
+
+	report.LoadMilliseconds = GetMillisecondsSince(start);
+
+	if (!validDirectory)
+	{
+		if (report.Error.empty())
+		{
+			report.Error = "Not a valid WAD2 or WAD3 file";
+		}
+
+		return {};
+	}
+
+	wad.File = std::move(*file);
+
+	return wad;
+}
+
+/**
+*	@brief Gets the memory owned by the decoded lumps. The mapped file is not included, it's owned by the system's file cache.
+*/
+static MemoryUsage GetMemoryUsage(const LoadedWad& wad)
+{
+	MemoryUsage usage;
+
+	usage.Add(MemoryCategory::Other, wad.Directory);
+	usage.Add(MemoryCategory::Other, wad.Lumps);
+
+	for (const auto& info : wad.Directory)
+	{
+		usage.Add(MemoryCategory::Other, info.Name);
+	}
+
+	for (const auto& lump : wad.Lumps)
+	{
+		if (!lump)
+		{
+			continue;
+		}
+
+		if (const auto entry = std::get_if<WadEntry>(&*lump); entry)
+		{
+			usage += GetMemoryUsage(*entry);
+		}
+		else if (const auto picture = std::get_if<WadPicture>(&*lump); picture)
+		{
+			usage.Add(MemoryCategory::Textures, picture->Pixels);
+			usage.Add(MemoryCategory::Palettes, picture->Colormap);
+		}
+		else if (const auto font = std::get_if<WadFont>(&*lump); font)
+		{
+			usage.Add(MemoryCategory::Textures, font->Pixels);
+			usage.Add(MemoryCategory::Palettes, font->Colormap);
+		}
+		else if (const auto palette = std::get_if<std::vector<RGB24>>(&*lump); palette)
+		{
+			usage.Add(MemoryCategory::Palettes, *palette);
+		}
+		else if (const auto colormap = std::get_if<WadColormap>(&*lump); colormap)
+		{
+			usage.Add(MemoryCategory::Palettes, colormap->Table);
+		}
+	}
+
+	return usage;
+}
+
+static void AddWadStats(AssetReport& report, const LoadedWad& wad)
+{
+	std::size_t textureCount = 0;
+	std::size_t pictureCount = 0;
+	std::size_t fontCount = 0;
+	std::size_t paletteCount = 0;
+	std::size_t colormapCount = 0;
+	std::size_t otherCount = 0;
+	std::size_t compressedCount = 0;
+	std::size_t invalidCount = 0;
+	std::size_t pixelBytes = 0;
+
+	for (std::size_t i = 0; i < wad.Directory.size(); ++i)
+	{
+		const auto& info = wad.Directory[i];
+		const auto& lump = wad.Lumps[i];
+
+		if (info.Compression != 0)
+		{
+			++compressedCount;
+		}
+
+		if (!lump)
+		{
+			++invalidCount;
+
+			if (report.Error.empty())
+			{
+				report.Error = "Invalid " + std::string{ GetWadLumpTypeName(info.Type) } + " lump \"" + info.Name + "\"";
+			}
+
+			continue;
+		}
+
+		switch (info.Type)
+		{
+		case WadLumpType::Miptex:
+			++textureCount;
+			pixelBytes += std::get<WadEntry>(*lump).Pixels.size();
+			break;
+
+		case WadLumpType::QPic:
+			++pictureCount;
+			pixelBytes += std::get<WadPicture>(*lump).Pixels.size();
+			break;
+
+		case WadLumpType::Font:
+			++fontCount;
+			pixelBytes += std::get<WadFont>(*lump).Pixels.size();
+			break;
+
+		case WadLumpType::Palette: ++paletteCount; break;
+
+		case WadLumpType::Colormap:
+		case WadLumpType::Colormap2: ++colormapCount; break;
+
+		default: ++otherCount; break;
+		}
+	}
+
+	report.Valid = invalidCount == 0;
+
+	AddCount(report, "lumps", wad.Directory.size());
+	AddCount(report, "textures", textureCount);
+	AddCount(report, "pictures", pictureCount);
+	AddCount(report, "fonts", fontCount);
+	AddCount(report, "palettes", paletteCount);
+	AddCount(report, "colormaps", colormapCount);
+	AddCount(report, "otherLumps", otherCount);
+	AddCount(report, "compressedLumps", compressedCount);
+	AddCount(report, "invalidLumps", invalidCount);
+	AddCount(report, "pixelBytes", pixelBytes);
+
+	report.Memory = GetMemoryUsage(wad);
+}
+
+static void ValidateWad(AssetReport& report)
+{
+	if (const auto wad = TryLoadWad(report); wad)
+	{
+		AddWadStats(report, *wad);
+	}
+}
+
+AssetReport ValidateAsset(const std::filesystem::path& path)
+{
+	const auto start = Clock::now();
+
+	auto report = CreateReport(path);
+
+	switch (report.Type)
+	{
+	case AssetType::Bsp: ValidateBsp(report); break;
+	case AssetType::Sprite: ValidateSprite(report); break;
+	case AssetType::StudioModel: ValidateStudioModel(report); break;
+	case AssetType::Wad: ValidateWad(report); break;
+	default: report.Error = "Unknown file type"; break;
+	}
+
+	report.TotalMilliseconds = GetMillisecondsSince(start);
+
+	return report;
+}
+
+static std::vector<std::uint32_t> ConvertIndexedImage(std::span<const std::uint8_t> pixels, std::span<const RGB24> palette)
+{
+	std::vector<std::uint32_t> result;
+
+	result.reserve(pixels.size());
+
+	for (const auto index : pixels)
+	{
+		const RGB24 color = index < palette.size() ? palette[index] : RGB24{ index, index, index };
+
+		result.push_back(0xFF000000U | (color.R << 16) | (color.G << 8) | color.B);
+	}
+
+	return result;
+}
+
+AssetReport ExportWadImages(const std::filesystem::path& path, const std::filesystem::path& outputDirectory)
+{
+	const auto start = Clock::now();
+
+	auto report = CreateReport(path);
+
+	const auto wad = TryLoadWad(report);
+
+	if (!wad)
+	{
+		report.TotalMilliseconds = GetMillisecondsSince(start);
+		return report;
+	}
+
+	AddWadStats(report, *wad);
+
+	// Pictures without a palette of their own use the wad's palette if it has one, like Quake's gfx.wad.
+	std::vector<RGB24> gamePalette;
+
+	for (const auto& lump : wad->Lumps)
+	{
+		if (lump && std::holds_alternative<std::vector<RGB24>>(*lump))
+		{
+			gamePalette = std::get<std::vector<RGB24>>(*lump);
+			break;
+		}
+	}
+
+	const auto wadDirectory = outputDirectory / path.stem();
+
+	std::error_code ec;
+
+	if (std::filesystem::create_directories(wadDirectory, ec); ec)
+	{
+		report.Valid = false;
+		report.Error = "Could not create directory \"" + wadDirectory.string() + "\": " + ec.message();
+		report.TotalMilliseconds = GetMillisecondsSince(start);
+		return report;
+	}
+
+	// Names are only unique per type, and file systems may be case insensitive.
+	std::unordered_set<std::string> usedNames;
+
+	const auto writeImage = [&](const std::string& name, unsigned int width, unsigned int height,
+		std::span<const std::uint8_t> pixels, std::span<const RGB24> palette)
+	{
+		auto baseName = ToSafeFileName(name);
+		auto fileName = baseName;
+
+		for (int suffix = 1; !usedNames.insert(ToLower(fileName)).second; ++suffix)
+		{
+			fileName = baseName + "_" + std::to_string(suffix);
+		}
+
+		const auto outputPath = wadDirectory / (fileName + ".png");
+
+		if (!TryWritePngFile(outputPath, width, height, ConvertIndexedImage(pixels, palette)))
+		{
+			if (report.Error.empty())
+			{
+				report.Error = "Could not write \"" + outputPath.string() + "\"";
+			}
+
+			report.Valid = false;
+			return;
+		}
+
+		report.OutputFiles.push_back(outputPath);
+	};
+
+	for (std::size_t i = 0; i < wad->Directory.size(); ++i)
+	{
+		const auto& info = wad->Directory[i];
+		const auto& lump = wad->Lumps[i];
+
+		if (!lump)
+		{
+			continue;
+		}
+
+		if (const auto texture = std::get_if<WadEntry>(&*lump); texture)
+		{
+			writeImage(info.Name, texture->Width, texture->Height, texture->GetMipPixels(0), texture->Colormap);
+		}
+		else if (const auto picture = std::get_if<WadPicture>(&*lump); picture)
+		{
+			writeImage(info.Name, picture->Width, picture->Height, picture->Pixels,
+				!picture->Colormap.empty() ? std::span<const RGB24>{ picture->Colormap } : std::span<const RGB24>{ gamePalette });
+		}
+		else if (const auto font = std::get_if<WadFont>(&*lump); font)
+		{
+			writeImage(info.Name, font->Width, font->Height, font->Pixels, font->Colormap);
+		}
+	}
+
+	report.TotalMilliseconds = GetMillisecondsSince(start);
+
+	return report;
+}
+
+AssetReport ExportSpriteFrames(const std::filesystem::path& path, const std::filesystem::path& outputDirectory,
+	std::uint32_t background)
+{
+	const auto start = Clock::now();
+
+	auto report = CreateReport(path);
+
+	const auto sprite = TryLoadSprite(report);
+
+	if (!sprite)
+	{
+		report.TotalMilliseconds = GetMillisecondsSince(start);
+		return report;
+	}
+
+	report.Valid = true;
+
+	std::error_code ec;
+
+	if (std::filesystem::create_directories(outputDirectory, ec); ec)
+	{
+		report.Valid = false;
+		report.Error = "Could not create directory \"" + outputDirectory.string() + "\": " + ec.message();
+		report.TotalMilliseconds = GetMillisecondsSince(start);
+		return report;
+	}
+
+	SpriteBackground spriteBackground;
+	spriteBackground.Color = background;
+
+	// Assets are already processed in parallel, so frames are composited on this thread.
+	const auto images = CompositeSpriteFrames(*sprite, spriteBackground, 1);
+
+	const auto baseName = path.stem().string();
+
+	for (std::size_t i = 0; i < images.size(); ++i)
+	{
+		// Room for any frame index.
+		char suffix[32];
+		std::snprintf(suffix, sizeof(suffix), "_%03zu.png", i);
+
+		const auto outputPath = outputDirectory / (baseName + suffix);
+		const auto& image = images[i];
+
+		if (!TryWritePngFile(outputPath, image.Width, image.Height, image.Pixels, true))
+		{
+			report.Valid = false;
+			report.Error = "Could not write \"" + outputPath.string() + "\"";
+			break;
+		}
+
+		report.OutputFiles.push_back(outputPath);
+	}
+
+	AddCount(report, "frames", images.size());
+
+	report.TotalMilliseconds = GetMillisecondsSince(start);
+
+	return report;
+}
+
+AssetReport UpdateWad(const std::filesystem::path& path, const WadUpdateChanges& changes)
+{
+	const auto start = Clock::now();
+
+	auto report = CreateReport(path);
+
+	std::vector<WadEntry> textures;
+
+	for (const auto& source : changes.TextureSources)
+	{
+		FILE* file = OpenFileForReading(source);
+
+		if (!file)
+		{
+			report.Error = "Could not open \"" + source.string() + "\"";
+			break;
+		}
+
+		std::optional<WadFile> wad;
+
+		RunCatchingErrors(report, [&]
+			{
+				wad = TryLoadWadFile(file);
+			});
+
+		std::fclose(file);
+
+		if (!wad)
+		{
+			if (report.Error.empty())
+			{
+				report.Error = "\"" + source.string() + "\" is not a valid WAD3 file";
+			}
+
+			break;
+		}
+
+		std::move(wad->Entries.begin(), wad->Entries.end(), std::back_inserter(textures));
+	}
+
+	report.LoadMilliseconds = GetMillisecondsSince(start);
+
+	if (!report.Error.empty())
+	{
+		report.TotalMilliseconds = GetMillisecondsSince(start);
+		return report;
+	}
+
+	std::error_code ec;
+
+	const bool exists = std::filesystem::exists(path, ec);
+
+	bool success;
+
+	if (exists)
+	{
+		WadChanges wadChanges;
+
+		wadChanges.Textures = std::move(textures);
+		wadChanges.Removals = changes.Removals;
+		wadChanges.Renames = changes.Renames;
+
+		success = TryUpdateWadFile(path, wadChanges);
+
+		AddCount(report, "addedTextures", wadChanges.Textures.size());
+	}
+	else
+	{
+		// Nothing to remove or rename in a new wad.
+		success = TryWriteWadFile(path, textures);
+
+		AddCount(report, "addedTextures", textures.size());
+	}
+
+	if (!success)
+	{
+		report.Error = exists ? "Could not update wad" : "Could not create wad";
+		report.TotalMilliseconds = GetMillisecondsSince(start);
+		return report;
+	}
+
+	report.Valid = true;
+	report.OutputFiles.push_back(path);
+
+	AddCount(report, "removals", changes.Removals.size());
+	AddCount(report, "renames", changes.Renames.size());
+
+	if (FILE* file = OpenFileForReading(path); file)
+	{
+		if (const auto info = TryReadWadInfo(file); info)
+		{
+			AddCount(report, "lumps", static_cast<std::size_t>(info->LumpCount));
+			AddCount(report, "textures", static_cast<std::size_t>(info->TextureCount));
+		}
+
+		std::fclose(file);
+	}
+
+	report.TotalMilliseconds = GetMillisecondsSince(start);
+
+	return report;
+}
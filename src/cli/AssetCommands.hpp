@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "formats/wad/WadWriter.hpp"
+
+#include "utils/MemoryUsage.hpp"
+
+enum class AssetType
+{
+	Unknown,
+	Bsp,
+	Sprite,
+	StudioModel,
+	Wad
+};
+
+std::string_view GetAssetTypeName(AssetType type);
+
+/**
+*	@brief Determines the type of an asset from its file extension.
+*	@details The texture and sequence group files of a StudioModel are part of the model, so they are Unknown.
+*/
+AssetType GetAssetType(const std::filesystem::path& path);
+
+using AssetStatValue = std::variant<bool, std::int64_t, double, std::string>;
+
+/**
+*	@brief Result of running a command on a single asset.
+*/
+struct AssetReport
+{
+	std::filesystem::path Path;
+	AssetType Type{ AssetType::Unknown };
+
+	bool Valid{ false };
+
+	/**
+	*	@brief Why the asset is not valid or the command failed. Empty on success.
+	*/
+	std::string Error;
+
+	std::uintmax_t FileSize{ 0 };
+
+	/**
+	*	@brief Time spent loading and validating the asset.
+	*/
+	double LoadMilliseconds{ 0 };
+
+	/**
+	*	@brief Time spent on the entire command, including loading.
+	*/
+	double TotalMilliseconds{ 0 };
+
+	/**
+	*	@brief Statistics in the order they should be shown.
+	*/
+	std::vector<std::pair<std::string, AssetStatValue>> Stats;
+
+	/**
+	*	@brief Memory owned by the loaded asset. Empty if the asset couldn't be loaded.
+	*/
+	std::optional<MemoryUsage> Memory;
+
+	/**
+	*	@brief Files written by export commands.
+	*/
+	std::vector<std::filesystem::path> OutputFiles;
+};
+
+/**
+*	@brief Loads an asset with the loader for its type and collects statistics about it.
+*	@details Wads are checked more thoroughly than the loader does: every lump is decoded, not just textures.
+*	StudioModels have their textures and every sequence group loaded, and all animation values checked.
+*/
+AssetReport ValidateAsset(const std::filesystem::path& path);
+
+/**
+*	@brief Exports the images in a wad (textures, pictures and fonts) to PNG files in a directory named after the wad.
+*/
+AssetReport ExportWadImages(const std::filesystem::path& path, const std::filesystem::path& outputDirectory);
+
+/**
+*	@brief Exports the frames of a sprite composited over a background to PNG files named @c <sprite>_<frame>.png.
+*	@param background Premultiplied ARGB background color, see SpriteBackground.
+*/
+AssetReport ExportSpriteFrames(const std::filesystem::path& path, const std::filesystem::path& outputDirectory,
+	std::uint32_t background);
+
+/**
+*	@brief Changes the wad-update command makes to every wad it is given.
+*/
+struct WadUpdateChanges
+{
+	/**
+	*	@brief Wads whose textures are added, replacing textures with the same name.
+	*/
+	std::vector<std::filesystem::path> TextureSources;
+
+	std::vector<std::string> Removals;
+	std::vector<WadRename> Renames;
+};
+
+/**
+*	@brief Adds, removes and renames lumps in a wad. Lumps that aren't changed are copied without being decoded.
+*	@details A wad that doesn't exist yet is created from the added textures. The texture sources are loaded for every wad.
+*/
+AssetReport UpdateWad(const std::filesystem::path& path, const WadUpdateChanges& changes);
@@ -0,0 +1,562 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cli/AssetCommands.hpp"
+#include "utils/JsonWriter.hpp"
+#include "utils/MemoryUsage.hpp"
+
+constexpr int ExitSuccess = 0;
+constexpr int ExitAssetsFailed = 1;
+constexpr int ExitUsageError = 2;
+
+constexpr std::string_view Usage = R"(Usage: multiasset-cli <command> [options] <paths...>
+
+Commands:
+  validate        Load every asset and report whether it is valid, how long it took and statistics about it.
+  export-wad      Export the textures, pictures and fonts in wads as PNG files, one directory per wad.
+  export-sprite   Export the frames of sprites as PNG files.
+  wad-update      Add, replace, remove and rename lumps in wads. Wads that don't exist yet are created.
+
+Paths can be files or directories. Directories are searched recursively for files the command handles.
+
+Options:
+  --list <file>         Also process the paths listed in a file, one per line.
+  --output <dir>        Directory to export to. Defaults to the current directory.
+  --threads <count>     Maximum number of assets to process at once. Defaults to one per hardware thread.
+  --background <color>  Background for exported sprite frames as AARRGGBB hex. Defaults to transparent.
+  --add <wad>           Add the textures of another wad, replacing textures with the same name. Can be repeated.
+  --remove <name>       Remove the lump with this name. Can be repeated.
+  --rename <old>=<new>  Rename a lump. Can be repeated.
+  --pretty              Indent the JSON report.
+  --help                Show this message.
+
+A JSON report is written to standard output. The exit code is 0 if every asset succeeded,
+1 if any asset failed and 2 if the command line is invalid.
+)";
+
+enum class CliCommand
+{
+	Validate,
+	ExportWad,
+	ExportSprite,
+	WadUpdate
+};
+
+struct Options
+{
+	CliCommand Command{ CliCommand::Validate };
+	std::vector<std::filesystem::path> Inputs;
+	std::filesystem::path OutputDirectory{ "." };
+	unsigned int ThreadCount{ 0 };
+	std::uint32_t Background{ 0 };
+	WadUpdateChanges WadChanges;
+	bool Pretty{ false };
+};
+
+static std::optional<CliCommand> ParseCommand(std::string_view name)
+{
+	if (name == "validate")
+	{
+		return CliCommand::Validate;
+	}
+
+	if (name == "export-wad")
+	{
+		return CliCommand::ExportWad;
+	}
+
+	if (name == "export-sprite")
+	{
+		return CliCommand::ExportSprite;
+	}
+
+	if (name == "wad-update")
+	{
+		return CliCommand::WadUpdate;
+	}
+
+	return {};
+}
+
+static std::filesystem::path PathFromUtf8(std::string_view text)
+{
+	return std::u8string_view{ reinterpret_cast<const char8_t*>(text.data()), text.size() };
+}
+
+template<typename T>
+static std::optional<T> ParseNumber(std::string_view text, int base = 10)
+{
+	T value{};
+
+	const auto result = std::from_chars(text.data(), text.data() + text.size(), value, base);
+
+	if (result.ec != std::errc{} || result.ptr != text.data() + text.size())
+	{
+		return {};
+	}
+
+	return value;
+}
+
+static bool TryReadList(const std::filesystem::path& listFile, std::vector<std::filesystem::path>& inputs)
+{
+	std::ifstream stream{ listFile };
+
+	if (!stream)
+	{
+		return false;
+	}
+
+	for (std::string line; std::getline(stream, line);)
+	{
+		// Lists written on Windows may have CRLF line endings.
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (!line.empty())
+		{
+			inputs.push_back(PathFromUtf8(line));
+		}
+	}
+
+	return true;
+}
+
+/**
+*	@return The options, or nothing if the program should exit with @p exitCode.
+*/
+static std::optional<Options> ParseOptions(int argc, char* argv[], int& exitCode)
+{
+	exitCode = ExitUsageError;
+
+	if (argc < 2)
+	{
+		std::fputs(Usage.data(), stderr);
+		return {};
+	}
+
+	if (std::string_view{ argv[1] } == "--help")
+	{
+		std::fputs(Usage.data(), stdout);
+		exitCode = ExitSuccess;
+		return {};
+	}
+
+	Options options;
+
+	if (const auto command = ParseCommand(argv[1]); command)
+	{
+		options.Command = *command;
+	}
+	else
+	{
+		std::fprintf(stderr, "Unknown command \"%s\"\n", argv[1]);
+		return {};
+	}
+
+	for (int i = 2; i < argc; ++i)
+	{
+		const std::string_view argument{ argv[i] };
+
+		const auto getValue = [&]() -> const char*
+		{
+			if ((i + 1) >= argc)
+			{
+				std::fprintf(stderr, "Missing value for option \"%s\"\n", argv[i]);
+				return nullptr;
+			}
+
+			return argv[++i];
+		};
+
+		if (argument == "--help")
+		{
+			std::fputs(Usage.data(), stdout);
+			exitCode = ExitSuccess;
+			return {};
+		}
+		else if (argument == "--pretty")
+		{
+			options.Pretty = true;
+		}
+		else if (argument == "--list")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			if (!TryReadList(PathFromUtf8(value), options.Inputs))
+			{
+				std::fprintf(stderr, "Could not read list \"%s\"\n", value);
+				return {};
+			}
+		}
+		else if (argument == "--output")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			options.OutputDirectory = PathFromUtf8(value);
+		}
+		else if (argument == "--threads")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			const auto count = ParseNumber<unsigned int>(value);
+
+			if (!count)
+			{
+				std::fprintf(stderr, "Invalid thread count \"%s\"\n", value);
+				return {};
+			}
+
+			options.ThreadCount = *count;
+		}
+		else if (argument == "--background")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			const auto color = std::string_view{ value }.size() == 8 ? ParseNumber<std::uint32_t>(value, 16) : std::nullopt;
+
+			if (!color)
+			{
+				std::fprintf(stderr, "Invalid background color \"%s\", expected AARRGGBB\n", value);
+				return {};
+			}
+
+			// The compositor works with premultiplied colors.
+			const std::uint32_t a = *color >> 24;
+			const std::uint32_t r = ((*color >> 16) & 0xFF) * a / 255;
+			const std::uint32_t g = ((*color >> 8) & 0xFF) * a / 255;
+			const std::uint32_t b = (*color & 0xFF) * a / 255;
+
+			options.Background = (a << 24) | (r << 16) | (g << 8) | b;
+		}
+		else if (argument == "--add")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			options.WadChanges.TextureSources.push_back(PathFromUtf8(value));
+		}
+		else if (argument == "--remove")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			options.WadChanges.Removals.emplace_back(value);
+		}
+		else if (argument == "--rename")
+		{
+			const auto value = getValue();
+
+			if (!value)
+			{
+				return {};
+			}
+
+			const std::string_view rename{ value };
+			const auto separator = rename.find('=');
+
+			if (separator == std::string_view::npos || separator == 0 || separator + 1 == rename.size()
+				|| (rename.size() - separator - 1) > WadMaxNameLength)
+			{
+				std::fprintf(stderr, "Invalid rename \"%s\", expected <old>=<new> with a new name of at most %zu characters\n",
+					value, WadMaxNameLength);
+				return {};
+			}
+
+			options.WadChanges.Renames.push_back({ std::string{ rename.substr(0, separator) }, std::string{ rename.substr(separator + 1) } });
+		}
+		else if (argument.starts_with("--"))
+		{
+			std::fprintf(stderr, "Unknown option \"%s\"\n", argv[i]);
+			return {};
+		}
+		else
+		{
+			options.Inputs.push_back(PathFromUtf8(argument));
+		}
+	}
+
+	if (options.Inputs.empty())
+	{
+		std::fputs("No paths given\n", stderr);
+		return {};
+	}
+
+	if (options.Command == CliCommand::WadUpdate && options.WadChanges.TextureSources.empty()
+		&& options.WadChanges.Removals.empty() && options.WadChanges.Renames.empty())
+	{
+		std::fputs("No changes given, use --add, --remove or --rename\n", stderr);
+		return {};
+	}
+
+	return options;
+}
+
+static bool IsHandledBy(CliCommand command, AssetType type)
+{
+	switch (command)
+	{
+	case CliCommand::Validate: return type != AssetType::Unknown;
+	case CliCommand::ExportWad: return type == AssetType::Wad;
+	case CliCommand::ExportSprite: return type == AssetType::Sprite;
+	case CliCommand::WadUpdate: return type == AssetType::Wad;
+	default: return false;
+	}
+}
+
+/**
+*	@brief Expands directories into the files in them that the command handles.
+*	Files given explicitly are always included so that unsupported files are reported rather than ignored.
+*/
+static std::vector<std::filesystem::path> CollectFiles(const Options& options)
+{
+	std::vector<std::filesystem::path> files;
+
+	for (const auto& input : options.Inputs)
+	{
+		std::error_code ec;
+
+		if (!std::filesystem::is_directory(input, ec))
+		{
+			files.push_back(input);
+			continue;
+		}
+
+		std::vector<std::filesystem::path> directoryFiles;
+
+		for (auto it = std::filesystem::recursive_directory_iterator{ input, std::filesystem::directory_options::skip_permission_denied, ec };
+			!ec && it != std::filesystem::recursive_directory_iterator{}; it.increment(ec))
+		{
+			if (it->is_regular_file(ec) && IsHandledBy(options.Command, GetAssetType(it->path())))
+			{
+				directoryFiles.push_back(it->path());
+			}
+		}
+
+		if (ec)
+		{
+			std::fprintf(stderr, "Error searching \"%s\": %s\n", input.string().c_str(), ec.message().c_str());
+		}
+
+		// Directory iteration order is unspecified, sort so reports can be compared between runs.
+		std::sort(directoryFiles.begin(), directoryFiles.end());
+
+		files.insert(files.end(), directoryFiles.begin(), directoryFiles.end());
+	}
+
+	return files;
+}
+
+static AssetReport RunCommand(const Options& options, const std::filesystem::path& path)
+{
+	// Report files of the wrong type instead of passing them to a loader that doesn't understand them.
+	if (options.Command != CliCommand::Validate && !IsHandledBy(options.Command, GetAssetType(path)))
+	{
+		AssetReport report;
+
+		report.Path = path;
+		report.Type = GetAssetType(path);
+		report.Error = "File type not supported by this command";
+
+		return report;
+	}
+
+	switch (options.Command)
+	{
+	case CliCommand::ExportWad: return ExportWadImages(path, options.OutputDirectory);
+	case CliCommand::ExportSprite: return ExportSpriteFrames(path, options.OutputDirectory, options.Background);
+	case CliCommand::WadUpdate: return UpdateWad(path, options.WadChanges);
+	default: return ValidateAsset(path);
+	}
+}
+
+/**
+*	@brief Runs the command on all files, spreading files over multiple threads.
+*	@return Reports in the same order as the files.
+*/
+static std::vector<AssetReport> RunCommand(const Options& options, const std::vector<std::filesystem::path>& files)
+{
+	std::vector<AssetReport> reports(files.size());
+
+	unsigned int threadCount = options.ThreadCount != 0 ? options.ThreadCount : std::max(1U, std::thread::hardware_concurrency());
+
+	threadCount = static_cast<unsigned int>(std::min<std::size_t>(threadCount, files.size()));
+
+	std::atomic<std::size_t> nextFile{ 0 };
+
+	const auto worker = [&]
+	{
+		// Files are handed out one at a time, since their sizes vary widely.
+		for (std::size_t i; (i = nextFile.fetch_add(1, std::memory_order_relaxed)) < files.size();)
+		{
+			reports[i] = RunCommand(options, files[i]);
+		}
+	};
+
+	{
+		std::vector<std::jthread> threads;
+
+		threads.reserve(threadCount);
+
+		for (unsigned int i = 1; i < threadCount; ++i)
+		{
+			threads.emplace_back(worker);
+		}
+
+		worker();
+	}
+
+	return reports;
+}
+
+static std::string PathToString(const std::filesystem::path& path)
+{
+	const auto string = path.generic_u8string();
+
+	return { reinterpret_cast<const char*>(string.data()), string.size() };
+}
+
+static void WriteReport(JsonWriter& writer, const AssetReport& report)
+{
+	writer.BeginObject();
+
+	writer.Property("path", PathToString(report.Path));
+	writer.Property("type", GetAssetTypeName(report.Type));
+	writer.Property("valid", report.Valid);
+
+	if (!report.Error.empty())
+	{
+		writer.Property("error", report.Error);
+	}
+
+	writer.Property("fileSize", static_cast<std::uint64_t>(report.FileSize));
+	writer.Property("loadMilliseconds", report.LoadMilliseconds);
+	writer.Property("totalMilliseconds", report.TotalMilliseconds);
+
+	writer.Key("stats");
+	writer.BeginObject();
+
+	for (const auto& [name, value] : report.Stats)
+	{
+		writer.Key(name);
+		std::visit([&](const auto& v) { writer.Value(v); }, value);
+	}
+
+	writer.EndObject();
+
+	if (report.Memory)
+	{
+		writer.Key("memory");
+		WriteMemoryUsage(writer, *report.Memory);
+	}
+
+	if (!report.OutputFiles.empty())
+	{
+		writer.Key("outputFiles");
+		writer.BeginArray();
+
+		for (const auto& file : report.OutputFiles)
+		{
+			writer.Value(PathToString(file));
+		}
+
+		writer.EndArray();
+	}
+
+	writer.EndObject();
+}
+
+int main(int argc, char* argv[])
+{
+	int exitCode = ExitSuccess;
+
+	const auto options = ParseOptions(argc, argv, exitCode);
+
+	if (!options)
+	{
+		return exitCode;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	const auto files = CollectFiles(*options);
+	const auto reports = RunCommand(*options, files);
+
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	const auto validCount = static_cast<std::size_t>(std::count_if(reports.begin(), reports.end(), [](const auto& report)
+		{
+			return report.Valid;
+		}));
+
+	JsonWriter writer{ options->Pretty };
+
+	writer.BeginObject();
+
+	writer.Key("assets");
+	writer.BeginArray();
+
+	for (const auto& report : reports)
+	{
+		WriteReport(writer, report);
+	}
+
+	writer.EndArray();
+
+	writer.Key("summary");
+	writer.BeginObject();
+	writer.Property("assets", static_cast<std::uint64_t>(reports.size()));
+	writer.Property("valid", static_cast<std::uint64_t>(validCount));
+	writer.Property("invalid", static_cast<std::uint64_t>(reports.size() - validCount));
+	writer.Property("elapsedMilliseconds", elapsed);
+	writer.EndObject();
+
+	writer.EndObject();
+
+	std::fwrite(writer.GetString().data(), 1, writer.GetString().size(), stdout);
+	std::fputc('\n', stdout);
+
+	return validCount == reports.size() ? ExitSuccess : ExitAssetsFailed;
+}
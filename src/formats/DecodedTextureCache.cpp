@@ -0,0 +1,161 @@
+#include <algorithm>
+
+#include "formats/DecodedTextureCache.hpp"
+
+void DecodeIndexedImage(std::span<const std::uint8_t> indexes, const PaletteHandle& palette, std::span<std::uint8_t> pixels)
+{
+	const std::size_t pixelCount = std::min(indexes.size(), pixels.size() / 4);
+
+	if (palette.empty())
+	{
+		for (std::size_t i = 0; i < pixelCount; ++i)
+		{
+			pixels[(i * 4) + 0] = 0;
+			pixels[(i * 4) + 1] = 0;
+			pixels[(i * 4) + 2] = 0;
+			pixels[(i * 4) + 3] = 0xFF;
+		}
+
+		return;
+	}
+
+	for (std::size_t i = 0; i < pixelCount; ++i)
+	{
+		const auto& color = palette[indexes[i]];
+
+		pixels[(i * 4) + 0] = color.R;
+		pixels[(i * 4) + 1] = color.G;
+		pixels[(i * 4) + 2] = color.B;
+		pixels[(i * 4) + 3] = 0xFF;
+	}
+}
+
+DecodedTextureCache::DecodedTextureCache(std::size_t budget)
+	: _budget(budget)
+{
+}
+
+DecodedTextureCache::~DecodedTextureCache() = default;
+
+DecodedTextureCache& DecodedTextureCache::GetInstance()
+{
+	static DecodedTextureCache instance;
+	return instance;
+}
+
+std::size_t DecodedTextureCache::GetBudget() const
+{
+	const std::lock_guard lock{ _mutex };
+	return _budget;
+}
+
+void DecodedTextureCache::SetBudget(std::size_t budget)
+{
+	const std::lock_guard lock{ _mutex };
+	_budget = budget;
+	Evict(_budget);
+}
+
+std::shared_ptr<const DecodedTexture> DecodedTextureCache::Get(std::uint64_t key, std::uint32_t width, std::uint32_t height,
+	const DecodeFunction& decode)
+{
+	{
+		const std::lock_guard lock{ _mutex };
+
+		if (const auto it = _lookup.find(key); it != _lookup.end())
+		{
+			++_hitCount;
+			_entries.splice(_entries.begin(), _entries, it->second);
+			return it->second->Texture;
+		}
+
+		++_missCount;
+	}
+
+	auto texture = std::make_shared<DecodedTexture>();
+
+	texture->Width = width;
+	texture->Height = height;
+	texture->Pixels.resize(static_cast<std::size_t>(width) * height * 4);
+
+	decode(texture->Pixels);
+
+	const std::size_t size = texture->Pixels.size();
+
+	const std::lock_guard lock{ _mutex };
+
+	// Another thread decoded it first.
+	if (const auto it = _lookup.find(key); it != _lookup.end())
+	{
+		return it->second->Texture;
+	}
+
+	// Still returned if it doesn't fit, it just isn't kept.
+	if (size > _budget)
+	{
+		return texture;
+	}
+
+	Evict(_budget - size);
+
+	_entries.push_front({ key, texture });
+	_lookup.emplace(key, _entries.begin());
+
+	_residentBytes += size;
+
+	return texture;
+}
+
+std::shared_ptr<const DecodedTexture> DecodedTextureCache::GetIndexed(std::uint32_t width, std::uint32_t height,
+	std::span<const std::uint8_t> indexes, const PaletteHandle& palette)
+{
+	return Get(HashIndexedImage(width, height, indexes, palette), width, height, [&](std::span<std::uint8_t> pixels)
+		{
+			DecodeIndexedImage(indexes, palette, pixels);
+		});
+}
+
+void DecodedTextureCache::Clear()
+{
+	const std::lock_guard lock{ _mutex };
+
+	_lookup.clear();
+	_entries.clear();
+	_residentBytes = 0;
+}
+
+std::size_t DecodedTextureCache::GetCount() const
+{
+	const std::lock_guard lock{ _mutex };
+	return _entries.size();
+}
+
+std::size_t DecodedTextureCache::GetResidentBytes() const
+{
+	const std::lock_guard lock{ _mutex };
+	return _residentBytes;
+}
+
+std::uint64_t DecodedTextureCache::GetHitCount() const
+{
+	const std::lock_guard lock{ _mutex };
+	return _hitCount;
+}
+
+std::uint64_t DecodedTextureCache::GetMissCount() const
+{
+	const std::lock_guard lock{ _mutex };
+	return _missCount;
+}
+
+void DecodedTextureCache::Evict(std::size_t budget)
+{
+	while (!_entries.empty() && _residentBytes > budget)
+	{
+		const auto& entry = _entries.back();
+
+		_residentBytes -= entry.Texture->Pixels.size();
+		_lookup.erase(entry.Key);
+		_entries.pop_back();
+	}
+}
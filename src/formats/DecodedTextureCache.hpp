@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "formats/Palette.hpp"
+
+/**
+*	@brief An image converted to 8 bit RGBA, ready to be shown or uploaded.
+*/
+struct DecodedTexture
+{
+	std::uint32_t Width{ 0 };
+	std::uint32_t Height{ 0 };
+
+	/**
+	*	@brief Rows are tightly packed, 4 bytes per pixel.
+	*/
+	std::vector<std::uint8_t> Pixels;
+};
+
+/**
+*	@brief Converts an image that uses a palette to RGBA. Every pixel is opaque, and black if there is no palette.
+*	@param pixels Must have room for 4 bytes per index.
+*/
+void DecodeIndexedImage(std::span<const std::uint8_t> indexes, const PaletteHandle& palette, std::span<std::uint8_t> pixels);
+
+/**
+*	@brief Least recently used cache of decoded textures shared by every window and thread in the process.
+*	@details Textures are keyed by a hash of their contents, usually HashIndexedImage, so a texture that appears in a map
+*	and in a wad is only decoded once. Textures evicted from the cache remain valid for as long as they are referenced.
+*	Thread safe, thumbnails are created on worker threads.
+*/
+class DecodedTextureCache final
+{
+public:
+	static constexpr std::size_t DefaultBudget = 128 * 1024 * 1024;
+
+	/**
+	*	@brief Writes the RGBA pixels of the texture.
+	*/
+	using DecodeFunction = std::function<void(std::span<std::uint8_t> pixels)>;
+
+	explicit DecodedTextureCache(std::size_t budget = DefaultBudget);
+	~DecodedTextureCache();
+
+	DecodedTextureCache(const DecodedTextureCache&) = delete;
+	DecodedTextureCache& operator=(const DecodedTextureCache&) = delete;
+
+	/**
+	*	@brief Gets the cache shared by all windows.
+	*/
+	static DecodedTextureCache& GetInstance();
+
+	std::size_t GetBudget() const;
+
+	/**
+	*	@brief Sets the maximum number of bytes used by decoded textures in the cache. Evicts textures if needed.
+	*/
+	void SetBudget(std::size_t budget);
+
+	/**
+	*	@brief Gets the texture with the given key, decoding it with @p decode if it isn't cached.
+	*	@details Decoding happens without holding the lock, so the same texture may be decoded by two threads at once.
+	*	Only one of the results is kept in that case.
+	*/
+	std::shared_ptr<const DecodedTexture> Get(std::uint64_t key, std::uint32_t width, std::uint32_t height,
+		const DecodeFunction& decode);
+
+	/**
+	*	@brief Gets an image that uses a palette, keyed by HashIndexedImage.
+	*/
+	std::shared_ptr<const DecodedTexture> GetIndexed(std::uint32_t width, std::uint32_t height,
+		std::span<const std::uint8_t> indexes, const PaletteHandle& palette);
+
+	void Clear();
+
+	std::size_t GetCount() const;
+
+	std::size_t GetResidentBytes() const;
+
+	std::uint64_t GetHitCount() const;
+	std::uint64_t GetMissCount() const;
+
+private:
+	struct Entry
+	{
+		std::uint64_t Key{ 0 };
+		std::shared_ptr<const DecodedTexture> Texture;
+	};
+
+	/**
+	*	@brief Must be called with the lock held.
+	*/
+	void Evict(std::size_t budget);
+
+private:
+	mutable std::mutex _mutex;
+
+	std::size_t _budget;
+	std::size_t _residentBytes{ 0 };
+
+	std::uint64_t _hitCount{ 0 };
+	std::uint64_t _missCount{ 0 };
+
+	// Most recently used first.
+	std::list<Entry> _entries;
+	std::unordered_map<std::uint64_t, std::list<Entry>::iterator> _lookup;
+};
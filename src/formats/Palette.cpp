@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstring>
+
+#include "formats/Palette.hpp"
+#include "utils/Hash.hpp"
+#include "utils/MemoryUsage.hpp"
+
+Palette::Palette(std::span<const RGB24, ColormapColorCount> colors, std::uint64_t hash)
+	: _hash(hash)
+{
+	std::copy(colors.begin(), colors.end(), _colors.begin());
+
+	for (std::size_t i = 0; i < ColormapColorCount; ++i)
+	{
+		_argbTable[i] = 0xFF000000U | (std::uint32_t{ colors[i].R } << 16) | (std::uint32_t{ colors[i].G } << 8) | colors[i].B;
+	}
+}
+
+void AddMemoryUsage(MemoryUsage& usage, const PaletteHandle& palette)
+{
+	if (const auto instance = palette.Get(); instance)
+	{
+		usage.AddShared(MemoryCategory::Palettes, instance, sizeof(Palette));
+	}
+}
+
+std::uint64_t HashIndexedImage(std::uint32_t width, std::uint32_t height, std::span<const std::uint8_t> pixels,
+	const PaletteHandle& palette)
+{
+	const std::uint32_t dimensions[] = { width, height };
+
+	std::uint64_t hash = HashBytes(std::as_bytes(std::span{ dimensions }));
+	hash = HashBytes(std::as_bytes(pixels), hash);
+
+	// Palettes are hashed when they are interned.
+	if (const auto instance = palette.Get(); instance)
+	{
+		hash = MixHash(hash ^ instance->GetHash());
+	}
+
+	return hash;
+}
+
+PalettePool& PalettePool::GetInstance()
+{
+	static PalettePool instance;
+	return instance;
+}
+
+PaletteHandle PalettePool::Intern(std::span<const RGB24, ColormapColorCount> colors)
+{
+	const auto bytes = std::as_bytes(colors);
+	const std::uint64_t hash = HashBytes(bytes);
+
+	const std::lock_guard lock{ _mutex };
+
+	const auto [first, last] = _palettes.equal_range(hash);
+
+	auto expired = last;
+
+	for (auto it = first; it != last; ++it)
+	{
+		if (auto palette = it->second.lock(); palette)
+		{
+			if (std::memcmp(palette->GetColors().data(), bytes.data(), bytes.size()) == 0)
+			{
+				return PaletteHandle{ std::move(palette) };
+			}
+		}
+		else
+		{
+			expired = it;
+		}
+	}
+
+	auto palette = std::make_shared<const Palette>(colors, hash);
+
+	// Reloading an asset recreates its palettes, so reuse their old entries instead of piling up expired ones.
+	if (expired != last)
+	{
+		expired->second = palette;
+		return PaletteHandle{ std::move(palette) };
+	}
+
+	_palettes.emplace(hash, palette);
+
+	if (_palettes.size() >= _cleanupSize)
+	{
+		RemoveExpired();
+		_cleanupSize = std::max(MinimumCleanupSize, _palettes.size() * 2);
+	}
+
+	return PaletteHandle{ std::move(palette) };
+}
+
+std::size_t PalettePool::GetCount() const
+{
+	const std::lock_guard lock{ _mutex };
+	return _palettes.size();
+}
+
+void PalettePool::RemoveExpired()
+{
+	std::erase_if(_palettes, [](const auto& entry)
+		{
+			return entry.second.expired();
+		});
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+class MemoryUsage;
+
+/**
+*	@brief Number of colors in the palettes used by all formats.
+*/
+constexpr std::size_t ColormapColorCount = 256;
+
+struct RGB24
+{
+	std::uint8_t R;
+	std::uint8_t G;
+	std::uint8_t B;
+};
+
+static_assert(sizeof(RGB24) == 3, "Palettes are hashed and compared as bytes");
+
+/**
+*	@brief An immutable palette, shared by every texture and sprite that uses the same colors.
+*	@details Palettes are created by PalettePool, which makes sure each distinct palette exists only once.
+*/
+class Palette final
+{
+public:
+	Palette(std::span<const RGB24, ColormapColorCount> colors, std::uint64_t hash);
+
+	Palette(const Palette&) = delete;
+	Palette& operator=(const Palette&) = delete;
+
+	std::span<const RGB24, ColormapColorCount> GetColors() const { return _colors; }
+
+	std::uint64_t GetHash() const { return _hash; }
+
+	/**
+	*	@brief Gets the colors as opaque 0xAARRGGBB values, the layout Qt uses for color tables.
+	*/
+	std::span<const std::uint32_t, ColormapColorCount> GetArgbTable() const { return _argbTable; }
+
+private:
+	const std::uint64_t _hash;
+	std::array<RGB24, ColormapColorCount> _colors;
+	std::array<std::uint32_t, ColormapColorCount> _argbTable;
+};
+
+/**
+*	@brief Shared reference to an interned palette, or no palette at all.
+*	@details Has the same interface as the color vectors it replaces, so colors can be accessed and iterated directly.
+*/
+class PaletteHandle final
+{
+public:
+	PaletteHandle() = default;
+
+	explicit PaletteHandle(std::shared_ptr<const Palette> palette)
+		: _palette(std::move(palette))
+	{
+	}
+
+	const Palette* Get() const { return _palette.get(); }
+
+	bool empty() const { return !_palette; }
+	std::size_t size() const { return _palette ? ColormapColorCount : 0; }
+
+	const RGB24* data() const { return _palette ? _palette->GetColors().data() : nullptr; }
+	const RGB24* begin() const { return data(); }
+	const RGB24* end() const { return data() + size(); }
+
+	const RGB24& operator[](std::size_t index) const { return _palette->GetColors()[index]; }
+
+	/**
+	*	@brief Gets the colors as opaque 0xAARRGGBB values. Empty if there is no palette.
+	*/
+	std::span<const std::uint32_t> GetArgbTable() const
+	{
+		return _palette ? std::span<const std::uint32_t>{ _palette->GetArgbTable() } : std::span<const std::uint32_t>{};
+	}
+
+	/**
+	*	@brief Palettes are interned, so handles to the same colors always refer to the same palette.
+	*/
+	bool operator==(const PaletteHandle& other) const { return _palette == other._palette; }
+
+private:
+	std::shared_ptr<const Palette> _palette;
+};
+
+/**
+*	@brief Adds the palette to @p usage. The palette is shared, so it is only counted once per usage.
+*/
+void AddMemoryUsage(MemoryUsage& usage, const PaletteHandle& palette);
+
+/**
+*	@brief Hashes the size, pixels and palette of an image that uses a palette.
+*	@details Images with the same contents get the same hash no matter which asset they are in,
+*	so it can be used to find the same texture in a map and a wad.
+*/
+std::uint64_t HashIndexedImage(std::uint32_t width, std::uint32_t height, std::span<const std::uint8_t> pixels,
+	const PaletteHandle& palette);
+
+/**
+*	@brief Deduplicates palettes so assets that use the same colors share a single copy.
+*	@details Most textures in a wad use one of a handful of palettes, so palettes are interned when assets are loaded.
+*	The pool only keeps weak references, palettes are destroyed once no asset uses them anymore.
+*	Thread safe, assets are loaded on worker threads.
+*/
+class PalettePool final
+{
+public:
+	PalettePool() = default;
+
+	PalettePool(const PalettePool&) = delete;
+	PalettePool& operator=(const PalettePool&) = delete;
+
+	/**
+	*	@brief Gets the pool shared by all loaders in the process.
+	*/
+	static PalettePool& GetInstance();
+
+	/**
+	*	@brief Gets the palette with the given colors, creating it if no asset currently uses these colors.
+	*/
+	PaletteHandle Intern(std::span<const RGB24, ColormapColorCount> colors);
+
+	/**
+	*	@brief Gets the number of palettes in the pool, including ones that are about to be removed.
+	*/
+	std::size_t GetCount() const;
+
+private:
+	void RemoveExpired();
+
+private:
+	/**
+	*	@brief Expired entries are removed when the pool has grown to this size.
+	*/
+	static constexpr std::size_t MinimumCleanupSize = 64;
+
+	mutable std::mutex _mutex;
+	std::unordered_multimap<std::uint64_t, std::weak_ptr<const Palette>> _palettes;
+	std::size_t _cleanupSize{ MinimumCleanupSize };
+};
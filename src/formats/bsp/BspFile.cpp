@@ -2,6 +2,8 @@
 #include <array>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <memory_resource>
 #include <span>
 #include <utility>
 #include <vector>
@@ -9,35 +11,7 @@
 #include "formats/bsp/BspFile.hpp"
 #include "utils/BinaryReader.hpp"
 #include "utils/IOutils.hpp"
-
-constexpr int BspVersion = 30;
-
-constexpr int BspLumpCount = 15;
-
-constexpr int BspFaceSize = 20;
-constexpr int BspModelSize = 64;
-
-namespace BspLumpId
-{
-enum BspLumpId : std::size_t
-{
-	Entities = 0,
-	Planes = 1,
-	Textures = 2,
-	Vertexes = 3,
-	Visibility = 4,
-	Nodes = 5,
-	TexInfo = 6,
-	Faces = 7,
-	Lighting = 8,
-	Clipnodes = 9,
-	Leafs = 10,
-	MarkSurfaces = 11,
-	Edges = 12,
-	SurfEdges = 13,
-	Models = 14,
-};
-}
+#include "utils/LoadProgress.hpp"
 
 struct BspLump
 {
@@ -50,11 +24,33 @@ struct Edge
 	std::uint16_t VertexIndexes[2];
 };
 
-static std::optional<std::string> TryLoadEntities(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps)
+/**
+*	@brief Reports progress and checks for cancellation.
+*	@return Whether loading should continue.
+*/
+static bool UpdateProgress(LoadProgress* progress, float value)
+{
+	if (!progress)
+	{
+		return true;
+	}
+
+	if (progress->IsCancelled())
+	{
+		return false;
+	}
+
+	progress->SetProgress(value);
+
+	return true;
+}
+
+static std::optional<std::pmr::string> TryLoadEntities(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps,
+	std::pmr::memory_resource* resource)
 {
 	const auto& lump = lumps[BspLumpId::Entities];
 
-	std::string entities;
+	std::pmr::string entities{ resource };
 
 	entities.resize(std::max(0, lump.SizeInBytes - 1));
 
@@ -64,7 +60,8 @@ static std::optional<std::string> TryLoadEntities(BinaryReader& reader, const st
 	return entities;
 }
 
-static std::optional<std::vector<BspTexture>> TryLoadTextures(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps)
+static std::optional<std::pmr::vector<BspTexture>> TryLoadTextures(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps,
+	std::pmr::memory_resource* resource)
 {
 	// TODO: this can probably reuse the wad loading code.
 	const auto& lump = lumps[BspLumpId::Textures];
@@ -78,7 +75,7 @@ static std::optional<std::vector<BspTexture>> TryLoadTextures(BinaryReader& read
 		return {};
 	}
 
-	std::vector<BspTexture> textures;
+	std::pmr::vector<BspTexture> textures{ resource };
 
 	textures.resize(textureCount);
 
@@ -99,7 +96,7 @@ static std::optional<std::vector<BspTexture>> TryLoadTextures(BinaryReader& read
 
 		reader.SetPosition(textureOffset);
 
-		texture.Name = reader.ReadFixedUTF8String(16);
+		texture.Name = reader.ReadFixedUTF8String(16, resource);
 
 		texture.Width = reader.ReadUInt32();
 		texture.Height = reader.ReadUInt32();
@@ -132,14 +129,16 @@ static std::optional<std::vector<BspTexture>> TryLoadTextures(BinaryReader& read
 
 			reader.SetPosition(textureOffset + mipLevelOffsets[0] + ((static_cast<std::size_t>(texture.Width) * texture.Height) / static_cast<std::size_t>(64) * 85) + 2);
 
-			texture.Colormap.resize(ColormapColorCount);
+			std::array<RGB24, ColormapColorCount> colormap;
 
-			for (std::size_t i = 0; i < ColormapColorCount; ++i)
+			for (auto& color : colormap)
 			{
-				texture.Colormap[i].R = reader.ReadUInt8();
-				texture.Colormap[i].G = reader.ReadUInt8();
-				texture.Colormap[i].B = reader.ReadUInt8();
+				color.R = reader.ReadUInt8();
+				color.G = reader.ReadUInt8();
+				color.B = reader.ReadUInt8();
 			}
+
+			texture.Colormap = PalettePool::GetInstance().Intern(colormap);
 		}
 
 		++i;
@@ -148,14 +147,14 @@ static std::optional<std::vector<BspTexture>> TryLoadTextures(BinaryReader& read
 	return textures;
 }
 
-static std::optional<std::vector<BspTextureInfo>> TryLoadTextureInfos(
-	BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps, const std::vector<BspTexture>& textures)
+static std::optional<std::pmr::vector<BspTextureInfo>> TryLoadTextureInfos(BinaryReader& reader,
+	const std::array<BspLump, BspLumpCount>& lumps, std::span<const BspTexture> textures, std::pmr::memory_resource* resource)
 {
 	const auto& lump = lumps[BspLumpId::TexInfo];
 
 	reader.SetPosition(lump.Offset);
 
-	std::vector<BspTextureInfo> textureInfos;
+	std::pmr::vector<BspTextureInfo> textureInfos{ resource };
 
 	textureInfos.resize(lump.SizeInBytes / 40);
 
@@ -184,13 +183,14 @@ static std::optional<std::vector<BspTextureInfo>> TryLoadTextureInfos(
 	return textureInfos;
 }
 
-static std::vector<glm::vec3> LoadVertexes(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps)
+static std::pmr::vector<glm::vec3> LoadVertexes(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps,
+	std::pmr::memory_resource* resource)
 {
 	const auto& lump = lumps[BspLumpId::Vertexes];
 
 	reader.SetPosition(lump.Offset);
 
-	std::vector<glm::vec3> vertexes;
+	std::pmr::vector<glm::vec3> vertexes{ resource };
 
 	vertexes.resize(lump.SizeInBytes / (sizeof(float) * 3));
 
@@ -204,13 +204,14 @@ static std::vector<glm::vec3> LoadVertexes(BinaryReader& reader, const std::arra
 	return vertexes;
 }
 
-static std::vector<Edge> LoadEdges(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps)
+static std::pmr::vector<Edge> LoadEdges(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps,
+	std::pmr::memory_resource* resource)
 {
 	const auto& lump = lumps[BspLumpId::Edges];
 
 	reader.SetPosition(lump.Offset);
 
-	std::vector<Edge> edges;
+	std::pmr::vector<Edge> edges{ resource };
 
 	edges.resize(lump.SizeInBytes / (sizeof(std::uint16_t) * 2));
 
@@ -223,13 +224,14 @@ static std::vector<Edge> LoadEdges(BinaryReader& reader, const std::array<BspLum
 	return edges;
 }
 
-static std::vector<int> LoadSurfEdges(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps)
+static std::pmr::vector<int> LoadSurfEdges(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps,
+	std::pmr::memory_resource* resource)
 {
 	const auto& lump = lumps[BspLumpId::SurfEdges];
 
 	reader.SetPosition(lump.Offset);
 
-	std::vector<int> surfEdges;
+	std::pmr::vector<int> surfEdges{ resource };
 
 	surfEdges.resize(lump.SizeInBytes / sizeof(std::int32_t));
 
@@ -238,23 +240,46 @@ static std::vector<int> LoadSurfEdges(BinaryReader& reader, const std::array<Bsp
 	return surfEdges;
 }
 
-static std::optional<std::vector<Face>> TryLoadFaces(
-	BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps, const std::vector<BspTextureInfo>& textureInfos)
+// Faces make up the bulk of the work so they get most of the progress range.
+constexpr float FacesProgressStart = 0.3f;
+constexpr float FacesProgressEnd = 0.9f;
+
+// How many faces to load before checking for cancellation again.
+constexpr std::size_t FacesPerProgressUpdate = 4096;
+
+/**
+*	@param scratch Resource for the vertexes and edges, which are only needed until each face has its own copy of its vertexes.
+*/
+static std::optional<std::pmr::vector<Face>> TryLoadFaces(BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps,
+	std::span<const BspTextureInfo> textureInfos, LoadProgress* progress,
+	std::pmr::memory_resource* resource, std::pmr::memory_resource* scratch)
 {
-	const auto vertexes = LoadVertexes(reader, lumps);
-	const auto edges = LoadEdges(reader, lumps);
-	const auto surfEdges = LoadSurfEdges(reader, lumps);
+	const auto vertexes = LoadVertexes(reader, lumps, scratch);
+	const auto edges = LoadEdges(reader, lumps, scratch);
+	const auto surfEdges = LoadSurfEdges(reader, lumps, scratch);
 
 	const auto& lump = lumps[BspLumpId::Faces];
 
 	reader.SetPosition(lump.Offset);
 
-	std::vector<Face> faces;
+	std::pmr::vector<Face> faces{ resource };
 
 	faces.resize(lump.SizeInBytes / BspFaceSize);
 
-	for (auto& face : faces)
+	for (std::size_t faceIndex = 0; auto& face : faces)
 	{
+		if ((faceIndex % FacesPerProgressUpdate) == 0)
+		{
+			const float fraction = static_cast<float>(faceIndex) / faces.size();
+
+			if (!UpdateProgress(progress, FacesProgressStart + (fraction * (FacesProgressEnd - FacesProgressStart))))
+			{
+				return {};
+			}
+		}
+
+		++faceIndex;
+
 		const std::int16_t planeNumber = reader.ReadInt16();
 		const std::int16_t side = reader.ReadInt16();
 		
@@ -328,14 +353,14 @@ typedef struct
 } dmodel_t;
 */
 
-static std::optional<std::vector<BspModel>> TryLoadModels(
-	BinaryReader& reader, const std::array<BspLump, BspLumpCount>& lumps, const std::vector<Face>& faces)
+static std::optional<std::pmr::vector<BspModel>> TryLoadModels(BinaryReader& reader,
+	const std::array<BspLump, BspLumpCount>& lumps, std::span<const Face> faces, std::pmr::memory_resource* resource)
 {
 	const auto& lump = lumps[BspLumpId::Models];
 
 	reader.SetPosition(lump.Offset);
 
-	std::vector<BspModel> models;
+	std::pmr::vector<BspModel> models{ resource };
 
 	models.resize(lump.SizeInBytes / BspModelSize);
 
@@ -381,6 +406,107 @@ static std::optional<std::vector<BspModel>> TryLoadModels(
 	return models;
 }
 
+MemoryUsage GetMemoryUsage(const BspFile& bspFile)
+{
+	MemoryUsage usage;
+
+	usage.Add(MemoryCategory::EntityText, bspFile.Entities);
+
+	usage.Add(MemoryCategory::Other, bspFile.Textures);
+
+	for (const auto& texture : bspFile.Textures)
+	{
+		usage.Add(MemoryCategory::Other, texture.Name);
+
+		for (const auto& data : texture.TextureDatas)
+		{
+			usage.Add(MemoryCategory::Textures, data);
+		}
+
+		AddMemoryUsage(usage, texture.Colormap);
+	}
+
+	usage.Add(MemoryCategory::Geometry, bspFile.TextureInfos);
+	usage.Add(MemoryCategory::Geometry, bspFile.Faces);
+
+	for (const auto& face : bspFile.Faces)
+	{
+		usage.Add(MemoryCategory::Geometry, face.Vertexes);
+	}
+
+	usage.Add(MemoryCategory::Geometry, bspFile.Models);
+
+	return usage;
+}
+
+std::optional<BspInfo> TryReadBspInfo(FILE* file)
+{
+	std::array<std::byte, BspHeaderSize> header;
+
+	if (!TryReadFileRange(file, 0, header))
+	{
+		return {};
+	}
+
+	BinaryReader reader{ header };
+
+	if (reader.ReadInt32() != BspVersion)
+	{
+		return {};
+	}
+
+	std::array<BspLump, BspLumpCount> lumps{};
+
+	for (auto& lump : lumps)
+	{
+		lump.Offset = reader.ReadInt32();
+		lump.SizeInBytes = reader.ReadInt32();
+
+		if (lump.Offset < 0 || lump.SizeInBytes < 0)
+		{
+			return {};
+		}
+	}
+
+	BspInfo info;
+
+	info.FaceCount = lumps[BspLumpId::Faces].SizeInBytes / BspFaceSize;
+
+	if (const auto& lump = lumps[BspLumpId::Textures]; lump.SizeInBytes >= 4)
+	{
+		std::array<std::byte, 4> textureCount;
+
+		if (!TryReadFileRange(file, lump.Offset, textureCount))
+		{
+			return {};
+		}
+
+		info.TextureCount = BinaryReader{ textureCount }.ReadInt32();
+	}
+
+	if (const auto& lump = lumps[BspLumpId::Models]; lump.SizeInBytes >= BspModelSize)
+	{
+		std::array<std::byte, sizeof(float) * 6> bounds;
+
+		if (!TryReadFileRange(file, lump.Offset, bounds))
+		{
+			return {};
+		}
+
+		BinaryReader boundsReader{ bounds };
+
+		info.Mins.x = boundsReader.ReadFloat();
+		info.Mins.y = boundsReader.ReadFloat();
+		info.Mins.z = boundsReader.ReadFloat();
+
+		info.Maxs.x = boundsReader.ReadFloat();
+		info.Maxs.y = boundsReader.ReadFloat();
+		info.Maxs.z = boundsReader.ReadFloat();
+	}
+
+	return info;
+}
+
 std::optional<BspFile> TryLoadBspFile(const std::string& fileName)
 {
 	FILE* file = std::fopen(fileName.c_str(), "rb");
@@ -397,9 +523,11 @@ std::optional<BspFile> TryLoadBspFile(const std::string& fileName)
 	return result;
 }
 
-std::optional<BspFile> TryLoadBspFile(FILE* file)
+std::optional<BspFile> TryLoadBspFile(FILE* file, LoadProgress* progress)
 {
-	std::optional<std::vector<std::byte>> buffer = TryReadFileIntoBuffer(file);
+	const ScratchArena::Scope scratch;
+
+	const auto buffer = TryReadFileIntoBuffer(file, scratch.GetResource());
 
 	if (!buffer)
 	{
@@ -429,43 +557,61 @@ std::optional<BspFile> TryLoadBspFile(FILE* file)
 		}
 	}
 
-	BspFile bsp;
+	BspFile bsp{ std::make_unique<AssetArena>() };
 
-	auto entities = TryLoadEntities(reader, lumps);
+	const auto resource = bsp.Arena->GetResource();
+
+	auto entities = TryLoadEntities(reader, lumps, resource);
 
 	if (!entities)
 	{
 		return {};
 	}
 
-	auto textures = TryLoadTextures(reader, lumps);
+	if (!UpdateProgress(progress, 0.1f))
+	{
+		return {};
+	}
+
+	auto textures = TryLoadTextures(reader, lumps, resource);
 
 	if (!textures)
 	{
 		return {};
 	}
 
-	auto textureInfos = TryLoadTextureInfos(reader, lumps, *textures);
+	if (!UpdateProgress(progress, 0.25f))
+	{
+		return {};
+	}
+
+	auto textureInfos = TryLoadTextureInfos(reader, lumps, *textures, resource);
 
 	if (!textureInfos)
 	{
 		return {};
 	}
 
-	auto faces = TryLoadFaces(reader, lumps, *textureInfos);
+	auto faces = TryLoadFaces(reader, lumps, *textureInfos, progress, resource, scratch.GetResource());
 
 	if (!faces)
 	{
 		return {};
 	}
 
-	auto models = TryLoadModels(reader, lumps, *faces);
+	if (!UpdateProgress(progress, FacesProgressEnd))
+	{
+		return {};
+	}
+
+	auto models = TryLoadModels(reader, lumps, *faces, resource);
 
 	if (!models)
 	{
 		return {};
 	}
 
+	// Everything was allocated from the map's arena, so these take over the memory without copying.
 	bsp.Entities = std::move(*entities);
 	bsp.Textures = std::move(*textures);
 	bsp.TextureInfos = std::move(*textureInfos);
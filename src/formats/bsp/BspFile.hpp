@@ -0,0 +1,244 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "formats/Palette.hpp"
+#include "utils/Arena.hpp"
+#include "utils/MemoryUsage.hpp"
+
+class LoadProgress;
+
+constexpr int BspVersion = 30;
+
+constexpr int BspLumpCount = 15;
+
+constexpr int BspHeaderSize = 4 + (BspLumpCount * 8);
+constexpr int BspFaceSize = 20;
+constexpr int BspModelSize = 64;
+
+namespace BspLumpId
+{
+enum BspLumpId : std::size_t
+{
+	Entities = 0,
+	Planes = 1,
+	Textures = 2,
+	Vertexes = 3,
+	Visibility = 4,
+	Nodes = 5,
+	TexInfo = 6,
+	Faces = 7,
+	Lighting = 8,
+	Clipnodes = 9,
+	Leafs = 10,
+	MarkSurfaces = 11,
+	Edges = 12,
+	SurfEdges = 13,
+	Models = 14,
+};
+}
+
+constexpr std::size_t BspMipLevelCount = 4;
+constexpr std::size_t BspTextureInfoDataCount = 2;
+constexpr std::size_t BspHullCount = 4;
+
+static_assert(BspMipLevelCount == 4, "BspTexture's constructors initialize each mip level");
+
+struct BspTexture
+{
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+
+	BspTexture() = default;
+
+	explicit BspTexture(const allocator_type& allocator)
+		: Name(allocator)
+		, TextureDatas{ std::pmr::vector<std::uint8_t>{ allocator }, std::pmr::vector<std::uint8_t>{ allocator },
+			std::pmr::vector<std::uint8_t>{ allocator }, std::pmr::vector<std::uint8_t>{ allocator } }
+	{
+	}
+
+	BspTexture(const BspTexture& other, const allocator_type& allocator)
+		: Name(other.Name, allocator)
+		, Width(other.Width)
+		, Height(other.Height)
+		, TextureDatas{ std::pmr::vector<std::uint8_t>{ other.TextureDatas[0], allocator },
+			std::pmr::vector<std::uint8_t>{ other.TextureDatas[1], allocator },
+			std::pmr::vector<std::uint8_t>{ other.TextureDatas[2], allocator },
+			std::pmr::vector<std::uint8_t>{ other.TextureDatas[3], allocator } }
+		, Colormap(other.Colormap)
+	{
+	}
+
+	BspTexture(BspTexture&& other, const allocator_type& allocator)
+		: Name(std::move(other.Name), allocator)
+		, Width(other.Width)
+		, Height(other.Height)
+		, TextureDatas{ std::pmr::vector<std::uint8_t>{ std::move(other.TextureDatas[0]), allocator },
+			std::pmr::vector<std::uint8_t>{ std::move(other.TextureDatas[1]), allocator },
+			std::pmr::vector<std::uint8_t>{ std::move(other.TextureDatas[2]), allocator },
+			std::pmr::vector<std::uint8_t>{ std::move(other.TextureDatas[3]), allocator } }
+		, Colormap(std::move(other.Colormap))
+	{
+	}
+
+	BspTexture(const BspTexture&) = default;
+	BspTexture(BspTexture&&) noexcept = default;
+	BspTexture& operator=(const BspTexture&) = default;
+	BspTexture& operator=(BspTexture&&) = default;
+
+	std::pmr::string Name;
+	unsigned int Width{ 0 };
+	unsigned int Height{ 0 };
+	std::array<std::pmr::vector<std::uint8_t>, BspMipLevelCount> TextureDatas;
+
+	/**
+	*	@brief Interned, shared with other textures that have the same colors. Empty if the texture isn't embedded in the map.
+	*/
+	PaletteHandle Colormap;
+};
+
+struct BspTextureInfo
+{
+	std::array<float, BspTextureInfoDataCount> STCoordinates{};
+	std::array<glm::vec3, BspTextureInfoDataCount> Vertices{};
+
+	const BspTexture* Texture{};
+
+	int Flags{ 0 };
+};
+
+struct Face
+{
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+
+	Face() = default;
+
+	explicit Face(const allocator_type& allocator)
+		: Vertexes(allocator)
+	{
+	}
+
+	Face(const Face& other, const allocator_type& allocator)
+		: Vertexes(other.Vertexes, allocator)
+		, TextureInfo(other.TextureInfo)
+	{
+	}
+
+	Face(Face&& other, const allocator_type& allocator)
+		: Vertexes(std::move(other.Vertexes), allocator)
+		, TextureInfo(other.TextureInfo)
+	{
+	}
+
+	Face(const Face&) = default;
+	Face(Face&&) noexcept = default;
+	Face& operator=(const Face&) = default;
+	Face& operator=(Face&&) = default;
+
+	std::pmr::vector<glm::vec3> Vertexes;
+
+	const BspTextureInfo* TextureInfo{};
+};
+
+struct BspModel
+{
+	glm::vec3 Mins{ 0 };
+	glm::vec3 Maxs{ 0 };
+	glm::vec3 Origin{ 0 };
+
+	std::span<const Face> Faces;
+};
+
+/**
+*	@brief A loaded map. Everything it contains is allocated from its arena, so destroying it is a single release.
+*	@details Faces and models refer to other parts of the map by pointer, so maps can be moved but not copied.
+*/
+class BspFile
+{
+public:
+	/**
+	*	@brief Creates an empty map that uses the default memory resource.
+	*/
+	BspFile() = default;
+
+	explicit BspFile(std::unique_ptr<AssetArena> arena)
+		: Arena(std::move(arena))
+		, Entities(Arena->GetResource())
+		, Textures(Arena->GetResource())
+		, TextureInfos(Arena->GetResource())
+		, Faces(Arena->GetResource())
+		, Models(Arena->GetResource())
+	{
+	}
+
+	BspFile(BspFile&&) noexcept = default;
+
+	/**
+	*	@brief Takes over the other map's arena along with its contents.
+	*	@details Containers only exchange their memory if they use the same resource, so the map is rebuilt in place instead.
+	*/
+	BspFile& operator=(BspFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			std::destroy_at(this);
+			std::construct_at(this, std::move(other));
+		}
+
+		return *this;
+	}
+
+	BspFile(const BspFile&) = delete;
+	BspFile& operator=(const BspFile&) = delete;
+
+	/**
+	*	@brief Declared first so it outlives the containers allocated from it. Null if the map uses the default memory resource.
+	*/
+	std::unique_ptr<AssetArena> Arena;
+
+	std::pmr::string Entities;
+	std::pmr::vector<BspTexture> Textures;
+	std::pmr::vector<BspTextureInfo> TextureInfos;
+	std::pmr::vector<Face> Faces;
+	std::pmr::vector<BspModel> Models;
+};
+
+/**
+*	@brief Gets the memory owned by the map. Texture infos and models count as geometry.
+*/
+MemoryUsage GetMemoryUsage(const BspFile& bspFile);
+
+/**
+*	@brief Summary of a map that can be read without loading the entire file.
+*/
+struct BspInfo
+{
+	int TextureCount{ 0 };
+	int FaceCount{ 0 };
+
+	// Bounds of the world model.
+	glm::vec3 Mins{ 0 };
+	glm::vec3 Maxs{ 0 };
+};
+
+/**
+*	@brief Reads only the header, texture count and world model bounds.
+*/
+std::optional<BspInfo> TryReadBspInfo(FILE* file);
+
+std::optional<BspFile> TryLoadBspFile(const std::string& fileName);
+/**
+*	@param progress If not null, receives load progress and is checked for cancellation requests.
+*/
+std::optional<BspFile> TryLoadBspFile(FILE* file, LoadProgress* progress = nullptr);
@@ -0,0 +1,701 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "formats/bsp/BspFile.hpp"
+#include "formats/bsp/BspGenerator.hpp"
+#include "formats/wad/WadGenerator.hpp"
+
+#include "utils/BinaryWriter.hpp"
+#include "utils/DeterministicRandom.hpp"
+#include "utils/IOutils.hpp"
+
+constexpr int GeneratedTileSize = 64;
+
+// Rows of tiles at the same height. Vertices are shared within a terrace, so this keeps the vertex count
+// below the 16 bit limit of edges even at the maximum face count.
+constexpr int GeneratedTerraceRows = 8;
+
+constexpr int GeneratedMaxHeight = 512;
+
+constexpr int LightmapSampleSize = 16;
+constexpr int LightmapSamplesPerAxis = (GeneratedTileSize / LightmapSampleSize) + 1;
+constexpr int LightmapSize = LightmapSamplesPerAxis * LightmapSamplesPerAxis * 3;
+
+constexpr int ContentsEmpty = -1;
+constexpr int ContentsSolid = -2;
+
+// Leaf 0 is the solid leaf shared by the entire map, child index -1 refers to it.
+constexpr int SolidLeafChild = -1;
+
+constexpr std::size_t MiptexHeaderSize = 40;
+
+struct GeneratedPlane
+{
+	int Axis{ 0 };
+	int Distance{ 0 };
+
+	auto operator<=>(const GeneratedPlane&) const = default;
+};
+
+struct GeneratedBounds
+{
+	std::array<int, 3> Mins{};
+	std::array<int, 3> Maxs{};
+};
+
+struct GeneratedNode
+{
+	int Plane{ 0 };
+
+	// Node index if positive, -(leaf index + 1) if negative, like in the file.
+	std::array<int, 2> Children{};
+
+	GeneratedBounds Bounds;
+	int FirstFace{ 0 };
+	int FaceCount{ 0 };
+};
+
+struct GeneratedLeaf
+{
+	int Contents{ ContentsEmpty };
+	GeneratedBounds Bounds;
+	int FirstMarkSurface{ 0 };
+	int MarkSurfaceCount{ 0 };
+};
+
+struct GeneratedFace
+{
+	int Plane{ 0 };
+	int TextureInfo{ 0 };
+	std::array<int, 3> Vertexes{};
+};
+
+/**
+*	@brief Builds the structures of the map in memory. Textures and lighting are generated while writing instead,
+*	since they make up most of the file.
+*/
+class BspBuilder final
+{
+public:
+	BspBuilder(const BspGeneratorSettings& settings, DeterministicRandom& random)
+		: _settings(settings)
+		, _random(random)
+	{
+		_tileCount = (settings.FaceCount + 1) / 2;
+		_columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(_tileCount)))));
+		_rows = (_tileCount + _columns - 1) / _columns;
+
+		_originX = -(_columns / 2) * GeneratedTileSize;
+		_originY = -(_rows / 2) * GeneratedTileSize;
+
+		// Limits the number of leaves to what the engine supports.
+		_tilesPerRegion = std::max(4, (_tileCount + 2047) / 2048);
+
+		const int terraceCount = (_rows + GeneratedTerraceRows - 1) / GeneratedTerraceRows;
+
+		for (int i = 0; i < terraceCount; ++i)
+		{
+			_heights.push_back(static_cast<int>(_random.NextInRange(0, GeneratedMaxHeight / 16)) * 16);
+		}
+	}
+
+	void Build()
+	{
+		_leaves.push_back({ ContentsSolid, {}, 0, 0 });
+
+		BuildNode(0, 0, _columns, _rows);
+	}
+
+	int GetVertexCount() const { return static_cast<int>(_heights.size()) * (GeneratedTerraceRows + 1) * (_columns + 1); }
+
+	std::array<int, 3> GetVertex(int index) const
+	{
+		const int perRow = _columns + 1;
+		const int perTerrace = (GeneratedTerraceRows + 1) * perRow;
+
+		const int terrace = index / perTerrace;
+		const int row = (terrace * GeneratedTerraceRows) + ((index % perTerrace) / perRow);
+		const int column = index % perRow;
+
+		return { _originX + (column * GeneratedTileSize), _originY + (row * GeneratedTileSize), _heights[terrace] };
+	}
+
+	GeneratedBounds GetWorldBounds() const
+	{
+		return GetBounds(0, 0, _columns, _rows);
+	}
+
+	const std::vector<GeneratedPlane>& GetPlanes() const { return _planes; }
+	const std::vector<GeneratedNode>& GetNodes() const { return _nodes; }
+	const std::vector<GeneratedLeaf>& GetLeaves() const { return _leaves; }
+	const std::vector<GeneratedFace>& GetFaces() const { return _faces; }
+
+private:
+	int GetVertexIndex(int column, int row, int terrace) const
+	{
+		return (terrace * (GeneratedTerraceRows + 1) * (_columns + 1))
+			+ ((row - (terrace * GeneratedTerraceRows)) * (_columns + 1))
+			+ column;
+	}
+
+	int GetTileCount(int x0, int y0, int x1, int y1) const
+	{
+		int count = 0;
+
+		for (int y = y0; y < y1; ++y)
+		{
+			count += std::clamp(_tileCount - (y * _columns) - x0, 0, x1 - x0);
+		}
+
+		return count;
+	}
+
+	GeneratedBounds GetBounds(int x0, int y0, int x1, int y1) const
+	{
+		const auto [minHeight, maxHeight] = std::minmax_element(
+			_heights.begin() + (y0 / GeneratedTerraceRows), _heights.begin() + ((y1 - 1) / GeneratedTerraceRows) + 1);
+
+		return {
+			{ _originX + (x0 * GeneratedTileSize), _originY + (y0 * GeneratedTileSize), *minHeight },
+			{ _originX + (x1 * GeneratedTileSize), _originY + (y1 * GeneratedTileSize), *maxHeight + GeneratedTileSize } };
+	}
+
+	int FindPlane(int axis, int distance)
+	{
+		const GeneratedPlane plane{ axis, distance };
+
+		if (const auto it = _planeIndexes.find(plane); it != _planeIndexes.end())
+		{
+			return it->second;
+		}
+
+		const int index = static_cast<int>(_planes.size());
+
+		_planes.push_back(plane);
+		_planeIndexes.emplace(plane, index);
+
+		return index;
+	}
+
+	int AddLeaf(const GeneratedBounds& bounds, int firstMarkSurface, int markSurfaceCount)
+	{
+		_leaves.push_back({ ContentsEmpty, bounds, firstMarkSurface, markSurfaceCount });
+		return -static_cast<int>(_leaves.size());
+	}
+
+	/**
+	*	@return The child index referring to the new node or leaf.
+	*/
+	int BuildNode(int x0, int y0, int x1, int y1)
+	{
+		const int tileCount = GetTileCount(x0, y0, x1, y1);
+		const auto bounds = GetBounds(x0, y0, x1, y1);
+
+		if (tileCount == 0)
+		{
+			return AddLeaf(bounds, 0, 0);
+		}
+
+		const int nodeIndex = static_cast<int>(_nodes.size());
+
+		_nodes.push_back({});
+		_nodes[nodeIndex].Bounds = bounds;
+
+		const int firstTerrace = y0 / GeneratedTerraceRows;
+		const int lastTerrace = (y1 - 1) / GeneratedTerraceRows;
+
+		int axis = -1;
+		int split = 0;
+
+		// Terraces are at different heights, so they are split apart before anything else.
+		if (firstTerrace != lastTerrace)
+		{
+			axis = 1;
+			split = ((firstTerrace + lastTerrace + 1) / 2) * GeneratedTerraceRows;
+		}
+		else if (tileCount > _tilesPerRegion)
+		{
+			axis = (x1 - x0) >= (y1 - y0) ? 0 : 1;
+			split = axis == 0 ? (x0 + x1) / 2 : (y0 + y1) / 2;
+		}
+
+		if (axis != -1)
+		{
+			const int distance = axis == 0 ? _originX + (split * GeneratedTileSize) : _originY + (split * GeneratedTileSize);
+			const int plane = FindPlane(axis, distance);
+
+			// The front of a plane is the side its normal points to, which is towards larger coordinates.
+			const int front = axis == 0 ? BuildNode(split, y0, x1, y1) : BuildNode(x0, split, x1, y1);
+			const int back = axis == 0 ? BuildNode(x0, y0, split, y1) : BuildNode(x0, y0, x1, split);
+
+			_nodes[nodeIndex].Plane = plane;
+			_nodes[nodeIndex].Children = { front, back };
+
+			return nodeIndex;
+		}
+
+		// A region of a single terrace: the faces lie on the node's plane, with empty space above and solid below.
+		const int height = _heights[firstTerrace];
+		const int plane = FindPlane(2, height);
+		const int firstFace = static_cast<int>(_faces.size());
+
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = x0; x < x1; ++x)
+			{
+				const int tile = (y * _columns) + x;
+
+				if (tile >= _tileCount)
+				{
+					continue;
+				}
+
+				const int textureInfo = static_cast<int>(_random.NextInRange(0, _settings.TextureCount - 1));
+
+				const int v00 = GetVertexIndex(x, y, firstTerrace);
+				const int v10 = GetVertexIndex(x + 1, y, firstTerrace);
+				const int v01 = GetVertexIndex(x, y + 1, firstTerrace);
+				const int v11 = GetVertexIndex(x + 1, y + 1, firstTerrace);
+
+				// Clockwise when seen from above, as the engine expects for front facing polygons.
+				_faces.push_back({ plane, textureInfo, { v00, v01, v11 } });
+
+				if (((tile * 2) + 1) < _settings.FaceCount)
+				{
+					_faces.push_back({ plane, textureInfo, { v00, v11, v10 } });
+				}
+			}
+		}
+
+		const int faceCount = static_cast<int>(_faces.size()) - firstFace;
+
+		auto leafBounds = bounds;
+		leafBounds.Mins[2] = height;
+		leafBounds.Maxs[2] = height + GeneratedTileSize;
+
+		// Faces are added in the order regions are visited, so each leaf's faces are contiguous
+		// and the mark surfaces are simply the face indexes in order.
+		const int leaf = AddLeaf(leafBounds, firstFace, faceCount);
+
+		auto& node = _nodes[nodeIndex];
+
+		node.Plane = plane;
+		node.Children = { leaf, SolidLeafChild };
+		node.FirstFace = firstFace;
+		node.FaceCount = faceCount;
+
+		return nodeIndex;
+	}
+
+private:
+	const BspGeneratorSettings& _settings;
+	DeterministicRandom& _random;
+
+	int _tileCount{ 0 };
+	int _columns{ 0 };
+	int _rows{ 0 };
+	int _originX{ 0 };
+	int _originY{ 0 };
+	int _tilesPerRegion{ 0 };
+
+	// Height of each terrace.
+	std::vector<int> _heights;
+
+	std::vector<GeneratedPlane> _planes;
+	std::map<GeneratedPlane, int> _planeIndexes;
+
+	std::vector<GeneratedNode> _nodes;
+	std::vector<GeneratedLeaf> _leaves;
+	std::vector<GeneratedFace> _faces;
+};
+
+static std::string GenerateEntities(DeterministicRandom& random, const BspGeneratorSettings& settings, const GeneratedBounds& bounds)
+{
+	const auto randomOrigin = [&]
+	{
+		const auto x = random.NextInRange(bounds.Mins[0], bounds.Maxs[0]);
+		const auto y = random.NextInRange(bounds.Mins[1], bounds.Maxs[1]);
+		const auto z = random.NextInRange(bounds.Maxs[2], bounds.Maxs[2] + 256);
+
+		return std::to_string(x) + " " + std::to_string(y) + " " + std::to_string(z);
+	};
+
+	std::string entities = "{\n\"classname\" \"worldspawn\"\n\"mapversion\" \"220\"\n";
+
+	if (!settings.EmbedTextures)
+	{
+		entities += "\"wad\" \"generated.wad\"\n";
+	}
+
+	entities += "}\n{\n\"classname\" \"info_player_start\"\n\"origin\" \"0 0 " + std::to_string(bounds.Maxs[2] + 36) + "\"\n}\n";
+
+	for (int i = 0; i < settings.EntityCount; ++i)
+	{
+		entities += "{\n\"classname\" \"light\"\n\"origin\" \"" + randomOrigin()
+			+ "\"\n\"_light\" \"255 255 255 " + std::to_string(random.NextInRange(100, 400)) + "\"\n}\n";
+	}
+
+	return entities;
+}
+
+static void WriteBounds(BinaryWriter& writer, const GeneratedBounds& bounds)
+{
+	constexpr int Min = std::numeric_limits<std::int16_t>::min();
+	constexpr int Max = std::numeric_limits<std::int16_t>::max();
+
+	for (const int value : bounds.Mins)
+	{
+		writer.WriteInt16(static_cast<std::int16_t>(std::clamp(value, Min, Max)));
+	}
+
+	for (const int value : bounds.Maxs)
+	{
+		writer.WriteInt16(static_cast<std::int16_t>(std::clamp(value, Min, Max)));
+	}
+}
+
+static std::size_t GetMiptexSize(const BspGeneratorSettings& settings)
+{
+	if (!settings.EmbedTextures)
+	{
+		return MiptexHeaderSize;
+	}
+
+	std::size_t size = MiptexHeaderSize;
+
+	for (std::size_t mipLevel = 0; mipLevel < BspMipLevelCount; ++mipLevel)
+	{
+		size += static_cast<std::size_t>(settings.TextureSize >> mipLevel) * (settings.TextureSize >> mipLevel);
+	}
+
+	// Color count, palette and padding to keep the next texture aligned.
+	return size + 2 + (ColormapColorCount * 3) + 2;
+}
+
+static void WriteTextures(BinaryWriter& writer, DeterministicRandom& random, const BspGeneratorSettings& settings)
+{
+	const std::size_t miptexSize = GetMiptexSize(settings);
+
+	writer.WriteInt32(settings.TextureCount);
+
+	for (int i = 0; i < settings.TextureCount; ++i)
+	{
+		writer.WriteInt32(static_cast<std::int32_t>(4 + (4 * settings.TextureCount) + (i * miptexSize)));
+	}
+
+	const auto palette = PalettePool::GetInstance().Intern(GeneratePalette(random));
+
+	// Reused for every texture so generating doesn't allocate per texture.
+	WadEntry entry;
+
+	entry.Width = settings.TextureSize;
+	entry.Height = settings.TextureSize;
+	entry.Colormap = palette;
+
+	for (int i = 0; i < settings.TextureCount && writer.IsOk(); ++i)
+	{
+		// Same names as generated wads, so maps without embedded textures can use them.
+		char name[16];
+		std::snprintf(name, sizeof(name), "gen%06d", i);
+
+		writer.WriteFixedUTF8String(name, 16);
+		writer.WriteUInt32(settings.TextureSize);
+		writer.WriteUInt32(settings.TextureSize);
+
+		if (!settings.EmbedTextures)
+		{
+			writer.WriteZeroes(4 * BspMipLevelCount);
+			continue;
+		}
+
+		GenerateTexturePixels(random, entry);
+
+		for (std::size_t mipLevel = 0; mipLevel < BspMipLevelCount; ++mipLevel)
+		{
+			writer.WriteUInt32(static_cast<std::uint32_t>(MiptexHeaderSize + entry.MipOffsets[mipLevel]));
+		}
+
+		writer.WriteBytes(std::as_bytes(std::span{ entry.Pixels }));
+		writer.WriteUInt16(static_cast<std::uint16_t>(ColormapColorCount));
+
+		for (const auto& color : entry.Colormap)
+		{
+			writer.WriteUInt8(color.R);
+			writer.WriteUInt8(color.G);
+			writer.WriteUInt8(color.B);
+		}
+
+		writer.WriteZeroes(2);
+	}
+}
+
+bool TryGenerateBspFile(const std::filesystem::path& fileName, const BspGeneratorSettings& settings)
+{
+	if (settings.FaceCount <= 0 || settings.FaceCount > BspMaxFaces
+		|| settings.TextureCount <= 0 || settings.EntityCount < 0
+		|| settings.TextureSize == 0 || (settings.TextureSize % 16) != 0)
+	{
+		return false;
+	}
+
+	// Offsets in the file are 32 bit.
+	if ((GetMiptexSize(settings) * settings.TextureCount) > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max() / 2))
+	{
+		return false;
+	}
+
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	DeterministicRandom random{ settings.Seed };
+
+	BspBuilder builder{ settings, random };
+
+	builder.Build();
+
+	BinaryWriter writer{ file };
+
+	std::array<std::pair<std::size_t, std::size_t>, BspLumpCount> lumps{};
+
+	// The header is written last, once the location of every lump is known.
+	writer.WriteZeroes(BspHeaderSize);
+
+	const auto writeLump = [&](BspLumpId::BspLumpId id, auto&& write)
+	{
+		writer.Align(4);
+
+		const std::size_t start = writer.GetPosition();
+
+		write();
+
+		lumps[id] = { start, writer.GetPosition() - start };
+	};
+
+	const auto& faces = builder.GetFaces();
+
+	writeLump(BspLumpId::Entities, [&]
+		{
+			const auto entities = GenerateEntities(random, settings, builder.GetWorldBounds());
+
+			writer.WriteBytes(std::as_bytes(std::span{ entities.c_str(), entities.size() + 1 }));
+		});
+
+	writeLump(BspLumpId::Planes, [&]
+		{
+			for (const auto& plane : builder.GetPlanes())
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					writer.WriteFloat(axis == plane.Axis ? 1.f : 0.f);
+				}
+
+				writer.WriteFloat(static_cast<float>(plane.Distance));
+				writer.WriteInt32(plane.Axis);
+			}
+		});
+
+	writeLump(BspLumpId::Textures, [&]
+		{
+			WriteTextures(writer, random, settings);
+		});
+
+	writeLump(BspLumpId::Vertexes, [&]
+		{
+			for (int i = 0; i < builder.GetVertexCount(); ++i)
+			{
+				for (const int value : builder.GetVertex(i))
+				{
+					writer.WriteFloat(static_cast<float>(value));
+				}
+			}
+		});
+
+	writeLump(BspLumpId::Visibility, [] {});
+
+	writeLump(BspLumpId::Nodes, [&]
+		{
+			for (const auto& node : builder.GetNodes())
+			{
+				writer.WriteInt32(node.Plane);
+				writer.WriteInt16(static_cast<std::int16_t>(node.Children[0]));
+				writer.WriteInt16(static_cast<std::int16_t>(node.Children[1]));
+				WriteBounds(writer, node.Bounds);
+				writer.WriteUInt16(static_cast<std::uint16_t>(node.FirstFace));
+				writer.WriteUInt16(static_cast<std::uint16_t>(node.FaceCount));
+			}
+		});
+
+	writeLump(BspLumpId::TexInfo, [&]
+		{
+			// Unscaled and unshifted, projected onto the floor.
+			for (int i = 0; i < settings.TextureCount; ++i)
+			{
+				writer.WriteFloat(1);
+				writer.WriteFloat(0);
+				writer.WriteFloat(0);
+				writer.WriteFloat(0);
+
+				writer.WriteFloat(0);
+				writer.WriteFloat(-1);
+				writer.WriteFloat(0);
+				writer.WriteFloat(0);
+
+				writer.WriteInt32(i);
+				writer.WriteInt32(0);
+			}
+		});
+
+	writeLump(BspLumpId::Faces, [&]
+		{
+			for (std::size_t i = 0; i < faces.size(); ++i)
+			{
+				const auto& face = faces[i];
+
+				writer.WriteInt16(static_cast<std::int16_t>(face.Plane));
+				writer.WriteInt16(0);
+				writer.WriteInt32(static_cast<std::int32_t>(i * 3));
+				writer.WriteInt16(3);
+				writer.WriteInt16(static_cast<std::int16_t>(face.TextureInfo));
+
+				writer.WriteUInt8(settings.Lighting ? 0 : 255);
+				writer.WriteUInt8(255);
+				writer.WriteUInt8(255);
+				writer.WriteUInt8(255);
+
+				writer.WriteInt32(settings.Lighting ? static_cast<std::int32_t>(i * LightmapSize) : -1);
+			}
+		});
+
+	writeLump(BspLumpId::Lighting, [&]
+		{
+			if (!settings.Lighting)
+			{
+				return;
+			}
+
+			// Every face covers a single tile, so every lightmap has the same size.
+			std::array<std::uint8_t, LightmapSize> lightmap{};
+
+			for (std::size_t i = 0; i < faces.size() && writer.IsOk(); ++i)
+			{
+				const auto base = static_cast<std::uint8_t>(random.NextInRange(64, 192));
+
+				random.Fill(lightmap);
+
+				for (auto& sample : lightmap)
+				{
+					sample = static_cast<std::uint8_t>(base + (sample % 32));
+				}
+
+				writer.WriteBytes(std::as_bytes(std::span{ lightmap }));
+			}
+		});
+
+	writeLump(BspLumpId::Clipnodes, [&]
+		{
+			// The clip hulls use the same tree as the visible hull, with leaves turned into contents.
+			const auto& leaves = builder.GetLeaves();
+
+			for (const auto& node : builder.GetNodes())
+			{
+				writer.WriteInt32(node.Plane);
+
+				for (const int child : node.Children)
+				{
+					writer.WriteInt16(static_cast<std::int16_t>(child >= 0 ? child : leaves[-child - 1].Contents));
+				}
+			}
+		});
+
+	writeLump(BspLumpId::Leafs, [&]
+		{
+			for (const auto& leaf : builder.GetLeaves())
+			{
+				writer.WriteInt32(leaf.Contents);
+				writer.WriteInt32(-1);
+				WriteBounds(writer, leaf.Bounds);
+				writer.WriteUInt16(static_cast<std::uint16_t>(leaf.FirstMarkSurface));
+				writer.WriteUInt16(static_cast<std::uint16_t>(leaf.MarkSurfaceCount));
+				writer.WriteZeroes(4);
+			}
+		});
+
+	writeLump(BspLumpId::MarkSurfaces, [&]
+		{
+			for (std::size_t i = 0; i < faces.size(); ++i)
+			{
+				writer.WriteUInt16(static_cast<std::uint16_t>(i));
+			}
+		});
+
+	writeLump(BspLumpId::Edges, [&]
+		{
+			// Edge 0 can't be used since surfedges use the sign to indicate direction.
+			writer.WriteZeroes(4);
+
+			for (const auto& face : faces)
+			{
+				for (std::size_t i = 0; i < face.Vertexes.size(); ++i)
+				{
+					writer.WriteUInt16(static_cast<std::uint16_t>(face.Vertexes[i]));
+					writer.WriteUInt16(static_cast<std::uint16_t>(face.Vertexes[(i + 1) % face.Vertexes.size()]));
+				}
+			}
+		});
+
+	writeLump(BspLumpId::SurfEdges, [&]
+		{
+			for (std::size_t i = 0; i < faces.size() * 3; ++i)
+			{
+				writer.WriteInt32(static_cast<std::int32_t>(i + 1));
+			}
+		});
+
+	writeLump(BspLumpId::Models, [&]
+		{
+			const auto bounds = builder.GetWorldBounds();
+
+			for (const int value : bounds.Mins)
+			{
+				writer.WriteFloat(static_cast<float>(value));
+			}
+
+			for (const int value : bounds.Maxs)
+			{
+				writer.WriteFloat(static_cast<float>(value));
+			}
+
+			writer.WriteZeroes(sizeof(float) * 3);
+
+			// The tree's root is node 0 and clipnode 0 for every hull.
+			writer.WriteZeroes(sizeof(std::int32_t) * BspHullCount);
+
+			writer.WriteInt32(static_cast<std::int32_t>(builder.GetLeaves().size()) - 1);
+			writer.WriteInt32(0);
+			writer.WriteInt32(static_cast<std::int32_t>(faces.size()));
+		});
+
+	writer.SetPosition(0);
+	writer.WriteInt32(BspVersion);
+
+	for (const auto& [offset, size] : lumps)
+	{
+		writer.WriteInt32(static_cast<std::int32_t>(offset));
+		writer.WriteInt32(static_cast<std::int32_t>(size));
+	}
+
+	const bool success = writer.IsOk();
+
+	return std::fclose(file) == 0 && success;
+}
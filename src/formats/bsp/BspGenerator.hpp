@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+/**
+*	@brief Largest number of faces the engine supports. Faces are referenced by 16 bit indices.
+*/
+constexpr int BspMaxFaces = 65535;
+
+/**
+*	@brief Settings for generated maps. The same settings always produce the same file.
+*/
+struct BspGeneratorSettings
+{
+	std::uint64_t Seed{ 0 };
+
+	/**
+	*	@brief Number of faces in the world, at most BspMaxFaces.
+	*/
+	int FaceCount{ 4096 };
+
+	int TextureCount{ 64 };
+
+	/**
+	*	@brief Width and height of every texture. Must be a multiple of 16.
+	*/
+	unsigned int TextureSize{ 64 };
+
+	/**
+	*	@brief Whether texture pixels are stored in the map. Otherwise only names are stored,
+	*	which match the textures in a wad generated with the same texture count.
+	*/
+	bool EmbedTextures{ true };
+
+	bool Lighting{ true };
+
+	/**
+	*	@brief Number of light entities, in addition to worldspawn and the player start.
+	*/
+	int EntityCount{ 64 };
+};
+
+/**
+*	@brief Writes a version 30 map with terraced terrain made of triangles.
+*	@details The terrain is split into regions with a BSP tree of axial planes, with a leaf above each region
+*	and the solid leaf below. Clip hulls reuse the same tree. There is no visibility data, so every leaf sees every other leaf.
+*/
+bool TryGenerateBspFile(const std::filesystem::path& fileName, const BspGeneratorSettings& settings);
@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include "formats/png/PngWriter.hpp"
+#include "utils/IOutils.hpp"
+
+constexpr std::array<std::uint8_t, 8> PngSignature{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+constexpr std::size_t DeflateWindowSize = 32768;
+constexpr std::size_t MinMatchLength = 3;
+constexpr std::size_t MaxMatchLength = 258;
+
+// Limits how many earlier occurrences are compared, trading ratio for speed.
+constexpr int MaxChainLength = 32;
+
+constexpr int HashBits = 15;
+
+constexpr std::array<std::uint16_t, 29> LengthBases{
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr std::array<std::uint8_t, 29> LengthExtraBits{
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+constexpr std::array<std::uint16_t, 30> DistanceBases{
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+	1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+constexpr std::array<std::uint8_t, 30> DistanceExtraBits{
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static constexpr auto CrcTable = []
+{
+	std::array<std::uint32_t, 256> table{};
+
+	for (std::uint32_t i = 0; i < table.size(); ++i)
+	{
+		std::uint32_t value = i;
+
+		for (int bit = 0; bit < 8; ++bit)
+		{
+			value = (value & 1) ? 0xEDB88320U ^ (value >> 1) : value >> 1;
+		}
+
+		table[i] = value;
+	}
+
+	return table;
+}();
+
+static std::uint32_t UpdateCrc(std::uint32_t crc, std::span<const std::byte> data)
+{
+	for (const auto value : data)
+	{
+		crc = CrcTable[(crc ^ static_cast<std::uint8_t>(value)) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+
+static std::uint32_t Adler32(std::span<const std::byte> data)
+{
+	constexpr std::uint32_t Modulus = 65521;
+
+	// Largest number of bytes that can be summed before the sums can overflow.
+	constexpr std::size_t BlockSize = 5552;
+
+	std::uint32_t a = 1;
+	std::uint32_t b = 0;
+
+	for (std::size_t offset = 0; offset < data.size(); offset += BlockSize)
+	{
+		const std::size_t end = std::min(data.size(), offset + BlockSize);
+
+		for (std::size_t i = offset; i < end; ++i)
+		{
+			a += static_cast<std::uint8_t>(data[i]);
+			b += a;
+		}
+
+		a %= Modulus;
+		b %= Modulus;
+	}
+
+	return (b << 16) | a;
+}
+
+static void AppendBigEndian(std::vector<std::byte>& buffer, std::uint32_t value)
+{
+	buffer.push_back(static_cast<std::byte>(value >> 24));
+	buffer.push_back(static_cast<std::byte>(value >> 16));
+	buffer.push_back(static_cast<std::byte>(value >> 8));
+	buffer.push_back(static_cast<std::byte>(value));
+}
+
+/**
+*	@brief Writes bits least significant bit first, as deflate requires.
+*/
+class BitWriter final
+{
+public:
+	explicit BitWriter(std::vector<std::byte>& buffer)
+		: _buffer(buffer)
+	{
+	}
+
+	void Write(std::uint32_t value, int count)
+	{
+		_bits |= static_cast<std::uint64_t>(value) << _count;
+		_count += count;
+
+		while (_count >= 8)
+		{
+			_buffer.push_back(static_cast<std::byte>(_bits & 0xFF));
+			_bits >>= 8;
+			_count -= 8;
+		}
+	}
+
+	/**
+	*	@brief Huffman codes are defined most significant bit first, so they are reversed before writing.
+	*/
+	void WriteCode(std::uint32_t code, int count)
+	{
+		std::uint32_t reversed = 0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+
+		Write(reversed, count);
+	}
+
+	void Flush()
+	{
+		if (_count > 0)
+		{
+			Write(0, 8 - _count);
+		}
+	}
+
+private:
+	std::vector<std::byte>& _buffer;
+	std::uint64_t _bits{ 0 };
+	int _count{ 0 };
+};
+
+static void WriteLiteralOrLength(BitWriter& writer, std::uint32_t symbol)
+{
+	if (symbol < 144)
+	{
+		writer.WriteCode(0x30 + symbol, 8);
+	}
+	else if (symbol < 256)
+	{
+		writer.WriteCode(0x190 + (symbol - 144), 9);
+	}
+	else if (symbol < 280)
+	{
+		writer.WriteCode(symbol - 256, 7);
+	}
+	else
+	{
+		writer.WriteCode(0xC0 + (symbol - 280), 8);
+	}
+}
+
+static void WriteMatch(BitWriter& writer, std::size_t length, std::size_t distance)
+{
+	const auto lengthCode = static_cast<std::size_t>(
+		std::upper_bound(LengthBases.begin(), LengthBases.end(), length) - LengthBases.begin() - 1);
+
+	WriteLiteralOrLength(writer, static_cast<std::uint32_t>(257 + lengthCode));
+	writer.Write(static_cast<std::uint32_t>(length - LengthBases[lengthCode]), LengthExtraBits[lengthCode]);
+
+	const auto distanceCode = static_cast<std::size_t>(
+		std::upper_bound(DistanceBases.begin(), DistanceBases.end(), distance) - DistanceBases.begin() - 1);
+
+	writer.WriteCode(static_cast<std::uint32_t>(distanceCode), 5);
+	writer.Write(static_cast<std::uint32_t>(distance - DistanceBases[distanceCode]), DistanceExtraBits[distanceCode]);
+}
+
+static std::uint32_t Hash3(const std::byte* data)
+{
+	const std::uint32_t value = static_cast<std::uint32_t>(data[0])
+		| (static_cast<std::uint32_t>(data[1]) << 8)
+		| (static_cast<std::uint32_t>(data[2]) << 16);
+
+	return (value * 2654435761U) >> (32 - HashBits);
+}
+
+/**
+*	@brief Compresses data as a zlib stream with a single fixed Huffman block.
+*/
+static std::vector<std::byte> Deflate(std::span<const std::byte> data)
+{
+	std::vector<std::byte> result;
+
+	result.reserve(data.size() / 2 + 64);
+
+	// Deflate with a 32K window, no preset dictionary, default compression level hint.
+	result.push_back(std::byte{ 0x78 });
+	result.push_back(std::byte{ 0x9C });
+
+	BitWriter writer{ result };
+
+	// Final block, fixed Huffman codes.
+	writer.Write(1, 1);
+	writer.Write(1, 2);
+
+	constexpr std::uint32_t NoPosition = 0xFFFFFFFF;
+
+	std::vector<std::uint32_t> head(std::size_t{ 1 } << HashBits, NoPosition);
+	std::vector<std::uint32_t> previous(DeflateWindowSize, NoPosition);
+
+	const auto insert = [&](std::size_t position)
+	{
+		const auto hash = Hash3(data.data() + position);
+		previous[position % DeflateWindowSize] = head[hash];
+		head[hash] = static_cast<std::uint32_t>(position);
+	};
+
+	std::size_t position = 0;
+
+	while (position < data.size())
+	{
+		std::size_t bestLength = 0;
+		std::size_t bestDistance = 0;
+
+		if (position + MinMatchLength <= data.size())
+		{
+			const std::size_t maxLength = std::min(MaxMatchLength, data.size() - position);
+
+			std::uint32_t candidate = head[Hash3(data.data() + position)];
+
+			for (int chain = 0; chain < MaxChainLength && candidate != NoPosition; ++chain)
+			{
+				const std::size_t distance = position - candidate;
+
+				if (distance > DeflateWindowSize)
+				{
+					break;
+				}
+
+				std::size_t length = 0;
+
+				while (length < maxLength && data[candidate + length] == data[position + length])
+				{
+					++length;
+				}
+
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestDistance = distance;
+
+					if (length == maxLength)
+					{
+						break;
+					}
+				}
+
+				const std::uint32_t next = previous[candidate % DeflateWindowSize];
+
+				// Entries older than the window may have been overwritten by newer positions.
+				if (next == NoPosition || next >= candidate)
+				{
+					break;
+				}
+
+				candidate = next;
+			}
+		}
+
+		if (bestLength >= MinMatchLength)
+		{
+			WriteMatch(writer, bestLength, bestDistance);
+
+			const std::size_t end = std::min(position + bestLength, data.size() - (MinMatchLength - 1));
+
+			for (std::size_t i = position; i < end; ++i)
+			{
+				insert(i);
+			}
+
+			position += bestLength;
+		}
+		else
+		{
+			WriteLiteralOrLength(writer, static_cast<std::uint8_t>(data[position]));
+
+			if (position + MinMatchLength <= data.size())
+			{
+				insert(position);
+			}
+
+			++position;
+		}
+	}
+
+	// End of block.
+	WriteLiteralOrLength(writer, 256);
+	writer.Flush();
+
+	AppendBigEndian(result, Adler32(data));
+
+	return result;
+}
+
+static void AppendChunk(std::vector<std::byte>& buffer, const char (&type)[5], std::span<const std::byte> data)
+{
+	AppendBigEndian(buffer, static_cast<std::uint32_t>(data.size()));
+
+	const std::size_t typeOffset = buffer.size();
+
+	for (int i = 0; i < 4; ++i)
+	{
+		buffer.push_back(static_cast<std::byte>(type[i]));
+	}
+
+	buffer.insert(buffer.end(), data.begin(), data.end());
+
+	// The CRC covers the type and data, but not the length.
+	const std::uint32_t crc = UpdateCrc(0xFFFFFFFF, std::span{ buffer }.subspan(typeOffset)) ^ 0xFFFFFFFF;
+
+	AppendBigEndian(buffer, crc);
+}
+
+std::vector<std::byte> EncodePng(std::uint32_t width, std::uint32_t height, std::span<const std::uint32_t> pixels, bool premultiplied)
+{
+	if (width == 0 || height == 0 || pixels.size() != static_cast<std::size_t>(width) * height)
+	{
+		return {};
+	}
+
+	// Each row starts with its filter type. Filtering is not used, so it's always 0.
+	std::vector<std::byte> scanlines;
+
+	scanlines.reserve(static_cast<std::size_t>(height) * (1 + static_cast<std::size_t>(width) * 4));
+
+	for (std::uint32_t y = 0; y < height; ++y)
+	{
+		scanlines.push_back(std::byte{ 0 });
+
+		for (const std::uint32_t pixel : pixels.subspan(static_cast<std::size_t>(y) * width, width))
+		{
+			const std::uint32_t a = pixel >> 24;
+			std::uint32_t r = (pixel >> 16) & 0xFF;
+			std::uint32_t g = (pixel >> 8) & 0xFF;
+			std::uint32_t b = pixel & 0xFF;
+
+			if (premultiplied && a != 0xFF)
+			{
+				if (a == 0)
+				{
+					r = g = b = 0;
+				}
+				else
+				{
+					r = std::min<std::uint32_t>(255, (r * 255 + a / 2) / a);
+					g = std::min<std::uint32_t>(255, (g * 255 + a / 2) / a);
+					b = std::min<std::uint32_t>(255, (b * 255 + a / 2) / a);
+				}
+			}
+
+			scanlines.push_back(static_cast<std::byte>(r));
+			scanlines.push_back(static_cast<std::byte>(g));
+			scanlines.push_back(static_cast<std::byte>(b));
+			scanlines.push_back(static_cast<std::byte>(a));
+		}
+	}
+
+	std::vector<std::byte> header;
+
+	AppendBigEndian(header, width);
+	AppendBigEndian(header, height);
+	header.push_back(std::byte{ 8 }); // Bit depth.
+	header.push_back(std::byte{ 6 }); // Truecolor with alpha.
+	header.push_back(std::byte{ 0 }); // Deflate compression.
+	header.push_back(std::byte{ 0 }); // Adaptive filtering.
+	header.push_back(std::byte{ 0 }); // No interlacing.
+
+	std::vector<std::byte> result;
+
+	for (const auto value : PngSignature)
+	{
+		result.push_back(static_cast<std::byte>(value));
+	}
+
+	AppendChunk(result, "IHDR", header);
+	AppendChunk(result, "IDAT", Deflate(scanlines));
+	AppendChunk(result, "IEND", {});
+
+	return result;
+}
+
+bool TryWritePngFile(const std::filesystem::path& fileName,
+	std::uint32_t width, std::uint32_t height, std::span<const std::uint32_t> pixels, bool premultiplied)
+{
+	const auto data = EncodePng(width, height, pixels, premultiplied);
+
+	if (data.empty())
+	{
+		return false;
+	}
+
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	const bool success = std::fwrite(data.data(), data.size(), 1, file) == 1;
+
+	return std::fclose(file) == 0 && success;
+}
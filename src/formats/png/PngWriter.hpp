@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+/**
+*	@brief Encodes 32 bit pixels as an 8 bit RGBA PNG.
+*	@details Uses fixed Huffman codes, which compresses palette based textures well enough
+*	without having to build code tables per image.
+*	@param pixels @p width * @p height pixels stored as @c 0xAARRGGBB, rows stored one after the other.
+*	@param premultiplied Whether the colors are premultiplied by alpha, like SpriteImage.
+*	PNG stores straight alpha, so premultiplied colors are converted back.
+*	@return The encoded file, or an empty buffer if the dimensions don't match the number of pixels.
+*/
+std::vector<std::byte> EncodePng(std::uint32_t width, std::uint32_t height, std::span<const std::uint32_t> pixels, bool premultiplied = false);
+
+/**
+*	@brief Encodes pixels as with EncodePng and writes them to a file.
+*/
+bool TryWritePngFile(const std::filesystem::path& fileName,
+	std::uint32_t width, std::uint32_t height, std::span<const std::uint32_t> pixels, bool premultiplied = false);
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cmath>
+
+#include "formats/sprite/SpriteAnimationScheduler.hpp"
+#include "formats/sprite/SpriteFile.hpp"
+#include "utils/Hash.hpp"
+
+SpriteAnimationScheduler::SpriteAnimationScheduler(const SpriteFile& sprite, float frameRate)
+	: _frameRate(frameRate > 0 ? frameRate : DefaultFrameRate)
+	, _randomSync(sprite.SyncType == SyncType::RAND)
+{
+	const double frameDuration = 1.0 / _frameRate;
+
+	_endTimes.reserve(sprite.Frames.size());
+
+	double time = 0;
+
+	for (const auto& descriptor : sprite.FrameDescriptors)
+	{
+		if (descriptor.Type == SpriteFrameType::SINGLE)
+		{
+			time += frameDuration;
+			_endTimes.push_back(time);
+			continue;
+		}
+
+		const auto& group = sprite.Groups[descriptor.Index];
+
+		// Intervals are already cumulative. The engine doesn't require them to increase,
+		// frames that end before the previous one are never shown.
+		float groupTime = 0;
+
+		for (const float interval : group.Intervals)
+		{
+			groupTime = std::max(groupTime, interval);
+			_endTimes.push_back(time + groupTime);
+		}
+
+		time += groupTime;
+	}
+}
+
+double SpriteAnimationScheduler::GetPhase(std::uint64_t seed) const
+{
+	if (!_randomSync)
+	{
+		return 0;
+	}
+
+	// Use the top 53 bits for a uniformly distributed fraction.
+	const double fraction = static_cast<double>(MixHash(seed) >> 11) / static_cast<double>(std::uint64_t{ 1 } << 53);
+
+	return fraction * GetDuration();
+}
+
+std::uint32_t SpriteAnimationScheduler::GetFrame(double time, double phase) const
+{
+	const double duration = GetDuration();
+
+	if (duration <= 0)
+	{
+		return 0;
+	}
+
+	double loopTime = std::fmod(time + phase, duration);
+
+	if (loopTime < 0)
+	{
+		loopTime += duration;
+	}
+
+	// The frame shown is the first one that ends after this time.
+	const auto it = std::upper_bound(_endTimes.begin(), _endTimes.end(), loopTime);
+
+	return static_cast<std::uint32_t>(std::min<std::size_t>(it - _endTimes.begin(), _endTimes.size() - 1));
+}
+
+void SpriteAnimationScheduler::GetFrames(double time, std::span<const double> phases, std::span<std::uint32_t> frames) const
+{
+	const std::size_t count = std::min(phases.size(), frames.size());
+
+	// Synchronized instances all show the same frame, so they share a single search.
+	const std::uint32_t synchronizedFrame = GetFrame(time);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		frames[i] = phases[i] == 0 ? synchronizedFrame : GetFrame(time, phases[i]);
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class SpriteFile;
+
+/**
+*	@brief Computes which frame of a sprite is shown at any point in time.
+*	@details Single frames are shown for 1 / frame rate seconds, frames in groups for their own interval.
+*	The time at which each frame ends is stored in a table once, so finding the frame for a time
+*	is a binary search that doesn't depend on how long the sprite has been playing.
+*	The scheduler is immutable once created and can be shared by any number of sprite instances and threads.
+*/
+class SpriteAnimationScheduler final
+{
+public:
+	static constexpr float DefaultFrameRate = 10;
+
+	SpriteAnimationScheduler() = default;
+
+	explicit SpriteAnimationScheduler(const SpriteFile& sprite, float frameRate = DefaultFrameRate);
+
+	float GetFrameRate() const { return _frameRate; }
+
+	/**
+	*	@brief Gets the length of one loop of the animation in seconds.
+	*/
+	double GetDuration() const { return _endTimes.empty() ? 0 : _endTimes.back(); }
+
+	/**
+	*	@brief Gets the time offset of an instance.
+	*	@details Synchronized sprites all start at the same time. Sprites with random sync
+	*	start at a random point in the animation, derived from @p seed so the same instance always gets the same offset.
+	*/
+	double GetPhase(std::uint64_t seed) const;
+
+	/**
+	*	@brief Gets the index in SpriteFile::Frames of the frame shown at the given time.
+	*	@param time Time in seconds since the animation started. The animation loops.
+	*	@param phase Time offset of this instance, see GetPhase.
+	*/
+	std::uint32_t GetFrame(double time, double phase = 0) const;
+
+	/**
+	*	@brief Gets the frame of many instances at once.
+	*	@param phases Time offset of each instance.
+	*	@param frames Receives the frame of each instance. Must be the same size as @p phases.
+	*/
+	void GetFrames(double time, std::span<const double> phases, std::span<std::uint32_t> frames) const;
+
+private:
+	float _frameRate{ DefaultFrameRate };
+	bool _randomSync{ false };
+
+	// Time at which each frame in SpriteFile::Frames ends, in ascending order.
+	std::vector<double> _endTimes;
+};
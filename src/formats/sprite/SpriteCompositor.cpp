@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPRITE_COMPOSITOR_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "formats/sprite/SpriteCompositor.hpp"
+
+namespace
+{
+using ColorTable = std::array<std::uint32_t, ColormapColorCount>;
+
+enum class CompositeOperation
+{
+	Copy,
+	Add,
+	Over
+};
+
+constexpr std::uint32_t PackColor(std::uint32_t a, std::uint32_t r, std::uint32_t g, std::uint32_t b)
+{
+	return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+/**
+*	@brief Divides by 255, rounding to nearest. Exact for all products of two 8 bit values.
+*/
+constexpr std::uint32_t DivideBy255(std::uint32_t value)
+{
+	value += 128;
+	return (value + (value >> 8)) >> 8;
+}
+
+/**
+*	@brief Converts the palette to the premultiplied color of each index, so kernels only need a table lookup per pixel.
+*/
+ColorTable CreateColorTable(const SpriteFile& sprite, CompositeOperation& operation)
+{
+	ColorTable table{};
+
+	for (std::size_t i = 0; i < ColormapColorCount; ++i)
+	{
+		const auto& color = sprite.Colormap[i];
+
+		switch (sprite.TextureFormat)
+		{
+		case SpriteTextureFormat::ADDITIVE:
+		{
+			// Adding this to a transparent background leaves a valid premultiplied color whose brightness is its coverage,
+			// adding it to an opaque background is a plain additive blend.
+			const std::uint32_t alpha = std::max({ color.R, color.G, color.B });
+			table[i] = PackColor(alpha, color.R, color.G, color.B);
+			break;
+		}
+
+		case SpriteTextureFormat::INDEXALPHA:
+		{
+			const auto& lastColor = sprite.Colormap[ColormapColorCount - 1];
+			const std::uint32_t alpha = static_cast<std::uint32_t>(i);
+			table[i] = PackColor(alpha, DivideBy255(lastColor.R * alpha), DivideBy255(lastColor.G * alpha), DivideBy255(lastColor.B * alpha));
+			break;
+		}
+
+		case SpriteTextureFormat::ALPHTEST:
+		{
+			table[i] = i == (ColormapColorCount - 1) ? 0 : PackColor(0xFF, color.R, color.G, color.B);
+			break;
+		}
+
+		default:
+		{
+			table[i] = PackColor(0xFF, color.R, color.G, color.B);
+			break;
+		}
+		}
+	}
+
+	switch (sprite.TextureFormat)
+	{
+	case SpriteTextureFormat::ADDITIVE: operation = CompositeOperation::Add; break;
+	// Alphatest colors are either opaque or fully transparent, so blending them is exact.
+	case SpriteTextureFormat::INDEXALPHA:
+	case SpriteTextureFormat::ALPHTEST: operation = CompositeOperation::Over; break;
+	default: operation = CompositeOperation::Copy; break;
+	}
+
+	return table;
+}
+
+std::uint32_t AddSaturate(std::uint32_t source, std::uint32_t dest)
+{
+	std::uint32_t result = 0;
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		const std::uint32_t sum = ((source >> shift) & 0xFF) + ((dest >> shift) & 0xFF);
+		result |= std::min(sum, 0xFFu) << shift;
+	}
+
+	return result;
+}
+
+std::uint32_t BlendOver(std::uint32_t source, std::uint32_t dest)
+{
+	const std::uint32_t inverseAlpha = 255 - (source >> 24);
+
+	std::uint32_t result = 0;
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		const std::uint32_t channel = ((source >> shift) & 0xFF) + DivideBy255(((dest >> shift) & 0xFF) * inverseAlpha);
+		result |= std::min(channel, 0xFFu) << shift;
+	}
+
+	return result;
+}
+
+/**
+*	@brief Scalar kernel, also used for the pixels left over by the SSE2 kernel.
+*/
+void CompositeScalar(const ColorTable& table, CompositeOperation operation,
+	const std::uint8_t* indices, std::uint32_t* pixels, std::size_t count)
+{
+	switch (operation)
+	{
+	case CompositeOperation::Copy:
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			pixels[i] = table[indices[i]];
+		}
+		break;
+
+	case CompositeOperation::Add:
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			pixels[i] = AddSaturate(table[indices[i]], pixels[i]);
+		}
+		break;
+
+	case CompositeOperation::Over:
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			pixels[i] = BlendOver(table[indices[i]], pixels[i]);
+		}
+		break;
+	}
+}
+
+#ifdef SPRITE_COMPOSITOR_SSE2
+/**
+*	@brief Looks up the colors of 4 pixels. SSE2 has no gather instruction, so this is done with scalar loads.
+*/
+__m128i LoadColors(const ColorTable& table, const std::uint8_t* indices)
+{
+	return _mm_setr_epi32(
+		static_cast<int>(table[indices[0]]), static_cast<int>(table[indices[1]]),
+		static_cast<int>(table[indices[2]]), static_cast<int>(table[indices[3]]));
+}
+
+/**
+*	@brief Blends 2 pixels unpacked to 16 bits per channel, with the same rounding as DivideBy255.
+*/
+__m128i BlendOver16(__m128i source, __m128i dest)
+{
+	// Broadcast each pixel's alpha to all of its channels.
+	__m128i alpha = _mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+	const __m128i inverseAlpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+	__m128i product = _mm_add_epi16(_mm_mullo_epi16(dest, inverseAlpha), _mm_set1_epi16(128));
+	product = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+
+	return _mm_add_epi16(source, product);
+}
+
+void CompositeSSE2(const ColorTable& table, CompositeOperation operation,
+	const std::uint8_t* indices, std::uint32_t* pixels, std::size_t count)
+{
+	const std::size_t vectorCount = count & ~std::size_t{ 3 };
+	const __m128i zero = _mm_setzero_si128();
+
+	for (std::size_t i = 0; i < vectorCount; i += 4)
+	{
+		const __m128i source = LoadColors(table, indices + i);
+		auto dest = reinterpret_cast<__m128i*>(pixels + i);
+
+		switch (operation)
+		{
+		case CompositeOperation::Copy:
+			_mm_storeu_si128(dest, source);
+			break;
+
+		case CompositeOperation::Add:
+			_mm_storeu_si128(dest, _mm_adds_epu8(source, _mm_loadu_si128(dest)));
+			break;
+
+		case CompositeOperation::Over:
+		{
+			const __m128i destColors = _mm_loadu_si128(dest);
+
+			const __m128i low = BlendOver16(_mm_unpacklo_epi8(source, zero), _mm_unpacklo_epi8(destColors, zero));
+			const __m128i high = BlendOver16(_mm_unpackhi_epi8(source, zero), _mm_unpackhi_epi8(destColors, zero));
+
+			_mm_storeu_si128(dest, _mm_packus_epi16(low, high));
+			break;
+		}
+		}
+	}
+
+	CompositeScalar(table, operation, indices + vectorCount, pixels + vectorCount, count - vectorCount);
+}
+#endif
+
+void Composite(const ColorTable& table, CompositeOperation operation,
+	const std::uint8_t* indices, std::uint32_t* pixels, std::size_t count)
+{
+#ifdef SPRITE_COMPOSITOR_SSE2
+	CompositeSSE2(table, operation, indices, pixels, count);
+#else
+	CompositeScalar(table, operation, indices, pixels, count);
+#endif
+}
+
+void FillBackground(const SpriteBackground& background, int width, int height, std::uint32_t* pixels)
+{
+	if (background.Image.empty() || background.ImageWidth <= 0 || background.ImageHeight <= 0)
+	{
+		std::fill_n(pixels, static_cast<std::size_t>(width) * height, background.Color);
+		return;
+	}
+
+	for (int y = 0; y < height; ++y)
+	{
+		const std::uint32_t* row = background.Image.data() + (static_cast<std::size_t>(y % background.ImageHeight) * background.ImageWidth);
+
+		for (int x = 0; x < width; ++x)
+		{
+			*pixels++ = row[x % background.ImageWidth];
+		}
+	}
+}
+
+SpriteImage CompositeFrame(const ColorTable& table, CompositeOperation operation,
+	const SingleSpriteFrame& frame, const SpriteBackground& background)
+{
+	SpriteImage image;
+
+	image.Width = frame.Width;
+	image.Height = frame.Height;
+	image.Pixels.resize(static_cast<std::size_t>(frame.Width) * frame.Height);
+
+	FillBackground(background, frame.Width, frame.Height, image.Pixels.data());
+
+	Composite(table, operation, frame.Pixels.data(), image.Pixels.data(), image.Pixels.size());
+
+	return image;
+}
+}
+
+void CompositeSpriteFrame(const SpriteFile& sprite, const SingleSpriteFrame& frame, std::span<std::uint32_t> pixels)
+{
+	CompositeOperation operation;
+	const auto table = CreateColorTable(sprite, operation);
+
+	const std::size_t count = std::min(pixels.size(), frame.Pixels.size());
+
+	Composite(table, operation, frame.Pixels.data(), pixels.data(), count);
+}
+
+SpriteImage CompositeSpriteFrame(const SpriteFile& sprite, const SingleSpriteFrame& frame, const SpriteBackground& background)
+{
+	CompositeOperation operation;
+	const auto table = CreateColorTable(sprite, operation);
+
+	return CompositeFrame(table, operation, frame, background);
+}
+
+std::vector<SpriteImage> CompositeSpriteFrames(const SpriteFile& sprite, const SpriteBackground& background, unsigned int maxThreadCount)
+{
+	CompositeOperation operation;
+	const auto table = CreateColorTable(sprite, operation);
+
+	std::vector<SpriteImage> images(sprite.Frames.size());
+
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	const unsigned int threadCount = static_cast<unsigned int>(std::min<std::size_t>(maxThreadCount, images.size()));
+
+	// Frames vary in size, so threads take the next frame as they finish instead of splitting the frames up front.
+	std::atomic<std::size_t> nextFrame{ 0 };
+
+	const auto work = [&]
+	{
+		for (std::size_t i = nextFrame++; i < images.size(); i = nextFrame++)
+		{
+			images[i] = CompositeFrame(table, operation, sprite.Frames[i], background);
+		}
+	};
+
+	if (threadCount <= 1)
+	{
+		work();
+		return images;
+	}
+
+	{
+		std::vector<std::jthread> threads;
+
+		threads.reserve(threadCount - 1);
+
+		for (unsigned int i = 1; i < threadCount; ++i)
+		{
+			threads.emplace_back(work);
+		}
+
+		// This thread helps out too. The other threads are joined at the end of this scope.
+		work();
+	}
+
+	return images;
+}
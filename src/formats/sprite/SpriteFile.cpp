@@ -1,10 +1,15 @@
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <memory_resource>
 #include <vector>
 
 #include "formats/sprite/SpriteFile.hpp"
 #include "utils/BinaryReader.hpp"
 #include "utils/IOutils.hpp"
+#include "utils/LoadProgress.hpp"
 
 const char* SpriteTypeToString(SpriteType type)
 {
@@ -31,11 +36,11 @@ const char* SpriteTextureFormatToString(SpriteTextureFormat format)
 	}
 }
 
-constexpr int SpriteVersion = 2;
+constexpr std::size_t SpriteHeaderSize = 40;
 
-static std::optional<SingleSpriteFrame> TryLoadSingleSpriteFrame(BinaryReader& reader)
+static std::optional<SingleSpriteFrame> TryLoadSingleSpriteFrame(BinaryReader& reader, std::pmr::memory_resource* resource)
 {
-	SingleSpriteFrame frame;
+	SingleSpriteFrame frame{ resource };
 
 	frame.Origin.x = reader.ReadInt32();
 	frame.Origin.y = reader.ReadInt32();
@@ -55,7 +60,7 @@ static std::optional<SingleSpriteFrame> TryLoadSingleSpriteFrame(BinaryReader& r
 	return frame;
 }
 
-static std::optional<SpriteGroup> TryLoadSpriteGroup(BinaryReader& reader)
+static std::optional<SpriteGroup> TryLoadSpriteGroup(BinaryReader& reader, std::pmr::vector<SingleSpriteFrame>& frames)
 {
 	const std::int32_t numFrames = reader.ReadInt32();
 
@@ -64,8 +69,9 @@ static std::optional<SpriteGroup> TryLoadSpriteGroup(BinaryReader& reader)
 		return {};
 	}
 
-	SpriteGroup group;
+	SpriteGroup group{ frames.get_allocator() };
 
+	group.FirstFrame = frames.size();
 	group.Intervals.reserve(numFrames);
 
 	for (int i = 0; i < numFrames; ++i)
@@ -78,23 +84,75 @@ static std::optional<SpriteGroup> TryLoadSpriteGroup(BinaryReader& reader)
 		}
 	}
 
-	group.Frames.reserve(numFrames);
-
 	for (int i = 0; i < numFrames; ++i)
 	{
-		auto frame = TryLoadSingleSpriteFrame(reader);
+		auto frame = TryLoadSingleSpriteFrame(reader, frames.get_allocator().resource());
 
 		if (!frame)
 		{
 			return {};
 		}
 
-		group.Frames.push_back(std::move(*frame));
+		frames.push_back(std::move(*frame));
 	}
 
 	return group;
 }
 
+MemoryUsage GetMemoryUsage(const SpriteFile& sprite)
+{
+	MemoryUsage usage;
+
+	AddMemoryUsage(usage, sprite.Colormap);
+	usage.Add(MemoryCategory::Other, sprite.FrameDescriptors);
+	usage.Add(MemoryCategory::Other, sprite.Frames);
+
+	for (const auto& frame : sprite.Frames)
+	{
+		usage.Add(MemoryCategory::Textures, frame.Pixels);
+	}
+
+	usage.Add(MemoryCategory::Other, sprite.Groups);
+
+	for (const auto& group : sprite.Groups)
+	{
+		usage.Add(MemoryCategory::Other, group.Intervals);
+	}
+
+	return usage;
+}
+
+std::optional<SpriteInfo> TryReadSpriteInfo(FILE* file)
+{
+	std::array<std::byte, SpriteHeaderSize> header;
+
+	if (!TryReadFileRange(file, 0, header))
+	{
+		return {};
+	}
+
+	BinaryReader reader{ header };
+
+	if (reader.ReadFixedUTF8String(4) != "IDSP" || reader.ReadInt32() != SpriteVersion)
+	{
+		return {};
+	}
+
+	SpriteInfo info;
+
+	info.Type = static_cast<SpriteType>(reader.ReadInt32());
+	info.TextureFormat = static_cast<SpriteTextureFormat>(reader.ReadInt32());
+
+	// Bounding radius.
+	reader.ReadFloat();
+
+	info.Width = reader.ReadInt32();
+	info.Height = reader.ReadInt32();
+	info.FrameCount = reader.ReadInt32();
+
+	return info;
+}
+
 std::optional<SpriteFile> TryLoadSpriteFile(const std::string& fileName)
 {
 	FILE* file = std::fopen(fileName.c_str(), "rb");
@@ -111,15 +169,17 @@ std::optional<SpriteFile> TryLoadSpriteFile(const std::string& fileName)
 	return result;
 }
 
-std::optional<SpriteFile> TryLoadSpriteFile(FILE* file)
+std::optional<SpriteFile> TryLoadSpriteFile(FILE* file, LoadProgress* progress, int maxFrameCount)
 {
-	std::optional<std::vector<std::byte>> buffer = TryReadFileIntoBuffer(file);
+	const ScratchArena::Scope scratch;
+
+	const auto buffer = TryReadFileIntoBuffer(file, scratch.GetResource());
 
 	if (!buffer)
 	{
 		return {};
 	}
-	
+
 	// TODO: catch out_of_range exceptions and return appropriate result.
 	BinaryReader reader{ *buffer };
 
@@ -137,7 +197,8 @@ std::optional<SpriteFile> TryLoadSpriteFile(FILE* file)
 		return {};
 	}
 
-	SpriteFile sprite;
+	SpriteFile sprite{ std::make_unique<AssetArena>() };
+	const auto resource = sprite.Arena->GetResource();
 
 	sprite.Type = static_cast<SpriteType>(reader.ReadInt32());
 	sprite.TextureFormat = static_cast<SpriteTextureFormat>(reader.ReadInt32());
@@ -189,45 +250,60 @@ std::optional<SpriteFile> TryLoadSpriteFile(FILE* file)
 		return {};
 	}
 
-	sprite.Colormap.resize(ColormapColorCount);
+	std::array<RGB24, ColormapColorCount> colormap;
 
-	for (std::size_t i = 0; i < ColormapColorCount; ++i)
+	for (auto& color : colormap)
 	{
-		sprite.Colormap[i].R = reader.ReadUInt8();
-		sprite.Colormap[i].G = reader.ReadUInt8();
-		sprite.Colormap[i].B = reader.ReadUInt8();
+		color.R = reader.ReadUInt8();
+		color.G = reader.ReadUInt8();
+		color.B = reader.ReadUInt8();
 	}
 
-	sprite.Frames.reserve(numFrames);
+	sprite.Colormap = PalettePool::GetInstance().Intern(colormap);
 
-	for (int i = 0; i < numFrames; ++i)
+	const int frameCount = std::min(numFrames, std::max(maxFrameCount, 0));
+
+	sprite.FrameDescriptors.reserve(frameCount);
+	sprite.Frames.reserve(frameCount);
+
+	for (int i = 0; i < frameCount; ++i)
 	{
+		if (progress)
+		{
+			if (progress->IsCancelled())
+			{
+				return {};
+			}
+
+			progress->SetProgress(i, frameCount);
+		}
+
 		const SpriteFrameType type = static_cast<SpriteFrameType>(reader.ReadInt32());
 
 		if (type == SpriteFrameType::SINGLE)
 		{
-			auto frame = TryLoadSingleSpriteFrame(reader);
+			auto frame = TryLoadSingleSpriteFrame(reader, resource);
 
 			if (!frame)
 			{
 				return {};
 			}
 
+			sprite.FrameDescriptors.push_back({ SpriteFrameType::SINGLE, sprite.Frames.size() });
 			sprite.Frames.push_back(std::move(*frame));
 		}
 		else
 		{
-			auto group = TryLoadSpriteGroup(reader);
+			// The engine loads groups but doesn't draw them. They are kept so they can be previewed.
+			auto group = TryLoadSpriteGroup(reader, sprite.Frames);
 
 			if (!group)
 			{
 				return {};
 			}
 
-			// Groups are discarded because the engine does not support them at all.
-			// The engine does still keep them around and skips rendering group frames
-			// but no sprite should contain group frames.
-			// TODO: report removal.
+			sprite.FrameDescriptors.push_back({ SpriteFrameType::GROUP, sprite.Groups.size() });
+			sprite.Groups.push_back(std::move(*group));
 		}
 	}
 
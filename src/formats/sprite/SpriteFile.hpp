@@ -3,13 +3,23 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <string>
 #include <variant>
+#include <vector>
 
 #include <glm/vec2.hpp>
 
-constexpr std::size_t ColormapColorCount = 256;
+#include "formats/Palette.hpp"
+#include "utils/Arena.hpp"
+#include "utils/MemoryUsage.hpp"
+
+class LoadProgress;
+
+constexpr int SpriteVersion = 2;
 
 enum class SpriteType : int
 {
@@ -40,47 +50,204 @@ enum class SpriteFrameType
 	GROUP
 };
 
-struct RGB24
-{
-	std::uint8_t R;
-	std::uint8_t G;
-	std::uint8_t B;
-};
-
 class SingleSpriteFrame
 {
 public:
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+
+	SingleSpriteFrame() = default;
+
+	explicit SingleSpriteFrame(const allocator_type& allocator)
+		: Pixels(allocator)
+	{
+	}
+
+	SingleSpriteFrame(const SingleSpriteFrame& other, const allocator_type& allocator)
+		: Origin(other.Origin)
+		, Width(other.Width)
+		, Height(other.Height)
+		, Pixels(other.Pixels, allocator)
+	{
+	}
+
+	SingleSpriteFrame(SingleSpriteFrame&& other, const allocator_type& allocator)
+		: Origin(other.Origin)
+		, Width(other.Width)
+		, Height(other.Height)
+		, Pixels(std::move(other.Pixels), allocator)
+	{
+	}
+
+	SingleSpriteFrame(const SingleSpriteFrame&) = default;
+	SingleSpriteFrame(SingleSpriteFrame&&) noexcept = default;
+	SingleSpriteFrame& operator=(const SingleSpriteFrame&) = default;
+	SingleSpriteFrame& operator=(SingleSpriteFrame&&) = default;
+
 	glm::ivec2 Origin{ 0 };
 	int Width{ 0 };
 	int Height{ 0 };
-	std::vector<std::uint8_t> Pixels;
+	std::pmr::vector<std::uint8_t> Pixels;
 };
 
+/**
+*	@brief A group of frames that animates on its own, independent of the entity's frame.
+*	The group's frames are stored in SpriteFile::Frames one after the other.
+*/
 class SpriteGroup
 {
 public:
-	std::vector<float> Intervals;
-	std::vector<SingleSpriteFrame> Frames;
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+
+	SpriteGroup() = default;
+
+	explicit SpriteGroup(const allocator_type& allocator)
+		: Intervals(allocator)
+	{
+	}
+
+	SpriteGroup(const SpriteGroup& other, const allocator_type& allocator)
+		: FirstFrame(other.FirstFrame)
+		, Intervals(other.Intervals, allocator)
+	{
+	}
+
+	SpriteGroup(SpriteGroup&& other, const allocator_type& allocator)
+		: FirstFrame(other.FirstFrame)
+		, Intervals(std::move(other.Intervals), allocator)
+	{
+	}
+
+	SpriteGroup(const SpriteGroup&) = default;
+	SpriteGroup(SpriteGroup&&) noexcept = default;
+	SpriteGroup& operator=(const SpriteGroup&) = default;
+	SpriteGroup& operator=(SpriteGroup&&) = default;
+
+	/**
+	*	@brief Index in SpriteFile::Frames of the group's first frame.
+	*/
+	std::size_t FirstFrame{ 0 };
+
+	/**
+	*	@brief Time in seconds at which each frame ends, relative to the start of the group.
+	*	These accumulate as stored in the file, so the last interval is the length of the group.
+	*/
+	std::pmr::vector<float> Intervals;
+
+	std::size_t GetFrameCount() const { return Intervals.size(); }
 };
 
+/**
+*	@brief An entry in the sprite's frame list, which is either a single frame or a group of frames.
+*/
+struct SpriteFrameDescriptor
+{
+	SpriteFrameType Type{ SpriteFrameType::SINGLE };
+
+	/**
+	*	@brief Index in SpriteFile::Frames for single frames, index in SpriteFile::Groups for groups.
+	*/
+	std::size_t Index{ 0 };
+};
+
+/**
+*	@brief A loaded sprite. Its frames are allocated from its arena, its palette is interned.
+*/
 class SpriteFile
 {
 public:
+	/**
+	*	@brief Creates an empty sprite that uses the default memory resource.
+	*/
+	SpriteFile() = default;
+
+	explicit SpriteFile(std::unique_ptr<AssetArena> arena)
+		: Arena(std::move(arena))
+		, FrameDescriptors(Arena->GetResource())
+		, Frames(Arena->GetResource())
+		, Groups(Arena->GetResource())
+	{
+	}
+
+	SpriteFile(SpriteFile&&) noexcept = default;
+
+	/**
+	*	@brief Takes over the other sprite's arena along with its contents.
+	*	@details See BspFile's move assignment operator.
+	*/
+	SpriteFile& operator=(SpriteFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			std::destroy_at(this);
+			std::construct_at(this, std::move(other));
+		}
+
+		return *this;
+	}
+
+	SpriteFile(const SpriteFile&) = delete;
+	SpriteFile& operator=(const SpriteFile&) = delete;
+
+	/**
+	*	@brief Declared first so it outlives the containers allocated from it. Null if the sprite uses the default memory resource.
+	*/
+	std::unique_ptr<AssetArena> Arena;
+
 	SpriteType Type{ SpriteType::ORIENTED };
 	SpriteTextureFormat TextureFormat{ SpriteTextureFormat::NORMAL };
 	float BoundingRadius{ 0 };
 	int Width{ 0 };
 	int Height{ 0 };
 	float BeamLength{ 0 };
-	SyncType SyncType{ SyncType::SYNC };
+	::SyncType SyncType{ ::SyncType::SYNC };
+
+	PaletteHandle Colormap;
 
-	std::vector<RGB24> Colormap; // 256 colors = 768 bytes
+	/**
+	*	@brief The frame list as stored in the file.
+	*/
+	std::pmr::vector<SpriteFrameDescriptor> FrameDescriptors;
 
-	std::vector<SingleSpriteFrame> Frames;
+	/**
+	*	@brief All frames in file order, including frames that are part of a group.
+	*/
+	std::pmr::vector<SingleSpriteFrame> Frames;
+
+	std::pmr::vector<SpriteGroup> Groups;
+};
+
+/**
+*	@brief Gets the memory owned by the sprite. Frame pixels count as textures.
+*/
+MemoryUsage GetMemoryUsage(const SpriteFile& sprite);
+
+/**
+*	@brief Summary of a sprite that can be read without loading its frames.
+*/
+struct SpriteInfo
+{
+	SpriteType Type{ SpriteType::ORIENTED };
+	SpriteTextureFormat TextureFormat{ SpriteTextureFormat::NORMAL };
+	int Width{ 0 };
+	int Height{ 0 };
+	/**
+	*	@brief Number of entries in the frame list. Groups count as a single entry.
+	*/
+	int FrameCount{ 0 };
 };
 
 const char* SpriteTypeToString(SpriteType type);
 const char* SpriteTextureFormatToString(SpriteTextureFormat format);
 
+/**
+*	@brief Reads only the sprite header.
+*/
+std::optional<SpriteInfo> TryReadSpriteInfo(FILE* file);
+
 std::optional<SpriteFile> TryLoadSpriteFile(const std::string& fileName);
-std::optional<SpriteFile> TryLoadSpriteFile(FILE* file);
+/**
+*	@param progress If not null, receives load progress and is checked for cancellation requests.
+*	@param maxFrameCount Frame list entries after this many are not decoded, for callers that only need the first few frames.
+*/
+std::optional<SpriteFile> TryLoadSpriteFile(FILE* file, LoadProgress* progress = nullptr,
+	int maxFrameCount = std::numeric_limits<int>::max());
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "formats/sprite/SpriteGenerator.hpp"
+#include "formats/wad/WadGenerator.hpp"
+
+#include "utils/BinaryWriter.hpp"
+#include "utils/DeterministicRandom.hpp"
+#include "utils/IOutils.hpp"
+
+// Interval of each frame in a group, in seconds.
+constexpr float GeneratedGroupFrameInterval = 0.1f;
+
+static void WriteFrame(BinaryWriter& writer, DeterministicRandom& random, const SpriteGeneratorSettings& settings,
+	std::vector<std::uint8_t>& pixels)
+{
+	const int width = static_cast<int>(random.NextInRange(std::max(1, settings.Width / 2), settings.Width));
+	const int height = static_cast<int>(random.NextInRange(std::max(1, settings.Height / 2), settings.Height));
+
+	// Centered, like most sprites.
+	writer.WriteInt32(-(width / 2));
+	writer.WriteInt32(height / 2);
+	writer.WriteInt32(width);
+	writer.WriteInt32(height);
+
+	pixels.resize(static_cast<std::size_t>(width) * height);
+
+	// A filled circle of noise, so every texture format has both transparent and opaque parts.
+	const int radiusSquared = (std::min(width, height) / 2) * (std::min(width, height) / 2);
+	const std::uint8_t transparentIndex = settings.TextureFormat == SpriteTextureFormat::ALPHTEST ? 255 : 0;
+
+	random.Fill(pixels);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const int dx = x - (width / 2);
+			const int dy = y - (height / 2);
+
+			auto& pixel = pixels[(static_cast<std::size_t>(y) * width) + x];
+
+			if (((dx * dx) + (dy * dy)) > radiusSquared)
+			{
+				pixel = transparentIndex;
+			}
+			else if (pixel == 255 && transparentIndex == 255)
+			{
+				pixel = 254;
+			}
+		}
+	}
+
+	writer.WriteBytes(std::as_bytes(std::span{ pixels }));
+}
+
+bool TryGenerateSpriteFile(const std::filesystem::path& fileName, const SpriteGeneratorSettings& settings)
+{
+	if (settings.FrameCount < 0 || settings.Width <= 0 || settings.Height <= 0 || settings.GroupSize < 0)
+	{
+		return false;
+	}
+
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	DeterministicRandom random{ settings.Seed };
+
+	BinaryWriter writer{ file };
+
+	const int groupSize = settings.GroupSize > 0 ? settings.GroupSize : 1;
+	const int entryCount = (settings.FrameCount + groupSize - 1) / groupSize;
+
+	writer.WriteFixedUTF8String("IDSP", 4);
+	writer.WriteInt32(SpriteVersion);
+	writer.WriteInt32(static_cast<std::int32_t>(settings.Type));
+	writer.WriteInt32(static_cast<std::int32_t>(settings.TextureFormat));
+	writer.WriteFloat(std::sqrt(static_cast<float>((settings.Width * settings.Width) + (settings.Height * settings.Height))) / 2);
+	writer.WriteInt32(settings.Width);
+	writer.WriteInt32(settings.Height);
+	writer.WriteInt32(entryCount);
+	writer.WriteFloat(0);
+	writer.WriteInt32(static_cast<std::int32_t>(settings.SyncType));
+
+	writer.WriteInt16(static_cast<std::int16_t>(ColormapColorCount));
+
+	for (const auto& color : GeneratePalette(random))
+	{
+		writer.WriteUInt8(color.R);
+		writer.WriteUInt8(color.G);
+		writer.WriteUInt8(color.B);
+	}
+
+	// Reused for every frame so generating doesn't allocate per frame.
+	std::vector<std::uint8_t> pixels;
+
+	for (int entry = 0, remaining = settings.FrameCount; entry < entryCount && writer.IsOk(); ++entry)
+	{
+		if (settings.GroupSize == 0)
+		{
+			writer.WriteInt32(static_cast<std::int32_t>(SpriteFrameType::SINGLE));
+			WriteFrame(writer, random, settings, pixels);
+			--remaining;
+			continue;
+		}
+
+		const int frameCount = std::min(groupSize, remaining);
+
+		writer.WriteInt32(static_cast<std::int32_t>(SpriteFrameType::GROUP));
+		writer.WriteInt32(frameCount);
+
+		// Intervals are cumulative.
+		for (int i = 1; i <= frameCount; ++i)
+		{
+			writer.WriteFloat(GeneratedGroupFrameInterval * i);
+		}
+
+		for (int i = 0; i < frameCount; ++i)
+		{
+			WriteFrame(writer, random, settings, pixels);
+		}
+
+		remaining -= frameCount;
+	}
+
+	const bool success = writer.IsOk();
+
+	return std::fclose(file) == 0 && success;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "formats/sprite/SpriteFile.hpp"
+
+/**
+*	@brief Settings for generated sprites. The same settings always produce the same file.
+*/
+struct SpriteGeneratorSettings
+{
+	std::uint64_t Seed{ 0 };
+
+	/**
+	*	@brief Total number of frames, including frames in groups.
+	*/
+	int FrameCount{ 16 };
+
+	int Width{ 64 };
+	int Height{ 64 };
+
+	/**
+	*	@brief If not 0, frames are stored in groups of this many frames instead of as single frames.
+	*/
+	int GroupSize{ 0 };
+
+	SpriteType Type{ SpriteType::VP_PARALLEL };
+	SpriteTextureFormat TextureFormat{ SpriteTextureFormat::NORMAL };
+	::SyncType SyncType{ ::SyncType::SYNC };
+};
+
+/**
+*	@brief Writes an IDSP version 2 sprite with random frames, streaming each frame to disk as it is generated.
+*	@details Frame sizes vary between half and the full size in the settings, like animated sprites often do.
+*/
+bool TryGenerateSpriteFile(const std::filesystem::path& fileName, const SpriteGeneratorSettings& settings);
@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory_resource>
+#include <mutex>
+#include <numbers>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "formats/studiomodel/StudioModelAnimator.hpp"
+
+#include "utils/Arena.hpp"
+
+namespace
+{
+// Sequences can remove the linear movement of their motion bone along these axes.
+constexpr std::int32_t StudioMotionX = 0x0001;
+constexpr std::int32_t StudioMotionY = 0x0002;
+constexpr std::int32_t StudioMotionZ = 0x0004;
+
+// Instances are handed out in batches so threads don't contend over the next instance.
+constexpr std::size_t InstanceBatchSize = 16;
+
+using Matrix = StudioBoneTransforms::Matrix;
+
+struct Quaternion
+{
+	float X{ 0 };
+	float Y{ 0 };
+	float Z{ 0 };
+	float W{ 1 };
+};
+
+struct BonePose
+{
+	Quaternion Rotation;
+	glm::vec3 Position{ 0 };
+};
+
+/**
+*	@brief Converts angles around the x, y and z axes in radians to a quaternion, like the engine does.
+*/
+Quaternion AngleQuaternion(float x, float y, float z)
+{
+	const float sy = std::sin(z * 0.5f);
+	const float cy = std::cos(z * 0.5f);
+	const float sp = std::sin(y * 0.5f);
+	const float cp = std::cos(y * 0.5f);
+	const float sr = std::sin(x * 0.5f);
+	const float cr = std::cos(x * 0.5f);
+
+	return {
+		(sr * cp * cy) - (cr * sp * sy),
+		(cr * sp * cy) + (sr * cp * sy),
+		(cr * cp * sy) - (sr * sp * cy),
+		(cr * cp * cy) + (sr * sp * sy)
+	};
+}
+
+/**
+*	@brief Interpolates along the shortest arc between two rotations, like the engine does.
+*/
+Quaternion QuaternionSlerp(const Quaternion& p, Quaternion q, float t)
+{
+	const float a = ((p.X - q.X) * (p.X - q.X)) + ((p.Y - q.Y) * (p.Y - q.Y)) + ((p.Z - q.Z) * (p.Z - q.Z)) + ((p.W - q.W) * (p.W - q.W));
+	const float b = ((p.X + q.X) * (p.X + q.X)) + ((p.Y + q.Y) * (p.Y + q.Y)) + ((p.Z + q.Z) * (p.Z + q.Z)) + ((p.W + q.W) * (p.W + q.W));
+
+	if (a > b)
+	{
+		q = { -q.X, -q.Y, -q.Z, -q.W };
+	}
+
+	const float cosom = (p.X * q.X) + (p.Y * q.Y) + (p.Z * q.Z) + (p.W * q.W);
+
+	float sclp;
+	float sclq;
+
+	if ((1.0f + cosom) <= 0.000001f)
+	{
+		// Opposite rotations, go through a perpendicular rotation.
+		sclp = std::sin((1.0f - t) * (0.5f * std::numbers::pi_v<float>));
+		sclq = std::sin(t * (0.5f * std::numbers::pi_v<float>));
+
+		return { (sclp * p.X) - (sclq * q.Y), (sclp * p.Y) + (sclq * q.X), (sclp * p.Z) - (sclq * q.W), q.Z };
+	}
+
+	if ((1.0f - cosom) > 0.000001f)
+	{
+		const float omega = std::acos(cosom);
+		const float sinom = std::sin(omega);
+		sclp = std::sin((1.0f - t) * omega) / sinom;
+		sclq = std::sin(t * omega) / sinom;
+	}
+	else
+	{
+		sclp = 1.0f - t;
+		sclq = t;
+	}
+
+	return { (sclp * p.X) + (sclq * q.X), (sclp * p.Y) + (sclq * q.Y), (sclp * p.Z) + (sclq * q.Z), (sclp * p.W) + (sclq * q.W) };
+}
+
+Matrix PoseMatrix(const BonePose& pose)
+{
+	const auto& [x, y, z, w] = pose.Rotation;
+
+	return {
+		1.0f - (2.0f * y * y) - (2.0f * z * z), (2.0f * x * y) - (2.0f * w * z), (2.0f * x * z) + (2.0f * w * y), pose.Position.x,
+		(2.0f * x * y) + (2.0f * w * z), 1.0f - (2.0f * x * x) - (2.0f * z * z), (2.0f * y * z) - (2.0f * w * x), pose.Position.y,
+		(2.0f * x * z) - (2.0f * w * y), (2.0f * y * z) + (2.0f * w * x), 1.0f - (2.0f * x * x) - (2.0f * y * y), pose.Position.z
+	};
+}
+
+Matrix ConcatTransforms(const Matrix& parent, const Matrix& child)
+{
+	Matrix result;
+
+	for (std::size_t row = 0; row < 3; ++row)
+	{
+		const float* p = parent.data() + (row * 4);
+
+		for (std::size_t column = 0; column < 4; ++column)
+		{
+			result[(row * 4) + column] = (p[0] * child[column]) + (p[1] * child[4 + column]) + (p[2] * child[8 + column])
+				+ (column == 3 ? p[3] : 0.0f);
+		}
+	}
+
+	return result;
+}
+
+/**
+*	@brief Gets the value of a channel at a frame. The runs must have been checked with AreValidAnimationValues.
+*/
+std::int16_t DecodeAnimationValue(const StudioAnimationValue* values, int frame)
+{
+	while (values->Count.Total <= frame)
+	{
+		frame -= values->Count.Total;
+		values += values->Count.Valid + 1;
+	}
+
+	// Values past the stored ones repeat the last stored value.
+	return values->Count.Valid > frame ? values[frame + 1].Value : values[values->Count.Valid].Value;
+}
+
+/**
+*	@brief Computes the pose of every bone at a frame of a sequence, using one set of animations of the sequence's blends.
+*/
+void ComputeBlendPose(const StudioModelFile& model, const StudioSequence& sequence, std::span<const StudioAnimation> animations,
+	float frame, std::span<BonePose> poses)
+{
+	const auto bones = model.GetBones();
+
+	frame = std::clamp(frame, 0.0f, static_cast<float>(sequence.FrameCount - 1));
+
+	const int first = static_cast<int>(frame);
+	const int next = std::min(first + 1, sequence.FrameCount - 1);
+	const float s = frame - static_cast<float>(first);
+
+	for (std::size_t i = 0; i < bones.size(); ++i)
+	{
+		const auto& bone = bones[i];
+		const auto& animation = animations[i];
+
+		float values[2][StudioAnimatedValueCount];
+
+		for (std::size_t channel = 0; channel < StudioAnimatedValueCount; ++channel)
+		{
+			values[0][channel] = values[1][channel] = bone.Values[channel];
+
+			if (animation.Offsets[channel] == 0)
+			{
+				continue;
+			}
+
+			const auto channelValues = reinterpret_cast<const StudioAnimationValue*>(
+				reinterpret_cast<const std::byte*>(&animation) + animation.Offsets[channel]);
+
+			values[0][channel] += DecodeAnimationValue(channelValues, first) * bone.Scales[channel];
+			values[1][channel] += DecodeAnimationValue(channelValues, next) * bone.Scales[channel];
+		}
+
+		auto& pose = poses[i];
+
+		pose.Rotation = AngleQuaternion(values[0][3], values[0][4], values[0][5]);
+
+		if (!std::equal(values[0] + 3, values[0] + 6, values[1] + 3))
+		{
+			pose.Rotation = QuaternionSlerp(pose.Rotation, AngleQuaternion(values[1][3], values[1][4], values[1][5]), s);
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			pose.Position[axis] = (values[0][axis] * (1.0f - s)) + (values[1][axis] * s);
+		}
+	}
+
+	if (sequence.MotionBone >= 0 && static_cast<std::size_t>(sequence.MotionBone) < bones.size())
+	{
+		auto& position = poses[sequence.MotionBone].Position;
+
+		if ((sequence.MotionType & StudioMotionX) != 0)
+		{
+			position.x = 0;
+		}
+
+		if ((sequence.MotionType & StudioMotionY) != 0)
+		{
+			position.y = 0;
+		}
+
+		if ((sequence.MotionType & StudioMotionZ) != 0)
+		{
+			position.z = 0;
+		}
+	}
+}
+
+void BlendPoses(std::span<BonePose> poses, std::span<const BonePose> other, float weight)
+{
+	for (std::size_t i = 0; i < poses.size(); ++i)
+	{
+		poses[i].Rotation = QuaternionSlerp(poses[i].Rotation, other[i].Rotation, weight);
+		poses[i].Position = (poses[i].Position * (1.0f - weight)) + (other[i].Position * weight);
+	}
+}
+
+/**
+*	@brief Selects the vertices or normals of one model per body part, laid out for the skinning kernels.
+*/
+template<typename GetVectors, typename GetBones>
+StudioSkinningInput CreateSkinningInput(std::span<const StudioSubModel* const> models, GetVectors&& getVectors, GetBones&& getBones)
+{
+	StudioSkinningInput input;
+
+	for (const auto model : models)
+	{
+		input.Count += getVectors(*model).size();
+	}
+
+	input.Vectors.Resize(input.Count);
+	input.Bones.resize(PadToSkinningLanes(input.Count));
+
+	std::size_t index = 0;
+
+	for (const auto model : models)
+	{
+		const auto vectors = getVectors(*model);
+		const auto bones = getBones(*model);
+
+		for (std::size_t i = 0; i < vectors.size(); ++i, ++index)
+		{
+			input.Vectors.X[index] = vectors[i].x;
+			input.Vectors.Y[index] = vectors[i].y;
+			input.Vectors.Z[index] = vectors[i].z;
+			input.Bones[index] = bones[i];
+		}
+	}
+
+	return input;
+}
+}
+
+struct StudioModelAnimator::SequenceAnimations
+{
+	std::once_flag Once;
+	std::optional<StudioSequenceAnimations> Animations;
+};
+
+StudioModelAnimator::StudioModelAnimator(const StudioModelFile& model, int body)
+	: _model(&model)
+	, _sequenceAnimations(std::make_unique<SequenceAnimations[]>(model.GetSequences().size()))
+{
+	std::vector<const StudioSubModel*> models;
+
+	for (const auto& bodyPart : model.GetBodyParts())
+	{
+		const auto bodyPartModels = model.GetModels(bodyPart);
+
+		if (!bodyPartModels.empty())
+		{
+			const int base = std::max(1, bodyPart.Base);
+			models.push_back(&bodyPartModels[static_cast<std::size_t>(std::abs(body / base)) % bodyPartModels.size()]);
+		}
+	}
+
+	_vertexes = CreateSkinningInput(models,
+		[&](const auto& subModel) { return model.GetVertexes(subModel); },
+		[&](const auto& subModel) { return model.GetVertexBones(subModel); });
+
+	_normals = CreateSkinningInput(models,
+		[&](const auto& subModel) { return model.GetNormals(subModel); },
+		[&](const auto& subModel) { return model.GetNormalBones(subModel); });
+}
+
+StudioModelAnimator::~StudioModelAnimator() = default;
+
+const StudioSequenceAnimations* StudioModelAnimator::GetAnimations(int sequence) const
+{
+	const auto sequences = _model->GetSequences();
+
+	if (sequence < 0 || static_cast<std::size_t>(sequence) >= sequences.size())
+	{
+		return nullptr;
+	}
+
+	auto& entry = _sequenceAnimations[sequence];
+
+	std::call_once(entry.Once, [&]
+		{
+			const auto& sequenceData = sequences[sequence];
+			auto animations = _model->GetAnimations(sequenceData);
+
+			if (animations && AreValidAnimationValues(*animations, sequenceData.FrameCount))
+			{
+				entry.Animations = animations;
+			}
+		});
+
+	return entry.Animations ? &*entry.Animations : nullptr;
+}
+
+bool StudioModelAnimator::TryComputeBoneTransforms(const StudioModelPose& pose, StudioBoneTransforms& bones) const
+{
+	const std::size_t boneCount = GetBoneCount();
+
+	bones.Resize(boneCount);
+
+	const ScratchArena::Scope scratch;
+
+	// Room for both blends of both sequences.
+	std::pmr::vector<BonePose> poses(boneCount * 4, scratch.GetResource());
+	const std::span allPoses{ poses };
+
+	const auto computeSequencePose = [&](const StudioAnimationState& state, std::span<BonePose> sequencePoses, std::span<BonePose> blendPoses)
+	{
+		const auto animations = GetAnimations(state.Sequence);
+
+		if (!animations)
+		{
+			return false;
+		}
+
+		const auto& sequence = _model->GetSequences()[state.Sequence];
+
+		ComputeBlendPose(*_model, sequence, animations->Animations.first(boneCount), state.Frame, sequencePoses);
+
+		// Only the first two blends are used, like the engine does.
+		if (sequence.BlendCount > 1 && state.Blend > 0)
+		{
+			ComputeBlendPose(*_model, sequence, animations->Animations.subspan(boneCount, boneCount), state.Frame, blendPoses);
+			BlendPoses(sequencePoses, blendPoses, std::min(state.Blend, 1.0f));
+		}
+
+		return true;
+	};
+
+	const auto mainPoses = allPoses.first(boneCount);
+
+	if (!computeSequencePose(pose.Sequence, mainPoses, allPoses.subspan(boneCount, boneCount)))
+	{
+		return false;
+	}
+
+	if (pose.BlendWeight > 0)
+	{
+		const auto otherPoses = allPoses.subspan(boneCount * 2, boneCount);
+
+		if (!computeSequencePose(pose.BlendSequence, otherPoses, allPoses.subspan(boneCount * 3, boneCount)))
+		{
+			return false;
+		}
+
+		BlendPoses(mainPoses, otherPoses, std::min(pose.BlendWeight, 1.0f));
+	}
+
+	// Parents come before their children, so their transform is always known.
+	std::pmr::vector<Matrix> transforms(boneCount, scratch.GetResource());
+
+	const auto modelBones = _model->GetBones();
+
+	for (std::size_t i = 0; i < boneCount; ++i)
+	{
+		const auto local = PoseMatrix(mainPoses[i]);
+		const auto parent = modelBones[i].Parent;
+
+		transforms[i] = parent == -1 ? local : ConcatTransforms(transforms[parent], local);
+
+		bones.Set(i, transforms[i]);
+	}
+
+	return true;
+}
+
+void EvaluateStudioModelInstances(std::span<StudioModelInstance> instances, StudioSkinningKernel kernel, unsigned int maxThreadCount)
+{
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	const std::size_t batchCount = (instances.size() + InstanceBatchSize - 1) / InstanceBatchSize;
+	const unsigned int threadCount = static_cast<unsigned int>(std::min<std::size_t>(maxThreadCount, batchCount));
+
+	std::atomic<std::size_t> nextBatch{ 0 };
+
+	const auto work = [&]
+	{
+		for (std::size_t batch = nextBatch++; batch < batchCount; batch = nextBatch++)
+		{
+			const auto end = std::min(instances.size(), (batch + 1) * InstanceBatchSize);
+
+			for (std::size_t i = batch * InstanceBatchSize; i < end; ++i)
+			{
+				auto& instance = instances[i];
+
+				instance.Valid = instance.Animator && instance.Animator->TryComputeBoneTransforms(instance.Pose, instance.Bones);
+
+				if (instance.Valid)
+				{
+					SkinStudioVectors(instance.Bones, instance.Animator->GetVertexes(), true, instance.Vertexes, kernel);
+					SkinStudioVectors(instance.Bones, instance.Animator->GetNormals(), false, instance.Normals, kernel);
+				}
+			}
+		}
+	};
+
+	if (threadCount <= 1)
+	{
+		work();
+		return;
+	}
+
+	std::vector<std::jthread> threads;
+
+	threads.reserve(threadCount - 1);
+
+	for (unsigned int i = 1; i < threadCount; ++i)
+	{
+		threads.emplace_back(work);
+	}
+
+	// This thread helps out too. The other threads are joined when they go out of scope.
+	work();
+}
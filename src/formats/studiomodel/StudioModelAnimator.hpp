@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "formats/studiomodel/StudioModelFile.hpp"
+#include "formats/studiomodel/StudioModelSkinning.hpp"
+
+struct StudioAnimationState
+{
+	int Sequence{ 0 };
+
+	/**
+	*	@brief Frame in the sequence, fractions interpolate between frames. Clamped to the sequence's frames.
+	*/
+	float Frame{ 0 };
+
+	/**
+	*	@brief Position between the sequence's first and second blend, 0 to 1. Ignored for sequences with one blend.
+	*/
+	float Blend{ 0 };
+};
+
+struct StudioModelPose
+{
+	StudioAnimationState Sequence;
+
+	/**
+	*	@brief Sequence blended over the first one by @c BlendWeight, for transitions between sequences.
+	*/
+	StudioAnimationState BlendSequence;
+	float BlendWeight{ 0 };
+};
+
+/**
+*	@brief Computes bone transforms of a model in any pose, and holds the vertices and normals of the model in the layout
+*	the skinning kernels use.
+*	@details Animation values are decoded straight from the mapped file. Each sequence's values are checked the first time
+*	the sequence is used, which also opens its sequence group file.
+*	Bone controllers are not applied yet, bones use their default controller values.
+*	Thread safe, so one animator can be shared by every instance of a model.
+*/
+class StudioModelAnimator final
+{
+public:
+	/**
+	*	@param model Must outlive the animator, and must not be moved while the animator exists.
+	*	@param body Selects a model from each body part, like the body value of an entity.
+	*/
+	explicit StudioModelAnimator(const StudioModelFile& model, int body = 0);
+	~StudioModelAnimator();
+
+	StudioModelAnimator(const StudioModelAnimator&) = delete;
+	StudioModelAnimator& operator=(const StudioModelAnimator&) = delete;
+
+	const StudioModelFile& GetModel() const { return *_model; }
+
+	std::size_t GetBoneCount() const { return _model->GetBones().size(); }
+
+	/**
+	*	@brief Vertices of the selected model of each body part, one body part after the other.
+	*/
+	const StudioSkinningInput& GetVertexes() const { return _vertexes; }
+	const StudioSkinningInput& GetNormals() const { return _normals; }
+
+	/**
+	*	@brief Computes the transform of each bone in the given pose.
+	*	@return Whether the pose could be computed. Fails if a sequence doesn't exist, or its animations couldn't be loaded.
+	*/
+	bool TryComputeBoneTransforms(const StudioModelPose& pose, StudioBoneTransforms& bones) const;
+
+private:
+	struct SequenceAnimations;
+
+	/**
+	*	@return The sequence's animations if they are valid, or null otherwise.
+	*/
+	const StudioSequenceAnimations* GetAnimations(int sequence) const;
+
+private:
+	const StudioModelFile* _model;
+	std::unique_ptr<SequenceAnimations[]> _sequenceAnimations;
+
+	StudioSkinningInput _vertexes;
+	StudioSkinningInput _normals;
+};
+
+/**
+*	@brief A model in a scene, with the results of evaluating its pose.
+*	Results are kept between evaluations so evaluating the same instances again doesn't allocate.
+*/
+struct StudioModelInstance
+{
+	const StudioModelAnimator* Animator{};
+	StudioModelPose Pose;
+
+	StudioBoneTransforms Bones;
+	StudioVectorArrays Vertexes;
+	StudioVectorArrays Normals;
+
+	/**
+	*	@brief Whether the pose could be computed. The results are not valid if not.
+	*/
+	bool Valid{ false };
+};
+
+/**
+*	@brief Computes the bone transforms and skinned vertices and normals of every instance,
+*	spreading batches of instances over multiple threads.
+*	@param maxThreadCount Maximum number of threads to use. 0 uses one per hardware thread.
+*/
+void EvaluateStudioModelInstances(std::span<StudioModelInstance> instances,
+	StudioSkinningKernel kernel = StudioSkinningKernel::Automatic, unsigned int maxThreadCount = 0);
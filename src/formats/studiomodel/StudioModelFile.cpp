@@ -0,0 +1,666 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+#include "formats/studiomodel/StudioModelFile.hpp"
+#include "utils/IOutils.hpp"
+
+/**
+*	@brief Gets an array of structures in the file, or nothing if it doesn't lie entirely within the file.
+*	@details Studiomdl aligns everything it writes, so misaligned data is treated as invalid instead of being read unaligned.
+*/
+template<typename T>
+static std::optional<std::span<const T>> TryGetArray(std::span<const std::byte> data, std::int64_t offset, std::int64_t count)
+{
+	if (count == 0)
+	{
+		return std::span<const T>{};
+	}
+
+	if (offset < 0 || count < 0 || (offset % alignof(T)) != 0 || static_cast<std::uint64_t>(offset) > data.size()
+		|| static_cast<std::uint64_t>(count) > ((data.size() - static_cast<std::size_t>(offset)) / sizeof(T)))
+	{
+		return {};
+	}
+
+	return std::span{ reinterpret_cast<const T*>(data.data() + offset), static_cast<std::size_t>(count) };
+}
+
+/**
+*	@brief Gets an array that was checked when the file was opened.
+*/
+template<typename T>
+static std::span<const T> GetArray(std::span<const std::byte> data, std::int64_t offset, std::int64_t count)
+{
+	return TryGetArray<T>(data, offset, count).value_or(std::span<const T>{});
+}
+
+/**
+*	@brief Finds the end of a mesh's triangle commands, checking that every vertex lies within the file and the model.
+*	@return Number of values in the commands including the terminating 0, or nothing if the commands are invalid.
+*/
+static std::optional<std::size_t> TryMeasureTriangleCommands(std::span<const std::byte> data, std::int64_t offset,
+	std::int32_t vertexCount, std::int32_t normalCount)
+{
+	if (offset < 0 || (offset % alignof(std::int16_t)) != 0 || static_cast<std::uint64_t>(offset) > data.size())
+	{
+		return {};
+	}
+
+	const std::span commands{ reinterpret_cast<const std::int16_t*>(data.data() + offset),
+		(data.size() - static_cast<std::size_t>(offset)) / sizeof(std::int16_t) };
+
+	constexpr std::size_t ValuesPerVertex = sizeof(StudioTriangleVertex) / sizeof(std::int16_t);
+
+	std::size_t position = 0;
+
+	while (position < commands.size())
+	{
+		const int count = std::abs(static_cast<int>(commands[position++]));
+
+		if (count == 0)
+		{
+			return position;
+		}
+
+		if ((static_cast<std::size_t>(count) * ValuesPerVertex) > (commands.size() - position))
+		{
+			return {};
+		}
+
+		for (int i = 0; i < count; ++i, position += ValuesPerVertex)
+		{
+			if (commands[position] < 0 || commands[position] >= vertexCount
+				|| commands[position + 1] < 0 || commands[position + 1] >= normalCount)
+			{
+				return {};
+			}
+		}
+	}
+
+	// Ran off the end of the file without finding the terminator.
+	return {};
+}
+
+static bool HasId(const char (&id)[4], std::string_view expected)
+{
+	return std::string_view{ id, sizeof(id) } == expected;
+}
+
+template<typename T>
+static bool IsValidBoneReference(const T& value, std::int32_t boneCount)
+{
+	return value.Bone >= 0 && value.Bone < boneCount;
+}
+
+static bool IsValidTextureSet(const StudioHeader& header, std::span<const std::byte> data)
+{
+	const auto textures = TryGetArray<StudioTexture>(data, header.TextureOffset, header.TextureCount);
+
+	if (!textures)
+	{
+		return false;
+	}
+
+	for (const auto& texture : *textures)
+	{
+		if (texture.Width <= 0 || texture.Height <= 0
+			|| !TryGetArray<std::uint8_t>(data, texture.Offset,
+				(static_cast<std::int64_t>(texture.Width) * texture.Height) + (ColormapColorCount * sizeof(RGB24))))
+		{
+			return false;
+		}
+	}
+
+	const auto skins = TryGetArray<std::int16_t>(data, header.SkinOffset,
+		static_cast<std::int64_t>(header.SkinFamilyCount) * header.SkinReferenceCount);
+
+	return skins && std::all_of(skins->begin(), skins->end(), [&](auto index)
+		{
+			return index >= 0 && index < header.TextureCount;
+		});
+}
+
+/**
+*	@brief Checks that the animations of the sequences in a group lie within the file containing them.
+*/
+static bool AreValidAnimations(const StudioHeader& header, std::span<const StudioSequence> sequences,
+	int group, std::int64_t baseOffset, std::span<const std::byte> data)
+{
+	return std::all_of(sequences.begin(), sequences.end(), [&](const auto& sequence)
+		{
+			return sequence.SequenceGroup != group
+				|| TryGetArray<StudioAnimation>(data, baseOffset + sequence.AnimationOffset,
+					static_cast<std::int64_t>(sequence.BlendCount) * header.BoneCount);
+		});
+}
+
+/**
+*	@brief A companion file that is opened on first use.
+*/
+struct LazyStudioFile
+{
+	std::once_flag Once;
+	std::optional<MappedFile> File;
+};
+
+struct StudioModelFile::State
+{
+	std::filesystem::path Path;
+	MappedFile File;
+	const StudioHeader* Header{};
+
+	/**
+	*	@brief Set when the model has its own textures, or once the texture file has been opened.
+	*/
+	std::optional<StudioTextureSet> TextureSet;
+	LazyStudioFile TextureFile;
+
+	/**
+	*	@brief One per group. The first group is in the model itself, so its entry is never used.
+	*/
+	std::unique_ptr<LazyStudioFile[]> SequenceGroupFiles;
+	std::atomic<std::size_t> LoadedSequenceGroupCount{ 0 };
+
+	std::span<const std::byte> GetData() const { return File.GetData(); }
+};
+
+std::span<const StudioTexture> StudioTextureSet::GetTextures() const
+{
+	return GetArray<StudioTexture>(_data, _header->TextureOffset, _header->TextureCount);
+}
+
+std::span<const std::uint8_t> StudioTextureSet::GetPixels(const StudioTexture& texture) const
+{
+	return GetArray<std::uint8_t>(_data, texture.Offset, static_cast<std::int64_t>(texture.Width) * texture.Height);
+}
+
+std::span<const RGB24, ColormapColorCount> StudioTextureSet::GetPalette(const StudioTexture& texture) const
+{
+	const auto offset = texture.Offset + (static_cast<std::int64_t>(texture.Width) * texture.Height);
+	return GetArray<RGB24>(_data, offset, ColormapColorCount).first<ColormapColorCount>();
+}
+
+std::span<const std::int16_t> StudioTextureSet::GetSkin(int family) const
+{
+	if (family < 0 || family >= _header->SkinFamilyCount)
+	{
+		return {};
+	}
+
+	return GetArray<std::int16_t>(_data, _header->SkinOffset, static_cast<std::int64_t>(_header->SkinFamilyCount) * _header->SkinReferenceCount)
+		.subspan(static_cast<std::size_t>(family) * _header->SkinReferenceCount, _header->SkinReferenceCount);
+}
+
+bool AreValidAnimationValues(const StudioSequenceAnimations& animations, int frameCount)
+{
+	const auto data = animations.Data;
+
+	for (const auto& animation : animations.Animations)
+	{
+		const auto animationOffset = static_cast<std::size_t>(reinterpret_cast<const std::byte*>(&animation) - data.data());
+
+		for (const auto offset : animation.Offsets)
+		{
+			if (offset == 0)
+			{
+				continue;
+			}
+
+			auto position = animationOffset + offset;
+
+			for (int remaining = frameCount;;)
+			{
+				const auto header = TryGetArray<StudioAnimationValue>(data, static_cast<std::int64_t>(position), 1);
+
+				if (!header)
+				{
+					return false;
+				}
+
+				const auto [valid, total] = header->front().Count;
+
+				if (valid == 0 || valid > total
+					|| !TryGetArray<StudioAnimationValue>(data, static_cast<std::int64_t>(position), valid + 1))
+				{
+					return false;
+				}
+
+				if (total >= remaining)
+				{
+					break;
+				}
+
+				remaining -= total;
+				position += (valid + 1) * sizeof(StudioAnimationValue);
+			}
+		}
+	}
+
+	return true;
+}
+
+StudioModelFile::StudioModelFile(std::unique_ptr<State> state)
+	: _state(std::move(state))
+{
+}
+
+StudioModelFile::StudioModelFile(StudioModelFile&&) noexcept = default;
+StudioModelFile& StudioModelFile::operator=(StudioModelFile&&) noexcept = default;
+StudioModelFile::~StudioModelFile() = default;
+
+std::optional<StudioModelFile> StudioModelFile::TryOpen(const std::filesystem::path& path)
+{
+	auto file = MappedFile::TryOpen(path);
+
+	if (!file)
+	{
+		return {};
+	}
+
+	const auto data = file->GetData();
+
+	const auto headers = TryGetArray<StudioHeader>(data, 0, 1);
+
+	if (!headers || !HasId(headers->front().Id, "IDST") || headers->front().Version != StudioVersion)
+	{
+		return {};
+	}
+
+	const auto& header = headers->front();
+
+	const auto bones = TryGetArray<StudioBone>(data, header.BoneOffset, header.BoneCount);
+	const auto boneControllers = TryGetArray<StudioBoneController>(data, header.BoneControllerOffset, header.BoneControllerCount);
+	const auto hitboxes = TryGetArray<StudioHitbox>(data, header.HitboxOffset, header.HitboxCount);
+	const auto sequences = TryGetArray<StudioSequence>(data, header.SequenceOffset, header.SequenceCount);
+	const auto sequenceGroups = TryGetArray<StudioSequenceGroup>(data, header.SequenceGroupOffset, header.SequenceGroupCount);
+	const auto bodyParts = TryGetArray<StudioBodyPart>(data, header.BodyPartOffset, header.BodyPartCount);
+	const auto attachments = TryGetArray<StudioAttachment>(data, header.AttachmentOffset, header.AttachmentCount);
+
+	if (!bones || !boneControllers || !hitboxes || !sequences || !sequenceGroups || !bodyParts || !attachments
+		|| sequenceGroups->empty())
+	{
+		return {};
+	}
+
+	// Bones are set up in order, so parents have to come first.
+	for (std::int32_t i = 0; i < header.BoneCount; ++i)
+	{
+		if ((*bones)[i].Parent < -1 || (*bones)[i].Parent >= i)
+		{
+			return {};
+		}
+	}
+
+	const auto isValidBoneReference = [&](const auto& value)
+	{
+		return IsValidBoneReference(value, header.BoneCount);
+	};
+
+	if (!std::all_of(boneControllers->begin(), boneControllers->end(), isValidBoneReference)
+		|| !std::all_of(hitboxes->begin(), hitboxes->end(), isValidBoneReference)
+		|| !std::all_of(attachments->begin(), attachments->end(), isValidBoneReference))
+	{
+		return {};
+	}
+
+	for (const auto& sequence : *sequences)
+	{
+		if (sequence.FrameCount <= 0 || sequence.BlendCount <= 0
+			|| sequence.SequenceGroup < 0 || sequence.SequenceGroup >= header.SequenceGroupCount
+			|| !TryGetArray<StudioEvent>(data, sequence.EventOffset, sequence.EventCount))
+		{
+			return {};
+		}
+	}
+
+	// Other groups are checked when their file is opened.
+	if (!AreValidAnimations(header, *sequences, 0, sequenceGroups->front().Data, data))
+	{
+		return {};
+	}
+
+	for (const auto& bodyPart : *bodyParts)
+	{
+		const auto models = TryGetArray<StudioSubModel>(data, bodyPart.ModelOffset, bodyPart.ModelCount);
+
+		if (!models)
+		{
+			return {};
+		}
+
+		for (const auto& model : *models)
+		{
+			const auto meshes = TryGetArray<StudioMesh>(data, model.MeshOffset, model.MeshCount);
+			const auto vertexBones = TryGetArray<std::uint8_t>(data, model.VertexInfoOffset, model.VertexCount);
+			const auto normalBones = TryGetArray<std::uint8_t>(data, model.NormalInfoOffset, model.NormalCount);
+
+			if (!meshes || !vertexBones || !normalBones
+				|| !TryGetArray<glm::vec3>(data, model.VertexOffset, model.VertexCount)
+				|| !TryGetArray<glm::vec3>(data, model.NormalOffset, model.NormalCount))
+			{
+				return {};
+			}
+
+			const auto isValidBone = [&](std::uint8_t bone)
+			{
+				return bone < header.BoneCount;
+			};
+
+			if (!std::all_of(vertexBones->begin(), vertexBones->end(), isValidBone)
+				|| !std::all_of(normalBones->begin(), normalBones->end(), isValidBone))
+			{
+				return {};
+			}
+
+			for (const auto& mesh : *meshes)
+			{
+				if (!TryMeasureTriangleCommands(data, mesh.TriangleOffset, model.VertexCount, model.NormalCount))
+				{
+					return {};
+				}
+			}
+		}
+	}
+
+	auto state = std::make_unique<State>();
+
+	// Models without textures keep them in a texture file, checked once it is opened.
+	if (header.TextureCount > 0)
+	{
+		if (!IsValidTextureSet(header, data))
+		{
+			return {};
+		}
+
+		state->TextureSet.emplace(header, data);
+	}
+
+	state->Path = path;
+	state->File = std::move(*file);
+	state->Header = &header;
+	state->SequenceGroupFiles = std::make_unique<LazyStudioFile[]>(static_cast<std::size_t>(header.SequenceGroupCount));
+
+	return StudioModelFile{ std::move(state) };
+}
+
+const std::filesystem::path& StudioModelFile::GetPath() const
+{
+	return _state->Path;
+}
+
+const StudioHeader& StudioModelFile::GetHeader() const
+{
+	return *_state->Header;
+}
+
+std::span<const StudioBone> StudioModelFile::GetBones() const
+{
+	return GetArray<StudioBone>(_state->GetData(), _state->Header->BoneOffset, _state->Header->BoneCount);
+}
+
+std::span<const StudioBoneController> StudioModelFile::GetBoneControllers() const
+{
+	return GetArray<StudioBoneController>(_state->GetData(), _state->Header->BoneControllerOffset, _state->Header->BoneControllerCount);
+}
+
+std::span<const StudioHitbox> StudioModelFile::GetHitboxes() const
+{
+	return GetArray<StudioHitbox>(_state->GetData(), _state->Header->HitboxOffset, _state->Header->HitboxCount);
+}
+
+std::span<const StudioSequence> StudioModelFile::GetSequences() const
+{
+	return GetArray<StudioSequence>(_state->GetData(), _state->Header->SequenceOffset, _state->Header->SequenceCount);
+}
+
+std::span<const StudioSequenceGroup> StudioModelFile::GetSequenceGroups() const
+{
+	return GetArray<StudioSequenceGroup>(_state->GetData(), _state->Header->SequenceGroupOffset, _state->Header->SequenceGroupCount);
+}
+
+std::span<const StudioBodyPart> StudioModelFile::GetBodyParts() const
+{
+	return GetArray<StudioBodyPart>(_state->GetData(), _state->Header->BodyPartOffset, _state->Header->BodyPartCount);
+}
+
+std::span<const StudioAttachment> StudioModelFile::GetAttachments() const
+{
+	return GetArray<StudioAttachment>(_state->GetData(), _state->Header->AttachmentOffset, _state->Header->AttachmentCount);
+}
+
+std::span<const StudioEvent> StudioModelFile::GetEvents(const StudioSequence& sequence) const
+{
+	return GetArray<StudioEvent>(_state->GetData(), sequence.EventOffset, sequence.EventCount);
+}
+
+std::span<const StudioSubModel> StudioModelFile::GetModels(const StudioBodyPart& bodyPart) const
+{
+	return GetArray<StudioSubModel>(_state->GetData(), bodyPart.ModelOffset, bodyPart.ModelCount);
+}
+
+std::span<const StudioMesh> StudioModelFile::GetMeshes(const StudioSubModel& model) const
+{
+	return GetArray<StudioMesh>(_state->GetData(), model.MeshOffset, model.MeshCount);
+}
+
+std::span<const glm::vec3> StudioModelFile::GetVertexes(const StudioSubModel& model) const
+{
+	return GetArray<glm::vec3>(_state->GetData(), model.VertexOffset, model.VertexCount);
+}
+
+std::span<const std::uint8_t> StudioModelFile::GetVertexBones(const StudioSubModel& model) const
+{
+	return GetArray<std::uint8_t>(_state->GetData(), model.VertexInfoOffset, model.VertexCount);
+}
+
+std::span<const glm::vec3> StudioModelFile::GetNormals(const StudioSubModel& model) const
+{
+	return GetArray<glm::vec3>(_state->GetData(), model.NormalOffset, model.NormalCount);
+}
+
+std::span<const std::uint8_t> StudioModelFile::GetNormalBones(const StudioSubModel& model) const
+{
+	return GetArray<std::uint8_t>(_state->GetData(), model.NormalInfoOffset, model.NormalCount);
+}
+
+std::span<const std::int16_t> StudioModelFile::GetTriangleCommands(const StudioMesh& mesh) const
+{
+	// Meshes don't store the size of their commands, so they are measured again. This only walks the command headers.
+	const auto data = _state->GetData();
+	const auto length = TryMeasureTriangleCommands(data, mesh.TriangleOffset,
+		std::numeric_limits<std::int16_t>::max(), std::numeric_limits<std::int16_t>::max());
+
+	return GetArray<std::int16_t>(data, mesh.TriangleOffset, static_cast<std::int64_t>(length.value_or(0)));
+}
+
+bool StudioModelFile::HasExternalTextures() const
+{
+	return _state->Header->TextureCount == 0;
+}
+
+const StudioTextureSet* StudioModelFile::GetTextureSet() const
+{
+	if (!HasExternalTextures())
+	{
+		return &*_state->TextureSet;
+	}
+
+	auto& lazyFile = _state->TextureFile;
+
+	std::call_once(lazyFile.Once, [&]
+		{
+			auto file = MappedFile::TryOpen(GetStudioTextureFilePath(_state->Path));
+
+			if (!file)
+			{
+				return;
+			}
+
+			const auto headers = TryGetArray<StudioHeader>(file->GetData(), 0, 1);
+
+			if (!headers || !HasId(headers->front().Id, "IDST") || headers->front().Version != StudioVersion
+				|| !IsValidTextureSet(headers->front(), file->GetData()))
+			{
+				return;
+			}
+
+			lazyFile.File = std::move(file);
+			_state->TextureSet.emplace(headers->front(), lazyFile.File->GetData());
+		});
+
+	return _state->TextureSet ? &*_state->TextureSet : nullptr;
+}
+
+std::optional<StudioSequenceAnimations> StudioModelFile::GetAnimations(const StudioSequence& sequence) const
+{
+	const auto& header = *_state->Header;
+	const auto count = static_cast<std::int64_t>(sequence.BlendCount) * header.BoneCount;
+
+	if (sequence.SequenceGroup == 0)
+	{
+		const auto data = _state->GetData();
+		const auto offset = GetSequenceGroups().front().Data + static_cast<std::int64_t>(sequence.AnimationOffset);
+
+		return StudioSequenceAnimations{ GetArray<StudioAnimation>(data, offset, count), data };
+	}
+
+	auto& lazyFile = _state->SequenceGroupFiles[sequence.SequenceGroup];
+
+	std::call_once(lazyFile.Once, [&]
+		{
+			auto file = MappedFile::TryOpen(GetStudioSequenceGroupPath(_state->Path, sequence.SequenceGroup));
+
+			if (!file)
+			{
+				return;
+			}
+
+			const auto headers = TryGetArray<StudioSequenceGroupHeader>(file->GetData(), 0, 1);
+
+			if (!headers || !HasId(headers->front().Id, "IDSQ") || headers->front().Version != StudioVersion
+				|| !AreValidAnimations(header, GetSequences(), sequence.SequenceGroup, 0, file->GetData()))
+			{
+				return;
+			}
+
+			lazyFile.File = std::move(file);
+			++_state->LoadedSequenceGroupCount;
+		});
+
+	if (!lazyFile.File)
+	{
+		return {};
+	}
+
+	const auto data = lazyFile.File->GetData();
+
+	return StudioSequenceAnimations{ GetArray<StudioAnimation>(data, sequence.AnimationOffset, count), data };
+}
+
+std::size_t StudioModelFile::GetLoadedSequenceGroupCount() const
+{
+	return _state->LoadedSequenceGroupCount;
+}
+
+MemoryUsage GetMemoryUsage(const StudioModelFile& model)
+{
+	MemoryUsage usage;
+
+	usage.AddHeap(MemoryCategory::Other, sizeof(StudioModelFile::State));
+	usage.AddHeap(MemoryCategory::Other, model.GetSequenceGroups().size() * sizeof(LazyStudioFile));
+
+	return usage;
+}
+
+std::filesystem::path GetStudioSequenceGroupPath(const std::filesystem::path& modelPath, int group)
+{
+	if (group == 0)
+	{
+		return modelPath;
+	}
+
+	char suffix[16];
+	std::snprintf(suffix, sizeof(suffix), "%02d", group);
+
+	auto fileName = modelPath.stem();
+	fileName += suffix;
+	fileName += modelPath.extension();
+
+	return modelPath.parent_path() / fileName;
+}
+
+std::filesystem::path GetStudioTextureFilePath(const std::filesystem::path& modelPath)
+{
+	auto fileName = modelPath.stem();
+	fileName += "T";
+	fileName += modelPath.extension();
+
+	return modelPath.parent_path() / fileName;
+}
+
+bool IsStudioModelCompanionFile(const std::filesystem::path& path)
+{
+	const auto stem = path.stem().native();
+
+	// <model>T.mdl
+	if (stem.size() > 1 && (stem.back() == 'T' || stem.back() == 't'))
+	{
+		auto modelPath = path;
+		modelPath.replace_filename(stem.substr(0, stem.size() - 1));
+		modelPath += path.extension();
+
+		std::error_code ec;
+
+		if (std::filesystem::is_regular_file(modelPath, ec))
+		{
+			return true;
+		}
+	}
+
+	// <model>01.mdl and so on.
+	const auto isDigit = [](auto c)
+	{
+		return c >= '0' && c <= '9';
+	};
+
+	if (stem.size() > 2 && isDigit(stem[stem.size() - 1]) && isDigit(stem[stem.size() - 2]))
+	{
+		auto modelPath = path;
+		modelPath.replace_filename(stem.substr(0, stem.size() - 2));
+		modelPath += path.extension();
+
+		std::error_code ec;
+
+		return std::filesystem::is_regular_file(modelPath, ec);
+	}
+
+	return false;
+}
+
+std::optional<StudioModelInfo> TryReadStudioModelInfo(FILE* file)
+{
+	StudioHeader header;
+
+	if (!TryReadFileRange(file, 0, std::as_writable_bytes(std::span{ &header, 1 }))
+		|| !HasId(header.Id, "IDST") || header.Version != StudioVersion)
+	{
+		return {};
+	}
+
+	StudioModelInfo info;
+
+	info.BoneCount = header.BoneCount;
+	info.SequenceCount = header.SequenceCount;
+	info.SequenceGroupCount = header.SequenceGroupCount;
+	info.TextureCount = header.TextureCount;
+	info.BBMin = header.BBMin;
+	info.BBMax = header.BBMax;
+
+	return info;
+}
@@ -0,0 +1,521 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <glm/vec3.hpp>
+
+#include "formats/Palette.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/MemoryUsage.hpp"
+
+constexpr int StudioVersion = 10;
+
+/**
+*	@brief Number of values animated per bone: position x, y, z and rotation x, y, z.
+*/
+constexpr std::size_t StudioAnimatedValueCount = 6;
+
+// The structures below have the same layout as the file, the loader returns views of them straight from the mapped file.
+// Offsets are relative to the start of the file that contains the data.
+
+struct StudioHeader
+{
+	char Id[4];
+	std::int32_t Version;
+	char Name[64];
+	std::int32_t Length;
+
+	glm::vec3 EyePosition;
+
+	/**
+	*	@brief Ideal movement hull size.
+	*/
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	/**
+	*	@brief Clipping bounding box.
+	*/
+	glm::vec3 BBMin;
+	glm::vec3 BBMax;
+
+	std::int32_t Flags;
+
+	std::int32_t BoneCount;
+	std::int32_t BoneOffset;
+
+	std::int32_t BoneControllerCount;
+	std::int32_t BoneControllerOffset;
+
+	std::int32_t HitboxCount;
+	std::int32_t HitboxOffset;
+
+	std::int32_t SequenceCount;
+	std::int32_t SequenceOffset;
+
+	std::int32_t SequenceGroupCount;
+	std::int32_t SequenceGroupOffset;
+
+	std::int32_t TextureCount;
+	std::int32_t TextureOffset;
+	std::int32_t TextureDataOffset;
+
+	std::int32_t SkinReferenceCount;
+	std::int32_t SkinFamilyCount;
+	std::int32_t SkinOffset;
+
+	std::int32_t BodyPartCount;
+	std::int32_t BodyPartOffset;
+
+	std::int32_t AttachmentCount;
+	std::int32_t AttachmentOffset;
+
+	// Unused by the engine.
+	std::int32_t SoundTable;
+	std::int32_t SoundOffset;
+	std::int32_t SoundGroups;
+	std::int32_t SoundGroupOffset;
+
+	std::int32_t TransitionCount;
+	std::int32_t TransitionOffset;
+};
+
+/**
+*	@brief Header of sequence group files (@c <model>01.mdl and so on), which only contain animation data.
+*/
+struct StudioSequenceGroupHeader
+{
+	char Id[4];
+	std::int32_t Version;
+	char Name[64];
+	std::int32_t Length;
+};
+
+struct StudioBone
+{
+	char Name[32];
+
+	/**
+	*	@brief Index of the parent bone, or -1 for root bones.
+	*/
+	std::int32_t Parent;
+	std::int32_t Flags;
+
+	/**
+	*	@brief Index of the controller that affects each value, or -1.
+	*/
+	std::int32_t BoneControllers[StudioAnimatedValueCount];
+
+	/**
+	*	@brief Default position and rotation.
+	*/
+	float Values[StudioAnimatedValueCount];
+
+	/**
+	*	@brief Scale applied to each animation value.
+	*/
+	float Scales[StudioAnimatedValueCount];
+};
+
+struct StudioBoneController
+{
+	std::int32_t Bone;
+	std::int32_t Type;
+	float Start;
+	float End;
+	std::int32_t Rest;
+
+	/**
+	*	@brief Index of the controller as set by the game, 4 is the mouth.
+	*/
+	std::int32_t Index;
+};
+
+struct StudioHitbox
+{
+	std::int32_t Bone;
+	std::int32_t Group;
+	glm::vec3 BBMin;
+	glm::vec3 BBMax;
+};
+
+struct StudioSequenceGroup
+{
+	char Label[32];
+
+	/**
+	*	@brief Path of the file relative to the game directory. The loader looks next to the model instead.
+	*/
+	char Name[64];
+	std::int32_t Unused;
+
+	/**
+	*	@brief For the first group, offset added to the animation offsets of its sequences.
+	*/
+	std::int32_t Data;
+};
+
+struct StudioSequence
+{
+	char Label[32];
+
+	float Fps;
+	std::int32_t Flags;
+
+	std::int32_t Activity;
+	std::int32_t ActivityWeight;
+
+	std::int32_t EventCount;
+	std::int32_t EventOffset;
+
+	std::int32_t FrameCount;
+
+	std::int32_t PivotCount;
+	std::int32_t PivotOffset;
+
+	std::int32_t MotionType;
+	std::int32_t MotionBone;
+	glm::vec3 LinearMovement;
+	std::int32_t AutoMovePositionOffset;
+	std::int32_t AutoMoveAngleOffset;
+
+	glm::vec3 BBMin;
+	glm::vec3 BBMax;
+
+	std::int32_t BlendCount;
+
+	/**
+	*	@brief Offset of the StudioAnimation list in the sequence's group: one per bone for each blend.
+	*/
+	std::int32_t AnimationOffset;
+
+	std::int32_t BlendTypes[2];
+	float BlendStarts[2];
+	float BlendEnds[2];
+	std::int32_t BlendParent;
+
+	std::int32_t SequenceGroup;
+
+	std::int32_t EntryNode;
+	std::int32_t ExitNode;
+	std::int32_t NodeFlags;
+
+	std::int32_t NextSequence;
+};
+
+struct StudioEvent
+{
+	std::int32_t Frame;
+	std::int32_t Event;
+	std::int32_t Type;
+	char Options[64];
+};
+
+struct StudioAttachment
+{
+	char Name[32];
+	std::int32_t Type;
+	std::int32_t Bone;
+	glm::vec3 Origin;
+	glm::vec3 Vectors[3];
+};
+
+/**
+*	@brief Offsets of the compressed values of a bone, relative to this structure. 0 if the value isn't animated.
+*/
+struct StudioAnimation
+{
+	std::uint16_t Offsets[StudioAnimatedValueCount];
+};
+
+/**
+*	@brief Run length encoded animation values: a header with the number of stored and total frames,
+*	followed by the stored values. The last stored value repeats for the remaining frames.
+*/
+union StudioAnimationValue
+{
+	struct
+	{
+		std::uint8_t Valid;
+		std::uint8_t Total;
+	} Count;
+
+	std::int16_t Value;
+};
+
+struct StudioBodyPart
+{
+	char Name[64];
+	std::int32_t ModelCount;
+
+	/**
+	*	@brief Used to compute which model is selected from the entity's body value.
+	*/
+	std::int32_t Base;
+	std::int32_t ModelOffset;
+};
+
+struct StudioTexture
+{
+	char Name[64];
+	std::int32_t Flags;
+	std::int32_t Width;
+	std::int32_t Height;
+
+	/**
+	*	@brief Offset of the pixels, which are followed by the texture's palette.
+	*/
+	std::int32_t Offset;
+};
+
+/**
+*	@brief One of the models a body part can be switched between.
+*/
+struct StudioSubModel
+{
+	char Name[64];
+
+	std::int32_t Type;
+	float BoundingRadius;
+
+	std::int32_t MeshCount;
+	std::int32_t MeshOffset;
+
+	std::int32_t VertexCount;
+
+	/**
+	*	@brief Offset of the bone index of each vertex, one byte per vertex.
+	*/
+	std::int32_t VertexInfoOffset;
+	std::int32_t VertexOffset;
+
+	std::int32_t NormalCount;
+	std::int32_t NormalInfoOffset;
+	std::int32_t NormalOffset;
+
+	std::int32_t GroupCount;
+	std::int32_t GroupOffset;
+};
+
+struct StudioMesh
+{
+	std::int32_t TriangleCount;
+
+	/**
+	*	@brief Offset of the triangle commands, see StudioModelFile::GetTriangleCommands.
+	*/
+	std::int32_t TriangleOffset;
+	std::int32_t SkinReference;
+
+	std::int32_t NormalCount;
+	std::int32_t NormalOffset;
+};
+
+/**
+*	@brief A vertex in a triangle command.
+*/
+struct StudioTriangleVertex
+{
+	std::int16_t Vertex;
+	std::int16_t Normal;
+	std::int16_t S;
+	std::int16_t T;
+};
+
+static_assert(sizeof(StudioHeader) == 244);
+static_assert(sizeof(StudioSequenceGroupHeader) == 76);
+static_assert(sizeof(StudioBone) == 112);
+static_assert(sizeof(StudioBoneController) == 24);
+static_assert(sizeof(StudioHitbox) == 32);
+static_assert(sizeof(StudioSequenceGroup) == 104);
+static_assert(sizeof(StudioSequence) == 176);
+static_assert(sizeof(StudioEvent) == 76);
+static_assert(sizeof(StudioAttachment) == 88);
+static_assert(sizeof(StudioAnimation) == 12);
+static_assert(sizeof(StudioAnimationValue) == 2);
+static_assert(sizeof(StudioBodyPart) == 76);
+static_assert(sizeof(StudioTexture) == 80);
+static_assert(sizeof(StudioSubModel) == 112);
+static_assert(sizeof(StudioMesh) == 20);
+static_assert(sizeof(StudioTriangleVertex) == 8);
+
+/**
+*	@brief Textures and skins, stored either in the model itself or in a companion @c <model>T.mdl file.
+*/
+class StudioTextureSet final
+{
+public:
+	StudioTextureSet(const StudioHeader& header, std::span<const std::byte> data)
+		: _header(&header)
+		, _data(data)
+	{
+	}
+
+	std::span<const StudioTexture> GetTextures() const;
+
+	std::span<const std::uint8_t> GetPixels(const StudioTexture& texture) const;
+	std::span<const RGB24, ColormapColorCount> GetPalette(const StudioTexture& texture) const;
+
+	int GetSkinFamilyCount() const { return _header->SkinFamilyCount; }
+
+	/**
+	*	@brief Gets the texture index used by each skin reference in the given skin family.
+	*/
+	std::span<const std::int16_t> GetSkin(int family) const;
+
+private:
+	const StudioHeader* _header;
+	std::span<const std::byte> _data;
+};
+
+/**
+*	@brief Animations of a sequence and the data their values are stored in.
+*/
+struct StudioSequenceAnimations
+{
+	/**
+	*	@brief One per bone for each blend, blends one after the other.
+	*/
+	std::span<const StudioAnimation> Animations;
+
+	/**
+	*	@brief The entire file the animations are in. Value offsets must be checked against it before use.
+	*/
+	std::span<const std::byte> Data;
+};
+
+/**
+*	@brief Checks that the compressed values of every animated bone cover @p frameCount frames and lie within the data.
+*	@details Run headers are only read by the code that decodes them, so this is checked separately from opening the model.
+*/
+bool AreValidAnimationValues(const StudioSequenceAnimations& animations, int frameCount);
+
+/**
+*	@brief Summary of a model that can be read without loading it.
+*/
+struct StudioModelInfo
+{
+	int BoneCount{ 0 };
+	int SequenceCount{ 0 };
+	int SequenceGroupCount{ 0 };
+	int TextureCount{ 0 };
+	glm::vec3 BBMin{ 0 };
+	glm::vec3 BBMax{ 0 };
+};
+
+/**
+*	@brief A memory mapped StudioModel (IDST version 10).
+*	@details Nothing is copied out of the file: every accessor returns a view of the mapping, checked when the model is opened.
+*	Models can keep their textures in a @c <model>T.mdl file and animations in @c <model>01.mdl, @c <model>02.mdl and so on.
+*	Those files are opened and checked the first time they are needed, so sequence groups that are never played are never read.
+*	Accessors are thread safe, the model is not modified after it is opened.
+*/
+class StudioModelFile final
+{
+public:
+	StudioModelFile(StudioModelFile&&) noexcept;
+	StudioModelFile& operator=(StudioModelFile&&) noexcept;
+	~StudioModelFile();
+
+	StudioModelFile(const StudioModelFile&) = delete;
+	StudioModelFile& operator=(const StudioModelFile&) = delete;
+
+	/**
+	*	@brief Maps the model and checks that everything the header refers to lies within the file.
+	*/
+	static std::optional<StudioModelFile> TryOpen(const std::filesystem::path& path);
+
+	const std::filesystem::path& GetPath() const;
+
+	const StudioHeader& GetHeader() const;
+
+	std::span<const StudioBone> GetBones() const;
+	std::span<const StudioBoneController> GetBoneControllers() const;
+	std::span<const StudioHitbox> GetHitboxes() const;
+	std::span<const StudioSequence> GetSequences() const;
+	std::span<const StudioSequenceGroup> GetSequenceGroups() const;
+	std::span<const StudioBodyPart> GetBodyParts() const;
+	std::span<const StudioAttachment> GetAttachments() const;
+
+	std::span<const StudioEvent> GetEvents(const StudioSequence& sequence) const;
+
+	std::span<const StudioSubModel> GetModels(const StudioBodyPart& bodyPart) const;
+	std::span<const StudioMesh> GetMeshes(const StudioSubModel& model) const;
+
+	std::span<const glm::vec3> GetVertexes(const StudioSubModel& model) const;
+	std::span<const std::uint8_t> GetVertexBones(const StudioSubModel& model) const;
+	std::span<const glm::vec3> GetNormals(const StudioSubModel& model) const;
+	std::span<const std::uint8_t> GetNormalBones(const StudioSubModel& model) const;
+
+	/**
+	*	@brief Gets the mesh's triangle commands, including the terminating 0.
+	*	@details Each command starts with a vertex count, followed by that many StudioTriangleVertex.
+	*	A positive count is a triangle strip, a negative count a triangle fan.
+	*/
+	std::span<const std::int16_t> GetTriangleCommands(const StudioMesh& mesh) const;
+
+	/**
+	*	@brief Whether the textures are in a separate @c <model>T.mdl file.
+	*/
+	bool HasExternalTextures() const;
+
+	/**
+	*	@brief Gets the model's textures, opening the texture file the first time if the model has one.
+	*	@return The textures, or null if the texture file is missing or invalid.
+	*/
+	const StudioTextureSet* GetTextureSet() const;
+
+	/**
+	*	@brief Gets the animations of a sequence, opening the sequence's group file the first time it is needed.
+	*	@return The animations, or nothing if the group file is missing or invalid.
+	*/
+	std::optional<StudioSequenceAnimations> GetAnimations(const StudioSequence& sequence) const;
+
+	/**
+	*	@brief Gets the number of sequence group files that have been opened so far.
+	*/
+	std::size_t GetLoadedSequenceGroupCount() const;
+
+private:
+	struct State;
+
+	explicit StudioModelFile(std::unique_ptr<State> state);
+
+	friend MemoryUsage GetMemoryUsage(const StudioModelFile& model);
+
+private:
+	std::unique_ptr<State> _state;
+};
+
+/**
+*	@brief Gets the bookkeeping memory of the model. Mapped files are not included, they're owned by the system's file cache.
+*/
+MemoryUsage GetMemoryUsage(const StudioModelFile& model);
+
+/**
+*	@brief Gets the path of a model's sequence group file. Group 0 is the model itself.
+*/
+std::filesystem::path GetStudioSequenceGroupPath(const std::filesystem::path& modelPath, int group);
+
+/**
+*	@brief Gets the path of the file a model keeps its textures in if they're not in the model itself.
+*/
+std::filesystem::path GetStudioTextureFilePath(const std::filesystem::path& modelPath);
+
+/**
+*	@brief Whether the file is the texture or sequence group file of a model next to it, rather than a model itself.
+*/
+bool IsStudioModelCompanionFile(const std::filesystem::path& path);
+
+/**
+*	@brief Reads only the model header.
+*/
+std::optional<StudioModelInfo> TryReadStudioModelInfo(FILE* file);
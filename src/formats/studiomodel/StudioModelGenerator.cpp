@@ -0,0 +1,535 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "formats/studiomodel/StudioModelFile.hpp"
+#include "formats/studiomodel/StudioModelGenerator.hpp"
+#include "formats/wad/WadGenerator.hpp"
+
+#include "utils/BinaryWriter.hpp"
+#include "utils/DeterministicRandom.hpp"
+#include "utils/IOutils.hpp"
+
+constexpr int StudioMaxBones = 128;
+
+// Vertex indices in triangle commands are 16 bit.
+constexpr int StudioMaxVertexes = std::numeric_limits<std::int16_t>::max();
+
+// Runs are limited by the 8 bit frame counts in their header.
+constexpr std::size_t StudioMaxRunLength = std::numeric_limits<std::uint8_t>::max();
+
+constexpr float GeneratedBoneLength = 8;
+constexpr float GeneratedVertexSpread = 4;
+
+// Animation values are 16 bit, scaled to 1/16th unit and 1/4096th radian.
+constexpr float GeneratedPositionScale = 1.f / 16;
+constexpr float GeneratedRotationScale = 1.f / 4096;
+
+template<std::size_t Size>
+static void CopyName(char (&destination)[Size], std::string_view name)
+{
+	std::memcpy(destination, name.data(), std::min(name.size(), Size - 1));
+}
+
+template<typename T>
+static void WriteStructures(BinaryWriter& writer, std::span<const T> values)
+{
+	writer.WriteBytes(std::as_bytes(values));
+}
+
+template<typename T>
+static void WriteStructure(BinaryWriter& writer, const T& value)
+{
+	WriteStructures(writer, std::span{ &value, 1 });
+}
+
+/**
+*	@brief Run length encodes the values of one animated channel.
+*	@details Values that repeat at the end of a run are only stored once, like studiomdl does.
+*/
+static void EncodeAnimationValues(std::span<const std::int16_t> frames, std::vector<StudioAnimationValue>& values)
+{
+	for (std::size_t start = 0; start < frames.size();)
+	{
+		const std::size_t total = std::min(frames.size() - start, StudioMaxRunLength);
+		std::size_t valid = total;
+
+		while (valid > 1 && frames[start + valid - 1] == frames[start + valid - 2])
+		{
+			--valid;
+		}
+
+		values.push_back(StudioAnimationValue{ .Count{ static_cast<std::uint8_t>(valid), static_cast<std::uint8_t>(total) } });
+
+		for (std::size_t i = 0; i < valid; ++i)
+		{
+			values.push_back(StudioAnimationValue{ .Value = frames[start + i] });
+		}
+
+		start += total;
+	}
+}
+
+/**
+*	@brief Generates the animations of a sequence: the StudioAnimation of each bone followed by all values.
+*	@details The root bone moves around, other bones rotate back and forth, hold still towards the end or not at all.
+*	@return The animation data, or nothing if the values are too far from the animations for 16 bit offsets.
+*/
+static std::optional<std::vector<std::byte>> TryGenerateSequenceAnimations(DeterministicRandom& random,
+	const StudioModelGeneratorSettings& settings)
+{
+	std::vector<StudioAnimation> animations(static_cast<std::size_t>(settings.BoneCount));
+	std::vector<StudioAnimationValue> values;
+	std::vector<std::int16_t> frames(static_cast<std::size_t>(settings.FrameCount));
+
+	for (std::size_t bone = 0; bone < animations.size(); ++bone)
+	{
+		for (std::size_t channel = 0; channel < StudioAnimatedValueCount; ++channel)
+		{
+			const bool isPosition = channel < 3;
+			const auto kind = random.NextInRange(0, 3);
+
+			if (isPosition ? bone != 0 : kind == 0)
+			{
+				continue;
+			}
+
+			if (!isPosition && kind == 1)
+			{
+				std::fill(frames.begin(), frames.end(), static_cast<std::int16_t>(random.NextInRange(-2048, 2048)));
+			}
+			else
+			{
+				const auto amplitude = static_cast<double>(isPosition ? random.NextInRange(64, 256) : random.NextInRange(256, 4096));
+				const auto phase = static_cast<double>(random.NextInRange(0, 359)) * std::numbers::pi / 180;
+
+				// Some bones come to rest before the sequence ends.
+				const std::size_t moving = kind == 2 ? std::max<std::size_t>(1, (frames.size() * 3) / 4) : frames.size();
+
+				for (std::size_t frame = 0; frame < frames.size(); ++frame)
+				{
+					const auto time = static_cast<double>(std::min(frame, moving - 1)) / static_cast<double>(frames.size());
+					frames[frame] = static_cast<std::int16_t>(std::lround(amplitude * std::sin(phase + (2 * std::numbers::pi * time))));
+				}
+			}
+
+			// Offsets are relative to the bone's StudioAnimation.
+			const std::size_t offset = ((animations.size() - bone) * sizeof(StudioAnimation)) + (values.size() * sizeof(StudioAnimationValue));
+
+			if (offset > std::numeric_limits<std::uint16_t>::max())
+			{
+				return {};
+			}
+
+			animations[bone].Offsets[channel] = static_cast<std::uint16_t>(offset);
+
+			EncodeAnimationValues(frames, values);
+		}
+	}
+
+	std::vector<std::byte> data;
+
+	const auto animationBytes = std::as_bytes(std::span{ animations });
+	const auto valueBytes = std::as_bytes(std::span{ values });
+
+	data.reserve(animationBytes.size() + valueBytes.size() + 2);
+	data.insert(data.end(), animationBytes.begin(), animationBytes.end());
+	data.insert(data.end(), valueBytes.begin(), valueBytes.end());
+	data.resize((data.size() + 3) & ~std::size_t{ 3 });
+
+	return data;
+}
+
+/**
+*	@brief Writes the textures and skins, and sets their offsets and counts in @p header.
+*/
+static void WriteTextures(BinaryWriter& writer, DeterministicRandom& random, const StudioModelGeneratorSettings& settings,
+	StudioHeader& header)
+{
+	const auto size = static_cast<std::size_t>(settings.TextureSize);
+
+	std::vector<std::uint8_t> pixels(size * size);
+	std::vector<StudioTexture> textures(static_cast<std::size_t>(settings.TextureCount));
+
+	header.TextureDataOffset = static_cast<std::int32_t>(writer.GetPosition());
+
+	for (std::size_t i = 0; i < textures.size(); ++i)
+	{
+		auto& texture = textures[i];
+
+		CopyName(texture.Name, "texture" + std::to_string(i) + ".bmp");
+		texture.Width = settings.TextureSize;
+		texture.Height = settings.TextureSize;
+		texture.Offset = static_cast<std::int32_t>(writer.GetPosition());
+
+		random.Fill(pixels);
+
+		WriteStructures(writer, std::span<const std::uint8_t>{ pixels });
+		WriteStructures(writer, std::span<const RGB24>{ GeneratePalette(random) });
+	}
+
+	writer.Align(4);
+
+	header.TextureCount = settings.TextureCount;
+	header.TextureOffset = static_cast<std::int32_t>(writer.GetPosition());
+
+	WriteStructures(writer, std::span<const StudioTexture>{ textures });
+
+	// A single skin family that uses each texture once.
+	header.SkinReferenceCount = settings.TextureCount;
+	header.SkinFamilyCount = 1;
+	header.SkinOffset = static_cast<std::int32_t>(writer.GetPosition());
+
+	for (int i = 0; i < settings.TextureCount; ++i)
+	{
+		writer.WriteInt16(static_cast<std::int16_t>(i));
+	}
+
+	writer.Align(4);
+}
+
+static bool TryGenerateTextureFile(const std::filesystem::path& fileName, DeterministicRandom& random,
+	const StudioModelGeneratorSettings& settings)
+{
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	BinaryWriter writer{ file };
+
+	StudioHeader header{};
+
+	writer.WriteZeroes(sizeof(header));
+
+	WriteTextures(writer, random, settings, header);
+
+	std::memcpy(header.Id, "IDST", sizeof(header.Id));
+	header.Version = StudioVersion;
+	CopyName(header.Name, "models/" + fileName.filename().string());
+	header.Length = static_cast<std::int32_t>(writer.GetPosition());
+
+	writer.SetPosition(0);
+	WriteStructure(writer, header);
+
+	const bool success = writer.IsOk();
+
+	return std::fclose(file) == 0 && success;
+}
+
+static bool TryGenerateSequenceGroupFile(const std::filesystem::path& fileName, std::span<const std::vector<std::byte>> animations,
+	std::span<StudioSequence> sequences, int group)
+{
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	BinaryWriter writer{ file };
+
+	writer.WriteZeroes(sizeof(StudioSequenceGroupHeader));
+
+	for (std::size_t i = 0; i < sequences.size(); ++i)
+	{
+		if (sequences[i].SequenceGroup == group)
+		{
+			sequences[i].AnimationOffset = static_cast<std::int32_t>(writer.GetPosition());
+			WriteStructures(writer, std::span<const std::byte>{ animations[i] });
+		}
+	}
+
+	StudioSequenceGroupHeader header{};
+
+	std::memcpy(header.Id, "IDSQ", sizeof(header.Id));
+	header.Version = StudioVersion;
+	CopyName(header.Name, "models/" + fileName.filename().string());
+	header.Length = static_cast<std::int32_t>(writer.GetPosition());
+
+	writer.SetPosition(0);
+	WriteStructure(writer, header);
+
+	const bool success = writer.IsOk();
+
+	return std::fclose(file) == 0 && success;
+}
+
+bool TryGenerateStudioModelFile(const std::filesystem::path& fileName, const StudioModelGeneratorSettings& settings)
+{
+	if (settings.BoneCount <= 0 || settings.BoneCount > StudioMaxBones
+		|| settings.VertexesPerBone < 3 || (settings.BoneCount * settings.VertexesPerBone) > StudioMaxVertexes
+		|| settings.SequenceCount <= 0 || settings.FrameCount <= 0 || settings.SequenceGroupCount <= 0
+		|| settings.TextureCount <= 0 || settings.TextureCount > std::numeric_limits<std::int16_t>::max()
+		|| settings.TextureSize <= 0 || settings.TextureSize > 4096)
+	{
+		return false;
+	}
+
+	DeterministicRandom random{ settings.Seed };
+
+	const auto boneCount = static_cast<std::size_t>(settings.BoneCount);
+	const auto vertexesPerBone = static_cast<std::size_t>(settings.VertexesPerBone);
+
+	// Bones branch off one of the last few bones, so the skeleton has both long chains and forks.
+	std::vector<StudioBone> bones(boneCount);
+	std::vector<glm::vec3> bonePositions(boneCount);
+
+	for (std::size_t i = 0; i < boneCount; ++i)
+	{
+		auto& bone = bones[i];
+
+		CopyName(bone.Name, "Bone" + std::to_string(i));
+		bone.Parent = i == 0 ? -1 : static_cast<std::int32_t>(random.NextInRange(std::max<std::int64_t>(0, i - 3), i - 1));
+		std::fill(std::begin(bone.BoneControllers), std::end(bone.BoneControllers), -1);
+
+		if (i > 0)
+		{
+			bone.Values[0] = static_cast<float>(random.NextInRange(-2, 2));
+			bone.Values[1] = static_cast<float>(random.NextInRange(-2, 2));
+			bone.Values[2] = GeneratedBoneLength;
+		}
+
+		std::fill(bone.Scales, bone.Scales + 3, GeneratedPositionScale);
+		std::fill(bone.Scales + 3, bone.Scales + StudioAnimatedValueCount, GeneratedRotationScale);
+
+		// Bones aren't rotated in their default pose.
+		bonePositions[i] = glm::vec3{ bone.Values[0], bone.Values[1], bone.Values[2] };
+
+		if (bone.Parent != -1)
+		{
+			bonePositions[i] += bonePositions[bone.Parent];
+		}
+	}
+
+	glm::vec3 mins{ std::numeric_limits<float>::max() };
+	glm::vec3 maxs{ std::numeric_limits<float>::lowest() };
+
+	for (const auto& position : bonePositions)
+	{
+		mins = glm::min(mins, position - GeneratedVertexSpread);
+		maxs = glm::max(maxs, position + GeneratedVertexSpread);
+	}
+
+	// Vertices are in the space of their bone, normals point away from the bone.
+	std::vector<glm::vec3> vertexes(boneCount * vertexesPerBone);
+	std::vector<glm::vec3> normals(vertexes.size());
+	std::vector<std::uint8_t> vertexBones(vertexes.size());
+
+	for (std::size_t i = 0; i < vertexes.size(); ++i)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			vertexes[i][axis] = static_cast<float>(random.NextInRange(-64, 64)) * (GeneratedVertexSpread / 64);
+		}
+
+		normals[i] = glm::length(vertexes[i]) > 0 ? glm::normalize(vertexes[i]) : glm::vec3{ 0, 0, 1 };
+		vertexBones[i] = static_cast<std::uint8_t>(i / vertexesPerBone);
+	}
+
+	// The vertices of each bone form a triangle strip, strips are divided over one mesh per texture.
+	const auto meshCount = static_cast<std::size_t>(settings.TextureCount);
+
+	std::vector<StudioMesh> meshes(meshCount);
+	std::vector<std::vector<std::int16_t>> meshCommands(meshCount);
+
+	for (std::size_t bone = 0; bone < boneCount; ++bone)
+	{
+		auto& mesh = meshes[bone % meshCount];
+		auto& commands = meshCommands[bone % meshCount];
+
+		commands.push_back(static_cast<std::int16_t>(vertexesPerBone));
+
+		for (std::size_t i = 0; i < vertexesPerBone; ++i)
+		{
+			const auto index = static_cast<std::int16_t>((bone * vertexesPerBone) + i);
+
+			commands.push_back(index);
+			commands.push_back(index);
+			commands.push_back(static_cast<std::int16_t>(random.NextInRange(0, settings.TextureSize - 1)));
+			commands.push_back(static_cast<std::int16_t>(random.NextInRange(0, settings.TextureSize - 1)));
+		}
+
+		mesh.TriangleCount += static_cast<std::int32_t>(vertexesPerBone - 2);
+		mesh.NormalCount += static_cast<std::int32_t>(vertexesPerBone);
+	}
+
+	std::vector<StudioSequence> sequences(static_cast<std::size_t>(settings.SequenceCount));
+	std::vector<std::vector<std::byte>> animations(sequences.size());
+
+	for (std::size_t i = 0; i < sequences.size(); ++i)
+	{
+		auto& sequence = sequences[i];
+
+		CopyName(sequence.Label, "sequence" + std::to_string(i));
+		sequence.Fps = 30;
+		sequence.FrameCount = settings.FrameCount;
+		sequence.BBMin = mins;
+		sequence.BBMax = maxs;
+		sequence.BlendCount = 1;
+		sequence.BlendEnds[0] = 1;
+		sequence.SequenceGroup = static_cast<std::int32_t>(i % static_cast<std::size_t>(settings.SequenceGroupCount));
+
+		auto data = TryGenerateSequenceAnimations(random, settings);
+
+		if (!data)
+		{
+			return false;
+		}
+
+		animations[i] = std::move(*data);
+	}
+
+	for (int group = 1; group < settings.SequenceGroupCount; ++group)
+	{
+		if (!TryGenerateSequenceGroupFile(GetStudioSequenceGroupPath(fileName, group), animations, sequences, group))
+		{
+			return false;
+		}
+	}
+
+	// Textures are generated last so the rest of the model doesn't depend on where they are stored.
+	if (settings.ExternalTextures && !TryGenerateTextureFile(GetStudioTextureFilePath(fileName), random, settings))
+	{
+		return false;
+	}
+
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	BinaryWriter writer{ file };
+
+	StudioHeader header{};
+
+	writer.WriteZeroes(sizeof(header));
+
+	const auto startSection = [&]
+	{
+		writer.Align(4);
+		return static_cast<std::int32_t>(writer.GetPosition());
+	};
+
+	header.BoneCount = settings.BoneCount;
+	header.BoneOffset = startSection();
+	WriteStructures(writer, std::span<const StudioBone>{ bones });
+
+	std::vector<StudioHitbox> hitboxes(boneCount);
+
+	for (std::size_t i = 0; i < boneCount; ++i)
+	{
+		hitboxes[i].Bone = static_cast<std::int32_t>(i);
+		hitboxes[i].BBMin = glm::vec3{ -GeneratedVertexSpread };
+		hitboxes[i].BBMax = glm::vec3{ GeneratedVertexSpread };
+	}
+
+	header.HitboxCount = settings.BoneCount;
+	header.HitboxOffset = startSection();
+	WriteStructures(writer, std::span<const StudioHitbox>{ hitboxes });
+
+	for (std::size_t i = 0; i < sequences.size(); ++i)
+	{
+		if (sequences[i].SequenceGroup == 0)
+		{
+			sequences[i].AnimationOffset = startSection();
+			WriteStructures(writer, std::span<const std::byte>{ animations[i] });
+		}
+	}
+
+	header.SequenceCount = settings.SequenceCount;
+	header.SequenceOffset = startSection();
+	WriteStructures(writer, std::span<const StudioSequence>{ sequences });
+
+	std::vector<StudioSequenceGroup> sequenceGroups(static_cast<std::size_t>(settings.SequenceGroupCount));
+
+	for (int i = 0; i < settings.SequenceGroupCount; ++i)
+	{
+		CopyName(sequenceGroups[i].Label, i == 0 ? std::string{ "default" } : "group" + std::to_string(i));
+		CopyName(sequenceGroups[i].Name, "models/" + GetStudioSequenceGroupPath(fileName, i).filename().string());
+	}
+
+	header.SequenceGroupCount = settings.SequenceGroupCount;
+	header.SequenceGroupOffset = startSection();
+	WriteStructures(writer, std::span<const StudioSequenceGroup>{ sequenceGroups });
+
+	StudioSubModel model{};
+
+	CopyName(model.Name, "body");
+	model.BoundingRadius = glm::length(glm::max(glm::abs(mins), glm::abs(maxs)));
+	model.VertexCount = static_cast<std::int32_t>(vertexes.size());
+	model.NormalCount = static_cast<std::int32_t>(normals.size());
+
+	model.VertexInfoOffset = startSection();
+	WriteStructures(writer, std::span<const std::uint8_t>{ vertexBones });
+
+	model.NormalInfoOffset = startSection();
+	WriteStructures(writer, std::span<const std::uint8_t>{ vertexBones });
+
+	model.VertexOffset = startSection();
+	WriteStructures(writer, std::span<const glm::vec3>{ vertexes });
+
+	model.NormalOffset = startSection();
+	WriteStructures(writer, std::span<const glm::vec3>{ normals });
+
+	for (std::size_t i = 0; i < meshCount; ++i)
+	{
+		meshCommands[i].push_back(0);
+
+		meshes[i].TriangleOffset = startSection();
+		meshes[i].SkinReference = static_cast<std::int32_t>(i);
+		WriteStructures(writer, std::span<const std::int16_t>{ meshCommands[i] });
+	}
+
+	model.MeshCount = static_cast<std::int32_t>(meshCount);
+	model.MeshOffset = startSection();
+	WriteStructures(writer, std::span<const StudioMesh>{ meshes });
+
+	StudioBodyPart bodyPart{};
+
+	CopyName(bodyPart.Name, "body");
+	bodyPart.ModelCount = 1;
+	bodyPart.Base = 1;
+	bodyPart.ModelOffset = startSection();
+	WriteStructure(writer, model);
+
+	header.BodyPartCount = 1;
+	header.BodyPartOffset = startSection();
+	WriteStructure(writer, bodyPart);
+
+	if (!settings.ExternalTextures)
+	{
+		startSection();
+		WriteTextures(writer, random, settings, header);
+	}
+
+	std::memcpy(header.Id, "IDST", sizeof(header.Id));
+	header.Version = StudioVersion;
+	CopyName(header.Name, "models/" + fileName.filename().string());
+	header.Length = static_cast<std::int32_t>(writer.GetPosition());
+	header.EyePosition = glm::vec3{ 0, 0, maxs.z };
+	header.BBMin = mins;
+	header.BBMax = maxs;
+
+	writer.SetPosition(0);
+	WriteStructure(writer, header);
+
+	const bool success = writer.IsOk();
+
+	return std::fclose(file) == 0 && success;
+}
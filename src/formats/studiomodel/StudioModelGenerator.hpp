@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+/**
+*	@brief Settings for generated models. The same settings always produce the same files.
+*/
+struct StudioModelGeneratorSettings
+{
+	std::uint64_t Seed{ 0 };
+
+	/**
+	*	@brief Number of bones, at most 128 like the engine supports.
+	*/
+	int BoneCount{ 32 };
+
+	/**
+	*	@brief Number of vertices attached to each bone, at least 3.
+	*/
+	int VertexesPerBone{ 16 };
+
+	int SequenceCount{ 8 };
+	int FrameCount{ 30 };
+
+	/**
+	*	@brief Number of sequence groups. Group 0 is stored in the model, the others in @c <model>01.mdl and so on.
+	*	Sequences are spread over the groups in turn.
+	*/
+	int SequenceGroupCount{ 1 };
+
+	/**
+	*	@brief Number of textures, one mesh is generated for each.
+	*/
+	int TextureCount{ 4 };
+	int TextureSize{ 64 };
+
+	/**
+	*	@brief Whether textures are stored in a separate @c <model>T.mdl file.
+	*/
+	bool ExternalTextures{ false };
+};
+
+/**
+*	@brief Writes a version 10 model with a tree of bones, a cluster of vertices around each bone and sine wave animations,
+*	along with its sequence group and texture files.
+*/
+bool TryGenerateStudioModelFile(const std::filesystem::path& fileName, const StudioModelGeneratorSettings& settings);
@@ -0,0 +1,224 @@
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define STUDIO_SKINNING_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+// MSVC allows intrinsics of any instruction set without enabling it for the whole file.
+#define STUDIO_TARGET_AVX2
+#else
+#define STUDIO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#include "formats/studiomodel/StudioModelSkinning.hpp"
+
+namespace
+{
+constexpr StudioBoneTransforms::Matrix IdentityMatrix{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };
+
+/**
+*	@brief Scalar kernel. Computes each element as ((x * m0 + y * m1) + z * m2) + m3, the vector kernels use the same order.
+*/
+void SkinScalar(const StudioBoneTransforms& bones, const StudioSkinningInput& input, bool translate, StudioVectorArrays& output)
+{
+	std::array<const float*, StudioBoneTransforms::ElementCount> elements;
+
+	for (std::size_t e = 0; e < elements.size(); ++e)
+	{
+		elements[e] = bones.GetElements(e).data();
+	}
+
+	const auto& vectors = input.Vectors;
+
+	for (std::size_t i = 0; i < input.Count; ++i)
+	{
+		const auto bone = static_cast<std::size_t>(input.Bones[i]);
+		const float x = vectors.X[i];
+		const float y = vectors.Y[i];
+		const float z = vectors.Z[i];
+
+		float* const results[3]{ &output.X[i], &output.Y[i], &output.Z[i] };
+
+		for (std::size_t row = 0; row < 3; ++row)
+		{
+			const float* const* rowElements = elements.data() + (row * 4);
+
+			float result = (x * rowElements[0][bone]) + (y * rowElements[1][bone]);
+			result = result + (z * rowElements[2][bone]);
+
+			if (translate)
+			{
+				result = result + rowElements[3][bone];
+			}
+
+			*results[row] = result;
+		}
+	}
+}
+
+#ifdef STUDIO_SKINNING_AVX2
+bool IsAvx2Supported()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	// The OS has to save the AVX registers on context switches.
+	__cpuid(info, 1);
+
+	constexpr int OsXsave = 1 << 27;
+	constexpr int Avx = 1 << 28;
+
+	if ((info[2] & OsXsave) == 0 || (info[2] & Avx) == 0 || (_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+/**
+*	@brief Skins 8 vectors per iteration, gathering the matrix elements of each vector's bone.
+*	FMA is not used so the results are identical to the scalar kernel.
+*/
+STUDIO_TARGET_AVX2 void SkinAvx2(const StudioBoneTransforms& bones, const StudioSkinningInput& input, bool translate,
+	StudioVectorArrays& output)
+{
+	std::array<const float*, StudioBoneTransforms::ElementCount> elements;
+
+	for (std::size_t e = 0; e < elements.size(); ++e)
+	{
+		elements[e] = bones.GetElements(e).data();
+	}
+
+	const auto& vectors = input.Vectors;
+	float* const results[3]{ output.X.data(), output.Y.data(), output.Z.data() };
+
+	// Inputs are padded, so there are no leftover vectors.
+	for (std::size_t i = 0; i < input.Count; i += StudioSkinningLaneCount)
+	{
+		const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input.Bones.data() + i));
+		const __m256 x = _mm256_loadu_ps(vectors.X.data() + i);
+		const __m256 y = _mm256_loadu_ps(vectors.Y.data() + i);
+		const __m256 z = _mm256_loadu_ps(vectors.Z.data() + i);
+
+		for (std::size_t row = 0; row < 3; ++row)
+		{
+			const float* const* rowElements = elements.data() + (row * 4);
+
+			__m256 result = _mm256_add_ps(
+				_mm256_mul_ps(x, _mm256_i32gather_ps(rowElements[0], indices, sizeof(float))),
+				_mm256_mul_ps(y, _mm256_i32gather_ps(rowElements[1], indices, sizeof(float))));
+			result = _mm256_add_ps(result, _mm256_mul_ps(z, _mm256_i32gather_ps(rowElements[2], indices, sizeof(float))));
+
+			if (translate)
+			{
+				result = _mm256_add_ps(result, _mm256_i32gather_ps(rowElements[3], indices, sizeof(float)));
+			}
+
+			_mm256_storeu_ps(results[row] + i, result);
+		}
+	}
+}
+#endif
+}
+
+void StudioBoneTransforms::Resize(std::size_t boneCount)
+{
+	_boneCount = boneCount;
+	_stride = PadToSkinningLanes(boneCount);
+	_elements.resize(_stride * ElementCount);
+
+	for (std::size_t bone = 0; bone < boneCount; ++bone)
+	{
+		Set(bone, IdentityMatrix);
+	}
+}
+
+StudioBoneTransforms::Matrix StudioBoneTransforms::Get(std::size_t bone) const
+{
+	Matrix matrix;
+
+	for (std::size_t e = 0; e < ElementCount; ++e)
+	{
+		matrix[e] = _elements[(e * _stride) + bone];
+	}
+
+	return matrix;
+}
+
+void StudioBoneTransforms::Set(std::size_t bone, const Matrix& matrix)
+{
+	for (std::size_t e = 0; e < ElementCount; ++e)
+	{
+		_elements[(e * _stride) + bone] = matrix[e];
+	}
+}
+
+void StudioVectorArrays::Resize(std::size_t count)
+{
+	const std::size_t paddedCount = PadToSkinningLanes(count);
+
+	for (auto array : { &X, &Y, &Z })
+	{
+		array->resize(paddedCount);
+	}
+}
+
+bool IsStudioSkinningKernelSupported(StudioSkinningKernel kernel)
+{
+	switch (kernel)
+	{
+	case StudioSkinningKernel::Automatic:
+	case StudioSkinningKernel::Scalar:
+		return true;
+
+	case StudioSkinningKernel::Avx2:
+	{
+#ifdef STUDIO_SKINNING_AVX2
+		static const bool supported = IsAvx2Supported();
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	default: return false;
+	}
+}
+
+void SkinStudioVectors(const StudioBoneTransforms& bones, const StudioSkinningInput& input, bool translate,
+	StudioVectorArrays& output, StudioSkinningKernel kernel)
+{
+	output.Resize(input.Count);
+
+	if (kernel == StudioSkinningKernel::Automatic)
+	{
+		kernel = IsStudioSkinningKernelSupported(StudioSkinningKernel::Avx2) ? StudioSkinningKernel::Avx2 : StudioSkinningKernel::Scalar;
+	}
+
+#ifdef STUDIO_SKINNING_AVX2
+	if (kernel == StudioSkinningKernel::Avx2 && IsStudioSkinningKernelSupported(kernel))
+	{
+		SkinAvx2(bones, input, translate, output);
+		return;
+	}
+#endif
+
+	SkinScalar(bones, input, translate, output);
+}
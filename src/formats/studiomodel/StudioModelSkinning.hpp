@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+*	@brief Number of values processed at once by the widest skinning kernel. Arrays are padded to a multiple of this.
+*/
+constexpr std::size_t StudioSkinningLaneCount = 8;
+
+/**
+*	@brief Rounds a count up to a multiple of StudioSkinningLaneCount.
+*/
+constexpr std::size_t PadToSkinningLanes(std::size_t count)
+{
+	return (count + StudioSkinningLaneCount - 1) & ~(StudioSkinningLaneCount - 1);
+}
+
+/**
+*	@brief Bone to model space transforms of one model instance, as 3x4 row major matrices.
+*	@details Stored as structure of arrays: element @c e of every bone's matrix is in GetElements(e),
+*	so the skinning kernels can load the matrices of 8 different bones with one gather per element.
+*/
+class StudioBoneTransforms final
+{
+public:
+	static constexpr std::size_t ElementCount = 12;
+
+	using Matrix = std::array<float, ElementCount>;
+
+	/**
+	*	@brief Resizes to @p boneCount identity matrices. Doesn't allocate if the size doesn't change.
+	*/
+	void Resize(std::size_t boneCount);
+
+	std::size_t GetBoneCount() const { return _boneCount; }
+
+	std::span<float> GetElements(std::size_t element)
+	{
+		return { _elements.data() + (element * _stride), _boneCount };
+	}
+
+	std::span<const float> GetElements(std::size_t element) const
+	{
+		return { _elements.data() + (element * _stride), _boneCount };
+	}
+
+	Matrix Get(std::size_t bone) const;
+	void Set(std::size_t bone, const Matrix& matrix);
+
+private:
+	std::size_t _boneCount{ 0 };
+	std::size_t _stride{ 0 };
+	std::vector<float> _elements;
+};
+
+/**
+*	@brief Positions in structure of arrays layout, padded to a multiple of StudioSkinningLaneCount.
+*/
+struct StudioVectorArrays
+{
+	std::vector<float> X;
+	std::vector<float> Y;
+	std::vector<float> Z;
+
+	/**
+	*	@brief Resizes to @p count zero vectors plus padding. Doesn't allocate if the size doesn't change.
+	*/
+	void Resize(std::size_t count);
+};
+
+/**
+*	@brief Vertices or normals to skin, each attached to a single bone.
+*/
+struct StudioSkinningInput
+{
+	StudioVectorArrays Vectors;
+
+	/**
+	*	@brief Bone of each vector, padding uses bone 0.
+	*/
+	std::vector<std::int32_t> Bones;
+
+	/**
+	*	@brief Number of vectors, not including padding.
+	*/
+	std::size_t Count{ 0 };
+};
+
+enum class StudioSkinningKernel
+{
+	/**
+	*	@brief The fastest kernel the processor supports.
+	*/
+	Automatic,
+	Scalar,
+
+	/**
+	*	@brief Requires a processor with AVX2, checked at runtime.
+	*/
+	Avx2
+};
+
+bool IsStudioSkinningKernelSupported(StudioSkinningKernel kernel);
+
+/**
+*	@brief Transforms vectors by the matrices of their bones: rotation and translation for vertices, only rotation for normals.
+*	@details All kernels compute the same operations in the same order, so they produce identical results
+*	unless the build enables FMA and the compiler fuses the scalar kernel's multiplies and adds.
+*	An unsupported kernel falls back to the scalar kernel.
+*	@param output Resized to the input's count.
+*/
+void SkinStudioVectors(const StudioBoneTransforms& bones, const StudioSkinningInput& input, bool translate,
+	StudioVectorArrays& output, StudioSkinningKernel kernel = StudioSkinningKernel::Automatic);
@@ -1,49 +1,56 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <cstdio>
 #include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #include "formats/wad/WadFile.hpp"
+#include "utils/Arena.hpp"
 #include "utils/BinaryReader.hpp"
 #include "utils/IOutils.hpp"
+#include "utils/LoadProgress.hpp"
 
-enum class WadLumpType : std::uint8_t
+std::string_view GetWadLumpTypeName(WadLumpType type)
 {
-	Palette = 64,
-	Colormap = 65,
-	QPic = 66,
-	Miptex = 67,
-	Raw = 68,
-	Colormap2 = 69,
-	Font = 70
-};
-
-constexpr int WadHeaderSize = 12;
-constexpr int WadEntrySize = 32;
+	switch (type)
+	{
+	case WadLumpType::Palette: return "Palette";
+	case WadLumpType::Colormap: return "Colormap";
+	case WadLumpType::QPic: return "Picture";
+	case WadLumpType::Miptex: return "Texture";
+	case WadLumpType::Raw: return "Raw";
+	case WadLumpType::Colormap2: return "Colormap";
+	case WadLumpType::Font: return "Font";
+	default: return "Unknown";
+	}
+}
 
-static std::optional<WadEntry> TryReadWadEntry(const BinaryReader& reader, int tableOffset)
+static WadLumpInfo ReadWadLumpInfo(BinaryReader& tableEntry)
 {
-	auto tableEntry = reader.subspan(tableOffset);
+	WadLumpInfo info;
 
-	const int filePos = tableEntry.ReadInt32();
-	const int diskSize = tableEntry.ReadInt32();
-	const int size = tableEntry.ReadInt32();
-	const WadLumpType type = static_cast<WadLumpType>(tableEntry.ReadUInt8());
-	const std::uint8_t compression = tableEntry.ReadUInt8();
+	info.FilePos = tableEntry.ReadInt32();
+	info.DiskSize = tableEntry.ReadInt32();
+	info.Size = tableEntry.ReadInt32();
+	info.Type = static_cast<WadLumpType>(tableEntry.ReadUInt8());
+	info.Compression = tableEntry.ReadUInt8();
 	const auto padding = tableEntry.ReadUInt16();
 
-	auto name = tableEntry.ReadFixedUTF8String(16);
+	info.Name = tableEntry.ReadFixedUTF8String(16);
 
-	// Check this after reading the name so we can debug it more easily.
-	// TODO: handle all lump types (see qlumpy source code for more information).
-	if (type != WadLumpType::Miptex)
-	{
-		return {};
-	}
+	return info;
+}
 
+static std::optional<WadEntry> TryReadMiptex(const BinaryReader& miptexEntryData, std::string name)
+{
 	WadEntry entry;
 
 	entry.Name = std::move(name);
 
-	auto miptexEntry = reader.subspan(filePos);
+	auto miptexEntry = miptexEntryData.subspan(0);
 
 	// Skip name
 	miptexEntry.SetPosition(16);
@@ -58,64 +65,99 @@ static std::optional<WadEntry> TryReadWadEntry(const BinaryReader& reader, int t
 
 	auto dataEntry = miptexEntry.subspan(dataOffset);
 
-	entry.Pixels.resize(static_cast<std::size_t>(entry.Width) * entry.Height);
-
-	dataEntry.ReadBytes(reinterpret_cast<std::byte*>(entry.Pixels.data()), entry.Pixels.size());
-
-	entry.Colormap.resize(ColormapColorCount);
-
 	std::size_t totalPixelCount = 0;
 
-	for (std::size_t i = 0; i < 4; ++i)
+	for (std::size_t i = 0; i < WadMipLevelCount; ++i)
 	{
-		const std::size_t divisor = static_cast<std::size_t>(1U) << i;
-		const std::size_t width = entry.Width / divisor;
-		const std::size_t height = entry.Height / divisor;
-
-		totalPixelCount += width * height;
+		entry.MipOffsets[i] = totalPixelCount;
+		totalPixelCount += static_cast<std::size_t>(entry.GetMipWidth(i)) * entry.GetMipHeight(i);
 	}
 
+	entry.Pixels.resize(totalPixelCount);
+
+	dataEntry.ReadBytes(reinterpret_cast<std::byte*>(entry.Pixels.data()), entry.Pixels.size());
+
 	// Colormap starts after the 4 mip levels.
 	// There is a 2 byte int indicating palette size but this is assumed to always be the maximum.
 	auto colorMapEntry = dataEntry.subspan(totalPixelCount + 2);
 
-	for (std::size_t i = 0; i < ColormapColorCount; ++i)
+	std::array<RGB24, ColormapColorCount> colormap;
+
+	for (auto& color : colormap)
 	{
-		entry.Colormap[i].R = colorMapEntry.ReadUInt8();
-		entry.Colormap[i].G = colorMapEntry.ReadUInt8();
-		entry.Colormap[i].B = colorMapEntry.ReadUInt8();
+		color.R = colorMapEntry.ReadUInt8();
+		color.G = colorMapEntry.ReadUInt8();
+		color.B = colorMapEntry.ReadUInt8();
 	}
 
+	entry.Colormap = PalettePool::GetInstance().Intern(colormap);
+
 	return entry;
 }
 
-std::optional<WadFile> TryLoadWadFile(const std::string& fileName)
+static std::optional<WadEntry> TryReadWadEntry(std::span<const std::byte> data, int tableOffset)
 {
-	FILE* file = std::fopen(fileName.c_str(), "rb");
+	auto tableEntry = BinaryReader{ data }.subspan(tableOffset);
 
-	if (!file)
+	auto info = ReadWadLumpInfo(tableEntry);
+
+	// Check this after reading the name so we can debug it more easily.
+	// Other lump types are decoded on demand, see TryLoadWadDirectory.
+	if (info.Type != WadLumpType::Miptex)
 	{
 		return {};
 	}
 
-	auto result = TryLoadWadFile(file);
+	if (info.FilePos < 0 || static_cast<std::size_t>(info.FilePos) > data.size())
+	{
+		return {};
+	}
 
-	std::fclose(file);
+	return TryDecodeWadMiptex(data.subspan(info.FilePos), std::move(info.Name));
+}
 
-	return result;
+std::size_t WadEntry::SelectMipLevel(unsigned int width, unsigned int height) const
+{
+	std::size_t mipLevel = 0;
+
+	while ((mipLevel + 1) < MipLevelCount
+		&& GetMipWidth(mipLevel + 1) >= width && GetMipHeight(mipLevel + 1) >= height)
+	{
+		++mipLevel;
+	}
+
+	return mipLevel;
 }
 
-std::optional<WadFile> TryLoadWadFile(FILE* file)
+MemoryUsage GetMemoryUsage(const WadEntry& entry)
 {
-	std::optional<std::vector<std::byte>> buffer = TryReadFileIntoBuffer(file);
+	MemoryUsage usage;
 
-	if (!buffer)
+	usage.Add(MemoryCategory::Other, entry.Name);
+	usage.Add(MemoryCategory::Textures, entry.Pixels);
+	AddMemoryUsage(usage, entry.Colormap);
+
+	return usage;
+}
+
+static bool EqualsCaseInsensitive(std::string_view lhs, std::string_view rhs)
+{
+	return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char l, char r)
+		{
+			return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r));
+		});
+}
+
+std::optional<WadInfo> TryReadWadInfo(FILE* file)
+{
+	std::array<std::byte, WadHeaderSize> header;
+
+	if (!TryReadFileRange(file, 0, header))
 	{
 		return {};
 	}
 
-	// TODO: catch out_of_range exceptions and return appropriate result.
-	BinaryReader reader{ *buffer };
+	BinaryReader reader{ header };
 
 	const auto identification = reader.ReadFixedUTF8String(4);
 
@@ -127,27 +169,480 @@ std::optional<WadFile> TryLoadWadFile(FILE* file)
 	const int lumpCount = reader.ReadInt32();
 	const int lumpTableOffset = reader.ReadInt32();
 
-	// Reject invalid headers.
 	if (lumpCount < 0 || lumpTableOffset < WadHeaderSize)
 	{
 		return {};
 	}
 
-	WadFile wadFile;
+	const std::size_t directorySize = static_cast<std::size_t>(lumpCount) * WadEntrySize;
+
+	// Check the directory fits in the file before allocating it, the lump count may be garbage.
+	if (const auto fileSize = TryGetFileSize(file);
+		!fileSize || (static_cast<std::size_t>(lumpTableOffset) + directorySize) > *fileSize)
+	{
+		return {};
+	}
+
+	std::vector<std::byte> directory;
+
+	directory.resize(directorySize);
+
+	if (!directory.empty() && !TryReadFileRange(file, lumpTableOffset, directory))
+	{
+		return {};
+	}
+
+	WadInfo info;
 
-	wadFile.Entries.reserve(lumpCount);
+	info.LumpCount = lumpCount;
 
-	int tableOffset = lumpTableOffset;
+	// Lump type is stored after the offset and sizes.
+	constexpr std::size_t LumpTypeOffset = 12;
 
 	for (int i = 0; i < lumpCount; ++i)
 	{
-		if (auto entry = TryReadWadEntry(reader, tableOffset); entry)
+		if (static_cast<WadLumpType>(directory[(i * WadEntrySize) + LumpTypeOffset]) == WadLumpType::Miptex)
+		{
+			++info.TextureCount;
+		}
+	}
+
+	return info;
+}
+
+std::optional<WadEntry> TryLoadWadTexture(FILE* file, std::string_view name)
+{
+	auto directory = TryLoadWadDirectory(file);
+
+	if (!directory)
+	{
+		return {};
+	}
+
+	for (auto& info : *directory)
+	{
+		if (info.Type != WadLumpType::Miptex || (!name.empty() && !EqualsCaseInsensitive(info.Name, name)))
+		{
+			continue;
+		}
+
+		const auto lump = TryReadWadLump(file, info);
+
+		if (!lump)
 		{
-			wadFile.Entries.push_back(std::move(*entry));
+			return {};
 		}
 
-		tableOffset += WadEntrySize;
+		return TryDecodeWadMiptex(*lump, std::move(info.Name));
+	}
+
+	return {};
+}
+
+std::optional<std::vector<WadLumpInfo>> TryLoadWadDirectory(FILE* file)
+{
+	std::array<std::byte, WadHeaderSize> header;
+
+	if (!TryReadFileRange(file, 0, header))
+	{
+		return {};
+	}
+
+	BinaryReader reader{ header };
+
+	const auto identification = reader.ReadFixedUTF8String(4);
+
+	if (identification != "WAD2" && identification != "WAD3")
+	{
+		return {};
 	}
 
-	return wadFile;
+	const int lumpCount = reader.ReadInt32();
+	const int lumpTableOffset = reader.ReadInt32();
+
+	if (lumpCount < 0 || lumpTableOffset < WadHeaderSize)
+	{
+		return {};
+	}
+
+	const std::size_t directorySize = static_cast<std::size_t>(lumpCount) * WadEntrySize;
+
+	if (const auto fileSize = TryGetFileSize(file);
+		!fileSize || (static_cast<std::size_t>(lumpTableOffset) + directorySize) > *fileSize)
+	{
+		return {};
+	}
+
+	std::vector<std::byte> directoryData;
+
+	directoryData.resize(directorySize);
+
+	if (!directoryData.empty() && !TryReadFileRange(file, lumpTableOffset, directoryData))
+	{
+		return {};
+	}
+
+	BinaryReader directoryReader{ directoryData };
+
+	std::vector<WadLumpInfo> directory;
+
+	directory.reserve(lumpCount);
+
+	for (int i = 0; i < lumpCount; ++i)
+	{
+		directory.push_back(ReadWadLumpInfo(directoryReader));
+	}
+
+	return directory;
+}
+
+std::optional<std::vector<std::byte>> TryReadWadLump(FILE* file, const WadLumpInfo& info)
+{
+	if (info.FilePos < 0 || info.DiskSize < 0 || info.Compression != 0)
+	{
+		return {};
+	}
+
+	// The directory is read separately from the lumps, so the lump may not fit in the file.
+	if (const auto fileSize = TryGetFileSize(file);
+		!fileSize || (static_cast<std::size_t>(info.FilePos) + static_cast<std::size_t>(info.DiskSize)) > *fileSize)
+	{
+		return {};
+	}
+
+	std::vector<std::byte> data;
+
+	data.resize(info.DiskSize);
+
+	if (!data.empty() && !TryReadFileRange(file, info.FilePos, data))
+	{
+		return {};
+	}
+
+	return data;
+}
+
+/**
+*	@brief Runs a decoder, treating reads past the end of the lump as a decoding failure.
+*/
+template <typename Decode>
+static auto TryDecode(Decode&& decode) -> decltype(decode())
+{
+	try
+	{
+		return decode();
+	}
+	catch (const std::out_of_range&)
+	{
+		return {};
+	}
+}
+
+/**
+*	@brief Reads the palette stored after the pixels of WAD3 images. The palette always has 256 colors,
+*	missing colors are black.
+*/
+static std::vector<RGB24> ReadColormap(BinaryReader& reader)
+{
+	const std::size_t colorCount = std::min<std::size_t>(reader.ReadUInt16(), ColormapColorCount);
+
+	std::vector<RGB24> colormap;
+
+	colormap.resize(ColormapColorCount, RGB24{ 0, 0, 0 });
+
+	for (std::size_t i = 0; i < colorCount; ++i)
+	{
+		colormap[i].R = reader.ReadUInt8();
+		colormap[i].G = reader.ReadUInt8();
+		colormap[i].B = reader.ReadUInt8();
+	}
+
+	return colormap;
+}
+
+/**
+*	@brief Reads @p width by @p height pixels, checking the size first so corrupt lumps can't cause huge allocations.
+*/
+static std::optional<std::vector<std::uint8_t>> TryReadPixels(BinaryReader& reader, std::size_t dataSize, unsigned int width, unsigned int height)
+{
+	const std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+
+	if (pixelCount > dataSize)
+	{
+		return {};
+	}
+
+	std::vector<std::uint8_t> pixels;
+
+	pixels.resize(pixelCount);
+
+	reader.ReadBytes(reinterpret_cast<std::byte*>(pixels.data()), pixels.size());
+
+	return pixels;
+}
+
+std::optional<WadEntry> TryDecodeWadMiptex(std::span<const std::byte> data, std::string name)
+{
+	return TryDecode([&]() -> std::optional<WadEntry>
+		{
+			BinaryReader reader{ data };
+
+			// Check dimensions before TryReadMiptex allocates the pixels.
+			reader.SetPosition(16);
+
+			const std::size_t width = reader.ReadUInt32();
+			const std::size_t height = reader.ReadUInt32();
+
+			if ((width * height) > data.size())
+			{
+				return {};
+			}
+
+			return TryReadMiptex(reader, std::move(name));
+		});
+}
+
+std::optional<WadPicture> TryDecodeWadPicture(std::span<const std::byte> data)
+{
+	return TryDecode([&]() -> std::optional<WadPicture>
+		{
+			BinaryReader reader{ data };
+
+			WadPicture picture;
+
+			picture.Width = reader.ReadUInt32();
+			picture.Height = reader.ReadUInt32();
+
+			auto pixels = TryReadPixels(reader, data.size(), picture.Width, picture.Height);
+
+			if (!pixels)
+			{
+				return {};
+			}
+
+			picture.Pixels = std::move(*pixels);
+
+			// WAD2 pictures use the game palette.
+			if (reader.GetPosition() < data.size())
+			{
+				picture.Colormap = ReadColormap(reader);
+			}
+
+			return picture;
+		});
+}
+
+std::optional<WadFont> TryDecodeWadFont(std::span<const std::byte> data)
+{
+	return TryDecode([&]() -> std::optional<WadFont>
+		{
+			BinaryReader reader{ data };
+
+			WadFont font;
+
+			font.Width = reader.ReadUInt32();
+			font.Height = reader.ReadUInt32();
+			font.RowCount = reader.ReadUInt32();
+			font.RowHeight = reader.ReadUInt32();
+
+			if (font.Width == 0)
+			{
+				return {};
+			}
+
+			// Glyphs are stored as an offset into the image and a width. The height is the row height.
+			for (auto& glyph : font.Glyphs)
+			{
+				const unsigned int offset = reader.ReadUInt16();
+
+				glyph.X = offset % font.Width;
+				glyph.Y = offset / font.Width;
+				glyph.Width = reader.ReadUInt16();
+			}
+
+			auto pixels = TryReadPixels(reader, data.size(), font.Width, font.Height);
+
+			if (!pixels)
+			{
+				return {};
+			}
+
+			font.Pixels = std::move(*pixels);
+			font.Colormap = ReadColormap(reader);
+
+			return font;
+		});
+}
+
+std::optional<std::vector<RGB24>> TryDecodeWadPalette(std::span<const std::byte> data)
+{
+	if (data.size() < (ColormapColorCount * 3))
+	{
+		return {};
+	}
+
+	std::vector<RGB24> palette;
+
+	palette.resize(ColormapColorCount);
+
+	for (std::size_t i = 0; i < ColormapColorCount; ++i)
+	{
+		palette[i].R = static_cast<std::uint8_t>(data[(i * 3) + 0]);
+		palette[i].G = static_cast<std::uint8_t>(data[(i * 3) + 1]);
+		palette[i].B = static_cast<std::uint8_t>(data[(i * 3) + 2]);
+	}
+
+	return palette;
+}
+
+std::optional<WadColormap> TryDecodeWadColormap(std::span<const std::byte> data)
+{
+	// Quake's colormap has an extra byte at the end, so only whole levels are used.
+	const std::size_t levelCount = data.size() / ColormapColorCount;
+
+	if (levelCount == 0)
+	{
+		return {};
+	}
+
+	WadColormap colormap;
+
+	colormap.Table.resize(levelCount * ColormapColorCount);
+
+	std::memcpy(colormap.Table.data(), data.data(), colormap.Table.size());
+
+	return colormap;
+}
+
+std::optional<std::vector<WadLumpInfo>> TryReadWadDirectory(std::span<const std::byte> data)
+{
+	try
+	{
+		BinaryReader reader{ data };
+
+		const auto identification = reader.ReadFixedUTF8String(4);
+
+		if (identification != "WAD2" && identification != "WAD3")
+		{
+			return {};
+		}
+
+		const int lumpCount = reader.ReadInt32();
+		const int lumpTableOffset = reader.ReadInt32();
+
+		const std::size_t directorySize = static_cast<std::size_t>(lumpCount) * WadEntrySize;
+
+		if (lumpCount < 0 || lumpTableOffset < WadHeaderSize || (lumpTableOffset + directorySize) > data.size())
+		{
+			return {};
+		}
+
+		auto directoryReader = reader.subspan(lumpTableOffset, directorySize);
+
+		std::vector<WadLumpInfo> directory;
+
+		directory.reserve(lumpCount);
+
+		for (int i = 0; i < lumpCount; ++i)
+		{
+			auto info = ReadWadLumpInfo(directoryReader);
+
+			if (info.FilePos < 0 || info.DiskSize < 0
+				|| (static_cast<std::size_t>(info.FilePos) + static_cast<std::size_t>(info.DiskSize)) > data.size())
+			{
+				return {};
+			}
+
+			directory.push_back(std::move(info));
+		}
+
+		return directory;
+	}
+	catch (const std::out_of_range&)
+	{
+		return {};
+	}
+}
+
+std::optional<WadFile> TryLoadWadFile(const std::string& fileName)
+{
+	FILE* file = std::fopen(fileName.c_str(), "rb");
+
+	if (!file)
+	{
+		return {};
+	}
+
+	auto result = TryLoadWadFile(file);
+
+	std::fclose(file);
+
+	return result;
+}
+
+std::optional<WadFile> TryLoadWadFile(FILE* file, LoadProgress* progress)
+{
+	const ScratchArena::Scope scratch;
+
+	const auto buffer = TryReadFileIntoBuffer(file, scratch.GetResource());
+
+	if (!buffer)
+	{
+		return {};
+	}
+
+	// Offsets read from the file may point past the end of it.
+	try
+	{
+		BinaryReader reader{ *buffer };
+
+		const auto identification = reader.ReadFixedUTF8String(4);
+
+		if (identification != "WAD2" && identification != "WAD3")
+		{
+			return {};
+		}
+
+		const int lumpCount = reader.ReadInt32();
+		const int lumpTableOffset = reader.ReadInt32();
+
+		// Reject invalid headers, including directories that don't fit in the file.
+		if (lumpCount < 0 || lumpTableOffset < WadHeaderSize
+			|| (static_cast<std::size_t>(lumpTableOffset) + (static_cast<std::size_t>(lumpCount) * WadEntrySize)) > buffer->size())
+		{
+			return {};
+		}
+
+		WadFile wadFile;
+
+		wadFile.Entries.reserve(lumpCount);
+
+		int tableOffset = lumpTableOffset;
+
+		for (int i = 0; i < lumpCount; ++i)
+		{
+			if (progress)
+			{
+				if (progress->IsCancelled())
+				{
+					return {};
+				}
+
+				progress->SetProgress(i, lumpCount);
+			}
+
+			if (auto entry = TryReadWadEntry(*buffer, tableOffset); entry)
+			{
+				wadFile.Entries.push_back(std::move(*entry));
+			}
+
+			tableOffset += WadEntrySize;
+		}
+
+		return wadFile;
+	}
+	catch (const std::out_of_range&)
+	{
+		return {};
+	}
 }
@@ -1,29 +1,107 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
-constexpr std::size_t ColormapColorCount = 256;
+#include "formats/Palette.hpp"
+#include "utils/MemoryUsage.hpp"
 
-struct RGB24
+class LoadProgress;
+
+constexpr std::size_t WadMipLevelCount = 4;
+
+enum class WadLumpType : std::uint8_t
 {
-	std::uint8_t R;
-	std::uint8_t G;
-	std::uint8_t B;
+	Palette = 64,
+	Colormap = 65,
+	QPic = 66,
+	Miptex = 67,
+	Raw = 68,
+	Colormap2 = 69,
+	Font = 70
 };
 
+/**
+*	@brief Gets the name of a lump type for display.
+*/
+std::string_view GetWadLumpTypeName(WadLumpType type);
+
 class WadEntry
 {
 public:
 	std::string Name;
+
+	/**
+	*	@brief The type of lump this image was decoded from. Only miptex lumps are textures that maps can use.
+	*/
+	WadLumpType Type{ WadLumpType::Miptex };
+
 	unsigned int Width{0};
 	unsigned int Height{0};
+
+	/**
+	*	@brief Number of mip levels in @c Pixels. Only textures have more than one.
+	*/
+	std::size_t MipLevelCount{ WadMipLevelCount };
+
+	/**
+	*	@brief Pixels of all mip levels, stored one after the other like they are in the wad.
+	*	Mip level 0 comes first, so the start of this is the full size texture.
+	*/
 	std::vector<std::uint8_t> Pixels;
-	std::vector<RGB24> Colormap; // 256 colors = 768 bytes
+	std::array<std::size_t, WadMipLevelCount> MipOffsets{};
+
+	/**
+	*	@brief Interned, entries with the same colors share the palette.
+	*/
+	PaletteHandle Colormap;
+
+	unsigned int GetMipWidth(std::size_t mipLevel) const { return Width >> mipLevel; }
+	unsigned int GetMipHeight(std::size_t mipLevel) const { return Height >> mipLevel; }
+
+	std::span<const std::uint8_t> GetMipPixels(std::size_t mipLevel) const
+	{
+		return std::span{ Pixels }.subspan(MipOffsets[mipLevel], static_cast<std::size_t>(GetMipWidth(mipLevel)) * GetMipHeight(mipLevel));
+	}
+
+	/**
+	*	@brief Returns the smallest mip level that is at least the given size in both dimensions,
+	*	or mip level 0 if the texture is smaller than that.
+	*/
+	std::size_t SelectMipLevel(unsigned int width, unsigned int height) const;
+};
+
+/**
+*	@brief Gets the memory owned by the entry, not including the entry itself. Its palette is shared with other entries.
+*/
+MemoryUsage GetMemoryUsage(const WadEntry& entry);
+
+constexpr int WadHeaderSize = 12;
+constexpr int WadEntrySize = 32;
+
+/**
+*	@brief Maximum length of a lump name, not including the null terminator.
+*/
+constexpr std::size_t WadMaxNameLength = 15;
+
+/**
+*	@brief A lump as described by the wad directory.
+*/
+struct WadLumpInfo
+{
+	int FilePos{ 0 };
+	int DiskSize{ 0 };
+	int Size{ 0 };
+	WadLumpType Type{};
+	std::uint8_t Compression{ 0 };
+	std::string Name;
 };
 
 class WadFile
@@ -32,5 +110,111 @@ public:
 	std::vector<WadEntry> Entries;
 };
 
+/**
+*	@brief Summary of a wad that can be read without loading its lumps.
+*/
+struct WadInfo
+{
+	int LumpCount{ 0 };
+	int TextureCount{ 0 };
+};
+
+/**
+*	@brief Reads only the wad header and lump directory.
+*/
+std::optional<WadInfo> TryReadWadInfo(FILE* file);
+
+/**
+*	@brief Loads a single texture without loading the rest of the wad.
+*	@details Only the header, directory and the texture's own lump are read.
+*	@param name Name of the texture to load. If empty, the first texture is loaded.
+*/
+std::optional<WadEntry> TryLoadWadTexture(FILE* file, std::string_view name);
+
+/**
+*	@brief Reads the directory of a wad that is already in memory, such as a mapped file.
+*	@details Fails if any lump lies outside of @p data, so callers can access lump data without further checks.
+*/
+std::optional<std::vector<WadLumpInfo>> TryReadWadDirectory(std::span<const std::byte> data);
+
+/**
+*	@brief Reads only the header and directory of a wad. Lumps can then be read and decoded as needed.
+*/
+std::optional<std::vector<WadLumpInfo>> TryLoadWadDirectory(FILE* file);
+
+/**
+*	@brief Reads the data of a single lump as stored on disk.
+*/
+std::optional<std::vector<std::byte>> TryReadWadLump(FILE* file, const WadLumpInfo& info);
+
+/**
+*	@brief A full screen or menu image (QPic lump).
+*/
+class WadPicture
+{
+public:
+	unsigned int Width{ 0 };
+	unsigned int Height{ 0 };
+	std::vector<std::uint8_t> Pixels;
+
+	/**
+	*	@brief Empty for WAD2 pictures, which use the game palette.
+	*/
+	std::vector<RGB24> Colormap;
+};
+
+/**
+*	@brief Location of a character in a font's image.
+*/
+struct WadFontGlyph
+{
+	unsigned int X{ 0 };
+	unsigned int Y{ 0 };
+	unsigned int Width{ 0 };
+};
+
+constexpr std::size_t WadFontGlyphCount = 256;
+
+/**
+*	@brief A bitmap font (Font lump). All glyphs are stored in a single image, in rows of @c RowHeight pixels.
+*/
+class WadFont
+{
+public:
+	unsigned int Width{ 0 };
+	unsigned int Height{ 0 };
+	unsigned int RowCount{ 0 };
+	unsigned int RowHeight{ 0 };
+	std::array<WadFontGlyph, WadFontGlyphCount> Glyphs{};
+	std::vector<std::uint8_t> Pixels;
+	std::vector<RGB24> Colormap;
+};
+
+/**
+*	@brief A lookup table that maps each palette index to another palette index for a number of levels,
+*	such as the lighting levels of the Quake colormap (Colormap and Colormap2 lumps).
+*/
+class WadColormap
+{
+public:
+	std::vector<std::uint8_t> Table;
+
+	std::size_t GetLevelCount() const { return Table.size() / ColormapColorCount; }
+};
+
+/**
+*	@brief Decoders for the data of each lump type, as returned by TryReadWadLump.
+*	Lumps are only decoded when asked for, so tools that only need the directory never pay for decoding.
+*	Compressed lumps are not supported by the engine and are rejected.
+*/
+std::optional<WadEntry> TryDecodeWadMiptex(std::span<const std::byte> data, std::string name);
+std::optional<WadPicture> TryDecodeWadPicture(std::span<const std::byte> data);
+std::optional<WadFont> TryDecodeWadFont(std::span<const std::byte> data);
+std::optional<std::vector<RGB24>> TryDecodeWadPalette(std::span<const std::byte> data);
+std::optional<WadColormap> TryDecodeWadColormap(std::span<const std::byte> data);
+
 std::optional<WadFile> TryLoadWadFile(const std::string& fileName);
-std::optional<WadFile> TryLoadWadFile(FILE* file);
+/**
+*	@param progress If not null, receives load progress and is checked for cancellation requests.
+*/
+std::optional<WadFile> TryLoadWadFile(FILE* file, LoadProgress* progress = nullptr);
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include "formats/wad/WadGenerator.hpp"
+#include "formats/wad/WadWriter.hpp"
+
+#include "utils/DeterministicRandom.hpp"
+#include "utils/IOutils.hpp"
+
+std::array<RGB24, ColormapColorCount> GeneratePalette(DeterministicRandom& random)
+{
+	constexpr std::size_t KeyColorCount = 8;
+	constexpr std::size_t ColorsPerKey = ColormapColorCount / KeyColorCount;
+
+	std::array<RGB24, KeyColorCount + 1> keys{};
+
+	for (auto& key : keys)
+	{
+		const auto value = random.Next();
+		key = { static_cast<std::uint8_t>(value), static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value >> 16) };
+	}
+
+	std::array<RGB24, ColormapColorCount> palette;
+
+	for (std::size_t i = 0; i < palette.size(); ++i)
+	{
+		const auto& from = keys[i / ColorsPerKey];
+		const auto& to = keys[(i / ColorsPerKey) + 1];
+		const int t = static_cast<int>(i % ColorsPerKey);
+
+		const auto lerp = [&](std::uint8_t a, std::uint8_t b)
+		{
+			return static_cast<std::uint8_t>(a + (((b - a) * t) / static_cast<int>(ColorsPerKey)));
+		};
+
+		palette[i] = { lerp(from.R, to.R), lerp(from.G, to.G), lerp(from.B, to.B) };
+	}
+
+	return palette;
+}
+
+void GenerateTexturePixels(DeterministicRandom& random, WadEntry& entry)
+{
+	entry.MipLevelCount = WadMipLevelCount;
+
+	std::size_t offset = 0;
+
+	for (std::size_t mipLevel = 0; mipLevel < WadMipLevelCount; ++mipLevel)
+	{
+		entry.MipOffsets[mipLevel] = offset;
+		offset += static_cast<std::size_t>(entry.GetMipWidth(mipLevel)) * entry.GetMipHeight(mipLevel);
+	}
+
+	entry.Pixels.resize(offset);
+
+	// Blocks of one of a few base colors with a little noise on top, scaled down for each mip level.
+	const unsigned int blockShift = static_cast<unsigned int>(random.NextInRange(2, 4));
+	const std::uint64_t baseColors = random.Next();
+
+	for (std::size_t mipLevel = 0; mipLevel < WadMipLevelCount; ++mipLevel)
+	{
+		const unsigned int width = entry.GetMipWidth(mipLevel);
+		const unsigned int height = entry.GetMipHeight(mipLevel);
+		const unsigned int shift = blockShift > mipLevel ? blockShift - static_cast<unsigned int>(mipLevel) : 0;
+
+		auto* pixels = entry.Pixels.data() + entry.MipOffsets[mipLevel];
+
+		for (unsigned int y = 0; y < height; ++y)
+		{
+			std::uint64_t noise = 0;
+
+			for (unsigned int x = 0; x < width; ++x, noise >>= 8)
+			{
+				if ((x % 8) == 0)
+				{
+					noise = random.Next();
+				}
+
+				const unsigned int block = ((x >> shift) + (y >> shift)) % 8;
+				const auto base = static_cast<std::uint8_t>(baseColors >> (block * 8));
+
+				pixels[(y * width) + x] = static_cast<std::uint8_t>((base & 0xF0) | (noise & 0x0F));
+			}
+		}
+	}
+}
+
+static unsigned int PickTextureSize(DeterministicRandom& random, unsigned int minSize, unsigned int maxSize)
+{
+	std::vector<unsigned int> sizes;
+
+	for (unsigned int size = 16; size <= maxSize && size != 0; size *= 2)
+	{
+		if (size >= minSize)
+		{
+			sizes.push_back(size);
+		}
+	}
+
+	if (sizes.empty())
+	{
+		return std::max(16U, (minSize + 15) & ~15U);
+	}
+
+	return sizes[static_cast<std::size_t>(random.NextInRange(0, static_cast<std::int64_t>(sizes.size()) - 1))];
+}
+
+bool TryGenerateWadFile(const std::filesystem::path& fileName, const WadGeneratorSettings& settings)
+{
+	FILE* file = OpenFileForWriting(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	DeterministicRandom random{ settings.Seed };
+
+	WadWriter writer{ file };
+
+	const auto palette = PalettePool::GetInstance().Intern(GeneratePalette(random));
+
+	// Reused for every texture so generating doesn't allocate per texture.
+	WadEntry entry;
+
+	entry.Type = WadLumpType::Miptex;
+
+	for (int i = 0; i < settings.TextureCount && writer.IsOk(); ++i)
+	{
+		char name[WadMaxNameLength + 1];
+		std::snprintf(name, sizeof(name), "gen%06d", i);
+
+		entry.Name = name;
+		entry.Width = PickTextureSize(random, settings.MinTextureSize, settings.MaxTextureSize);
+		entry.Height = PickTextureSize(random, settings.MinTextureSize, settings.MaxTextureSize);
+
+		// Most textures in a wad share a palette, some have their own.
+		entry.Colormap = (random.Next() % 4) == 0 ? PalettePool::GetInstance().Intern(GeneratePalette(random)) : palette;
+
+		GenerateTexturePixels(random, entry);
+
+		writer.WriteTexture(entry);
+	}
+
+	const bool success = writer.Finish();
+
+	return std::fclose(file) == 0 && success;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "formats/wad/WadFile.hpp"
+
+class DeterministicRandom;
+
+/**
+*	@brief Settings for generated wads. The same settings always produce the same file.
+*/
+struct WadGeneratorSettings
+{
+	std::uint64_t Seed{ 0 };
+	int TextureCount{ 256 };
+
+	/**
+	*	@brief Texture dimensions are picked from the powers of 2 in this range, rounded to multiples of 16.
+	*/
+	unsigned int MinTextureSize{ 16 };
+	unsigned int MaxTextureSize{ 256 };
+};
+
+/**
+*	@brief Generates a palette with a gradient through random colors, like most texture palettes.
+*/
+std::array<RGB24, ColormapColorCount> GeneratePalette(DeterministicRandom& random);
+
+/**
+*	@brief Fills a texture with a pattern of blocks and noise, for every mip level.
+*	@details Pure noise doesn't compress or mip like real textures do, while this is about as fast to generate.
+*	@param entry Texture with its name, dimensions and colormap set. Its pixel buffer is reused if it is large enough.
+*/
+void GenerateTexturePixels(DeterministicRandom& random, WadEntry& entry);
+
+/**
+*	@brief Writes a WAD3 file with random textures, streaming each texture to disk as it is generated.
+*/
+bool TryGenerateWadFile(const std::filesystem::path& fileName, const WadGeneratorSettings& settings);
@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "formats/wad/WadWriter.hpp"
+#include "utils/IOutils.hpp"
+#include "utils/LoadProgress.hpp"
+#include "utils/MappedFile.hpp"
+
+constexpr std::size_t MiptexHeaderSize = 40;
+constexpr std::size_t MiptexNameSize = 16;
+
+// Every lump starts on a 4 byte boundary, like qlumpy and Wally write them.
+constexpr std::size_t LumpAlignment = 4;
+
+static std::string FoldLumpName(std::string_view name)
+{
+	std::string result{ name };
+
+	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c)
+		{
+			return static_cast<char>(std::tolower(c));
+		});
+
+	return result;
+}
+
+static bool IsValidTexture(const WadEntry& entry)
+{
+	// The engine requires textures to be a multiple of 16 so every mip level has a whole number of pixels.
+	return entry.Type == WadLumpType::Miptex
+		&& !entry.Name.empty()
+		&& entry.Name.size() <= WadMaxNameLength
+		&& entry.Width > 0 && entry.Height > 0
+		&& (entry.Width % 16) == 0 && (entry.Height % 16) == 0
+		&& entry.Colormap.size() == ColormapColorCount;
+}
+
+static std::size_t GetMipChainSize(const WadEntry& entry)
+{
+	std::size_t size = 0;
+
+	for (std::size_t i = 0; i < WadMipLevelCount; ++i)
+	{
+		size += static_cast<std::size_t>(entry.GetMipWidth(i)) * entry.GetMipHeight(i);
+	}
+
+	return size;
+}
+
+/**
+*	@brief Creates the smaller mip levels of a texture that only has mip level 0.
+*	@details Each pixel is the average color of the block it covers, mapped back to the closest palette color.
+*/
+static std::vector<std::uint8_t> GenerateMipChain(const WadEntry& entry)
+{
+	const std::size_t width = entry.Width;
+	const std::size_t height = entry.Height;
+
+	std::vector<std::uint8_t> pixels;
+
+	pixels.reserve(GetMipChainSize(entry));
+	pixels.insert(pixels.end(), entry.Pixels.begin(), entry.Pixels.begin() + (width * height));
+
+	// Most textures use few distinct averaged colors, so cache the closest palette index of each 15 bit color.
+	std::vector<std::int16_t> closestColors(1 << 15, -1);
+
+	const auto findClosestColor = [&](int r, int g, int b)
+	{
+		auto& closest = closestColors[((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)];
+
+		if (closest == -1)
+		{
+			int bestDistance = std::numeric_limits<int>::max();
+
+			for (std::size_t i = 0; i < ColormapColorCount; ++i)
+			{
+				const auto& color = entry.Colormap[i];
+				const int dr = color.R - r;
+				const int dg = color.G - g;
+				const int db = color.B - b;
+				const int distance = (dr * dr) + (dg * dg) + (db * db);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					closest = static_cast<std::int16_t>(i);
+				}
+			}
+		}
+
+		return static_cast<std::uint8_t>(closest);
+	};
+
+	for (std::size_t level = 1; level < WadMipLevelCount; ++level)
+	{
+		const std::size_t blockSize = std::size_t{ 1 } << level;
+		const std::size_t blockArea = blockSize * blockSize;
+
+		for (std::size_t y = 0; y < (height >> level); ++y)
+		{
+			for (std::size_t x = 0; x < (width >> level); ++x)
+			{
+				int r = 0, g = 0, b = 0;
+
+				for (std::size_t by = 0; by < blockSize; ++by)
+				{
+					const std::uint8_t* row = entry.Pixels.data() + (((y * blockSize) + by) * width) + (x * blockSize);
+
+					for (std::size_t bx = 0; bx < blockSize; ++bx)
+					{
+						const auto& color = entry.Colormap[row[bx]];
+						r += color.R;
+						g += color.G;
+						b += color.B;
+					}
+				}
+
+				pixels.push_back(findClosestColor(r / blockArea, g / blockArea, b / blockArea));
+			}
+		}
+	}
+
+	return pixels;
+}
+
+WadWriter::WadWriter(FILE* file)
+	: _writer(file)
+{
+	_writer.WriteFixedUTF8String("WAD3", 4);
+
+	// Lump count and directory offset are written by Finish.
+	_writer.WriteInt32(0);
+	_writer.WriteInt32(0);
+}
+
+void WadWriter::CopyLump(const WadLumpInfo& info, std::span<const std::byte> data, std::string_view name)
+{
+	if (name.size() > WadMaxNameLength)
+	{
+		_ok = false;
+		return;
+	}
+
+	_writer.Align(LumpAlignment);
+
+	AddDirectoryEntry(info.Type, info.Compression, name, _writer.GetPosition());
+
+	auto& directoryEntry = _directory.back();
+
+	directoryEntry.DiskSize = info.DiskSize;
+	directoryEntry.Size = info.Size;
+
+	// Textures store their name as well. Replace it so it matches the directory.
+	if (info.Type == WadLumpType::Miptex && info.Compression == 0 && data.size() >= MiptexNameSize
+		&& FoldLumpName(name) != FoldLumpName(info.Name))
+	{
+		_writer.WriteFixedUTF8String(name, MiptexNameSize);
+		data = data.subspan(MiptexNameSize);
+	}
+
+	_writer.WriteBytes(data);
+}
+
+void WadWriter::WriteTexture(const WadEntry& entry)
+{
+	const std::size_t mipChainSize = GetMipChainSize(entry);
+
+	if (!IsValidTexture(entry) || entry.Pixels.size() < (static_cast<std::size_t>(entry.Width) * entry.Height))
+	{
+		_ok = false;
+		return;
+	}
+
+	std::optional<std::vector<std::uint8_t>> generatedPixels;
+
+	if (entry.Pixels.size() < mipChainSize)
+	{
+		generatedPixels = GenerateMipChain(entry);
+	}
+
+	const std::span<const std::uint8_t> pixels = generatedPixels ? std::span{ *generatedPixels } : std::span{ entry.Pixels }.first(mipChainSize);
+
+	_writer.Align(LumpAlignment);
+
+	const std::size_t start = _writer.GetPosition();
+
+	AddDirectoryEntry(WadLumpType::Miptex, 0, entry.Name, start);
+
+	_writer.WriteFixedUTF8String(entry.Name, MiptexNameSize);
+	_writer.WriteUInt32(entry.Width);
+	_writer.WriteUInt32(entry.Height);
+
+	std::size_t mipOffset = MiptexHeaderSize;
+
+	for (std::size_t i = 0; i < WadMipLevelCount; ++i)
+	{
+		_writer.WriteUInt32(static_cast<std::uint32_t>(mipOffset));
+		mipOffset += static_cast<std::size_t>(entry.GetMipWidth(i)) * entry.GetMipHeight(i);
+	}
+
+	_writer.WriteBytes(std::as_bytes(pixels));
+
+	_writer.WriteUInt16(static_cast<std::uint16_t>(ColormapColorCount));
+
+	for (const auto& color : entry.Colormap)
+	{
+		_writer.WriteUInt8(color.R);
+		_writer.WriteUInt8(color.G);
+		_writer.WriteUInt8(color.B);
+	}
+
+	_writer.Align(LumpAlignment);
+
+	const int size = static_cast<int>(_writer.GetPosition() - start);
+
+	_directory.back().DiskSize = size;
+	_directory.back().Size = size;
+}
+
+bool WadWriter::Finish()
+{
+	_writer.Align(LumpAlignment);
+
+	const std::size_t directoryOffset = _writer.GetPosition();
+
+	// Offsets are stored as 32 bit signed integers.
+	if ((directoryOffset + (_directory.size() * WadEntrySize)) > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+	{
+		_ok = false;
+	}
+
+	for (const auto& info : _directory)
+	{
+		_writer.WriteInt32(info.FilePos);
+		_writer.WriteInt32(info.DiskSize);
+		_writer.WriteInt32(info.Size);
+		_writer.WriteUInt8(static_cast<std::uint8_t>(info.Type));
+		_writer.WriteUInt8(info.Compression);
+		_writer.WriteUInt16(0);
+		_writer.WriteFixedUTF8String(info.Name, MiptexNameSize);
+	}
+
+	_writer.SetPosition(4);
+	_writer.WriteInt32(static_cast<std::int32_t>(_directory.size()));
+	_writer.WriteInt32(static_cast<std::int32_t>(directoryOffset));
+
+	return IsOk();
+}
+
+void WadWriter::AddDirectoryEntry(WadLumpType type, std::uint8_t compression, std::string_view name, std::size_t filePos)
+{
+	if (filePos > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+	{
+		_ok = false;
+	}
+
+	WadLumpInfo info;
+
+	info.FilePos = static_cast<int>(filePos);
+	info.Type = type;
+	info.Compression = compression;
+	info.Name = name;
+
+	_directory.push_back(std::move(info));
+}
+
+static std::filesystem::path GetTemporaryFileName(const std::filesystem::path& fileName)
+{
+	// Stay in the same directory so the file can be renamed instead of copied.
+	auto temporaryFileName = fileName;
+	temporaryFileName += ".tmp";
+	return temporaryFileName;
+}
+
+/**
+*	@brief Writes a wad to a temporary file using @p write, then replaces @p fileName with it.
+*	@param beforeReplace Called after the file has been written, to release anything that prevents replacing the original.
+*/
+template <typename Write, typename BeforeReplace>
+static bool TryReplaceWadFile(const std::filesystem::path& fileName, Write&& write, BeforeReplace&& beforeReplace)
+{
+	const auto temporaryFileName = GetTemporaryFileName(fileName);
+
+	FILE* file = OpenFileForWriting(temporaryFileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	bool success;
+
+	{
+		WadWriter writer{ file };
+		success = write(writer) && writer.Finish();
+	}
+
+	success = (std::fclose(file) == 0) && success;
+
+	beforeReplace();
+
+	std::error_code error;
+
+	if (success)
+	{
+		std::filesystem::rename(temporaryFileName, fileName, error);
+		success = !error;
+	}
+
+	if (!success)
+	{
+		std::filesystem::remove(temporaryFileName, error);
+	}
+
+	return success;
+}
+
+bool TryWriteWadFile(const std::filesystem::path& fileName, std::span<const WadEntry> textures, LoadProgress* progress)
+{
+	return TryReplaceWadFile(fileName, [&](WadWriter& writer)
+		{
+			for (std::size_t i = 0; i < textures.size(); ++i)
+			{
+				if (progress)
+				{
+					if (progress->IsCancelled())
+					{
+						return false;
+					}
+
+					progress->SetProgress(static_cast<int>(i), static_cast<int>(textures.size()));
+				}
+
+				writer.WriteTexture(textures[i]);
+			}
+
+			return writer.IsOk();
+		}, [] {});
+}
+
+bool TryUpdateWadFile(const std::filesystem::path& fileName, const WadChanges& changes, LoadProgress* progress)
+{
+	auto source = MappedFile::TryOpen(fileName);
+
+	if (!source)
+	{
+		return false;
+	}
+
+	const auto directory = TryReadWadDirectory(source->GetData());
+
+	if (!directory)
+	{
+		return false;
+	}
+
+	std::unordered_set<std::string> removals;
+
+	for (const auto& name : changes.Removals)
+	{
+		removals.insert(FoldLumpName(name));
+	}
+
+	std::unordered_map<std::string, std::string_view> renames;
+
+	for (const auto& rename : changes.Renames)
+	{
+		renames.insert_or_assign(FoldLumpName(rename.Name), rename.NewName);
+	}
+
+	// If a name is used more than once, the last texture wins.
+	std::unordered_map<std::string, std::size_t> textures;
+
+	for (std::size_t i = 0; i < changes.Textures.size(); ++i)
+	{
+		textures.insert_or_assign(FoldLumpName(changes.Textures[i].Name), i);
+	}
+
+	return TryReplaceWadFile(fileName, [&](WadWriter& writer)
+		{
+			const int lumpCount = static_cast<int>(directory->size());
+
+			for (int i = 0; i < lumpCount && writer.IsOk(); ++i)
+			{
+				if (progress)
+				{
+					if (progress->IsCancelled())
+					{
+						return false;
+					}
+
+					progress->SetProgress(i, lumpCount);
+				}
+
+				const auto& info = (*directory)[i];
+
+				auto foldedName = FoldLumpName(info.Name);
+
+				if (removals.contains(foldedName))
+				{
+					continue;
+				}
+
+				std::string_view name = info.Name;
+
+				if (const auto it = renames.find(foldedName); it != renames.end())
+				{
+					name = it->second;
+					foldedName = FoldLumpName(name);
+				}
+
+				if (const auto it = textures.find(foldedName); it != textures.end())
+				{
+					writer.WriteTexture(changes.Textures[it->second]);
+					textures.erase(it);
+					continue;
+				}
+
+				// TryReadWadDirectory has already checked that the lump lies inside the file.
+				writer.CopyLump(info, source->GetData().subspan(info.FilePos, info.DiskSize), name);
+			}
+
+			// Whatever is left is new. Add them in the order they were given.
+			for (std::size_t i = 0; i < changes.Textures.size() && writer.IsOk(); ++i)
+			{
+				if (const auto it = textures.find(FoldLumpName(changes.Textures[i].Name)); it != textures.end() && it->second == i)
+				{
+					writer.WriteTexture(changes.Textures[i]);
+				}
+			}
+
+			return writer.IsOk();
+		},
+		[&]
+		{
+			// Windows doesn't allow replacing a mapped file.
+			source->Close();
+		});
+}
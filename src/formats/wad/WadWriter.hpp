@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "formats/wad/WadFile.hpp"
+#include "utils/BinaryWriter.hpp"
+
+class LoadProgress;
+
+struct WadRename
+{
+	std::string Name;
+	std::string NewName;
+};
+
+/**
+*	@brief Changes to apply to an existing wad. Lumps are matched by name, ignoring case.
+*/
+class WadChanges
+{
+public:
+	/**
+	*	@brief Textures to write. A texture replaces the lump with the same name (after renaming) in place,
+	*	otherwise it is added after the existing lumps.
+	*	Textures that only have mip level 0 get the other mip levels generated.
+	*/
+	std::vector<WadEntry> Textures;
+
+	/**
+	*	@brief Names of lumps to remove.
+	*/
+	std::vector<std::string> Removals;
+
+	std::vector<WadRename> Renames;
+};
+
+/**
+*	@brief Streams a WAD3 file to disk.
+*	@details Lumps are written as soon as they are added, so only the directory is kept in memory.
+*	The directory is written last by Finish, which then fills in the header.
+*/
+class WadWriter final
+{
+public:
+	/**
+	*	@param file File opened for binary writing. Must be seekable so the header can be written last.
+	*/
+	explicit WadWriter(FILE* file);
+
+	WadWriter(const WadWriter&) = delete;
+	WadWriter& operator=(const WadWriter&) = delete;
+
+	bool IsOk() const { return _ok && _writer.IsOk(); }
+
+	/**
+	*	@brief Copies a lump as-is without decoding it.
+	*	@param data The lump's data as stored on disk.
+	*	@param name Name to store the lump under. If this renames a texture, the name stored in the texture is updated as well.
+	*/
+	void CopyLump(const WadLumpInfo& info, std::span<const std::byte> data, std::string_view name);
+
+	/**
+	*	@brief Encodes a texture with its mip levels and palette.
+	*/
+	void WriteTexture(const WadEntry& entry);
+
+	/**
+	*	@brief Writes the directory and header. No lumps can be added after this.
+	*	@return Whether the entire file was written successfully.
+	*/
+	bool Finish();
+
+private:
+	void AddDirectoryEntry(WadLumpType type, std::uint8_t compression, std::string_view name, std::size_t filePos);
+
+private:
+	BinaryWriter _writer;
+	std::vector<WadLumpInfo> _directory;
+	bool _ok{ true };
+};
+
+/**
+*	@brief Writes a new wad containing the given textures, replacing the file if it exists.
+*/
+bool TryWriteWadFile(const std::filesystem::path& fileName, std::span<const WadEntry> textures, LoadProgress* progress = nullptr);
+
+/**
+*	@brief Applies changes to an existing wad.
+*	@details The wad is mapped into memory and unchanged lumps are copied straight from the mapping,
+*	so memory use does not depend on the size of the wad.
+*	The new wad is written to a temporary file next to it which then replaces the original,
+*	so the original is left untouched if anything fails.
+*	@param progress If not null, receives progress and is checked for cancellation requests.
+*/
+bool TryUpdateWadFile(const std::filesystem::path& fileName, const WadChanges& changes, LoadProgress* progress = nullptr);
@@ -0,0 +1,343 @@
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "formats/bsp/BspGenerator.hpp"
+#include "formats/sprite/SpriteGenerator.hpp"
+#include "formats/studiomodel/StudioModelGenerator.hpp"
+#include "formats/wad/WadGenerator.hpp"
+
+constexpr int ExitSuccess = 0;
+constexpr int ExitGenerationFailed = 1;
+constexpr int ExitUsageError = 2;
+
+constexpr std::string_view Usage = R"(Usage: multiasset-generate <format> --output <file> [options]
+
+Writes a valid file of the given format. The same options always produce the same file.
+
+Formats and their options:
+  bsp     --faces <count>          Number of faces, at most 65535. Defaults to 4096.
+          --textures <count>       Number of textures. Defaults to 64.
+          --texture-size <size>    Width and height of textures, a multiple of 16. Defaults to 64.
+          --entities <count>       Number of light entities. Defaults to 64.
+          --external-textures      Only store texture names. A wad generated with at least as many textures provides them.
+          --no-lighting            Leave out lightmaps.
+  wad     --textures <count>       Number of textures. Defaults to 256.
+          --min-size <size>        Smallest texture width and height, a multiple of 16. Defaults to 16.
+          --max-size <size>        Largest texture width and height, a multiple of 16. Defaults to 256.
+  sprite  --frames <count>         Number of frames. Defaults to 16.
+          --width <size>           Frame width. Defaults to 64.
+          --height <size>          Frame height. Defaults to 64.
+          --group-size <count>     Put frames in groups of this many frames. Defaults to 0, no groups.
+          --random-sync            Start animations at a random time.
+  mdl     --bones <count>          Number of bones, at most 128. Defaults to 32.
+          --vertexes <count>       Number of vertices per bone, at least 3. Defaults to 16.
+          --sequences <count>      Number of sequences. Defaults to 8.
+          --frames <count>         Number of frames in each sequence. Defaults to 30.
+          --groups <count>         Number of sequence groups, stored in <file>01.mdl and so on. Defaults to 1.
+          --textures <count>       Number of textures. Defaults to 4.
+          --texture-size <size>    Width and height of textures. Defaults to 64.
+          --external-textures      Store textures in <file>T.mdl.
+
+Common options:
+  --seed <number>  Seed for the generated contents. Defaults to 0.
+  --help           Show this message.
+
+The exit code is 0 if the file was written, 1 if writing failed and 2 if the command line is invalid.
+)";
+
+static std::filesystem::path PathFromUtf8(std::string_view text)
+{
+	return std::u8string_view{ reinterpret_cast<const char8_t*>(text.data()), text.size() };
+}
+
+/**
+*	@brief Options given on the command line. Generators take the options they understand,
+*	anything left over is not valid for the format.
+*/
+class Arguments final
+{
+public:
+	void Add(std::string_view name, std::optional<std::string_view> value)
+	{
+		_values.insert_or_assign(std::string{ name }, value);
+	}
+
+	bool TakeFlag(std::string_view name)
+	{
+		const auto it = _values.find(std::string{ name });
+
+		if (it == _values.end() || it->second)
+		{
+			return false;
+		}
+
+		_values.erase(it);
+
+		return true;
+	}
+
+	template<typename T>
+	bool TakeNumber(std::string_view name, T& value)
+	{
+		const auto it = _values.find(std::string{ name });
+
+		if (it == _values.end())
+		{
+			return true;
+		}
+
+		const auto text = it->second.value_or(std::string_view{});
+
+		const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+
+		if (text.empty() || result.ec != std::errc{} || result.ptr != text.data() + text.size())
+		{
+			std::fprintf(stderr, "Invalid value for option \"%s\"\n", it->first.c_str());
+			return false;
+		}
+
+		_values.erase(it);
+
+		return true;
+	}
+
+	bool ReportUnused() const
+	{
+		for (const auto& [name, value] : _values)
+		{
+			std::fprintf(stderr, "Option \"%s\" is not valid for this format\n", name.c_str());
+		}
+
+		return !_values.empty();
+	}
+
+private:
+	std::map<std::string, std::optional<std::string_view>, std::less<>> _values;
+};
+
+/**
+*	@return Whether the file was written, or nothing if the options are invalid.
+*/
+static std::optional<bool> GenerateBsp(const std::filesystem::path& fileName, std::uint64_t seed, Arguments& arguments)
+{
+	BspGeneratorSettings settings;
+
+	settings.Seed = seed;
+
+	if (!arguments.TakeNumber("--faces", settings.FaceCount)
+		|| !arguments.TakeNumber("--textures", settings.TextureCount)
+		|| !arguments.TakeNumber("--texture-size", settings.TextureSize)
+		|| !arguments.TakeNumber("--entities", settings.EntityCount))
+	{
+		return {};
+	}
+
+	settings.EmbedTextures = !arguments.TakeFlag("--external-textures");
+	settings.Lighting = !arguments.TakeFlag("--no-lighting");
+
+	if (arguments.ReportUnused())
+	{
+		return {};
+	}
+
+	return TryGenerateBspFile(fileName, settings);
+}
+
+static std::optional<bool> GenerateWad(const std::filesystem::path& fileName, std::uint64_t seed, Arguments& arguments)
+{
+	WadGeneratorSettings settings;
+
+	settings.Seed = seed;
+
+	if (!arguments.TakeNumber("--textures", settings.TextureCount)
+		|| !arguments.TakeNumber("--min-size", settings.MinTextureSize)
+		|| !arguments.TakeNumber("--max-size", settings.MaxTextureSize)
+		|| arguments.ReportUnused())
+	{
+		return {};
+	}
+
+	return TryGenerateWadFile(fileName, settings);
+}
+
+static std::optional<bool> GenerateSprite(const std::filesystem::path& fileName, std::uint64_t seed, Arguments& arguments)
+{
+	SpriteGeneratorSettings settings;
+
+	settings.Seed = seed;
+
+	if (!arguments.TakeNumber("--frames", settings.FrameCount)
+		|| !arguments.TakeNumber("--width", settings.Width)
+		|| !arguments.TakeNumber("--height", settings.Height)
+		|| !arguments.TakeNumber("--group-size", settings.GroupSize))
+	{
+		return {};
+	}
+
+	if (arguments.TakeFlag("--random-sync"))
+	{
+		settings.SyncType = SyncType::RAND;
+	}
+
+	if (arguments.ReportUnused())
+	{
+		return {};
+	}
+
+	return TryGenerateSpriteFile(fileName, settings);
+}
+
+static std::optional<bool> GenerateStudioModel(const std::filesystem::path& fileName, std::uint64_t seed, Arguments& arguments)
+{
+	StudioModelGeneratorSettings settings;
+
+	settings.Seed = seed;
+
+	if (!arguments.TakeNumber("--bones", settings.BoneCount)
+		|| !arguments.TakeNumber("--vertexes", settings.VertexesPerBone)
+		|| !arguments.TakeNumber("--sequences", settings.SequenceCount)
+		|| !arguments.TakeNumber("--frames", settings.FrameCount)
+		|| !arguments.TakeNumber("--groups", settings.SequenceGroupCount)
+		|| !arguments.TakeNumber("--textures", settings.TextureCount)
+		|| !arguments.TakeNumber("--texture-size", settings.TextureSize))
+	{
+		return {};
+	}
+
+	settings.ExternalTextures = arguments.TakeFlag("--external-textures");
+
+	if (arguments.ReportUnused())
+	{
+		return {};
+	}
+
+	return TryGenerateStudioModelFile(fileName, settings);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::fputs(Usage.data(), stderr);
+		return ExitUsageError;
+	}
+
+	const std::string_view format{ argv[1] };
+
+	if (format == "--help")
+	{
+		std::fputs(Usage.data(), stdout);
+		return ExitSuccess;
+	}
+
+	Arguments arguments;
+	std::optional<std::filesystem::path> output;
+	std::uint64_t seed = 0;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		const std::string_view argument{ argv[i] };
+
+		if (argument == "--help")
+		{
+			std::fputs(Usage.data(), stdout);
+			return ExitSuccess;
+		}
+
+		if (!argument.starts_with("--"))
+		{
+			std::fprintf(stderr, "Unexpected argument \"%s\"\n", argv[i]);
+			return ExitUsageError;
+		}
+
+		// Options either are flags or take a single value.
+		std::optional<std::string_view> value;
+
+		if ((i + 1) < argc && !std::string_view{ argv[i + 1] }.starts_with("--"))
+		{
+			value = argv[++i];
+		}
+
+		if (argument == "--output")
+		{
+			if (!value)
+			{
+				std::fputs("Missing value for option \"--output\"\n", stderr);
+				return ExitUsageError;
+			}
+
+			output = PathFromUtf8(*value);
+		}
+		else
+		{
+			arguments.Add(argument, value);
+		}
+	}
+
+	if (!arguments.TakeNumber("--seed", seed))
+	{
+		return ExitUsageError;
+	}
+
+	if (!output)
+	{
+		std::fputs("No output file given\n", stderr);
+		return ExitUsageError;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::optional<bool> result;
+
+	if (format == "bsp")
+	{
+		result = GenerateBsp(*output, seed, arguments);
+	}
+	else if (format == "wad")
+	{
+		result = GenerateWad(*output, seed, arguments);
+	}
+	else if (format == "sprite")
+	{
+		result = GenerateSprite(*output, seed, arguments);
+	}
+	else if (format == "mdl")
+	{
+		result = GenerateStudioModel(*output, seed, arguments);
+	}
+	else
+	{
+		std::fprintf(stderr, "Unknown format \"%s\"\n", argv[1]);
+		return ExitUsageError;
+	}
+
+	if (!result)
+	{
+		return ExitUsageError;
+	}
+
+	if (!*result)
+	{
+		std::fprintf(stderr, "Could not generate \"%s\". Check that the options are within the format's limits.\n",
+			reinterpret_cast<const char*>(output->u8string().c_str()));
+		return ExitGenerationFailed;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::error_code error;
+	const auto size = std::filesystem::file_size(*output, error);
+
+	std::printf("%s: %llu bytes in %.3f seconds\n",
+		reinterpret_cast<const char*>(output->u8string().c_str()), static_cast<unsigned long long>(size), seconds);
+
+	return ExitSuccess;
+}
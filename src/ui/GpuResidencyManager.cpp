@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+#include "ui/GpuResidencyManager.hpp"
+
+static QOpenGLFunctions* GetCurrentFunctions()
+{
+	const auto context = QOpenGLContext::currentContext();
+
+	assert(context);
+
+	return context ? context->functions() : nullptr;
+}
+
+GpuResidencyManager::GpuResidencyManager(std::size_t budget)
+	: _budget(budget)
+{
+}
+
+// Objects that still exist are deleted along with the context group.
+GpuResidencyManager::~GpuResidencyManager() = default;
+
+void GpuResidencyManager::SetBudget(std::size_t budget)
+{
+	_budget = budget;
+}
+
+void GpuResidencyManager::BeginFrame(const void* widget)
+{
+	auto& frames = _widgetFrames[widget];
+
+	frames.Previous = frames.Current;
+	frames.Current = ++_frame;
+
+	Evict(_budget);
+}
+
+void GpuResidencyManager::RemoveWidget(const void* widget)
+{
+	_widgetFrames.erase(widget);
+}
+
+GpuResourceId GpuResidencyManager::Add(const void* owner, GpuResourceType type, std::size_t bytes, UploadFunction upload)
+{
+	const GpuResourceId id = _nextId++;
+
+	auto& resource = _resources.emplace(id, Resource{ owner, type, bytes, std::move(upload) }).first->second;
+
+	MakeResident(id, resource);
+
+	return id;
+}
+
+GLuint GpuResidencyManager::Acquire(GpuResourceId id)
+{
+	const auto it = _resources.find(id);
+
+	if (it == _resources.end())
+	{
+		return 0;
+	}
+
+	auto& resource = it->second;
+
+	if (resource.Name == 0)
+	{
+		MakeResident(id, resource);
+	}
+	else
+	{
+		_resident.splice(_resident.begin(), _resident, resource.ResidentPosition);
+		resource.LastUsedFrame = _frame;
+	}
+
+	return resource.Name;
+}
+
+GLuint GpuResidencyManager::GetName(GpuResourceId id) const
+{
+	const auto it = _resources.find(id);
+	return it != _resources.end() ? it->second.Name : 0;
+}
+
+void GpuResidencyManager::Remove(GpuResourceId id)
+{
+	if (const auto it = _resources.find(id); it != _resources.end())
+	{
+		Release(it->second);
+		_resources.erase(it);
+	}
+}
+
+void GpuResidencyManager::RemoveAll(const void* owner)
+{
+	for (auto it = _resources.begin(); it != _resources.end();)
+	{
+		if (it->second.Owner == owner)
+		{
+			Release(it->second);
+			it = _resources.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	_ownerBytes.erase(owner);
+}
+
+std::size_t GpuResidencyManager::GetResidentBytes(const void* owner, GpuResourceType type) const
+{
+	const auto it = _ownerBytes.find(owner);
+	return it != _ownerBytes.end() ? it->second[static_cast<std::size_t>(type)] : 0;
+}
+
+void GpuResidencyManager::ResetCounters()
+{
+	_uploadCount = 0;
+	_evictionCount = 0;
+}
+
+void GpuResidencyManager::MakeResident(GpuResourceId id, Resource& resource)
+{
+	// Make room first so the old objects can be freed before the new one is allocated.
+	Evict(resource.Bytes < _budget ? _budget - resource.Bytes : 0);
+
+	const auto functions = GetCurrentFunctions();
+
+	if (!functions)
+	{
+		return;
+	}
+
+	switch (resource.Type)
+	{
+	case GpuResourceType::Buffer:
+		functions->glGenBuffers(1, &resource.Name);
+		break;
+
+	case GpuResourceType::Texture:
+		functions->glGenTextures(1, &resource.Name);
+		break;
+
+	default: break;
+	}
+
+	resource.Upload(id, resource.Name);
+
+	_resident.push_front(id);
+	resource.ResidentPosition = _resident.begin();
+	resource.LastUsedFrame = _frame;
+
+	_residentBytes += resource.Bytes;
+	_ownerBytes[resource.Owner][static_cast<std::size_t>(resource.Type)] += resource.Bytes;
+
+	++_uploadCount;
+}
+
+void GpuResidencyManager::Evict(std::size_t budget)
+{
+	// Resources used before the oldest of the widgets' latest frames are not protected by any of them.
+	std::uint64_t oldestFrame = _frame;
+
+	for (const auto& [widget, frames] : _widgetFrames)
+	{
+		oldestFrame = std::min(oldestFrame, frames.Previous);
+	}
+
+	for (auto it = _resident.end(); it != _resident.begin() && _residentBytes > budget;)
+	{
+		--it;
+
+		auto& resource = _resources.at(*it);
+
+		// Everything after this was used this frame too.
+		if (resource.LastUsedFrame == _frame)
+		{
+			break;
+		}
+
+		if (resource.LastUsedFrame >= oldestFrame
+			&& std::ranges::any_of(_widgetFrames, [&](const auto& entry)
+				{
+					return entry.second.Current == resource.LastUsedFrame || entry.second.Previous == resource.LastUsedFrame;
+				}))
+		{
+			continue;
+		}
+
+		// Releasing the resource removes it from the list, so step past it first.
+		it = std::next(it);
+		Release(resource);
+		++_evictionCount;
+	}
+}
+
+void GpuResidencyManager::Release(Resource& resource)
+{
+	if (resource.Name == 0)
+	{
+		return;
+	}
+
+	if (const auto functions = GetCurrentFunctions(); functions)
+	{
+		switch (resource.Type)
+		{
+		case GpuResourceType::Buffer:
+			functions->glDeleteBuffers(1, &resource.Name);
+			break;
+
+		case GpuResourceType::Texture:
+			functions->glDeleteTextures(1, &resource.Name);
+			break;
+
+		default: break;
+		}
+	}
+
+	resource.Name = 0;
+
+	_resident.erase(resource.ResidentPosition);
+
+	_residentBytes -= resource.Bytes;
+
+	if (const auto it = _ownerBytes.find(resource.Owner); it != _ownerBytes.end())
+	{
+		it->second[static_cast<std::size_t>(resource.Type)] -= resource.Bytes;
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include <qopengl.h>
+
+enum class GpuResourceType
+{
+	Buffer = 0,
+	Texture,
+	Count
+};
+
+/**
+*	@brief Identifies a resource in the residency manager. 0 is never used by a resource.
+*/
+using GpuResourceId = std::uint64_t;
+
+/**
+*	@brief Tracks the buffers and textures of every OpenGL widget and keeps their total size within a budget.
+*	@details Resources are registered with a function that fills a newly created object with the resource's data.
+*	When the resident resources exceed the budget the least recently used ones are deleted,
+*	and recreated from their upload function the next time they are acquired.
+*	Resources acquired during the current or previous frame of any widget are never evicted, so widgets that need
+*	more than the budget, alone or together, exceed it instead of evicting and uploading each other's resources
+*	over and over. A shared resource is protected by the frame that used it last.
+*
+*	All windows share one OpenGL context group, so any widget can delete the objects of another.
+*	All members must be used on the GUI thread, and members that create or delete objects need a current context.
+*/
+class GpuResidencyManager final
+{
+public:
+	static constexpr std::size_t DefaultBudget = 512 * 1024 * 1024;
+
+	/**
+	*	@brief Fills the object with the given name with the resource's data. Called with the owner's context current.
+	*	@details The data may also be uploaded later, as long as the upload is dropped if GetName no longer returns @p name.
+	*/
+	using UploadFunction = std::function<void(GpuResourceId id, GLuint name)>;
+
+	explicit GpuResidencyManager(std::size_t budget = DefaultBudget);
+	~GpuResidencyManager();
+
+	GpuResidencyManager(const GpuResidencyManager&) = delete;
+	GpuResidencyManager& operator=(const GpuResidencyManager&) = delete;
+
+	std::size_t GetBudget() const { return _budget; }
+
+	/**
+	*	@brief Sets the maximum number of bytes used by resident resources.
+	*	Resources over the budget are evicted when the next frame begins.
+	*/
+	void SetBudget(std::size_t budget);
+
+	/**
+	*	@brief Marks the start of a frame of @p widget and evicts resources if the budget is exceeded.
+	*	The resources the widget used two frames ago and not since are no longer protected from eviction.
+	*	Widgets must call this at the start of every paint.
+	*/
+	void BeginFrame(const void* widget);
+
+	/**
+	*	@brief Stops protecting the resources used in the latest frames of @p widget.
+	*	Widgets must call this when they are destroyed.
+	*/
+	void RemoveWidget(const void* widget);
+
+	/**
+	*	@brief Registers a resource and uploads it right away.
+	*	@param bytes Memory used by the resource once uploaded.
+	*/
+	GpuResourceId Add(const void* owner, GpuResourceType type, std::size_t bytes, UploadFunction upload);
+
+	/**
+	*	@brief Gets the object of a resource, uploading it again if it was evicted.
+	*	@return The name of the object, or 0 if the id is invalid.
+	*/
+	GLuint Acquire(GpuResourceId id);
+
+	/**
+	*	@brief Gets the object of a resource without uploading it or marking it as used.
+	*	@return The name of the object, or 0 if the id is invalid or the resource is evicted.
+	*/
+	GLuint GetName(GpuResourceId id) const;
+
+	/**
+	*	@brief Deletes a resource and its object.
+	*/
+	void Remove(GpuResourceId id);
+
+	/**
+	*	@brief Deletes all resources belonging to the given owner.
+	*	Owners must call this when the data the resources were created from changes or is destroyed.
+	*/
+	void RemoveAll(const void* owner);
+
+	std::size_t GetCount() const { return _resources.size(); }
+
+	std::size_t GetResidentBytes() const { return _residentBytes; }
+
+	/**
+	*	@brief Gets the number of bytes used by resident resources of the given type belonging to the given owner.
+	*/
+	std::size_t GetResidentBytes(const void* owner, GpuResourceType type) const;
+
+	std::uint64_t GetUploadCount() const { return _uploadCount; }
+	std::uint64_t GetEvictionCount() const { return _evictionCount; }
+
+	void ResetCounters();
+
+private:
+	struct WidgetFrames
+	{
+		std::uint64_t Previous{ 0 };
+		std::uint64_t Current{ 0 };
+	};
+
+	struct Resource
+	{
+		const void* Owner{};
+		GpuResourceType Type{ GpuResourceType::Buffer };
+		std::size_t Bytes{ 0 };
+		UploadFunction Upload;
+
+		// 0 while evicted.
+		GLuint Name{ 0 };
+		std::uint64_t LastUsedFrame{ 0 };
+		std::list<GpuResourceId>::iterator ResidentPosition{};
+	};
+
+	void MakeResident(GpuResourceId id, Resource& resource);
+
+	void Evict(std::size_t budget);
+
+	/**
+	*	@brief Deletes a resource's object and removes its size from the totals. Does not remove the resource itself.
+	*/
+	void Release(Resource& resource);
+
+private:
+	std::size_t _budget;
+	std::size_t _residentBytes{ 0 };
+
+	// Incremented by every widget's frame, so frames of different widgets never have the same number.
+	std::uint64_t _frame{ 1 };
+	GpuResourceId _nextId{ 1 };
+
+	std::uint64_t _uploadCount{ 0 };
+	std::uint64_t _evictionCount{ 0 };
+
+	std::unordered_map<GpuResourceId, Resource> _resources;
+
+	// Resident resources, most recently used first.
+	std::list<GpuResourceId> _resident;
+
+	// Latest frames of every widget that has painted.
+	std::unordered_map<const void*, WidgetFrames> _widgetFrames;
+
+	// Kept up to date so owners can show their usage without going over every resource.
+	std::unordered_map<const void*, std::array<std::size_t, static_cast<std::size_t>(GpuResourceType::Count)>> _ownerBytes;
+};
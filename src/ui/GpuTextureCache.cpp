@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+#include "ui/GpuTextureCache.hpp"
+#include "ui/TextureUploader.hpp"
+
+GpuTextureCache::GpuTextureCache(GpuResidencyManager* residencyManager)
+	: _residencyManager(residencyManager)
+{
+}
+
+// Textures that still exist are deleted along with the context group.
+GpuTextureCache::~GpuTextureCache() = default;
+
+void GpuTextureCache::Retain(const void* user, std::uint64_t key, std::uint32_t width, std::uint32_t height,
+	DecodedTextureCache::DecodeFunction decode)
+{
+	auto& texture = _textures[key];
+
+	if (texture.UserCount == 0)
+	{
+		texture.Width = width;
+		texture.Height = height;
+		texture.Decode = std::move(decode);
+	}
+
+	++texture.UserCount;
+
+	_userTextures[user].push_back(key);
+}
+
+void GpuTextureCache::ReleaseAll(const void* user)
+{
+	const auto it = _userTextures.find(user);
+
+	if (it == _userTextures.end())
+	{
+		return;
+	}
+
+	for (const auto key : it->second)
+	{
+		auto& texture = _textures.at(key);
+
+		if (--texture.UserCount == 0)
+		{
+			// Releases the data the user's decode function kept alive. Uploads in progress have their own copy.
+			texture.Decode = {};
+		}
+	}
+
+	_userTextures.erase(it);
+
+	RemoveUnused();
+}
+
+GLuint GpuTextureCache::Acquire(std::uint64_t key, TextureUploader& uploader)
+{
+	const auto it = _textures.find(key);
+
+	if (it == _textures.end() || it->second.UserCount == 0)
+	{
+		return 0;
+	}
+
+	auto& texture = it->second;
+
+	_activeUploader = &uploader;
+
+	if (texture.Resource == 0)
+	{
+		texture.Resource = _residencyManager->Add(this, GpuResourceType::Texture,
+			static_cast<std::size_t>(texture.Width) * texture.Height * 4,
+			[this, key](GpuResourceId resource, GLuint name)
+			{
+				// The texture was evicted, so uploads of the old object that were still pending have been dropped.
+				_textures.at(key).PendingUploaders.clear();
+				Upload(key, resource, name, *_activeUploader);
+			});
+	}
+
+	// Uploads the texture again if it was evicted.
+	const GLuint name = _residencyManager->Acquire(texture.Resource);
+
+	// The widget whose uploader has the texture queued may be hidden and never get to upload it.
+	if (name != 0 && (texture.NeedsUpload
+		|| (!texture.PendingUploaders.empty() && std::ranges::find(texture.PendingUploaders, &uploader) == texture.PendingUploaders.end())))
+	{
+		Upload(key, texture.Resource, name, uploader);
+	}
+
+	_activeUploader = nullptr;
+
+	return name;
+}
+
+std::size_t GpuTextureCache::GetResidentBytes(const void* user) const
+{
+	const auto it = _userTextures.find(user);
+
+	if (it == _userTextures.end())
+	{
+		return 0;
+	}
+
+	// Maps often list the same texture more than once.
+	auto keys = it->second;
+
+	std::ranges::sort(keys);
+	const auto duplicates = std::ranges::unique(keys);
+	keys.erase(duplicates.begin(), duplicates.end());
+
+	std::size_t bytes = 0;
+
+	for (const auto key : keys)
+	{
+		const auto& texture = _textures.at(key);
+
+		if (texture.Resource != 0 && _residencyManager->GetName(texture.Resource) != 0)
+		{
+			bytes += static_cast<std::size_t>(texture.Width) * texture.Height * 4;
+		}
+	}
+
+	return bytes;
+}
+
+void GpuTextureCache::Upload(std::uint64_t key, GpuResourceId resource, GLuint name, TextureUploader& uploader)
+{
+	auto& texture = _textures.at(key);
+
+	texture.NeedsUpload = false;
+
+	const int width = static_cast<int>(texture.Width);
+	const int height = static_cast<int>(texture.Height);
+
+	// Uploads queued on other uploaders already created the storage, and it has the same size.
+	if (texture.PendingUploaders.empty())
+	{
+		const auto context = QOpenGLContext::currentContext();
+
+		assert(context);
+
+		if (!context)
+		{
+			return;
+		}
+
+		const auto functions = context->functions();
+
+		functions->glBindTexture(GL_TEXTURE_2D, name);
+		functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		uploader.CreateStorage(name, width, height);
+	}
+
+	texture.PendingUploaders.push_back(&uploader);
+
+	uploader.Enqueue(resource, name, width, height,
+		[key, width = texture.Width, height = texture.Height, decode = texture.Decode](std::span<std::uint8_t> pixels)
+		{
+			// Another window or a previous map may have decoded it already.
+			const auto decoded = DecodedTextureCache::GetInstance().Get(key, width, height, decode);
+
+			std::copy_n(decoded->Pixels.begin(), std::min(decoded->Pixels.size(), pixels.size()), pixels.begin());
+		},
+		[this, key, name, uploader = &uploader](bool uploaded)
+		{
+			const auto it = _textures.find(key);
+
+			// Uploads that were still pending elsewhere when another one finished have nothing left to do.
+			if (it == _textures.end() || _residencyManager->GetName(it->second.Resource) != name)
+			{
+				return;
+			}
+
+			auto& pending = it->second.PendingUploaders;
+
+			const auto uploaderIt = std::ranges::find(pending, uploader);
+
+			if (uploaderIt == pending.end())
+			{
+				return;
+			}
+
+			if (uploaded)
+			{
+				pending.clear();
+				return;
+			}
+
+			pending.erase(uploaderIt);
+
+			// The upload was dropped, most likely because the uploader's widget switched maps or was destroyed.
+			// If no other uploader has it queued the texture is still resident with no pixels in it,
+			// so the next user to acquire it uploads it again.
+			if (pending.empty())
+			{
+				it->second.NeedsUpload = true;
+			}
+		});
+}
+
+void GpuTextureCache::RemoveUnused()
+{
+	// Unused textures that are still resident are kept so the next map can reuse them.
+	// Evicted ones have no object left to reuse, and removing them needs no context.
+	std::erase_if(_textures, [this](const auto& entry)
+		{
+			const auto& texture = entry.second;
+
+			if (texture.UserCount > 0 || (texture.Resource != 0 && _residencyManager->GetName(texture.Resource) != 0))
+			{
+				return false;
+			}
+
+			_residencyManager->Remove(texture.Resource);
+			return true;
+		});
+}
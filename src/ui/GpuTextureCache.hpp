@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <qopengl.h>
+
+#include "formats/DecodedTextureCache.hpp"
+
+#include "ui/GpuResidencyManager.hpp"
+
+class TextureUploader;
+
+/**
+*	@brief Shares the GL textures of identical images between windows, and between the maps shown in one window.
+*	@details Textures are keyed by a hash of their contents, the same keys DecodedTextureCache uses.
+*	Users retain the textures they show, the first user to retain a texture provides the function that decodes it.
+*	Textures no user retains stay resident until GpuResidencyManager evicts them, so switching to a map that uses
+*	the same textures reuses them instead of decoding and uploading them again.
+*	Pixels are decoded through DecodedTextureCache on the uploader's worker thread.
+*
+*	All windows share one OpenGL context group, so the textures can be used by any widget.
+*	All members must be used on the GUI thread.
+*/
+class GpuTextureCache final
+{
+public:
+	explicit GpuTextureCache(GpuResidencyManager* residencyManager);
+	~GpuTextureCache();
+
+	GpuTextureCache(const GpuTextureCache&) = delete;
+	GpuTextureCache& operator=(const GpuTextureCache&) = delete;
+
+	/**
+	*	@brief Marks a texture as used by @p user.
+	*	@param decode Writes the texture's RGBA pixels on a worker thread.
+	*		It must keep the data it reads alive itself, since uploads can outlive the user.
+	*/
+	void Retain(const void* user, std::uint64_t key, std::uint32_t width, std::uint32_t height,
+		DecodedTextureCache::DecodeFunction decode);
+
+	/**
+	*	@brief Releases all textures retained by @p user. Textures no longer used by anyone stay cached while resident.
+	*/
+	void ReleaseAll(const void* user);
+
+	/**
+	*	@brief Gets the object of a retained texture, queuing an upload on @p uploader if the texture isn't resident.
+	*	If another uploader is still uploading the texture it is queued on @p uploader as well,
+	*	so it doesn't depend on another widget painting again. Must be called with the uploader's context current.
+	*	@return The name of the texture, or 0 if no user retains a texture with this key.
+	*/
+	GLuint Acquire(std::uint64_t key, TextureUploader& uploader);
+
+	std::size_t GetCount() const { return _textures.size(); }
+
+	/**
+	*	@brief Gets the number of bytes used by resident textures retained by @p user.
+	*/
+	std::size_t GetResidentBytes(const void* user) const;
+
+private:
+	struct Texture
+	{
+		std::uint32_t Width{ 0 };
+		std::uint32_t Height{ 0 };
+		std::size_t UserCount{ 0 };
+		DecodedTextureCache::DecodeFunction Decode;
+		GpuResourceId Resource{ 0 };
+
+		// Uploaders with an unfinished upload of the texture, cleared once one of them finishes it.
+		std::vector<TextureUploader*> PendingUploaders;
+
+		// Set when all uploads were dropped while the texture remained resident.
+		bool NeedsUpload{ false };
+	};
+
+	void Upload(std::uint64_t key, GpuResourceId resource, GLuint name, TextureUploader& uploader);
+
+	/**
+	*	@brief Removes textures that no user retains and that have been evicted.
+	*/
+	void RemoveUnused();
+
+private:
+	GpuResidencyManager* const _residencyManager;
+
+	std::unordered_map<std::uint64_t, Texture> _textures;
+	std::unordered_map<const void*, std::vector<std::uint64_t>> _userTextures;
+
+	// Uploader of the Acquire call in progress, used when the residency manager uploads a texture again.
+	TextureUploader* _activeUploader{};
+};
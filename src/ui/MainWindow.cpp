@@ -1,12 +1,22 @@
-#include <cstdio>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QLabel>
 #include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QStatusBar>
+#include <QTimer>
 
 #include "ui_MainWindow.h"
 
 #include "application/MultiAsset.hpp"
 
+#include "formats/DecodedTextureCache.hpp"
+
 #include "ui/MainWindow.hpp"
 
 MainWindow::MainWindow(MultiAsset* multiAsset)
@@ -20,8 +30,62 @@ MainWindow::MainWindow(MultiAsset* multiAsset)
 		{
 			emit _multiAsset->PromptOpenFile(this, {});
 		});
+	connect(_ui->ActionIndexDirectory, &QAction::triggered, this, &MainWindow::OnIndexDirectory);
 	connect(_multiAsset, &MultiAsset::PromptOpenFile, this, &MainWindow::OnPromptOpenFile);
 
+	_indexLabel = new QLabel(this);
+	statusBar()->addWidget(_indexLabel);
+
+	auto indexer = _multiAsset->GetAssetIndexer();
+
+	connect(indexer, &AssetIndexer::IndexingStarted, this, &MainWindow::UpdateIndexStatus);
+	connect(indexer, &AssetIndexer::IndexingFinished, this, &MainWindow::UpdateIndexStatus);
+	connect(indexer, &AssetIndexer::EntriesChanged, this, &MainWindow::UpdateIndexStatus);
+
+	_loadLabel = new QLabel(this);
+	_loadProgress = new QProgressBar(this);
+	_cancelLoadButton = new QPushButton("Cancel", this);
+
+	_loadProgress->setRange(0, 100);
+	_loadProgress->setMaximumWidth(200);
+
+	statusBar()->addPermanentWidget(_loadLabel);
+	statusBar()->addPermanentWidget(_loadProgress);
+	statusBar()->addPermanentWidget(_cancelLoadButton);
+
+	// Progress is polled instead of signalled so workers don't flood the event loop.
+	_loadProgressTimer = new QTimer(this);
+
+	auto loadQueue = _multiAsset->GetAssetLoadQueue();
+
+	connect(_cancelLoadButton, &QPushButton::clicked, loadQueue, &AssetLoadQueue::CancelAll);
+	connect(_loadProgressTimer, &QTimer::timeout, this, &MainWindow::UpdateLoadProgress);
+	connect(loadQueue, &AssetLoadQueue::LoadStarted, this, &MainWindow::UpdateLoadProgress);
+	connect(loadQueue, &AssetLoadQueue::LoadFinished, this, &MainWindow::OnLoadFinished);
+
+	UpdateLoadProgress();
+
+	_pixmapCacheLabel = new QLabel(this);
+	statusBar()->addPermanentWidget(_pixmapCacheLabel);
+
+	_gpuResidencyLabel = new QLabel(this);
+	statusBar()->addPermanentWidget(_gpuResidencyLabel);
+
+	_textureCacheLabel = new QLabel(this);
+	statusBar()->addPermanentWidget(_textureCacheLabel);
+
+	auto pixmapCacheTimer = new QTimer(this);
+
+	connect(pixmapCacheTimer, &QTimer::timeout, this, &MainWindow::UpdatePixmapCacheStatus);
+	connect(pixmapCacheTimer, &QTimer::timeout, this, &MainWindow::UpdateGpuResidencyStatus);
+	connect(pixmapCacheTimer, &QTimer::timeout, this, &MainWindow::UpdateTextureCacheStatus);
+
+	pixmapCacheTimer->start(1000);
+
+	UpdatePixmapCacheStatus();
+	UpdateGpuResidencyStatus();
+	UpdateTextureCacheStatus();
+
 	QStringList extensions;
 	QStringList filters;
 
@@ -50,37 +114,128 @@ MainWindow::~MainWindow() = default;
 
 void MainWindow::OnPromptOpenFile(QWidget* parent, QString defaultFilter)
 {
-	const QString fileName = QFileDialog::getOpenFileName(parent, {}, {}, _openFileFilters, &defaultFilter);
+	const QStringList fileNames = QFileDialog::getOpenFileNames(parent, {}, {}, _openFileFilters, &defaultFilter);
+
+	for (const auto& fileName : fileNames)
+	{
+		_multiAsset->GetAssetLoadQueue()->Load(fileName);
+	}
+}
+
+void MainWindow::OnIndexDirectory()
+{
+	const QString directory = QFileDialog::getExistingDirectory(this, "Select game or mod directory");
 
-	if (fileName.isEmpty())
+	if (directory.isEmpty())
 	{
 		return;
 	}
 
-	FILE* file = fopen(fileName.toStdString().c_str(), "rb");
+	_multiAsset->GetAssetIndexer()->SetRootDirectory(directory);
+}
+
+void MainWindow::UpdateIndexStatus()
+{
+	const auto indexer = _multiAsset->GetAssetIndexer();
 
-	if (!file)
+	if (indexer->GetRootDirectory().isEmpty())
 	{
+		_indexLabel->clear();
 		return;
 	}
 
-	bool handled = false;
+	const auto& entries = indexer->GetEntries();
 
-	for (auto assetLoader : _multiAsset->GetAssetLoaders()->GetLoaders())
+	const auto assetCount = std::count_if(entries.begin(), entries.end(), [](const auto& entry) { return !entry.Type.isEmpty(); });
+
+	_indexLabel->setText(QString{ "%1: %2 assets in %3 files%4" }
+		.arg(indexer->GetRootDirectory())
+		.arg(assetCount)
+		.arg(entries.size())
+		.arg(indexer->IsIndexing() ? " (indexing)" : ""));
+}
+
+void MainWindow::OnLoadFinished(const QString& fileName, AssetLoadStatus status)
+{
+	UpdateLoadProgress();
+
+	switch (status)
 	{
-		if (assetLoader->TryLoadFile(file))
-		{
-			handled = true;
-			break;
-		}
+	case AssetLoadStatus::NotSupported:
+		QMessageBox::critical(this, "Asset not supported",
+			QString{ "The file \"%1\" is not a supported asset type" }.arg(QFileInfo{ fileName }.fileName()));
+		break;
+
+	case AssetLoadStatus::Failed:
+		QMessageBox::critical(this, "Error loading asset",
+			QString{ "The file \"%1\" could not be loaded" }.arg(QFileInfo{ fileName }.fileName()));
+		break;
 
-		rewind(file);
+	default: break;
 	}
+}
+
+void MainWindow::UpdateLoadProgress()
+{
+	const auto loadQueue = _multiAsset->GetAssetLoadQueue();
+
+	const int pendingCount = loadQueue->GetPendingCount();
 
-	fclose(file);
+	const bool isLoading = pendingCount > 0;
 
-	if (!handled)
+	_loadLabel->setVisible(isLoading);
+	_loadProgress->setVisible(isLoading);
+	_cancelLoadButton->setVisible(isLoading);
+
+	if (!isLoading)
 	{
-		QMessageBox::critical(this, "Asset not supported", "The selected file is not a supported asset type");
+		_loadProgressTimer->stop();
+		return;
 	}
+
+	if (!_loadProgressTimer->isActive())
+	{
+		_loadProgressTimer->start(100);
+	}
+
+	_loadLabel->setText(QString{ "Loading %1 file(s)" }.arg(pendingCount));
+	_loadProgress->setValue(static_cast<int>(std::floor(loadQueue->GetProgress() * 100)));
+}
+
+void MainWindow::UpdatePixmapCacheStatus()
+{
+	const auto pixmapCache = _multiAsset->GetPixmapCache();
+
+	constexpr double BytesPerMiB = 1024 * 1024;
+
+	_pixmapCacheLabel->setText(QString{ "Pixmaps: %1 / %2 MiB, %3% hits" }
+		.arg(pixmapCache->GetResidentBytes() / BytesPerMiB, 0, 'f', 1)
+		.arg(pixmapCache->GetBudget() / BytesPerMiB, 0, 'f', 0)
+		.arg(static_cast<int>(std::round(pixmapCache->GetHitRate() * 100))));
+}
+
+void MainWindow::UpdateGpuResidencyStatus()
+{
+	const auto residencyManager = _multiAsset->GetGpuResidencyManager();
+
+	constexpr double BytesPerMiB = 1024 * 1024;
+
+	_gpuResidencyLabel->setText(QString{ "GPU: %1 / %2 MiB, %3 evictions" }
+		.arg(residencyManager->GetResidentBytes() / BytesPerMiB, 0, 'f', 1)
+		.arg(residencyManager->GetBudget() / BytesPerMiB, 0, 'f', 0)
+		.arg(residencyManager->GetEvictionCount()));
+}
+
+void MainWindow::UpdateTextureCacheStatus()
+{
+	const auto& textureCache = DecodedTextureCache::GetInstance();
+
+	constexpr double BytesPerMiB = 1024 * 1024;
+
+	const std::uint64_t lookupCount = textureCache.GetHitCount() + textureCache.GetMissCount();
+
+	_textureCacheLabel->setText(QString{ "Textures: %1 / %2 MiB, %3% hits" }
+		.arg(textureCache.GetResidentBytes() / BytesPerMiB, 0, 'f', 1)
+		.arg(textureCache.GetBudget() / BytesPerMiB, 0, 'f', 0)
+		.arg(lookupCount > 0 ? static_cast<int>(std::round((textureCache.GetHitCount() * 100.0) / lookupCount)) : 0));
 }
@@ -5,7 +5,13 @@
 #include <QString>
 #include <QMainWindow>
 
+#include "assets/IAssetLoader.hpp"
+
 class MultiAsset;
+class QLabel;
+class QProgressBar;
+class QPushButton;
+class QTimer;
 class Ui_MainWindow;
 
 class MainWindow final : public QMainWindow
@@ -17,9 +23,34 @@ public:
 private slots:
 	void OnPromptOpenFile(QWidget* parent, QString defaultFilter);
 
+	void OnIndexDirectory();
+
+	void UpdateIndexStatus();
+
+	void OnLoadFinished(const QString& fileName, AssetLoadStatus status);
+
+	void UpdateLoadProgress();
+
+	void UpdatePixmapCacheStatus();
+
+	void UpdateGpuResidencyStatus();
+
+	void UpdateTextureCacheStatus();
+
 private:
 	MultiAsset* const _multiAsset;
 	std::unique_ptr<Ui_MainWindow> _ui;
 
 	QString _openFileFilters;
+
+	QLabel* _indexLabel;
+
+	QLabel* _loadLabel;
+	QProgressBar* _loadProgress;
+	QPushButton* _cancelLoadButton;
+	QTimer* _loadProgressTimer;
+
+	QLabel* _pixmapCacheLabel;
+	QLabel* _gpuResidencyLabel;
+	QLabel* _textureCacheLabel;
 };
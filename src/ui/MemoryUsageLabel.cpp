@@ -0,0 +1,84 @@
+#include <utility>
+
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QMenu>
+#include <QTimer>
+
+#include "ui/MemoryUsageLabel.hpp"
+
+#include "utils/JsonWriter.hpp"
+
+static QString FormatBytes(std::size_t bytes)
+{
+	return QString::fromStdString(FormatByteSize(bytes));
+}
+
+MemoryUsageLabel::MemoryUsageLabel(Provider provider, QWidget* parent)
+	: QLabel(parent)
+	, _provider(std::move(provider))
+	, _timer(new QTimer(this))
+{
+	connect(_timer, &QTimer::timeout, this, &MemoryUsageLabel::Update);
+}
+
+void MemoryUsageLabel::Update()
+{
+	const auto usage = _provider();
+	const auto total = usage.GetTotal();
+
+	setText(QString{ "Memory: %1 in %2 allocations, GPU: %3" }
+		.arg(FormatBytes(total.HeapBytes))
+		.arg(total.AllocationCount)
+		.arg(FormatBytes(total.GpuBytes)));
+
+	QString toolTip = "<table><tr><th align=\"left\">Category</th><th>Memory</th><th>Allocations</th><th>GPU</th></tr>";
+
+	for (std::size_t i = 0; i < MemoryCategoryCount; ++i)
+	{
+		const auto category = static_cast<MemoryCategory>(i);
+		const auto& categoryUsage = usage.Get(category);
+
+		toolTip += QString{ "<tr><td>%1</td><td align=\"right\">%2</td><td align=\"right\">%3</td><td align=\"right\">%4</td></tr>" }
+			.arg(QString::fromUtf8(GetMemoryCategoryName(category)))
+			.arg(FormatBytes(categoryUsage.HeapBytes))
+			.arg(categoryUsage.AllocationCount)
+			.arg(FormatBytes(categoryUsage.GpuBytes));
+	}
+
+	toolTip += "</table>";
+
+	setToolTip(toolTip);
+}
+
+void MemoryUsageLabel::showEvent(QShowEvent* event)
+{
+	QLabel::showEvent(event);
+
+	Update();
+	_timer->start(1000);
+}
+
+void MemoryUsageLabel::hideEvent(QHideEvent* event)
+{
+	_timer->stop();
+
+	QLabel::hideEvent(event);
+}
+
+void MemoryUsageLabel::contextMenuEvent(QContextMenuEvent* event)
+{
+	QMenu menu{ this };
+
+	menu.addAction("Copy as JSON", this, [this]
+		{
+			JsonWriter writer{ true };
+
+			WriteMemoryUsage(writer, _provider());
+
+			QApplication::clipboard()->setText(QString::fromStdString(writer.GetString()));
+		});
+
+	menu.exec(event->globalPos());
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+
+#include <QLabel>
+
+#include "utils/MemoryUsage.hpp"
+
+class QTimer;
+
+/**
+*	@brief Status bar label showing the memory used by a window's asset, with a breakdown by category in its tool tip.
+*	@details Usage changes as pixmaps and GPU objects are created on demand, so it is polled while the label is visible.
+*	The context menu copies the usage to the clipboard as JSON.
+*/
+class MemoryUsageLabel final : public QLabel
+{
+public:
+	using Provider = std::function<MemoryUsage()>;
+
+	MemoryUsageLabel(Provider provider, QWidget* parent = nullptr);
+
+	void Update();
+
+protected:
+	void showEvent(QShowEvent* event) override;
+	void hideEvent(QHideEvent* event) override;
+
+	void contextMenuEvent(QContextMenuEvent* event) override;
+
+private:
+	const Provider _provider;
+	QTimer* const _timer;
+};
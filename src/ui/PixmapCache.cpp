@@ -0,0 +1,132 @@
+#include <algorithm>
+
+#include "ui/PixmapCache.hpp"
+
+static qint64 GetPixmapSize(const QPixmap& pixmap)
+{
+	return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+PixmapCache::PixmapCache(qint64 budget)
+	: _budget(budget)
+{
+}
+
+PixmapCache::~PixmapCache() = default;
+
+void PixmapCache::SetBudget(qint64 budget)
+{
+	_budget = std::max(qint64{ 0 }, budget);
+	Evict(_budget);
+}
+
+QPixmap PixmapCache::Get(const PixmapKey& key, const std::function<QImage()>& createImage)
+{
+	if (const auto it = _lookup.find(key); it != _lookup.end())
+	{
+		++_hitCount;
+		_entries.splice(_entries.begin(), _entries, it->second);
+		return it->second->Pixmap;
+	}
+
+	++_missCount;
+
+	QPixmap pixmap = QPixmap::fromImage(createImage());
+
+	const qint64 size = GetPixmapSize(pixmap);
+
+	if (size > _budget)
+	{
+		return pixmap;
+	}
+
+	Evict(_budget - size);
+
+	_entries.push_front({ key, pixmap, size });
+	_lookup.emplace(key, _entries.begin());
+
+	_residentBytes += size;
+
+	auto& ownerUsage = _ownerUsage[key.Owner];
+	++ownerUsage.Count;
+	ownerUsage.Bytes += size;
+
+	return pixmap;
+}
+
+void PixmapCache::RemoveAll(const void* owner)
+{
+	for (auto it = _entries.begin(); it != _entries.end();)
+	{
+		if (it->Key.Owner == owner)
+		{
+			Release(*it);
+			_lookup.erase(it->Key);
+			it = _entries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void PixmapCache::Clear()
+{
+	_lookup.clear();
+	_entries.clear();
+	_ownerUsage.clear();
+	_residentBytes = 0;
+}
+
+std::size_t PixmapCache::GetCount(const void* owner) const
+{
+	const auto it = _ownerUsage.find(owner);
+	return it != _ownerUsage.end() ? it->second.Count : 0;
+}
+
+qint64 PixmapCache::GetResidentBytes(const void* owner) const
+{
+	const auto it = _ownerUsage.find(owner);
+	return it != _ownerUsage.end() ? it->second.Bytes : 0;
+}
+
+float PixmapCache::GetHitRate() const
+{
+	const std::uint64_t lookupCount = _hitCount + _missCount;
+
+	return lookupCount > 0 ? static_cast<float>(_hitCount) / lookupCount : 0.f;
+}
+
+void PixmapCache::ResetCounters()
+{
+	_hitCount = 0;
+	_missCount = 0;
+}
+
+void PixmapCache::Evict(qint64 budget)
+{
+	while (!_entries.empty() && _residentBytes > budget)
+	{
+		const auto& entry = _entries.back();
+
+		Release(entry);
+		_lookup.erase(entry.Key);
+		_entries.pop_back();
+	}
+}
+
+void PixmapCache::Release(const Entry& entry)
+{
+	_residentBytes -= entry.Size;
+
+	if (const auto it = _ownerUsage.find(entry.Key.Owner); it != _ownerUsage.end())
+	{
+		it->second.Bytes -= entry.Size;
+
+		if (--it->second.Count == 0)
+		{
+			_ownerUsage.erase(it);
+		}
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include <QImage>
+#include <QPixmap>
+#include <QtTypes>
+
+/**
+*	@brief Identifies a pixmap in the cache.
+*	@details The owner is usually the window that displays the pixmap, the id is chosen by the owner.
+*/
+struct PixmapKey
+{
+	const void* Owner{};
+	std::uint64_t Id{ 0 };
+
+	bool operator==(const PixmapKey&) const = default;
+};
+
+struct PixmapKeyHash
+{
+	std::size_t operator()(const PixmapKey& key) const
+	{
+		const std::size_t ownerHash = std::hash<const void*>{}(key.Owner);
+		return ownerHash ^ (std::hash<std::uint64_t>{}(key.Id) + 0x9e3779b9 + (ownerHash << 6) + (ownerHash >> 2));
+	}
+};
+
+/**
+*	@brief Least recently used cache of pixmaps shared by all windows.
+*	@details Pixmaps are created on demand when an item is painted and evicted once the cache exceeds its memory budget,
+*	so only pixmaps of recently visible items are resident.
+*	All members must be used on the GUI thread.
+*/
+class PixmapCache final
+{
+public:
+	static constexpr qint64 DefaultBudget = 256 * 1024 * 1024;
+
+	explicit PixmapCache(qint64 budget = DefaultBudget);
+	~PixmapCache();
+
+	PixmapCache(const PixmapCache&) = delete;
+	PixmapCache& operator=(const PixmapCache&) = delete;
+
+	qint64 GetBudget() const { return _budget; }
+
+	/**
+	*	@brief Sets the maximum number of bytes used by pixmaps in the cache. Evicts pixmaps if needed.
+	*/
+	void SetBudget(qint64 budget);
+
+	/**
+	*	@brief Returns the pixmap with the given key, creating it from the image returned by @p createImage if needed.
+	*	@details The pixmap is returned even if it is larger than the budget, but it is not kept in that case.
+	*/
+	QPixmap Get(const PixmapKey& key, const std::function<QImage()>& createImage);
+
+	/**
+	*	@brief Removes all pixmaps belonging to the given owner.
+	*	Owners must call this when the data the pixmaps were created from changes or is destroyed.
+	*/
+	void RemoveAll(const void* owner);
+
+	void Clear();
+
+	std::size_t GetCount() const { return _entries.size(); }
+
+	qint64 GetResidentBytes() const { return _residentBytes; }
+
+	/**
+	*	@brief Gets the number of resident pixmaps belonging to the given owner.
+	*/
+	std::size_t GetCount(const void* owner) const;
+
+	/**
+	*	@brief Gets the number of bytes used by resident pixmaps belonging to the given owner.
+	*/
+	qint64 GetResidentBytes(const void* owner) const;
+
+	std::uint64_t GetHitCount() const { return _hitCount; }
+	std::uint64_t GetMissCount() const { return _missCount; }
+
+	/**
+	*	@brief Gets the fraction of lookups that found a resident pixmap, between 0 and 1.
+	*/
+	float GetHitRate() const;
+
+	void ResetCounters();
+
+private:
+	struct Entry
+	{
+		PixmapKey Key;
+		QPixmap Pixmap;
+		qint64 Size{ 0 };
+	};
+
+	void Evict(qint64 budget);
+
+	/**
+	*	@brief Removes an entry's size from the totals. Does not remove the entry itself.
+	*/
+	void Release(const Entry& entry);
+
+private:
+	qint64 _budget;
+	qint64 _residentBytes{ 0 };
+
+	std::uint64_t _hitCount{ 0 };
+	std::uint64_t _missCount{ 0 };
+
+	// Most recently used first.
+	std::list<Entry> _entries;
+	std::unordered_map<PixmapKey, std::list<Entry>::iterator, PixmapKeyHash> _lookup;
+
+	struct OwnerUsage
+	{
+		std::size_t Count{ 0 };
+		qint64 Bytes{ 0 };
+	};
+
+	// Kept up to date so owners can show their usage without going over every entry.
+	std::unordered_map<const void*, OwnerUsage> _ownerUsage;
+};
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <utility>
+
+#include "ui/TextureUploader.hpp"
+
+// Keeps every upload's offset suitably aligned for the driver to copy from.
+constexpr std::size_t RingBufferAlignment = 256;
+
+constexpr GLbitfield RingBufferFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+TextureUploader::TextureUploader(QOpenGLFunctions_4_5_Compatibility* functions, GpuResidencyManager* residencyManager,
+	std::size_t ringBufferSize)
+	: _functions(functions)
+	, _residencyManager(residencyManager)
+	, _ringBufferSize(ringBufferSize)
+{
+	// Conversions finish in the order they were started, so ring buffer space is released in order too.
+	_threadPool.setMaxThreadCount(1);
+
+	_functions->glCreateBuffers(1, &_ringBuffer);
+	_functions->glNamedBufferStorage(_ringBuffer, static_cast<GLsizeiptr>(_ringBufferSize), nullptr, RingBufferFlags);
+
+	// If the buffer can't be mapped every texture is converted into memory of its own instead.
+	_ringBufferData = static_cast<std::uint8_t*>(
+		_functions->glMapNamedBufferRange(_ringBuffer, 0, static_cast<GLsizeiptr>(_ringBufferSize), RingBufferFlags));
+}
+
+TextureUploader::~TextureUploader()
+{
+	CancelAll();
+
+	// The copies have been issued, so they complete even though their fences are deleted.
+	for (const auto& job : _activeJobs)
+	{
+		_functions->glDeleteSync(job->Fence);
+		Finish(*job, true);
+	}
+
+	if (_ringBufferData)
+	{
+		_functions->glUnmapNamedBuffer(_ringBuffer);
+	}
+
+	_functions->glDeleteBuffers(1, &_ringBuffer);
+}
+
+void TextureUploader::CreateStorage(GLuint texture, int width, int height)
+{
+	_functions->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	constexpr std::uint8_t PendingColor[]{ 0x80, 0x80, 0x80, 0xFF };
+	_functions->glClearTexImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, PendingColor);
+}
+
+void TextureUploader::Enqueue(GpuResourceId resource, GLuint texture, int width, int height, ConvertFunction convert,
+	FinishedFunction finished)
+{
+	auto job = std::make_shared<Job>();
+
+	job->Resource = resource;
+	job->Texture = texture;
+	job->Width = width;
+	job->Height = height;
+	job->Bytes = static_cast<std::size_t>(width) * height * 4;
+	job->Convert = std::move(convert);
+	job->OnFinished = std::move(finished);
+
+	_queuedJobs.push_back(std::move(job));
+}
+
+void TextureUploader::Update()
+{
+	// Retire jobs oldest first so ring buffer space is released in the order it was allocated.
+	while (!_activeJobs.empty())
+	{
+		auto& job = *_activeJobs.front();
+
+		if (job.State == JobState::Copying)
+		{
+			if (!IsFenceSignalled(job.Fence))
+			{
+				break;
+			}
+
+			_functions->glDeleteSync(job.Fence);
+
+			_uploadedBytes += job.Bytes;
+			Finish(job, true);
+		}
+		else if (job.Cancelled)
+		{
+			Finish(job, false);
+		}
+		else
+		{
+			break;
+		}
+
+		_activeJobs.pop_front();
+	}
+
+	std::size_t copiedBytes = 0;
+
+	for (const auto& job : _activeJobs)
+	{
+		if (job->State == JobState::Converting && job->Finished)
+		{
+			job->State = JobState::Converted;
+		}
+
+		if (job->State == JobState::Copying || job->Cancelled)
+		{
+			continue;
+		}
+
+		// Copy in order so fences signal in the order their space was allocated.
+		if (job->State != JobState::Converted || (copiedBytes > 0 && (copiedBytes + job->Bytes) > _frameBudget))
+		{
+			break;
+		}
+
+		// The texture was evicted, and a new upload was queued if it was brought back.
+		if (_residencyManager->GetName(job->Resource) != job->Texture)
+		{
+			job->Cancelled = true;
+			continue;
+		}
+
+		Copy(*job);
+
+		copiedBytes += job->Bytes;
+	}
+
+	while (!_queuedJobs.empty())
+	{
+		const auto& job = _queuedJobs.front();
+
+		if (!_ringBufferData || job->Bytes > _ringBufferSize)
+		{
+			job->OwnPixels.resize(job->Bytes);
+		}
+		else
+		{
+			const auto offset = AllocateRingSpace(job->Bytes);
+
+			if (!offset)
+			{
+				break;
+			}
+
+			job->Offset = *offset;
+			_ringHead = *offset + ((job->Bytes + RingBufferAlignment - 1) & ~(RingBufferAlignment - 1));
+		}
+
+		_activeJobs.push_back(job);
+		StartConverting(job);
+
+		_queuedJobs.pop_front();
+	}
+}
+
+void TextureUploader::CancelAll()
+{
+	for (const auto& job : _activeJobs)
+	{
+		job->Cancelled = true;
+	}
+
+	_threadPool.clear();
+	_threadPool.waitForDone();
+
+	for (const auto& job : _queuedJobs)
+	{
+		Finish(*job, false);
+	}
+
+	_queuedJobs.clear();
+
+	// Nothing uses the memory of jobs that aren't being copied anymore.
+	// Copies still need their space until their fence signals.
+	std::erase_if(_activeJobs, [](const auto& job)
+		{
+			if (job->State == JobState::Copying)
+			{
+				return false;
+			}
+
+			Finish(*job, false);
+			return true;
+		});
+}
+
+std::size_t TextureUploader::GetPendingCount() const
+{
+	return _queuedJobs.size() + static_cast<std::size_t>(std::ranges::count_if(_activeJobs, [](const auto& job)
+		{
+			return !job->Cancelled;
+		}));
+}
+
+std::optional<std::size_t> TextureUploader::AllocateRingSpace(std::size_t bytes) const
+{
+	const auto oldest = std::ranges::find_if(_activeJobs, [](const auto& job)
+		{
+			return job->Offset.has_value();
+		});
+
+	if (oldest == _activeJobs.end())
+	{
+		return 0;
+	}
+
+	const std::size_t tail = *(*oldest)->Offset;
+
+	if (_ringHead > tail)
+	{
+		if ((_ringBufferSize - _ringHead) >= bytes)
+		{
+			return _ringHead;
+		}
+
+		// Wrap around, leaving the end of the buffer unused until the allocations before it are released.
+		if (tail >= bytes)
+		{
+			return 0;
+		}
+
+		return {};
+	}
+
+	// The used space has wrapped around, the head catching up with the tail means the buffer is full.
+	if (_ringHead < tail && (tail - _ringHead) >= bytes)
+	{
+		return _ringHead;
+	}
+
+	return {};
+}
+
+void TextureUploader::StartConverting(const std::shared_ptr<Job>& job)
+{
+	job->State = JobState::Converting;
+
+	std::uint8_t* const pixels = job->Offset ? _ringBufferData + *job->Offset : job->OwnPixels.data();
+
+	_threadPool.start([job, pixels]
+		{
+			if (!job->Cancelled)
+			{
+				job->Convert({ pixels, job->Bytes });
+			}
+
+			job->Finished = true;
+		});
+}
+
+void TextureUploader::Copy(Job& job)
+{
+	if (job.Offset)
+	{
+		_functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _ringBuffer);
+		_functions->glTextureSubImage2D(job.Texture, 0, 0, 0, job.Width, job.Height, GL_RGBA, GL_UNSIGNED_BYTE,
+			reinterpret_cast<const void*>(*job.Offset));
+		_functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+	{
+		_functions->glTextureSubImage2D(job.Texture, 0, 0, 0, job.Width, job.Height, GL_RGBA, GL_UNSIGNED_BYTE,
+			job.OwnPixels.data());
+
+		// The driver has its own copy now.
+		job.OwnPixels = {};
+	}
+
+	job.Fence = _functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	job.State = JobState::Copying;
+}
+
+bool TextureUploader::IsFenceSignalled(GLsync fence)
+{
+	// Flushes so the fence is guaranteed to signal eventually, but never waits.
+	const GLenum result = _functions->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED;
+}
+
+void TextureUploader::Finish(Job& job, bool uploaded)
+{
+	if (auto finished = std::move(job.OnFinished); finished)
+	{
+		finished(uploaded);
+	}
+}
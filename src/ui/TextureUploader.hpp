@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <QOpenGLFunctions_4_5_Compatibility>
+#include <QThreadPool>
+
+#include "ui/GpuResidencyManager.hpp"
+
+/**
+*	@brief Streams texture data to the GPU without blocking the render thread.
+*	@details Pixels are converted to RGBA on a worker thread straight into a persistently mapped pixel buffer,
+*	which is used as a ring buffer. Each frame, converted textures are copied from the pixel buffer into their textures
+*	until the frame's upload budget is used up, and a fence is placed after each copy.
+*	Ring buffer space is reused once the fence of the copy that used it has signalled, fences are polled and never waited on.
+*	Textures larger than the ring buffer are converted into memory of their own and uploaded from there.
+*
+*	Uploads are tied to a resource of a GpuResidencyManager, and are dropped if the resource is evicted first.
+*	All members must be used on the render thread with the owning widget's context current, except CancelAll.
+*/
+class TextureUploader final
+{
+public:
+	static constexpr std::size_t DefaultRingBufferSize = 32 * 1024 * 1024;
+	static constexpr std::size_t DefaultFrameBudget = 4 * 1024 * 1024;
+
+	/**
+	*	@brief Writes the RGBA pixels of a texture. Runs on a worker thread.
+	*	The data it reads must remain valid until the upload is finished or CancelAll returns.
+	*/
+	using ConvertFunction = std::function<void(std::span<std::uint8_t> pixels)>;
+
+	/**
+	*	@brief Called on the render thread once an upload is finished or dropped.
+	*	@param uploaded Whether the pixels were copied into the texture.
+	*/
+	using FinishedFunction = std::function<void(bool uploaded)>;
+
+	TextureUploader(QOpenGLFunctions_4_5_Compatibility* functions, GpuResidencyManager* residencyManager,
+		std::size_t ringBufferSize = DefaultRingBufferSize);
+	~TextureUploader();
+
+	TextureUploader(const TextureUploader&) = delete;
+	TextureUploader& operator=(const TextureUploader&) = delete;
+
+	std::size_t GetFrameBudget() const { return _frameBudget; }
+
+	/**
+	*	@brief Sets the maximum number of bytes copied into textures each frame.
+	*	At least one texture is copied every frame, even if it is larger than the budget.
+	*/
+	void SetFrameBudget(std::size_t frameBudget) { _frameBudget = frameBudget; }
+
+	/**
+	*	@brief Gives the texture bound to GL_TEXTURE_2D storage for an upload, cleared to grey until the pixels arrive.
+	*/
+	void CreateStorage(GLuint texture, int width, int height);
+
+	/**
+	*	@brief Queues an upload of the texture's first mip level.
+	*	@details The texture must already have storage of the given size in GL_RGBA8,
+	*	its contents are replaced once the upload finishes.
+	*/
+	void Enqueue(GpuResourceId resource, GLuint texture, int width, int height, ConvertFunction convert,
+		FinishedFunction finished = {});
+
+	/**
+	*	@brief Finishes completed uploads, copies converted textures and starts converting queued ones.
+	*	Call once at the start of every frame.
+	*/
+	void Update();
+
+	/**
+	*	@brief Drops all uploads and waits for the worker to stop using their data. Doesn't need a current context.
+	*	Uploads that are already being copied finish in the background, but no longer count as pending.
+	*	Their finished functions are called when they finish, the ones of dropped uploads are called right away.
+	*/
+	void CancelAll();
+
+	/**
+	*	@brief Gets the number of uploads that have not finished yet.
+	*/
+	std::size_t GetPendingCount() const;
+
+	/**
+	*	@brief Gets the total number of bytes uploaded to textures, counted when each upload finishes.
+	*/
+	std::uint64_t GetUploadedBytes() const { return _uploadedBytes; }
+
+	std::size_t GetRingBufferSize() const { return _ringBufferSize; }
+
+private:
+	enum class JobState
+	{
+		Queued,
+		Converting,
+		Converted,
+		Copying
+	};
+
+	struct Job
+	{
+		GpuResourceId Resource{ 0 };
+		GLuint Texture{ 0 };
+		int Width{ 0 };
+		int Height{ 0 };
+		std::size_t Bytes{ 0 };
+		ConvertFunction Convert;
+		FinishedFunction OnFinished;
+
+		// Offset in the ring buffer, or nothing if the job has its own memory.
+		std::optional<std::size_t> Offset;
+		std::vector<std::uint8_t> OwnPixels;
+
+		JobState State{ JobState::Queued };
+		GLsync Fence{};
+
+		// Shared with the worker thread. Set once the worker no longer uses the job, whether it converted it or not.
+		std::atomic<bool> Finished{ false };
+		std::atomic<bool> Cancelled{ false };
+	};
+
+	/**
+	*	@brief Finds space for a job at the end of the ring buffer or by wrapping around to its start.
+	*/
+	std::optional<std::size_t> AllocateRingSpace(std::size_t bytes) const;
+
+	void StartConverting(const std::shared_ptr<Job>& job);
+
+	void Copy(Job& job);
+
+	static void Finish(Job& job, bool uploaded);
+
+	bool IsFenceSignalled(GLsync fence);
+
+private:
+	QOpenGLFunctions_4_5_Compatibility* const _functions;
+	GpuResidencyManager* const _residencyManager;
+
+	std::size_t _frameBudget{ DefaultFrameBudget };
+
+	const std::size_t _ringBufferSize;
+	GLuint _ringBuffer{ 0 };
+	std::uint8_t* _ringBufferData{};
+
+	// Where the next allocation starts if it fits before the end of the ring buffer.
+	std::size_t _ringHead{ 0 };
+
+	QThreadPool _threadPool;
+
+	// Jobs waiting for ring buffer space, in the order they were queued.
+	std::deque<std::shared_ptr<Job>> _queuedJobs;
+
+	// Jobs that are being converted or copied, in the order their space was allocated.
+	std::deque<std::shared_ptr<Job>> _activeJobs;
+
+	std::uint64_t _uploadedBytes{ 0 };
+};
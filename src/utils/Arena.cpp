@@ -0,0 +1,59 @@
+#include "utils/Arena.hpp"
+
+ScratchArena::Scope::Scope()
+	: _arena(ScratchArena::GetForThread())
+{
+	++_arena._depth;
+}
+
+ScratchArena::Scope::~Scope()
+{
+	if (--_arena._depth == 0)
+	{
+		_arena.Reset();
+	}
+}
+
+std::pmr::memory_resource* ScratchArena::Scope::GetResource() const
+{
+	return _arena.GetResource();
+}
+
+ScratchArena& ScratchArena::GetForThread()
+{
+	thread_local ScratchArena arena;
+	return arena;
+}
+
+std::pmr::memory_resource* ScratchArena::GetResource()
+{
+	if (!_resource)
+	{
+		if (_buffer)
+		{
+			_resource.emplace(_buffer.get(), _bufferSize, &_overflow);
+		}
+		else
+		{
+			_resource.emplace(&_overflow);
+		}
+	}
+
+	return &*_resource;
+}
+
+void ScratchArena::Reset()
+{
+	// Anything that didn't fit in the buffer had to be allocated separately. Grow the buffer so it fits next time.
+	const std::size_t usedBytes = _bufferSize + _overflow.GetAllocatedBytes();
+
+	_resource.reset();
+
+	// Larger loads keep using separate memory, which has just been released,
+	// so a single large asset doesn't leave a large buffer behind on every thread that loaded one.
+	if (usedBytes > _bufferSize && usedBytes <= MaxRetainedBytes)
+	{
+		_bufferSize = usedBytes;
+		_buffer = std::make_unique_for_overwrite<std::byte[]>(_bufferSize);
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+/**
+*	@brief Forwards to another resource and keeps track of what it allocated.
+*/
+class CountingMemoryResource final : public std::pmr::memory_resource
+{
+public:
+	explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: _upstream(upstream)
+	{
+	}
+
+	/**
+	*	@brief Gets the number of bytes currently allocated.
+	*/
+	std::size_t GetAllocatedBytes() const { return _allocatedBytes; }
+
+	/**
+	*	@brief Gets the number of allocations that haven't been deallocated yet.
+	*/
+	std::size_t GetAllocationCount() const { return _allocationCount; }
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override
+	{
+		void* const memory = _upstream->allocate(bytes, alignment);
+		_allocatedBytes += bytes;
+		++_allocationCount;
+		return memory;
+	}
+
+	void do_deallocate(void* memory, std::size_t bytes, std::size_t alignment) override
+	{
+		_upstream->deallocate(memory, bytes, alignment);
+		_allocatedBytes -= bytes;
+		--_allocationCount;
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	std::pmr::memory_resource* const _upstream;
+	std::size_t _allocatedBytes{ 0 };
+	std::size_t _allocationCount{ 0 };
+};
+
+/**
+*	@brief Memory for everything an asset owns, released all at once when the asset is destroyed.
+*	@details Memory is handed out from large blocks and individual deallocations are ignored,
+*	so loading an asset only makes a handful of allocations regardless of how many containers it has.
+*	Containers that grow after loading leave their old memory behind until the asset is destroyed.
+*	Not thread safe, an asset must only be loaded by one thread at a time.
+*/
+class AssetArena final
+{
+public:
+	AssetArena() = default;
+
+	AssetArena(const AssetArena&) = delete;
+	AssetArena& operator=(const AssetArena&) = delete;
+
+	std::pmr::memory_resource* GetResource() { return &_arena; }
+
+	/**
+	*	@brief Gets the number of bytes in the blocks the arena allocated.
+	*/
+	std::size_t GetReservedBytes() const { return _blocks.GetAllocatedBytes(); }
+
+	std::size_t GetBlockCount() const { return _blocks.GetAllocationCount(); }
+
+private:
+	static constexpr std::size_t InitialBlockSize = 64 * 1024;
+
+	CountingMemoryResource _blocks;
+	std::pmr::monotonic_buffer_resource _arena{ InitialBlockSize, &_blocks };
+};
+
+/**
+*	@brief Memory for temporaries that only live while an asset is loaded, reused by every load on the same thread.
+*	@details The arena keeps a buffer the size of the largest load so far that fits within a limit,
+*	so loading similar assets over and over makes no allocations for temporaries.
+*	Memory is released once the outermost Scope on the thread ends, so nothing allocated from it may outlive that scope.
+*/
+class ScratchArena final
+{
+public:
+	/**
+	*	@brief The buffer is never grown past this size. Memory used by loads that need more is released after each load.
+	*/
+	static constexpr std::size_t MaxRetainedBytes = 64 * 1024 * 1024;
+
+	class Scope final
+	{
+	public:
+		Scope();
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		std::pmr::memory_resource* GetResource() const;
+
+	private:
+		ScratchArena& _arena;
+	};
+
+	ScratchArena() = default;
+
+	ScratchArena(const ScratchArena&) = delete;
+	ScratchArena& operator=(const ScratchArena&) = delete;
+
+	static ScratchArena& GetForThread();
+
+private:
+	std::pmr::memory_resource* GetResource();
+
+	void Reset();
+
+private:
+	CountingMemoryResource _overflow;
+
+	std::unique_ptr<std::byte[]> _buffer;
+	std::size_t _bufferSize{ 0 };
+
+	std::optional<std::pmr::monotonic_buffer_resource> _resource;
+
+	int _depth{ 0 };
+};
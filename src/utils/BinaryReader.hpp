@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstring>
+#include <memory_resource>
 #include <span>
 #include <stdexcept>
 #include <string>
@@ -34,6 +35,11 @@ public:
 
 	BinaryReader subspan(std::size_t offset, std::size_t count = std::dynamic_extent) const
 	{
+		if (offset > _data.size() || (count != std::dynamic_extent && count > (_data.size() - offset)))
+		{
+			throw std::out_of_range("Attempted to create a subspan beyond the end of the buffer");
+		}
+
 		return BinaryReader{_data.subspan(offset, count)};
 	}
 
@@ -86,7 +92,24 @@ public:
 	std::string ReadFixedUTF8String(std::size_t sizeInCharacters)
 	{
 		std::string result;
+		ReadFixedUTF8StringInto(sizeInCharacters, result);
+		return result;
+	}
+
+	/**
+	*	@brief Reads a string into memory from @p resource.
+	*/
+	std::pmr::string ReadFixedUTF8String(std::size_t sizeInCharacters, std::pmr::memory_resource* resource)
+	{
+		std::pmr::string result{ resource };
+		ReadFixedUTF8StringInto(sizeInCharacters, result);
+		return result;
+	}
 
+private:
+	template <typename String>
+	void ReadFixedUTF8StringInto(std::size_t sizeInCharacters, String& result)
+	{
 		result.resize(sizeInCharacters);
 
 		ReadBytes(reinterpret_cast<std::byte*>(result.data()), result.size());
@@ -96,11 +119,8 @@ public:
 		{
 			result.resize(length);
 		}
-
-		return result;
 	}
 
-private:
 	template <typename T>
 	T ReadValue()
 	{
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+/**
+*	@brief Writes binary data to a file, the counterpart of BinaryReader.
+*	@details Write errors are sticky: once a write fails all further writes are ignored,
+*	so callers can write a whole structure and check IsOk once at the end.
+*/
+class BinaryWriter final
+{
+public:
+	explicit BinaryWriter(FILE* file)
+		: _file(file)
+	{
+	}
+
+	BinaryWriter(const BinaryWriter&) = delete;
+	BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+	bool IsOk() const { return _ok; }
+
+	std::size_t GetPosition() const { return _position; }
+
+	void SetPosition(std::size_t offset)
+	{
+		if (_ok && std::fseek(_file, static_cast<long>(offset), SEEK_SET) != 0)
+		{
+			_ok = false;
+		}
+
+		_position = offset;
+	}
+
+	void WriteBytes(std::span<const std::byte> data)
+	{
+		if (_ok && !data.empty() && std::fwrite(data.data(), data.size(), 1, _file) != 1)
+		{
+			_ok = false;
+		}
+
+		_position += data.size();
+	}
+
+	void WriteZeroes(std::size_t count)
+	{
+		constexpr std::byte Zeroes[16]{};
+
+		while (count > 0)
+		{
+			const std::size_t size = std::min(count, sizeof(Zeroes));
+			WriteBytes({ Zeroes, size });
+			count -= size;
+		}
+	}
+
+	/**
+	*	@brief Writes zeroes until the position is a multiple of @p alignment.
+	*/
+	void Align(std::size_t alignment)
+	{
+		WriteZeroes((alignment - (_position % alignment)) % alignment);
+	}
+
+	void WriteUInt8(std::uint8_t value)
+	{
+		WriteValue(value);
+	}
+
+	void WriteUInt16(std::uint16_t value)
+	{
+		WriteValue(value);
+	}
+
+	void WriteUInt32(std::uint32_t value)
+	{
+		WriteValue(value);
+	}
+
+	void WriteInt8(std::int8_t value)
+	{
+		WriteValue(value);
+	}
+
+	void WriteInt16(std::int16_t value)
+	{
+		WriteValue(value);
+	}
+
+	void WriteInt32(std::int32_t value)
+	{
+		WriteValue(value);
+	}
+
+	void WriteFloat(float value)
+	{
+		WriteValue(value);
+	}
+
+	/**
+	*	@brief Writes a string padded with null characters to @p sizeInCharacters.
+	*	The string is truncated if it is too long.
+	*/
+	void WriteFixedUTF8String(std::string_view value, std::size_t sizeInCharacters)
+	{
+		const std::size_t length = std::min(value.size(), sizeInCharacters);
+
+		WriteBytes(std::as_bytes(std::span{ value.data(), length }));
+		WriteZeroes(sizeInCharacters - length);
+	}
+
+private:
+	template <typename T>
+	void WriteValue(const T& value)
+	{
+		WriteBytes(std::as_bytes(std::span{ &value, 1 }));
+	}
+
+private:
+	FILE* _file;
+	std::size_t _position{ 0 };
+	bool _ok{ true };
+};
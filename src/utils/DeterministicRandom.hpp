@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "utils/Hash.hpp"
+
+/**
+*	@brief SplitMix64 random number generator for generated test data.
+*	@details The standard distributions are implementation defined, so they can produce different values
+*	on different platforms. This only uses integer arithmetic, which gives the same sequence everywhere for the same seed.
+*/
+class DeterministicRandom final
+{
+public:
+	explicit DeterministicRandom(std::uint64_t seed)
+		: _state(seed)
+	{
+	}
+
+	std::uint64_t Next()
+	{
+		_state += 0x9E3779B97F4A7C15ULL;
+		return MixHash(_state);
+	}
+
+	/**
+	*	@brief Returns a value in the range [min, max]. The slight bias of the modulo doesn't matter for test data.
+	*/
+	std::int64_t NextInRange(std::int64_t min, std::int64_t max)
+	{
+		const auto range = static_cast<std::uint64_t>(max - min) + 1;
+		return min + static_cast<std::int64_t>(range != 0 ? Next() % range : Next());
+	}
+
+	void Fill(std::span<std::uint8_t> data)
+	{
+		std::size_t i = 0;
+
+		for (; (i + 8) <= data.size(); i += 8)
+		{
+			const std::uint64_t value = Next();
+
+			for (std::size_t j = 0; j < 8; ++j)
+			{
+				data[i + j] = static_cast<std::uint8_t>(value >> (j * 8));
+			}
+		}
+
+		for (std::uint64_t value = Next(); i < data.size(); ++i, value >>= 8)
+		{
+			data[i] = static_cast<std::uint8_t>(value);
+		}
+	}
+
+private:
+	std::uint64_t _state;
+};
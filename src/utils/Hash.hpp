@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+/**
+*	@brief Final mixing step of SplitMix64. Spreads every input bit over the entire result.
+*/
+constexpr std::uint64_t MixHash(std::uint64_t value)
+{
+	value ^= value >> 30;
+	value *= 0xBF58476D1CE4E5B9ULL;
+	value ^= value >> 27;
+	value *= 0x94D049BB133111EBULL;
+	value ^= value >> 31;
+	return value;
+}
+
+/**
+*	@brief Fast non-cryptographic 64 bit hash for detecting identical data.
+*	@details Data is consumed 8 bytes at a time. Pass the result of a previous call as @p seed to hash multiple buffers.
+*/
+inline std::uint64_t HashBytes(std::span<const std::byte> data, std::uint64_t seed = 0)
+{
+	std::uint64_t hash = MixHash(seed ^ (data.size() * 0x9E3779B97F4A7C15ULL));
+
+	std::size_t offset = 0;
+
+	for (; (offset + sizeof(std::uint64_t)) <= data.size(); offset += sizeof(std::uint64_t))
+	{
+		std::uint64_t word;
+		std::memcpy(&word, data.data() + offset, sizeof(word));
+		hash = MixHash(hash ^ word);
+	}
+
+	if (offset < data.size())
+	{
+		std::uint64_t word = 0;
+		std::memcpy(&word, data.data() + offset, data.size() - offset);
+		hash = MixHash(hash ^ word);
+	}
+
+	return hash;
+}
@@ -2,9 +2,36 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <filesystem>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <vector>
 
+/**
+*	@brief Opens a file for binary reading. Unlike @c std::fopen this handles non-ASCII paths on Windows.
+*/
+inline FILE* OpenFileForReading(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+	return _wfopen(path.c_str(), L"rb");
+#else
+	return std::fopen(path.c_str(), "rb");
+#endif
+}
+
+/**
+*	@brief Opens a file for binary writing, truncating it if it exists.
+*/
+inline FILE* OpenFileForWriting(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+	return _wfopen(path.c_str(), L"wb");
+#else
+	return std::fopen(path.c_str(), "wb");
+#endif
+}
+
 inline std::optional<std::vector<std::byte>> TryReadFileIntoBuffer(FILE* file)
 {
 	std::vector<std::byte> buffer;
@@ -23,3 +50,58 @@ inline std::optional<std::vector<std::byte>> TryReadFileIntoBuffer(FILE* file)
 	return {};
 }
 
+/**
+*	@brief Reads the entire file into a buffer allocated from @p resource, such as a ScratchArena.
+*/
+inline std::optional<std::pmr::vector<std::byte>> TryReadFileIntoBuffer(FILE* file, std::pmr::memory_resource* resource)
+{
+	std::pmr::vector<std::byte> buffer{ resource };
+
+	std::fseek(file, 0, SEEK_END);
+	buffer.resize(std::ftell(file));
+	std::fseek(file, 0, SEEK_SET);
+
+	if (std::fread(buffer.data(), buffer.size(), 1, file) == 1)
+	{
+		return buffer;
+	}
+
+	return {};
+}
+
+/**
+*	@brief Gets the size of the file without changing its read position.
+*	@details Used to check sizes read from a file before allocating memory for them.
+*/
+inline std::optional<std::size_t> TryGetFileSize(FILE* file)
+{
+	const long position = std::ftell(file);
+
+	if (position < 0 || std::fseek(file, 0, SEEK_END) != 0)
+	{
+		return {};
+	}
+
+	const long size = std::ftell(file);
+
+	if (std::fseek(file, position, SEEK_SET) != 0 || size < 0)
+	{
+		return {};
+	}
+
+	return static_cast<std::size_t>(size);
+}
+
+/**
+*	@brief Reads @p size bytes starting at @p offset into @p dest.
+*	@details Meant for reading small parts of files without loading the entire file.
+*/
+inline bool TryReadFileRange(FILE* file, long offset, std::span<std::byte> dest)
+{
+	if (std::fseek(file, offset, SEEK_SET) != 0)
+	{
+		return false;
+	}
+
+	return std::fread(dest.data(), dest.size(), 1, file) == 1;
+}
@@ -0,0 +1,172 @@
+#include <charconv>
+#include <cmath>
+#include <iterator>
+
+#include "utils/JsonWriter.hpp"
+
+JsonWriter::JsonWriter(bool pretty)
+	: _pretty(pretty)
+{
+}
+
+void JsonWriter::BeginObject()
+{
+	BeginValue();
+	_buffer += '{';
+	_hasElements.push_back(false);
+}
+
+void JsonWriter::EndObject()
+{
+	Close('}');
+}
+
+void JsonWriter::BeginArray()
+{
+	BeginValue();
+	_buffer += '[';
+	_hasElements.push_back(false);
+}
+
+void JsonWriter::EndArray()
+{
+	Close(']');
+}
+
+void JsonWriter::Key(std::string_view name)
+{
+	BeginValue();
+	AppendString(name);
+	_buffer += _pretty ? ": " : ":";
+	_afterKey = true;
+}
+
+void JsonWriter::Value(std::string_view value)
+{
+	BeginValue();
+	AppendString(value);
+}
+
+void JsonWriter::Value(bool value)
+{
+	BeginValue();
+	_buffer += value ? "true" : "false";
+}
+
+void JsonWriter::Value(std::int64_t value)
+{
+	BeginValue();
+	_buffer += std::to_string(value);
+}
+
+void JsonWriter::Value(std::uint64_t value)
+{
+	BeginValue();
+	_buffer += std::to_string(value);
+}
+
+void JsonWriter::Value(double value)
+{
+	// JSON has no representation for these.
+	if (!std::isfinite(value))
+	{
+		Null();
+		return;
+	}
+
+	BeginValue();
+
+	char buffer[32];
+	const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+	_buffer.append(buffer, result.ptr);
+}
+
+void JsonWriter::Null()
+{
+	BeginValue();
+	_buffer += "null";
+}
+
+void JsonWriter::BeginValue()
+{
+	// Values following a key are part of the same element.
+	if (_afterKey)
+	{
+		_afterKey = false;
+		return;
+	}
+
+	if (_hasElements.empty())
+	{
+		return;
+	}
+
+	if (_hasElements.back())
+	{
+		_buffer += ',';
+	}
+
+	_hasElements.back() = true;
+
+	NewLine();
+}
+
+void JsonWriter::Close(char token)
+{
+	const bool hadElements = _hasElements.back();
+
+	_hasElements.pop_back();
+
+	if (hadElements)
+	{
+		NewLine();
+	}
+
+	_buffer += token;
+}
+
+void JsonWriter::AppendString(std::string_view value)
+{
+	constexpr char HexDigits[] = "0123456789abcdef";
+
+	_buffer += '"';
+
+	// Bytes outside the ASCII range are passed through as is, so UTF-8 input produces UTF-8 output.
+	for (const char c : value)
+	{
+		switch (c)
+		{
+		case '"': _buffer += "\\\""; break;
+		case '\\': _buffer += "\\\\"; break;
+		case '\b': _buffer += "\\b"; break;
+		case '\f': _buffer += "\\f"; break;
+		case '\n': _buffer += "\\n"; break;
+		case '\r': _buffer += "\\r"; break;
+		case '\t': _buffer += "\\t"; break;
+
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				_buffer += "\\u00";
+				_buffer += HexDigits[(c >> 4) & 0xF];
+				_buffer += HexDigits[c & 0xF];
+			}
+			else
+			{
+				_buffer += c;
+			}
+			break;
+		}
+	}
+
+	_buffer += '"';
+}
+
+void JsonWriter::NewLine()
+{
+	if (_pretty)
+	{
+		_buffer += '\n';
+		_buffer.append(_hasElements.size(), '\t');
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+*	@brief Builds a JSON document in memory, one token at a time.
+*	@details The writer only inserts separators and indentation, callers are responsible for producing valid structure:
+*	every value in an object must be preceded by a key, and every object and array must be ended.
+*/
+class JsonWriter final
+{
+public:
+	/**
+	*	@param pretty Whether to put each value on its own line, indented by nesting depth.
+	*/
+	explicit JsonWriter(bool pretty = false);
+
+	const std::string& GetString() const { return _buffer; }
+
+	void BeginObject();
+	void EndObject();
+
+	void BeginArray();
+	void EndArray();
+
+	void Key(std::string_view name);
+
+	void Value(std::string_view value);
+	void Value(const char* value) { Value(std::string_view{ value }); }
+	void Value(bool value);
+	void Value(int value) { Value(static_cast<std::int64_t>(value)); }
+	void Value(unsigned int value) { Value(static_cast<std::uint64_t>(value)); }
+	void Value(std::int64_t value);
+	void Value(std::uint64_t value);
+	void Value(double value);
+	void Null();
+
+	template<typename T>
+	void Property(std::string_view name, const T& value)
+	{
+		Key(name);
+		Value(value);
+	}
+
+private:
+	void BeginValue();
+
+	void Close(char token);
+
+	void AppendString(std::string_view value);
+
+	void NewLine();
+
+private:
+	const bool _pretty;
+
+	std::string _buffer;
+
+	// Whether the container at each depth already has an element, to know when to insert a comma.
+	std::vector<bool> _hasElements;
+
+	bool _afterKey{ false };
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+/**
+*	@brief Lets a load running on a worker thread report its progress and observe cancellation requests.
+*	@details All members can be used from any thread.
+*/
+class LoadProgress final
+{
+public:
+	LoadProgress() = default;
+
+	LoadProgress(const LoadProgress&) = delete;
+	LoadProgress& operator=(const LoadProgress&) = delete;
+
+	bool IsCancelled() const
+	{
+		return _cancelled.load(std::memory_order_relaxed);
+	}
+
+	void Cancel()
+	{
+		_cancelled.store(true, std::memory_order_relaxed);
+	}
+
+	/**
+	*	@brief Gets the progress in the range [0, 1].
+	*/
+	float GetProgress() const
+	{
+		return _progress.load(std::memory_order_relaxed);
+	}
+
+	void SetProgress(float progress)
+	{
+		_progress.store(std::clamp(progress, 0.f, 1.f), std::memory_order_relaxed);
+	}
+
+	/**
+	*	@brief Convenience function for loaders that process a list of items.
+	*/
+	void SetProgress(std::size_t current, std::size_t total)
+	{
+		SetProgress(total > 0 ? static_cast<float>(current) / total : 1.f);
+	}
+
+private:
+	std::atomic<bool> _cancelled{ false };
+	std::atomic<float> _progress{ 0.f };
+};
@@ -0,0 +1,153 @@
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "utils/MappedFile.hpp"
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: _data(std::exchange(other._data, nullptr))
+	, _size(std::exchange(other._size, 0))
+#ifdef _WIN32
+	, _mapping(std::exchange(other._mapping, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+
+		_data = std::exchange(other._data, nullptr);
+		_size = std::exchange(other._size, 0);
+#ifdef _WIN32
+		_mapping = std::exchange(other._mapping, nullptr);
+#endif
+	}
+
+	return *this;
+}
+
+std::optional<MappedFile> MappedFile::TryOpen(const std::filesystem::path& path)
+{
+	MappedFile mappedFile;
+
+#ifdef _WIN32
+	const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return {};
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return {};
+	}
+
+	// Empty files can't be mapped, but there is nothing to map anyway.
+	if (size.QuadPart > 0)
+	{
+		// The mapping keeps the file open, so the file handle isn't needed anymore.
+		mappedFile._mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		CloseHandle(file);
+
+		if (!mappedFile._mapping)
+		{
+			return {};
+		}
+
+		mappedFile._data = static_cast<const std::byte*>(MapViewOfFile(mappedFile._mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (!mappedFile._data)
+		{
+			return {};
+		}
+
+		mappedFile._size = static_cast<std::size_t>(size.QuadPart);
+	}
+	else
+	{
+		CloseHandle(file);
+	}
+#else
+	const int file = open(path.c_str(), O_RDONLY);
+
+	if (file == -1)
+	{
+		return {};
+	}
+
+	struct stat status;
+
+	if (fstat(file, &status) != 0)
+	{
+		close(file);
+		return {};
+	}
+
+	// Empty files can't be mapped, but there is nothing to map anyway.
+	if (status.st_size > 0)
+	{
+		void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			return {};
+		}
+
+		mappedFile._data = static_cast<const std::byte*>(data);
+		mappedFile._size = static_cast<std::size_t>(status.st_size);
+	}
+
+	// The mapping keeps the file open, so the descriptor isn't needed anymore.
+	close(file);
+#endif
+
+	return mappedFile;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (_data)
+	{
+		UnmapViewOfFile(_data);
+	}
+
+	if (_mapping)
+	{
+		CloseHandle(_mapping);
+	}
+
+	_mapping = nullptr;
+#else
+	if (_data)
+	{
+		munmap(const_cast<std::byte*>(_data), _size);
+	}
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+/**
+*	@brief Read-only memory mapping of an entire file.
+*	@details Pages are read on demand by the operating system, so large files can be accessed
+*	without reading them into memory first, and passing mapped data to @c fwrite does not make an extra copy.
+*	The file cannot be replaced or deleted on Windows while it is mapped.
+*/
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	static std::optional<MappedFile> TryOpen(const std::filesystem::path& path);
+
+	std::span<const std::byte> GetData() const { return { _data, _size }; }
+
+	/**
+	*	@brief Unmaps the file. Any spans returned by GetData are no longer valid.
+	*/
+	void Close();
+
+private:
+	const std::byte* _data{ nullptr };
+	std::size_t _size{ 0 };
+
+#ifdef _WIN32
+	void* _mapping{ nullptr };
+#endif
+};
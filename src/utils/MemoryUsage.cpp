@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string>
+
+#include "utils/JsonWriter.hpp"
+#include "utils/MemoryUsage.hpp"
+
+std::string_view GetMemoryCategoryName(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::Geometry: return "geometry";
+	case MemoryCategory::Textures: return "textures";
+	case MemoryCategory::Palettes: return "palettes";
+	case MemoryCategory::Pixmaps: return "pixmaps";
+	case MemoryCategory::EntityText: return "entityText";
+	case MemoryCategory::Other: return "other";
+	default: return "unknown";
+	}
+}
+
+MemoryCategoryUsage MemoryUsage::GetTotal() const
+{
+	MemoryCategoryUsage total;
+
+	for (const auto& usage : _categories)
+	{
+		total += usage;
+	}
+
+	return total;
+}
+
+void MemoryUsage::AddShared(MemoryCategory category, const void* block, std::size_t bytes)
+{
+	if (_sharedBlocks.try_emplace(block, category, bytes).second)
+	{
+		AddHeap(category, bytes);
+	}
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other)
+{
+	for (std::size_t i = 0; i < MemoryCategoryCount; ++i)
+	{
+		_categories[i] += other._categories[i];
+	}
+
+	for (const auto& [block, size] : other._sharedBlocks)
+	{
+		if (!_sharedBlocks.insert({ block, size }).second)
+		{
+			// Counted on both sides, take the second one back out.
+			auto& usage = _categories[static_cast<std::size_t>(size.first)];
+			usage.HeapBytes -= size.second;
+			--usage.AllocationCount;
+		}
+	}
+
+	return *this;
+}
+
+std::string FormatByteSize(std::size_t bytes)
+{
+	constexpr const char* Units[] = { "bytes", "KiB", "MiB", "GiB", "TiB" };
+
+	if (bytes < 1024)
+	{
+		return std::to_string(bytes) + " bytes";
+	}
+
+	double size = static_cast<double>(bytes);
+	std::size_t unit = 0;
+
+	while (size >= 1024 && (unit + 1) < std::size(Units))
+	{
+		size /= 1024;
+		++unit;
+	}
+
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.1f %s", size, Units[unit]);
+
+	return buffer;
+}
+
+static void WriteCategoryUsage(JsonWriter& writer, const MemoryCategoryUsage& usage)
+{
+	writer.Property("heapBytes", static_cast<std::uint64_t>(usage.HeapBytes));
+	writer.Property("allocationCount", static_cast<std::uint64_t>(usage.AllocationCount));
+	writer.Property("gpuBytes", static_cast<std::uint64_t>(usage.GpuBytes));
+}
+
+void WriteMemoryUsage(JsonWriter& writer, const MemoryUsage& usage)
+{
+	writer.BeginObject();
+
+	WriteCategoryUsage(writer, usage.GetTotal());
+
+	writer.Key("categories");
+	writer.BeginObject();
+
+	for (std::size_t i = 0; i < MemoryCategoryCount; ++i)
+	{
+		const auto category = static_cast<MemoryCategory>(i);
+
+		writer.Key(GetMemoryCategoryName(category));
+		writer.BeginObject();
+		WriteCategoryUsage(writer, usage.Get(category));
+		writer.EndObject();
+	}
+
+	writer.EndObject();
+
+	writer.EndObject();
+}
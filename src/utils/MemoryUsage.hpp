@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class JsonWriter;
+
+enum class MemoryCategory : std::size_t
+{
+	Geometry = 0,
+	Textures,
+	Palettes,
+	Pixmaps,
+	EntityText,
+
+	/**
+	*	@brief Names, lookup tables and other bookkeeping.
+	*/
+	Other,
+
+	Count
+};
+
+constexpr std::size_t MemoryCategoryCount = static_cast<std::size_t>(MemoryCategory::Count);
+
+/**
+*	@brief Gets the name of a category, used as its key in machine-readable output.
+*/
+std::string_view GetMemoryCategoryName(MemoryCategory category);
+
+struct MemoryCategoryUsage
+{
+	std::size_t HeapBytes{ 0 };
+	std::size_t AllocationCount{ 0 };
+	std::size_t GpuBytes{ 0 };
+
+	MemoryCategoryUsage& operator+=(const MemoryCategoryUsage& other)
+	{
+		HeapBytes += other.HeapBytes;
+		AllocationCount += other.AllocationCount;
+		GpuBytes += other.GpuBytes;
+		return *this;
+	}
+};
+
+/**
+*	@brief Memory owned by an asset, broken down by category.
+*	@details Heap usage is measured from the capacity of the containers an asset owns, so it doesn't include
+*	allocator overhead or memory owned by libraries. Each non-empty container counts as one allocation,
+*	even if it was carved out of an AssetArena.
+*	Memory shared between assets, such as interned palettes, is counted once no matter how many times it is added,
+*	including when usages are combined.
+*/
+class MemoryUsage final
+{
+public:
+	const MemoryCategoryUsage& Get(MemoryCategory category) const { return _categories[static_cast<std::size_t>(category)]; }
+
+	MemoryCategoryUsage GetTotal() const;
+
+	void AddHeap(MemoryCategory category, std::size_t bytes, std::size_t allocationCount = 1)
+	{
+		auto& usage = _categories[static_cast<std::size_t>(category)];
+		usage.HeapBytes += bytes;
+		usage.AllocationCount += allocationCount;
+	}
+
+	template<typename T, typename Allocator>
+	void Add(MemoryCategory category, const std::vector<T, Allocator>& vector)
+	{
+		if (vector.capacity() > 0)
+		{
+			AddHeap(category, vector.capacity() * sizeof(T));
+		}
+	}
+
+	/**
+	*	@brief Adds the string's buffer if it is too large to be stored in the string itself.
+	*/
+	template<typename Allocator>
+	void Add(MemoryCategory category, const std::basic_string<char, std::char_traits<char>, Allocator>& string)
+	{
+		// A default constructed string's capacity is exactly what fits in the string itself.
+		if (string.capacity() > std::basic_string<char, std::char_traits<char>, Allocator>{}.capacity())
+		{
+			AddHeap(category, string.capacity() + 1);
+		}
+	}
+
+	/**
+	*	@brief Adds an estimate of a hash table's memory: its buckets and one node per element.
+	*/
+	template<typename Key, typename Value, typename... Rest>
+	void Add(MemoryCategory category, const std::unordered_map<Key, Value, Rest...>& map)
+	{
+		AddHashTable(category, map);
+	}
+
+	template<typename Key, typename Value, typename... Rest>
+	void Add(MemoryCategory category, const std::unordered_multimap<Key, Value, Rest...>& map)
+	{
+		AddHashTable(category, map);
+	}
+
+	/**
+	*	@brief Adds memory that can be shared with other assets, unless the block identified by @p block was already added.
+	*/
+	void AddShared(MemoryCategory category, const void* block, std::size_t bytes);
+
+	void AddGpu(MemoryCategory category, std::size_t bytes)
+	{
+		_categories[static_cast<std::size_t>(category)].GpuBytes += bytes;
+	}
+
+	MemoryUsage& operator+=(const MemoryUsage& other);
+
+private:
+	template<typename Map>
+	void AddHashTable(MemoryCategory category, const Map& map)
+	{
+		if (map.bucket_count() > 0)
+		{
+			// Nodes hold the element, the next pointer and usually the cached hash.
+			constexpr std::size_t NodeSize = sizeof(typename Map::value_type) + (2 * sizeof(void*));
+
+			AddHeap(category, (map.bucket_count() * sizeof(void*)) + (map.size() * NodeSize), map.size() + 1);
+		}
+	}
+
+private:
+	std::array<MemoryCategoryUsage, MemoryCategoryCount> _categories{};
+
+	/**
+	*	@brief Shared blocks that were added, so combining usages can leave out the ones counted on both sides.
+	*/
+	std::unordered_map<const void*, std::pair<MemoryCategory, std::size_t>> _sharedBlocks;
+};
+
+/**
+*	@brief Formats a byte count for display, such as "1.5 MiB".
+*/
+std::string FormatByteSize(std::size_t bytes);
+
+/**
+*	@brief Writes the usage as an object with the totals and an object per category.
+*/
+void WriteMemoryUsage(JsonWriter& writer, const MemoryUsage& usage);